@@ -0,0 +1,93 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "allocation_tests/allocation_counter.h"
+
+#include <cassert>
+#include <cstddef>
+
+namespace ConnectivityManager::AllocationTests
+{
+    namespace
+    {
+        // Thread local storage in the executable is static TLS, accessing it does not allocate.
+        thread_local bool counting = false;
+        thread_local AllocationCounter::Count current;
+
+        void allocated(std::size_t size)
+        {
+            if (counting) {
+                current.allocations++;
+                current.bytes += size;
+            }
+        }
+    }
+
+    AllocationCounter::AllocationCounter()
+    {
+        assert(!counting);
+
+        current = Count();
+        counting = true;
+    }
+
+    AllocationCounter::~AllocationCounter()
+    {
+        counting = false;
+    }
+
+    bool AllocationCounter::available()
+    {
+#ifdef __GLIBC__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    AllocationCounter::Count AllocationCounter::count() const
+    {
+        return current;
+    }
+}
+
+#ifdef __GLIBC__
+
+// Replacements for the allocator in glibc. Symbols in the executable take precedence over those in
+// libc.so for all shared libraries. The __libc_* functions are glibc's implementations.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(std::size_t size) noexcept
+{
+    ConnectivityManager::AllocationTests::allocated(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) noexcept
+{
+    ConnectivityManager::AllocationTests::allocated(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size) noexcept
+{
+    ConnectivityManager::AllocationTests::allocated(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer) noexcept
+{
+    __libc_free(pointer);
+}
+}
+
+#endif
@@ -0,0 +1,49 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_ALLOCATION_TESTS_ALLOCATION_COUNTER_H
+#define CONNECTIVITY_MANAGER_ALLOCATION_TESTS_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+namespace ConnectivityManager::AllocationTests
+{
+    // Counts heap allocations made by the calling thread while it exists.
+    //
+    // malloc(), calloc() and realloc() are replaced in executables linking allocation_counter.cpp
+    // and forwarded to glibc, so allocations from all libraries (GLib, operator new in libstdc++
+    // etc.) are seen. realloc() counts as one allocation of the new size. Memory from
+    // posix_memalign() and friends is not counted. Other threads (e.g. the GDBus worker thread
+    // doing socket I/O) are not counted.
+    //
+    // Only one AllocationCounter per thread at a time. available() is false if replacing malloc()
+    // is not supported (not glibc), counts are then always 0.
+    class AllocationCounter
+    {
+    public:
+        struct Count
+        {
+            std::uint64_t allocations = 0;
+            std::uint64_t bytes = 0;
+        };
+
+        AllocationCounter();
+        ~AllocationCounter();
+
+        AllocationCounter(const AllocationCounter &other) = delete;
+        AllocationCounter(AllocationCounter &&other) = delete;
+        AllocationCounter &operator=(const AllocationCounter &other) = delete;
+        AllocationCounter &operator=(AllocationCounter &&other) = delete;
+
+        static bool available();
+
+        Count count() const;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_ALLOCATION_TESTS_ALLOCATION_COUNTER_H
@@ -0,0 +1,620 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+// Allocation accounting test of the daemon. Run by "meson test" in dbus-run-session, see
+// meson.build.
+//
+// Counts heap allocations (see AllocationCounter) made by the daemon when handling an event, end
+// to end from ConnMan through ConnManBackend, Backend and DBusService, and fails if the average
+// number of allocations or bytes per event exceeds the budget of the scenario (BUDGET_*).
+// Scenarios:
+//
+// - strength-change: ConnMan service Strength changes until the access point is updated.
+// - access-point-add: ConnMan adds a service until the access point is added.
+// - access-point-remove: ConnMan removes a service until the access point is removed.
+// - connect: Backend::wifi_connect() of a service requiring a passphrase until finished, including
+//   the agent RequestInput() round trip.
+//
+// The daemon objects run in this process so their allocations can be counted. MockConnMan runs in
+// a child process (this executable with --mock-connman) so that its allocations are not, and is
+// controlled with commands on its stdin:
+//
+//   strength INDEX STRENGTH  Set strength of service INDEX.
+//   add                      Add a service.
+//   remove                   Remove most recently added service.
+//
+// Every scenario is first run WARMUP_ITERATIONS times without counting, so that one-time
+// allocations (first use of a code path, caches etc.) are not part of the result.
+
+#include <giomm.h>
+#include <glib.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+#include <unistd.h>
+
+#include <clocale>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocation_tests/allocation_counter.h"
+#include "common/credentials.h"
+#include "common/dbus.h"
+#include "daemon/arguments.h"
+#include "daemon/backend.h"
+#include "daemon/dbus_service.h"
+#include "mock_connman/arguments.h"
+#include "mock_connman/connman_dbus.h"
+#include "mock_connman/mock_connman.h"
+
+namespace
+{
+    using ConnectivityManager::AllocationTests::AllocationCounter;
+    using ConnectivityManager::Common::Credentials;
+    using ConnectivityManager::Common::DBus;
+    using ConnectivityManager::Daemon::Backend;
+    using ConnectivityManager::Daemon::DBusService;
+    using ConnectivityManager::MockConnMan::ConnManDBus;
+    using ConnectivityManager::MockConnMan::MockConnMan;
+
+    using Count = AllocationCounter::Count;
+    using DaemonArguments = ConnectivityManager::Daemon::Arguments;
+    using MockConnManArguments = ConnectivityManager::MockConnMan::Arguments;
+
+    // Maximum average allocations and bytes per event. Lower these when allocations are removed
+    // from a path so that they do not come back unnoticed.
+    struct Budget
+    {
+        const char *scenario;
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    constexpr Budget BUDGET_STRENGTH_CHANGE = {"strength-change", 150, 16 * 1024};
+    constexpr Budget BUDGET_ACCESS_POINT_ADD = {"access-point-add", 1500, 256 * 1024};
+    constexpr Budget BUDGET_ACCESS_POINT_REMOVE = {"access-point-remove", 600, 64 * 1024};
+    constexpr Budget BUDGET_CONNECT = {"connect", 4000, 512 * 1024};
+
+    constexpr std::size_t WARMUP_ITERATIONS = 2;
+    constexpr std::size_t ITERATIONS = 20;
+
+    // Service 0 is used for strength changes, one service per connect after that.
+    constexpr std::uint64_t SERVICE_COUNT = 1 + WARMUP_ITERATIONS + ITERATIONS;
+
+    constexpr std::uint64_t MOCK_CONNECT_STEP_MS = 1;
+
+    constexpr unsigned int STARTUP_TIMEOUT_MS = 10 * 1000;
+    constexpr unsigned int EVENT_TIMEOUT_MS = 5 * 1000;
+    constexpr unsigned int SETTLE_TIME_MS = 50;
+    constexpr unsigned int MOCK_EXIT_TIMEOUT_MS = 5 * 1000;
+
+    constexpr int EXIT_SKIP = 77; // Test skipped, see meson documentation for test().
+
+    struct Arguments
+    {
+        bool mock_connman = false;
+    };
+
+    std::optional<Arguments> arguments_parse(int argc, char *argv[])
+    {
+        Arguments arguments;
+        Glib::OptionGroup main_group("allocation-test", "Test Options");
+        Glib::OptionContext context;
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("mock-connman");
+            entry.set_description("Run mock ConnMan controlled by commands on stdin (internal)");
+            main_group.add_entry(entry, arguments.mock_connman);
+        }
+
+        context.set_summary("Checks heap allocations of the daemon per event against budgets, "
+                            "with a mock ConnMan on the session bus.");
+        context.set_main_group(main_group);
+
+        try {
+            context.parse(argc, argv);
+        } catch (const Glib::Error &error) {
+            std::cerr << Glib::get_prgname() << ": " << error.what() << '\n';
+            return {};
+        }
+
+        return arguments;
+    }
+
+    // Iterates the default main context until done() returns true or timeout_ms has passed.
+    bool run_until(const std::function<bool()> &done, unsigned int timeout_ms)
+    {
+        Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+        bool timed_out = false;
+
+        sigc::connection timeout = Glib::signal_timeout().connect(
+            [&timed_out] {
+                timed_out = true;
+                return false;
+            },
+            timeout_ms);
+
+        while (!done() && !timed_out) {
+            context->iteration(true);
+        }
+
+        timeout.disconnect();
+
+        return done();
+    }
+
+    void run_for(unsigned int time_ms)
+    {
+        run_until([] { return false; }, time_ms);
+    }
+
+    // Like run_until() but counts allocations made by trigger() and the main loop iterations after
+    // it. The timeout source is created before counting starts.
+    std::optional<Count> count_until(const std::function<void()> &trigger,
+                                     const std::function<bool()> &done)
+    {
+        // Do not count handling of events from previous scenario.
+        run_for(SETTLE_TIME_MS);
+
+        Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+        bool timed_out = false;
+
+        sigc::connection timeout = Glib::signal_timeout().connect(
+            [&timed_out] {
+                timed_out = true;
+                return false;
+            },
+            EVENT_TIMEOUT_MS);
+
+        std::optional<Count> count;
+
+        {
+            AllocationCounter counter;
+
+            trigger();
+
+            while (!done() && !timed_out) {
+                context->iteration(true);
+            }
+
+            count = counter.count();
+        }
+
+        timeout.disconnect();
+
+        if (!done()) {
+            return {};
+        }
+
+        return count;
+    }
+
+    bool wait_for_name(const Glib::ustring &name)
+    {
+        bool appeared = false;
+
+        guint watch_id = Gio::DBus::watch_name(
+            Gio::DBus::BUS_TYPE_SYSTEM,
+            name,
+            [&appeared](const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                        const Glib::ustring & /*name*/,
+                        const Glib::ustring & /*name_owner*/) { appeared = true; });
+
+        bool result = run_until([&appeared] { return appeared; }, STARTUP_TIMEOUT_MS);
+
+        Gio::DBus::unwatch_name(watch_id);
+
+        return result;
+    }
+
+    MockConnManArguments mock_connman_arguments()
+    {
+        MockConnManArguments arguments;
+        arguments.services = SERVICE_COUNT;
+        arguments.connect_step_ms = MOCK_CONNECT_STEP_MS;
+        return arguments;
+    }
+
+    void mock_connman_command(MockConnMan &mock_connman, const std::string &line)
+    {
+        std::istringstream stream(line);
+        std::string command;
+        stream >> command;
+
+        if (command == "strength") {
+            std::uint64_t index = 0;
+            unsigned int strength = 0;
+            stream >> index >> strength;
+            mock_connman.service_set_strength(index, static_cast<std::uint8_t>(strength));
+        } else if (command == "add") {
+            mock_connman.services_add(1, "psk");
+        } else if (command == "remove") {
+            mock_connman.services_remove(1);
+        } else {
+            g_warning("Unknown mock ConnMan command \"%s\"", line.c_str());
+        }
+    }
+
+    // Runs MockConnMan in the child process until stdin is closed.
+    int mock_connman_run()
+    {
+        Glib::RefPtr<Glib::MainLoop> main_loop = Glib::MainLoop::create();
+        MockConnMan mock_connman(main_loop, mock_connman_arguments());
+        std::string buffer;
+
+        Glib::signal_io().connect(
+            [&](Glib::IOCondition /*condition*/) {
+                char data[256];
+                ssize_t size = read(STDIN_FILENO, data, sizeof(data));
+                if (size <= 0) {
+                    main_loop->quit();
+                    return false;
+                }
+
+                buffer.append(data, static_cast<std::size_t>(size));
+
+                for (std::size_t end = buffer.find('\n'); end != std::string::npos;
+                     end = buffer.find('\n')) {
+                    mock_connman_command(mock_connman, buffer.substr(0, end));
+                    buffer.erase(0, end + 1);
+                }
+
+                return true;
+            },
+            STDIN_FILENO,
+            Glib::IO_IN | Glib::IO_HUP);
+
+        mock_connman.own_name();
+
+        main_loop->run();
+
+        return EXIT_SUCCESS;
+    }
+
+    // Mock ConnMan child process, exits when its stdin is closed on destruction.
+    class MockConnManProcess
+    {
+    public:
+        MockConnManProcess()
+        {
+            // Executing /proc/self/exe runs this executable regardless of how it was started.
+            Glib::spawn_async_with_pipes("",
+                                         std::vector<std::string>{"/proc/self/exe",
+                                                                  "--mock-connman"},
+                                         Glib::SPAWN_DO_NOT_REAP_CHILD |
+                                             Glib::SPAWN_STDOUT_TO_DEV_NULL,
+                                         {},
+                                         &pid_,
+                                         &stdin_fd_);
+
+            child_watch_ = Glib::signal_child_watch().connect(
+                [this](Glib::Pid /*pid*/, int /*status*/) { exited_ = true; }, pid_);
+        }
+
+        ~MockConnManProcess()
+        {
+            close(stdin_fd_);
+
+            if (!run_until([this] { return exited_; }, MOCK_EXIT_TIMEOUT_MS)) {
+                g_warning("Mock ConnMan did not exit when stdin was closed, killing it");
+                kill(pid_, SIGKILL);
+                run_until([this] { return exited_; }, MOCK_EXIT_TIMEOUT_MS);
+            }
+
+            child_watch_.disconnect();
+            Glib::spawn_close_pid(pid_);
+        }
+
+        MockConnManProcess(const MockConnManProcess &other) = delete;
+        MockConnManProcess(MockConnManProcess &&other) = delete;
+        MockConnManProcess &operator=(const MockConnManProcess &other) = delete;
+        MockConnManProcess &operator=(MockConnManProcess &&other) = delete;
+
+        // Command must end with a newline. Small enough to be written in one go to the pipe.
+        bool command(const std::string &command) const
+        {
+            return write(stdin_fd_, command.data(), command.size()) ==
+                   static_cast<ssize_t>(command.size());
+        }
+
+    private:
+        Glib::Pid pid_ = 0;
+        int stdin_fd_ = -1;
+        bool exited_ = false;
+        sigc::connection child_watch_;
+    };
+
+    // Backend and D-Bus service of the daemon running against a mock ConnMan.
+    class Session
+    {
+    public:
+        Session() = default;
+
+        ~Session()
+        {
+            if (dbus_service_) {
+                dbus_service_->unown_name();
+            }
+        }
+
+        Session(const Session &other) = delete;
+        Session(Session &&other) = delete;
+        Session &operator=(const Session &other) = delete;
+        Session &operator=(Session &&other) = delete;
+
+        bool start()
+        {
+            if (!wait_for_name(ConnManDBus::SERVICE_NAME)) {
+                std::cerr << "Mock ConnMan did not appear on bus\n";
+                return false;
+            }
+
+            backend_ = Backend::create_default(daemon_arguments_);
+            backend_->signals().wifi.access_points_changed.connect(
+                sigc::mem_fun(*this, &Session::access_points_changed));
+
+            dbus_service_.emplace(
+                main_loop_, *backend_, daemon_arguments_.wifi_access_points_order);
+            dbus_service_->own_name();
+
+            if (!wait_for_name(DBus::MANAGER_SERVICE_NAME)) {
+                std::cerr << "Daemon did not appear on bus\n";
+                return false;
+            }
+
+            auto populated = [this] {
+                return backend_->state().wifi.access_points.size() == SERVICE_COUNT;
+            };
+
+            if (!run_until(populated, STARTUP_TIMEOUT_MS)) {
+                std::cerr << "Access points not populated from mock ConnMan services\n";
+                return false;
+            }
+
+            return true;
+        }
+
+        std::optional<Count> strength_change(std::size_t iteration)
+        {
+            // Alternate so that strength always changes.
+            std::string command = iteration % 2 == 0 ? "strength 0 20\n" : "strength 0 80\n";
+
+            return count_access_point_event(command,
+                                            Backend::WiFiAccessPoint::Event::STRENGTH_CHANGED);
+        }
+
+        std::optional<Count> access_point_add()
+        {
+            return count_access_point_event("add\n", Backend::WiFiAccessPoint::Event::ADDED_ONE);
+        }
+
+        std::optional<Count> access_point_remove()
+        {
+            return count_access_point_event("remove\n",
+                                            Backend::WiFiAccessPoint::Event::REMOVED_ONE);
+        }
+
+        std::optional<Count> connect(std::size_t iteration)
+        {
+            // Mock service names are "mock-N" with N starting at 1, service 0 is for strength.
+            const std::string ssid = "mock-" + std::to_string(iteration + 2);
+            const Backend::WiFiAccessPoint *access_point = access_point_find(ssid);
+            if (!access_point) {
+                std::cerr << "No access point with SSID " << ssid << '\n';
+                return {};
+            }
+
+            const Backend::WiFiAccessPoint::Id id = access_point->id;
+            const Glib::ustring passphrase = MockConnManArguments().passphrase;
+            std::optional<Backend::ConnectResult> result;
+
+            std::optional<Count> count = count_until(
+                [&] {
+                    backend_->wifi_connect(
+                        *access_point,
+                        [&result](Backend::ConnectResult connect_result) {
+                            result = connect_result;
+                        },
+                        [&passphrase](const Credentials::Requested & /*requested*/,
+                                      Backend::RequestCredentialsFromUserReply &&reply) {
+                            Credentials credentials;
+                            credentials.password = Credentials::Password{
+                                Credentials::Password::Type::PASSPHRASE, passphrase};
+                            reply(credentials);
+                        },
+                        {});
+                },
+                [&result] { return result.has_value(); });
+
+            if (!count || *result != Backend::ConnectResult::SUCCESS) {
+                std::cerr << "Failed to connect to " << ssid << '\n';
+                return {};
+            }
+
+            // Disconnect so the next connect is not a switch between services. Not counted.
+            if (const Backend::WiFiAccessPoint *connected = access_point_find(id)) {
+                backend_->wifi_disconnect(*connected);
+
+                auto disconnected = [this, id] {
+                    const Backend::WiFiAccessPoint *ap = access_point_find(id);
+                    return !ap || !ap->connected;
+                };
+
+                if (!run_until(disconnected, EVENT_TIMEOUT_MS)) {
+                    std::cerr << "Failed to disconnect from " << ssid << '\n';
+                    return {};
+                }
+            }
+
+            return count;
+        }
+
+    private:
+        void access_points_changed(Backend::WiFiAccessPoint::Event event,
+                                   const Backend::WiFiAccessPoint * /*access_point*/)
+        {
+            if (event == awaited_event_) {
+                awaited_event_seen_ = true;
+            }
+        }
+
+        std::optional<Count> count_access_point_event(const std::string &command,
+                                                      Backend::WiFiAccessPoint::Event event)
+        {
+            awaited_event_ = event;
+            awaited_event_seen_ = false;
+
+            return count_until(
+                [this, &command] {
+                    if (!mock_connman_.command(command)) {
+                        std::cerr << "Failed to send command to mock ConnMan\n";
+                    }
+                },
+                [this] { return awaited_event_seen_; });
+        }
+
+        const Backend::WiFiAccessPoint *access_point_find(const std::string &ssid) const
+        {
+            for (const auto &[id, access_point] : backend_->state().wifi.access_points) {
+                if (access_point.ssid == ssid) {
+                    return &access_point;
+                }
+            }
+            return nullptr;
+        }
+
+        const Backend::WiFiAccessPoint *access_point_find(Backend::WiFiAccessPoint::Id id) const
+        {
+            const auto &access_points = backend_->state().wifi.access_points;
+            auto i = access_points.find(id);
+            return i != access_points.cend() ? &i->second : nullptr;
+        }
+
+        DaemonArguments daemon_arguments_;
+        MockConnManProcess mock_connman_;
+
+        Glib::RefPtr<Glib::MainLoop> main_loop_ = Glib::MainLoop::create();
+        std::unique_ptr<Backend> backend_;
+        std::optional<DBusService> dbus_service_;
+
+        Backend::WiFiAccessPoint::Event awaited_event_ = Backend::WiFiAccessPoint::Event::ADDED_ALL;
+        bool awaited_event_seen_ = false;
+    };
+
+    // Runs a scenario and prints the average per event. False if it failed or is over budget.
+    bool scenario_run(const Budget &budget,
+                      const std::function<std::optional<Count>(std::size_t iteration)> &run)
+    {
+        for (std::size_t i = 0; i < WARMUP_ITERATIONS; i++) {
+            if (!run(i)) {
+                std::cerr << budget.scenario << ": failed during warmup\n";
+                return false;
+            }
+        }
+
+        Count total;
+
+        for (std::size_t i = WARMUP_ITERATIONS; i < WARMUP_ITERATIONS + ITERATIONS; i++) {
+            std::optional<Count> count = run(i);
+            if (!count) {
+                std::cerr << budget.scenario << ": failed\n";
+                return false;
+            }
+
+            total.allocations += count->allocations;
+            total.bytes += count->bytes;
+        }
+
+        const std::uint64_t allocations = total.allocations / ITERATIONS;
+        const std::uint64_t bytes = total.bytes / ITERATIONS;
+        const bool within_budget = allocations <= budget.allocations && bytes <= budget.bytes;
+
+        std::cout << budget.scenario << ": " << allocations << " allocations (budget "
+                  << budget.allocations << "), " << bytes << " bytes (budget " << budget.bytes
+                  << ") per event" << (within_budget ? "" : " - OVER BUDGET") << '\n';
+
+        return within_budget;
+    }
+
+    bool test()
+    {
+        Session session;
+
+        if (!session.start()) {
+            return false;
+        }
+
+        bool success = true;
+
+        success &= scenario_run(BUDGET_STRENGTH_CHANGE,
+                                [&](std::size_t i) { return session.strength_change(i); });
+
+        success &= scenario_run(BUDGET_CONNECT, [&](std::size_t i) { return session.connect(i); });
+
+        // Removes the services added by access-point-add, most recently added first.
+        success &= scenario_run(BUDGET_ACCESS_POINT_ADD,
+                                [&](std::size_t /*i*/) { return session.access_point_add(); });
+
+        success &= scenario_run(BUDGET_ACCESS_POINT_REMOVE,
+                                [&](std::size_t /*i*/) { return session.access_point_remove(); });
+
+        return success;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::setlocale(LC_ALL, "");
+
+    Glib::init();
+    Gio::init();
+
+    std::optional<Arguments> arguments = arguments_parse(argc, argv);
+    if (!arguments) {
+        return EXIT_FAILURE;
+    }
+
+    if (arguments->mock_connman) {
+        return mock_connman_run();
+    }
+
+    if (!AllocationCounter::available()) {
+        std::cout << "Counting allocations not supported on this platform, skipping\n";
+        return EXIT_SKIP;
+    }
+
+    // The daemon and the mock use the system bus, run them on the (private) session bus.
+    std::string bus_address = Glib::getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (bus_address.empty()) {
+        std::cerr << Glib::get_prgname() << ": DBUS_SESSION_BUS_ADDRESS not set, run in "
+                  << "dbus-run-session\n";
+        return EXIT_FAILURE;
+    }
+
+    Glib::setenv("DBUS_SYSTEM_BUS_ADDRESS", bus_address);
+
+    try {
+        if (!test()) {
+            return EXIT_FAILURE;
+        }
+    } catch (const Glib::Error &e) {
+        std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,723 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+// End-to-end benchmark of the daemon against MockConnMan. Run by "meson benchmark" in
+// dbus-run-session, see meson.build.
+//
+// The mock runs in this process so that the time a ConnMan property change is sent can be
+// compared to the time the resulting PropertiesChanged signal from the daemon is received. The
+// daemon is spawned, with the private session bus used as system bus. Measures:
+//
+// - Startup: Time from spawning the daemon until WiFiAccessPoints contains all services, for
+//   STARTUP_SERVICE_COUNTS services. Daemon RSS is read when populated, RSS per access point is
+//   the slope between the smallest and largest count.
+// - Latency: Time from a ConnMan Strength change of one service until PropertiesChanged for
+//   Strength of the corresponding access point, one change at a time.
+// - Throughput: Strength storms at increasing rates (see MockConnMan::strength_storm()). After
+//   each storm a service is added and the time until it shows up in WiFiAccessPoints is the time
+//   the daemon needs to drain its backlog. The highest rate with a drain time within
+//   DRAIN_LIMIT_MS is the sustained throughput.
+//
+// Results are written as JSON to stdout and, if given, to the file passed with --output.
+
+#include <giomm.h>
+#include <glib.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/dbus.h"
+#include "generated/dbus/connectivity_manager_proxy.h"
+#include "mock_connman/arguments.h"
+#include "mock_connman/connman_dbus.h"
+#include "mock_connman/mock_connman.h"
+
+namespace
+{
+    using ConnectivityManager::Common::DBus;
+    using ConnectivityManager::MockConnMan::ConnManDBus;
+    using ConnectivityManager::MockConnMan::MockConnMan;
+
+    using ManagerProxy = com::luxoft::ConnectivityManagerProxy;
+    using AccessPointProxy = com::luxoft::ConnectivityManager::WiFiAccessPointProxy;
+
+    constexpr char PROPERTIES_INTERFACE[] = "org.freedesktop.DBus.Properties";
+    constexpr char MANAGER_INTERFACE[] = "com.luxoft.ConnectivityManager";
+
+    constexpr std::uint64_t STARTUP_SERVICE_COUNTS[] = {10, 100, 1000};
+    constexpr unsigned int STARTUP_TIMEOUT_MS = 60 * 1000;
+    constexpr unsigned int SETTLE_TIME_MS = 500;
+
+    constexpr std::uint64_t LATENCY_SERVICE_COUNT = 100;
+    constexpr std::size_t LATENCY_SAMPLES = 500;
+    constexpr unsigned int LATENCY_TIMEOUT_MS = 5 * 1000;
+
+    constexpr std::uint64_t STORM_RATES_HZ[] = {250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+    constexpr std::uint64_t STORM_DURATION_MS = 2 * 1000;
+    constexpr unsigned int DRAIN_LIMIT_MS = 100;
+    constexpr unsigned int DRAIN_TIMEOUT_MS = 30 * 1000;
+
+    constexpr unsigned int NAME_TIMEOUT_MS = 5 * 1000;
+    constexpr unsigned int DAEMON_EXIT_TIMEOUT_MS = 5 * 1000;
+
+    struct Arguments
+    {
+        std::string daemon_path;
+        std::string output_path;
+    };
+
+    struct StartupResult
+    {
+        std::uint64_t services = 0;
+        double startup_ms = 0;
+        std::uint64_t rss_kib = 0;
+    };
+
+    struct LatencyResult
+    {
+        std::size_t samples = 0;
+        double p50_us = 0;
+        double p99_us = 0;
+        double max_us = 0;
+    };
+
+    struct StormResult
+    {
+        std::uint64_t rate_hz = 0;
+        double storm_ms = 0;
+        double drain_ms = 0;
+        bool sustained = false;
+    };
+
+    std::optional<Arguments> arguments_parse(int argc, char *argv[])
+    {
+        Arguments arguments;
+        Glib::OptionGroup main_group("daemon-benchmark", "Benchmark Options");
+        Glib::OptionContext context("DAEMON");
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_short_name('o');
+            entry.set_long_name("output");
+            entry.set_description("Also write JSON results to FILE");
+            entry.set_arg_description("FILE");
+            main_group.add_entry_filename(entry, arguments.output_path);
+        }
+
+        context.set_summary("Benchmarks the daemon executable DAEMON against a mock ConnMan on "
+                            "the session bus.");
+        context.set_main_group(main_group);
+
+        try {
+            context.parse(argc, argv);
+        } catch (const Glib::Error &error) {
+            std::cerr << Glib::get_prgname() << ": " << error.what() << '\n';
+            return {};
+        }
+
+        if (argc != 2) {
+            std::cerr << Glib::get_prgname() << ": expected path to daemon executable\n";
+            return {};
+        }
+
+        arguments.daemon_path = argv[1];
+
+        return arguments;
+    }
+
+    double us_to_ms(gint64 us)
+    {
+        return static_cast<double>(us) / 1000.0;
+    }
+
+    // Iterates the default main context until done() returns true or timeout_ms has passed.
+    bool run_until(const std::function<bool()> &done, unsigned int timeout_ms)
+    {
+        Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+        bool timed_out = false;
+
+        sigc::connection timeout = Glib::signal_timeout().connect(
+            [&timed_out] {
+                timed_out = true;
+                return false;
+            },
+            timeout_ms);
+
+        while (!done() && !timed_out) {
+            context->iteration(true);
+        }
+
+        timeout.disconnect();
+
+        return done();
+    }
+
+    void run_for(unsigned int time_ms)
+    {
+        run_until([] { return false; }, time_ms);
+    }
+
+    bool wait_for_name(const Glib::ustring &name)
+    {
+        bool appeared = false;
+
+        guint watch_id = Gio::DBus::watch_name(
+            Gio::DBus::BUS_TYPE_SYSTEM,
+            name,
+            [&appeared](const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                        const Glib::ustring & /*name*/,
+                        const Glib::ustring & /*name_owner*/) { appeared = true; });
+
+        bool result = run_until([&appeared] { return appeared; }, NAME_TIMEOUT_MS);
+
+        Gio::DBus::unwatch_name(watch_id);
+
+        return result;
+    }
+
+    // Value of property name in a PropertiesChanged signal, false if not changed.
+    Glib::VariantBase changed_property(const Glib::VariantContainerBase &parameters,
+                                       const Glib::ustring &name)
+    {
+        Glib::Variant<std::map<Glib::ustring, Glib::VariantBase>> changed;
+        parameters.get_child(changed, 1);
+
+        auto properties = changed.get();
+        auto i = properties.find(name);
+
+        return i != properties.cend() ? i->second : Glib::VariantBase();
+    }
+
+    double percentile(const std::vector<gint64> &sorted, double p)
+    {
+        auto index = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return static_cast<double>(sorted[index > 0 ? index - 1 : 0]);
+    }
+
+    // Daemon child process, stopped with SIGTERM when destroyed.
+    class DaemonProcess
+    {
+    public:
+        explicit DaemonProcess(const std::string &path)
+        {
+            Glib::spawn_async("",
+                              std::vector<std::string>{path},
+                              Glib::SPAWN_DO_NOT_REAP_CHILD | Glib::SPAWN_STDOUT_TO_DEV_NULL,
+                              {},
+                              &pid_);
+
+            child_watch_ = Glib::signal_child_watch().connect(
+                [this](Glib::Pid /*pid*/, int /*status*/) { exited_ = true; }, pid_);
+        }
+
+        ~DaemonProcess()
+        {
+            if (!exited_) {
+                kill(pid_, SIGTERM);
+
+                if (!run_until([this] { return exited_; }, DAEMON_EXIT_TIMEOUT_MS)) {
+                    g_warning("Daemon did not exit on SIGTERM, killing it");
+                    kill(pid_, SIGKILL);
+                    run_until([this] { return exited_; }, DAEMON_EXIT_TIMEOUT_MS);
+                }
+            }
+
+            child_watch_.disconnect();
+            Glib::spawn_close_pid(pid_);
+        }
+
+        DaemonProcess(const DaemonProcess &other) = delete;
+        DaemonProcess(DaemonProcess &&other) = delete;
+        DaemonProcess &operator=(const DaemonProcess &other) = delete;
+        DaemonProcess &operator=(DaemonProcess &&other) = delete;
+
+        bool exited() const
+        {
+            return exited_;
+        }
+
+        std::optional<std::uint64_t> rss_kib() const
+        {
+            std::ifstream status("/proc/" + std::to_string(pid_) + "/status");
+            std::string line;
+
+            while (std::getline(status, line)) {
+                std::istringstream stream(line);
+                std::string key;
+                std::uint64_t value = 0;
+
+                if (stream >> key >> value && key == "VmRSS:") {
+                    return value;
+                }
+            }
+
+            return {};
+        }
+
+    private:
+        Glib::Pid pid_ = 0;
+        bool exited_ = false;
+        sigc::connection child_watch_;
+    };
+
+    // Mock ConnMan with a number of services and the daemon running against it.
+    class Session
+    {
+    public:
+        Session(const Arguments &arguments, std::uint64_t services) :
+            services_(services),
+            mock_connman_(Glib::MainLoop::create(), mock_arguments(services)),
+            daemon_path_(arguments.daemon_path)
+        {
+        }
+
+        ~Session()
+        {
+            if (sentinel_subscription_id_ != 0) {
+                connection_->signal_unsubscribe(sentinel_subscription_id_);
+            }
+
+            if (manager_subscription_id_ != 0) {
+                connection_->signal_unsubscribe(manager_subscription_id_);
+            }
+
+            daemon_.reset();
+        }
+
+        Session(const Session &other) = delete;
+        Session(Session &&other) = delete;
+        Session &operator=(const Session &other) = delete;
+        Session &operator=(Session &&other) = delete;
+
+        std::optional<StartupResult> start()
+        {
+            mock_connman_.own_name();
+
+            if (!wait_for_name(ConnManDBus::SERVICE_NAME)) {
+                std::cerr << "Mock ConnMan did not appear on bus\n";
+                return {};
+            }
+
+            connection_ = Gio::DBus::Connection::get_sync(Gio::DBus::BUS_TYPE_SYSTEM);
+
+            manager_subscription_id_ = connection_->signal_subscribe(
+                sigc::mem_fun(*this, &Session::manager_properties_changed),
+                "",
+                PROPERTIES_INTERFACE,
+                "PropertiesChanged",
+                DBus::MANAGER_OBJECT_PATH);
+
+            gint64 start_us = g_get_monotonic_time();
+
+            daemon_.emplace(daemon_path_);
+
+            // WiFiAccessPoints may be populated before the manager object is registered, then
+            // there is no PropertiesChanged to wait for.
+            if (wait_for_name(DBus::MANAGER_SERVICE_NAME)) {
+                access_points_get();
+            }
+
+            run_until([this] { return access_points_ == services_ || daemon_->exited(); },
+                      STARTUP_TIMEOUT_MS);
+
+            if (access_points_ != services_) {
+                std::cerr << "Daemon did not populate WiFiAccessPoints with " << services_
+                          << " services\n";
+                return {};
+            }
+
+            StartupResult result;
+            result.services = services_;
+            result.startup_ms = us_to_ms(access_points_populated_us_ - start_us);
+
+            run_for(SETTLE_TIME_MS);
+
+            result.rss_kib = daemon_->rss_kib().value_or(0);
+
+            return result;
+        }
+
+        std::optional<LatencyResult> property_change_latency()
+        {
+            if (!sentinel_subscribe()) {
+                return {};
+            }
+
+            std::vector<gint64> latencies_us;
+
+            for (std::size_t i = 0; i <= LATENCY_SAMPLES; i++) {
+                std::uint8_t strength = i % 2 == 0 ? 20 : 80;
+                gint64 sent_us = g_get_monotonic_time();
+
+                mock_connman_.service_set_strength(SENTINEL_INDEX, strength);
+
+                if (!run_until([this, strength] { return sentinel_strength_ == strength; },
+                               LATENCY_TIMEOUT_MS)) {
+                    std::cerr << "No PropertiesChanged for Strength from daemon\n";
+                    return {};
+                }
+
+                // First change only makes sure current strength is known.
+                if (i > 0) {
+                    latencies_us.push_back(sentinel_changed_us_ - sent_us);
+                }
+            }
+
+            std::sort(latencies_us.begin(), latencies_us.end());
+
+            LatencyResult result;
+            result.samples = latencies_us.size();
+            result.p50_us = percentile(latencies_us, 0.50);
+            result.p99_us = percentile(latencies_us, 0.99);
+            result.max_us = static_cast<double>(latencies_us.back());
+
+            return result;
+        }
+
+        std::optional<StormResult> strength_storm(std::uint64_t rate_hz)
+        {
+            StormResult result;
+            result.rate_hz = rate_hz;
+
+            gint64 storm_start_us = g_get_monotonic_time();
+
+            mock_connman_.strength_storm(rate_hz, STORM_DURATION_MS);
+
+            run_until([this] { return !mock_connman_.strength_storm_running(); },
+                      STORM_DURATION_MS + DRAIN_TIMEOUT_MS);
+
+            gint64 storm_end_us = g_get_monotonic_time();
+
+            // Signals from the mock are handled in order by the daemon, so the added service
+            // shows up when all strength changes before it have been handled.
+            std::uint64_t expected = access_points_ + 1;
+            mock_connman_.services_add(1, "psk");
+
+            bool drained = run_until([this, expected] { return access_points_ == expected; },
+                                     DRAIN_TIMEOUT_MS);
+
+            gint64 drain_end_us = g_get_monotonic_time();
+
+            mock_connman_.services_remove(1);
+            run_until([this, expected] { return access_points_ == expected - 1; },
+                      DRAIN_TIMEOUT_MS);
+
+            if (!drained) {
+                std::cerr << "Daemon did not drain strength storm of " << rate_hz << " Hz\n";
+                return {};
+            }
+
+            result.storm_ms = us_to_ms(storm_end_us - storm_start_us);
+            result.drain_ms = us_to_ms(drain_end_us - storm_end_us);
+            result.sustained = result.drain_ms <= DRAIN_LIMIT_MS;
+
+            return result;
+        }
+
+    private:
+        static constexpr std::uint64_t SENTINEL_INDEX = 0;
+
+        static ConnectivityManager::MockConnMan::Arguments mock_arguments(std::uint64_t services)
+        {
+            ConnectivityManager::MockConnMan::Arguments arguments;
+            arguments.services = services;
+            return arguments;
+        }
+
+        void access_points_set(std::uint64_t count)
+        {
+            access_points_ = count;
+            access_points_populated_us_ = g_get_monotonic_time();
+        }
+
+        void access_points_get()
+        {
+            try {
+                Glib::VariantContainerBase reply = connection_->call_sync(
+                    DBus::MANAGER_OBJECT_PATH,
+                    PROPERTIES_INTERFACE,
+                    "Get",
+                    Glib::VariantContainerBase::create_tuple(
+                        {Glib::Variant<Glib::ustring>::create(MANAGER_INTERFACE),
+                         Glib::Variant<Glib::ustring>::create("WiFiAccessPoints")}),
+                    DBus::MANAGER_SERVICE_NAME);
+
+                Glib::Variant<Glib::VariantBase> value;
+                reply.get_child(value, 0);
+
+                // Signal may have been received while waiting for the reply.
+                if (access_points_ != services_) {
+                    access_points_set(
+                        Glib::VariantBase::cast_dynamic<Glib::VariantContainerBase>(value.get())
+                            .get_n_children());
+                }
+            } catch (const Glib::Error &e) {
+                std::cerr << "Failed to get WiFiAccessPoints: " << e.what() << '\n';
+            }
+        }
+
+        void manager_properties_changed(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                        const Glib::ustring & /*sender_name*/,
+                                        const Glib::ustring & /*object_path*/,
+                                        const Glib::ustring & /*interface_name*/,
+                                        const Glib::ustring & /*signal_name*/,
+                                        const Glib::VariantContainerBase &parameters)
+        {
+            Glib::VariantBase value = changed_property(parameters, "WiFiAccessPoints");
+            if (!value) {
+                return;
+            }
+
+            access_points_set(
+                Glib::VariantBase::cast_dynamic<Glib::VariantContainerBase>(value)
+                    .get_n_children());
+        }
+
+        // Subscribes to PropertiesChanged of the access point for the service at SENTINEL_INDEX.
+        bool sentinel_subscribe()
+        {
+            std::string ssid = "mock-" + std::to_string(SENTINEL_INDEX + 1);
+            Glib::ustring path;
+
+            try {
+                auto manager_proxy =
+                    ManagerProxy::createForBus_sync(Gio::DBus::BUS_TYPE_SYSTEM,
+                                                    Gio::DBus::PROXY_FLAGS_NONE,
+                                                    DBus::MANAGER_SERVICE_NAME,
+                                                    DBus::MANAGER_OBJECT_PATH);
+
+                for (const auto &object_path : manager_proxy->WiFiAccessPoints_get()) {
+                    auto proxy = AccessPointProxy::createForBus_sync(Gio::DBus::BUS_TYPE_SYSTEM,
+                                                                     Gio::DBus::PROXY_FLAGS_NONE,
+                                                                     DBus::MANAGER_SERVICE_NAME,
+                                                                     object_path);
+                    if (std::string(proxy->SSID_get()) == ssid) {
+                        path = object_path;
+                        break;
+                    }
+                }
+            } catch (const Glib::Error &e) {
+                std::cerr << "Failed to get access points: " << e.what() << '\n';
+                return false;
+            }
+
+            if (path.empty()) {
+                std::cerr << "No access point with SSID " << ssid << '\n';
+                return false;
+            }
+
+            sentinel_subscription_id_ = connection_->signal_subscribe(
+                sigc::mem_fun(*this, &Session::sentinel_properties_changed),
+                "",
+                PROPERTIES_INTERFACE,
+                "PropertiesChanged",
+                path);
+
+            return true;
+        }
+
+        void sentinel_properties_changed(
+            const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+            const Glib::ustring & /*sender_name*/,
+            const Glib::ustring & /*object_path*/,
+            const Glib::ustring & /*interface_name*/,
+            const Glib::ustring & /*signal_name*/,
+            const Glib::VariantContainerBase &parameters)
+        {
+            Glib::VariantBase value = changed_property(parameters, "Strength");
+            if (!value) {
+                return;
+            }
+
+            sentinel_strength_ =
+                Glib::VariantBase::cast_dynamic<Glib::Variant<guchar>>(value).get();
+            sentinel_changed_us_ = g_get_monotonic_time();
+        }
+
+        const std::uint64_t services_;
+        MockConnMan mock_connman_;
+        const std::string daemon_path_;
+        std::optional<DaemonProcess> daemon_;
+
+        Glib::RefPtr<Gio::DBus::Connection> connection_;
+        guint manager_subscription_id_ = 0;
+        guint sentinel_subscription_id_ = 0;
+
+        std::uint64_t access_points_ = 0;
+        gint64 access_points_populated_us_ = 0;
+
+        std::optional<std::uint8_t> sentinel_strength_;
+        gint64 sentinel_changed_us_ = 0;
+    };
+
+    std::string results_to_json(const std::vector<StartupResult> &startup,
+                                const LatencyResult &latency,
+                                const std::vector<StormResult> &storms)
+    {
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+
+        json << "{\n";
+        json << "  \"startup\": [\n";
+
+        for (std::size_t i = 0; i < startup.size(); i++) {
+            json << "    {\"services\": " << startup[i].services
+                 << ", \"startup_ms\": " << startup[i].startup_ms
+                 << ", \"rss_kib\": " << startup[i].rss_kib << '}'
+                 << (i + 1 < startup.size() ? ",\n" : "\n");
+        }
+
+        json << "  ],\n";
+
+        const StartupResult &smallest = startup.front();
+        const StartupResult &largest = startup.back();
+        double rss_per_access_point_bytes =
+            (static_cast<double>(largest.rss_kib) - static_cast<double>(smallest.rss_kib)) *
+            1024.0 / static_cast<double>(largest.services - smallest.services);
+
+        json << "  \"rss_per_access_point_bytes\": " << rss_per_access_point_bytes << ",\n";
+
+        json << "  \"property_change_latency_us\": {\"services\": " << LATENCY_SERVICE_COUNT
+             << ", \"samples\": " << latency.samples << ", \"p50\": " << latency.p50_us
+             << ", \"p99\": " << latency.p99_us << ", \"max\": " << latency.max_us << "},\n";
+
+        std::uint64_t max_sustained_rate_hz = 0;
+        for (const StormResult &storm : storms) {
+            if (storm.sustained) {
+                max_sustained_rate_hz = std::max(max_sustained_rate_hz, storm.rate_hz);
+            }
+        }
+
+        json << "  \"property_change_throughput\": {\n";
+        json << "    \"services\": " << LATENCY_SERVICE_COUNT << ",\n";
+        json << "    \"storm_duration_ms\": " << STORM_DURATION_MS << ",\n";
+        json << "    \"drain_limit_ms\": " << DRAIN_LIMIT_MS << ",\n";
+        json << "    \"max_sustained_rate_hz\": " << max_sustained_rate_hz << ",\n";
+        json << "    \"storms\": [\n";
+
+        for (std::size_t i = 0; i < storms.size(); i++) {
+            json << "      {\"rate_hz\": " << storms[i].rate_hz
+                 << ", \"storm_ms\": " << storms[i].storm_ms
+                 << ", \"drain_ms\": " << storms[i].drain_ms
+                 << ", \"sustained\": " << (storms[i].sustained ? "true" : "false") << '}'
+                 << (i + 1 < storms.size() ? ",\n" : "\n");
+        }
+
+        json << "    ]\n";
+        json << "  }\n";
+        json << "}\n";
+
+        return json.str();
+    }
+
+    bool benchmark(const Arguments &arguments)
+    {
+        std::vector<StartupResult> startup;
+        std::optional<LatencyResult> latency;
+        std::vector<StormResult> storms;
+
+        for (std::uint64_t services : STARTUP_SERVICE_COUNTS) {
+            Session session(arguments, services);
+
+            std::optional<StartupResult> result = session.start();
+            if (!result) {
+                return false;
+            }
+
+            startup.push_back(*result);
+
+            if (services != LATENCY_SERVICE_COUNT) {
+                continue;
+            }
+
+            latency = session.property_change_latency();
+            if (!latency) {
+                return false;
+            }
+
+            // Stop at first rate not sustained, higher rates only grow the backlog.
+            for (std::uint64_t rate_hz : STORM_RATES_HZ) {
+                std::optional<StormResult> storm = session.strength_storm(rate_hz);
+                if (!storm) {
+                    return false;
+                }
+
+                storms.push_back(*storm);
+
+                if (!storm->sustained) {
+                    break;
+                }
+            }
+        }
+
+        std::string json = results_to_json(startup, *latency, storms);
+
+        std::cout << json;
+
+        if (!arguments.output_path.empty()) {
+            try {
+                Glib::file_set_contents(arguments.output_path, json);
+            } catch (const Glib::FileError &e) {
+                std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::setlocale(LC_ALL, "");
+
+    Glib::init();
+    Gio::init();
+
+    std::optional<Arguments> arguments = arguments_parse(argc, argv);
+    if (!arguments) {
+        return EXIT_FAILURE;
+    }
+
+    // The daemon and the mock use the system bus, run them on the (private) session bus.
+    std::string bus_address = Glib::getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (bus_address.empty()) {
+        std::cerr << Glib::get_prgname() << ": DBUS_SESSION_BUS_ADDRESS not set, run in "
+                  << "dbus-run-session\n";
+        return EXIT_FAILURE;
+    }
+
+    Glib::setenv("DBUS_SYSTEM_BUS_ADDRESS", bus_address);
+
+    try {
+        if (!benchmark(*arguments)) {
+            return EXIT_FAILURE;
+        }
+    } catch (const Glib::Error &e) {
+        std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
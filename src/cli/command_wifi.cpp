@@ -11,8 +11,10 @@
 #include <glibmm.h>
 
 #include <iostream>
+#include <string>
 
 #include "cli/input_handler.h"
+#include "common/credentials.h"
 #include "common/dbus.h"
 
 // TODO: How to choose hidden AP for "connect"/"disconnect" from list shown by "status"?
@@ -34,7 +36,9 @@ namespace ConnectivityManager::Cli
             "  enable          Enable Wi-Fi\n"
             "  disable         Disable Wi-Fi\n"
             "  status          Show Wi-Fi status and access points\n"
+            "  scan            Scan for Wi-Fi access points\n"
             "  connect         Connect to Wi-Fi access point\n"
+            "  cancel-connect  Cancel connecting to Wi-Fi access point\n"
             "  disconnect      Disconnect from Wi-Fi access point\n"
             "  enable-hotspot  Enable Wi-Fi hotspot\n"
             "  disable-hotspot Disable Wi-Fi hotspot";
@@ -49,9 +53,15 @@ namespace ConnectivityManager::Cli
             if (str == "status") {
                 return Subcommand::STATUS;
             }
+            if (str == "scan") {
+                return Subcommand::SCAN;
+            }
             if (str == "connect") {
                 return Subcommand::CONNECT;
             }
+            if (str == "cancel-connect") {
+                return Subcommand::CANCEL_CONNECT;
+            }
             if (str == "disconnect") {
                 return Subcommand::DISCONNECT;
             }
@@ -87,24 +97,29 @@ namespace ConnectivityManager::Cli
 
         auto verify_arguments = [&]() {
             bool ssid_required = arguments_.subcommand == Subcommand::CONNECT ||
+                                 arguments_.subcommand == Subcommand::CANCEL_CONNECT ||
                                  arguments_.subcommand == Subcommand::DISCONNECT;
             bool ssid_accepted =
                 ssid_required || arguments_.subcommand == Subcommand::ENABLE_HOTSPOT;
-            bool passphrase_accepted = arguments_.subcommand == Subcommand::ENABLE_HOTSPOT;
+            bool passphrase_accepted = arguments_.subcommand == Subcommand::CONNECT ||
+                                       arguments_.subcommand == Subcommand::ENABLE_HOTSPOT;
 
             if (ssid_required && arguments_.ssid.empty()) {
-                output << Glib::get_prgname() << ": SSID required for connect and disconnect\n";
+                output << Glib::get_prgname()
+                       << ": SSID required for connect, cancel-connect and disconnect\n";
                 return false;
             }
 
             if (!ssid_accepted && !arguments_.ssid.empty()) {
                 output << Glib::get_prgname()
-                       << ": SSID only accepted for connect, disconnect and enable-hotspot\n";
+                       << ": SSID only accepted for connect, cancel-connect, disconnect and "
+                          "enable-hotspot\n";
                 return false;
             }
 
             if (!passphrase_accepted && !arguments_.passphrase.empty()) {
-                output << Glib::get_prgname() << ": Passphrase only valid for enable-hotspot\n";
+                output << Glib::get_prgname()
+                       << ": Passphrase only valid for connect and enable-hotspot\n";
                 return false;
             }
 
@@ -119,7 +134,7 @@ namespace ConnectivityManager::Cli
             Glib::OptionEntry entry;
             entry.set_short_name('s');
             entry.set_long_name("ssid");
-            entry.set_description("SSID for connect, disconnect or enable-hotspot");
+            entry.set_description("SSID for connect, cancel-connect, disconnect or enable-hotspot");
             main_group.add_entry(entry, arguments_.ssid);
         }
 
@@ -127,7 +142,8 @@ namespace ConnectivityManager::Cli
             Glib::OptionEntry entry;
             entry.set_short_name('p');
             entry.set_long_name("passphrase");
-            entry.set_description("Hotspot passphrase for enable-hotspot");
+            entry.set_description("Passphrase for connect (no prompt, SSID may be hidden) or "
+                                  "enable-hotspot");
             main_group.add_entry(entry, arguments_.passphrase);
         }
 
@@ -166,9 +182,15 @@ namespace ConnectivityManager::Cli
         case Subcommand::STATUS:
             return status();
 
+        case Subcommand::SCAN:
+            return scan();
+
         case Subcommand::CONNECT:
             return connect();
 
+        case Subcommand::CANCEL_CONNECT:
+            return cancel_connect();
+
         case Subcommand::DISCONNECT:
             return disconnect();
 
@@ -246,8 +268,26 @@ namespace ConnectivityManager::Cli
         return true;
     }
 
+    bool CommandWiFi::scan() const
+    {
+        constexpr int SCAN_TIMEOUT_MS = 60 * 1000;
+
+        try {
+            manager_proxy()->Scan_sync({}, SCAN_TIMEOUT_MS);
+        } catch (const Glib::Error &e) {
+            std::cout << "Failed to scan for Wi-Fi access points: " << e.what() << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
     bool CommandWiFi::connect() const
     {
+        if (!arguments_.passphrase.empty()) {
+            return connect_with_credentials();
+        }
+
         auto ap_proxy = access_point_proxy_with_ssid(arguments_.ssid);
         if (!ap_proxy) {
             std::cout << "No access point with name " << arguments_.ssid << '\n';
@@ -285,6 +325,57 @@ namespace ConnectivityManager::Cli
         return result;
     }
 
+    bool CommandWiFi::connect_with_credentials() const
+    {
+        using Credentials = Common::Credentials;
+
+        Credentials credentials;
+        Glib::DBusObjectPathString object("/");
+
+        // Access point not in list, try as a hidden network.
+        if (auto ap_proxy = access_point_proxy_with_ssid(arguments_.ssid); ap_proxy) {
+            object = Glib::DBusObjectPathString(ap_proxy->dbusProxy()->get_object_path());
+        } else {
+            credentials.ssid = arguments_.ssid.raw();
+        }
+
+        credentials.password = Credentials::Password{Credentials::Password::Type::WPA_PSK,
+                                                     arguments_.passphrase};
+
+        constexpr int CONNECT_TIMEOUT_MS = 5 * 60 * 1000;
+
+        try {
+            manager_proxy()->ConnectWithCredentials_sync(
+                object, Credentials::to_dbus_value(credentials), {}, CONNECT_TIMEOUT_MS);
+        } catch (const Glib::Error &e) {
+            std::cout << "Failed to connect to " << arguments_.ssid << ": " << e.what() << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CommandWiFi::cancel_connect() const
+    {
+        auto ap_proxy = access_point_proxy_with_ssid(arguments_.ssid);
+        if (!ap_proxy) {
+            std::cout << "No access point with name " << arguments_.ssid << '\n';
+            return false;
+        }
+
+        Glib::ustring ap_object_path = ap_proxy->dbusProxy()->get_object_path();
+
+        try {
+            manager_proxy()->CancelConnect_sync(Glib::DBusObjectPathString(ap_object_path));
+        } catch (const Glib::Error &e) {
+            std::cout << "Failed to cancel connect to " << arguments_.ssid << ": " << e.what()
+                      << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
     bool CommandWiFi::disconnect() const
     {
         auto ap_proxy = access_point_proxy_with_ssid(arguments_.ssid);
@@ -307,16 +398,17 @@ namespace ConnectivityManager::Cli
 
     bool CommandWiFi::enable_hotspot() const
     {
-        try {
-            if (!arguments_.ssid.empty()) {
-                manager_proxy()->WiFiHotspotSSID_set_sync(arguments_.ssid);
-            }
+        constexpr int CONFIGURE_TIMEOUT_MS = 90 * 1000;
 
-            if (!arguments_.passphrase.empty()) {
-                manager_proxy()->WiFiHotspotPassphrase_set_sync(arguments_.passphrase);
-            }
-
-            manager_proxy()->WiFiHotspotEnabled_set_sync(true);
+        try {
+            std::string ssid = arguments_.ssid.empty() ? manager_proxy()->WiFiHotspotSSID_get() :
+                                                         arguments_.ssid.raw();
+            Glib::ustring passphrase = arguments_.passphrase.empty() ?
+                                           manager_proxy()->WiFiHotspotPassphrase_get() :
+                                           arguments_.passphrase;
+
+            manager_proxy()->ConfigureHotspot_sync(
+                ssid, passphrase, true, {}, CONFIGURE_TIMEOUT_MS);
         } catch (const Glib::Error &e) {
             std::cout << "Failed to enable Wi-Fi hotspot: " << e.what() << '\n';
             return false;
@@ -37,7 +37,9 @@ namespace ConnectivityManager::Cli
             ENABLE,
             DISABLE,
             STATUS,
+            SCAN,
             CONNECT,
+            CANCEL_CONNECT,
             DISCONNECT,
             ENABLE_HOTSPOT,
             DISABLE_HOTSPOT
@@ -48,7 +50,10 @@ namespace ConnectivityManager::Cli
         bool enable() const;
         bool disable() const;
         bool status() const;
+        bool scan() const;
         bool connect() const;
+        bool connect_with_credentials() const;
+        bool cancel_connect() const;
         bool disconnect() const;
         bool enable_hotspot() const;
         bool disable_hotspot() const;
@@ -16,6 +16,7 @@ namespace ConnectivityManager::Common
     public:
         static constexpr char MANAGER_SERVICE_NAME[] = "com.luxoft.ConnectivityManager";
         static constexpr char MANAGER_OBJECT_PATH[] = "/com/luxoft/ConnectivityManager";
+        static constexpr char METRICS_OBJECT_PATH[] = "/com/luxoft/ConnectivityManager/Metrics";
     };
 }
 
@@ -0,0 +1,123 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "connman_recorder/capture_recorder.h"
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::ConnManRecorder
+{
+    namespace
+    {
+        using ConnManDBus = MockConnMan::ConnManDBus;
+    }
+
+    CaptureRecorder::CaptureRecorder(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                                     Capture::Writer &writer) :
+        main_loop_(main_loop),
+        writer_(writer)
+    {
+    }
+
+    CaptureRecorder::~CaptureRecorder()
+    {
+        if (watch_id_ != 0) {
+            Gio::DBus::unwatch_name(watch_id_);
+        }
+
+        if (subscription_id_ != 0) {
+            connection_->signal_unsubscribe(subscription_id_);
+        }
+    }
+
+    void CaptureRecorder::start()
+    {
+        connection_ = Gio::DBus::Connection::get_sync(Gio::DBus::BUS_TYPE_SYSTEM);
+        start_us_ = g_get_monotonic_time();
+
+        // Subscribe before watching so that no signals are missed between the state and signals.
+        subscription_id_ = connection_->signal_subscribe(
+            sigc::mem_fun(*this, &CaptureRecorder::signal_received), ConnManDBus::SERVICE_NAME);
+
+        watch_id_ = Gio::DBus::watch_name(connection_,
+                                          ConnManDBus::SERVICE_NAME,
+                                          sigc::mem_fun(*this, &CaptureRecorder::name_appeared),
+                                          sigc::mem_fun(*this, &CaptureRecorder::name_vanished));
+    }
+
+    void CaptureRecorder::name_appeared(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                        const Glib::ustring &name,
+                                        const Glib::ustring &name_owner)
+    {
+        g_info("%s appeared on the bus (%s), recording", name.c_str(), name_owner.c_str());
+
+        state_get("GetTechnologies");
+        state_get("GetServices");
+    }
+
+    void CaptureRecorder::name_vanished(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                        const Glib::ustring &name)
+    {
+        g_info("%s not on the bus, waiting for it to appear", name.c_str());
+    }
+
+    void CaptureRecorder::signal_received(
+        const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+        const Glib::ustring & /*sender*/,
+        const Glib::ustring &path,
+        const Glib::ustring &interface,
+        const Glib::ustring &member,
+        const Glib::VariantContainerBase &body)
+    {
+        record(Capture::Record::Type::SIGNAL, path, interface, member, body);
+    }
+
+    void CaptureRecorder::state_get(const Glib::ustring &member)
+    {
+        connection_->call(
+            ConnManDBus::MANAGER_OBJECT_PATH,
+            ConnManDBus::MANAGER_INTERFACE,
+            member,
+            Glib::VariantContainerBase(),
+            [this, member](Glib::RefPtr<Gio::AsyncResult> &result) {
+                try {
+                    record(Capture::Record::Type::METHOD_REPLY,
+                           ConnManDBus::MANAGER_OBJECT_PATH,
+                           ConnManDBus::MANAGER_INTERFACE,
+                           member,
+                           connection_->call_finish(result));
+                } catch (const Glib::Error &e) {
+                    g_warning("Failed to call %s(): %s", member.c_str(), e.what().c_str());
+                }
+            },
+            ConnManDBus::SERVICE_NAME);
+    }
+
+    void CaptureRecorder::record(Capture::Record::Type type,
+                                 const Glib::ustring &path,
+                                 const Glib::ustring &interface,
+                                 const Glib::ustring &member,
+                                 const Glib::VariantContainerBase &body)
+    {
+        Capture::Record record;
+        record.time_us = static_cast<std::uint64_t>(g_get_monotonic_time() - start_us_);
+        record.type = type;
+        record.path = path;
+        record.interface = interface;
+        record.member = member;
+        record.body = body;
+
+        try {
+            writer_.write(record);
+            records_++;
+        } catch (const Glib::Error &e) {
+            g_warning("Failed to write capture: %s", e.what().c_str());
+            main_loop_->quit();
+        }
+    }
+}
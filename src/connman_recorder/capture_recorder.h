@@ -0,0 +1,83 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_CONNMAN_RECORDER_CAPTURE_RECORDER_H
+#define CONNECTIVITY_MANAGER_CONNMAN_RECORDER_CAPTURE_RECORDER_H
+
+#include <giomm.h>
+#include <glib.h>
+#include <glibmm.h>
+
+#include <cstdint>
+
+#include "mock_connman/capture.h"
+
+namespace ConnectivityManager::ConnManRecorder
+{
+    // Records ConnMan D-Bus traffic on the system bus to a capture, see MockConnMan::Capture.
+    //
+    // All signals from ConnMan are recorded. Each time ConnMan appears on the bus, the state is
+    // recorded by calling GetTechnologies() and GetServices() like the daemon does. Nothing is
+    // sent to ConnMan otherwise, so recording can run next to the daemon without affecting it.
+    //
+    // Quits the main loop if writing fails.
+    class CaptureRecorder
+    {
+    public:
+        using Capture = MockConnMan::Capture;
+
+        CaptureRecorder(const Glib::RefPtr<Glib::MainLoop> &main_loop, Capture::Writer &writer);
+        ~CaptureRecorder();
+
+        CaptureRecorder(const CaptureRecorder &other) = delete;
+        CaptureRecorder(CaptureRecorder &&other) = delete;
+        CaptureRecorder &operator=(const CaptureRecorder &other) = delete;
+        CaptureRecorder &operator=(CaptureRecorder &&other) = delete;
+
+        // Throws Glib::Error if not able to connect to the bus.
+        void start();
+
+        std::uint64_t records() const
+        {
+            return records_;
+        }
+
+    private:
+        void name_appeared(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                           const Glib::ustring &name,
+                           const Glib::ustring &name_owner);
+        void name_vanished(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                           const Glib::ustring &name);
+
+        void signal_received(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                             const Glib::ustring &sender,
+                             const Glib::ustring &path,
+                             const Glib::ustring &interface,
+                             const Glib::ustring &member,
+                             const Glib::VariantContainerBase &body);
+
+        void state_get(const Glib::ustring &member);
+
+        void record(Capture::Record::Type type,
+                    const Glib::ustring &path,
+                    const Glib::ustring &interface,
+                    const Glib::ustring &member,
+                    const Glib::VariantContainerBase &body);
+
+        Glib::RefPtr<Glib::MainLoop> main_loop_;
+        Capture::Writer &writer_;
+
+        gint64 start_us_ = 0;
+        Glib::RefPtr<Gio::DBus::Connection> connection_;
+        guint subscription_id_ = 0;
+        guint watch_id_ = 0;
+        std::uint64_t records_ = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_CONNMAN_RECORDER_CAPTURE_RECORDER_H
@@ -0,0 +1,106 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <giomm.h>
+#include <glib-unix.h>
+#include <glibmm.h>
+
+#include <clocale>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "connman_recorder/capture_recorder.h"
+#include "mock_connman/capture.h"
+
+namespace
+{
+    using Capture = ConnectivityManager::MockConnMan::Capture;
+    using CaptureRecorder = ConnectivityManager::ConnManRecorder::CaptureRecorder;
+
+    std::optional<std::string> output_path_parse(int argc, char *argv[])
+    {
+        Glib::OptionContext context("FILE");
+
+        context.set_summary("Records ConnMan D-Bus traffic to FILE until interrupted. The capture "
+                            "can be replayed with mock-connman --replay.");
+
+        try {
+            context.parse(argc, argv);
+        } catch (const Glib::Error &error) {
+            std::cerr << Glib::get_prgname() << ": " << error.what() << '\n';
+            return {};
+        }
+
+        if (argc != 2) {
+            std::cerr << Glib::get_prgname() << ": expected one output FILE\n";
+            return {};
+        }
+
+        return std::string(argv[1]);
+    }
+
+    gboolean sigint_and_sigterm_callback(void *main_loop)
+    {
+        static_cast<Glib::MainLoop *>(main_loop)->quit();
+        return G_SOURCE_CONTINUE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::setlocale(LC_ALL, "");
+
+    Glib::init();
+    Gio::init();
+
+    std::optional<std::string> path = output_path_parse(argc, argv);
+    if (!path) {
+        return EXIT_FAILURE;
+    }
+
+    Glib::RefPtr<Glib::MainLoop> main_loop = Glib::MainLoop::create();
+    std::optional<Capture::Writer> writer;
+    std::optional<CaptureRecorder> recorder;
+
+    try {
+        writer.emplace(*path);
+        recorder.emplace(main_loop, *writer);
+        recorder->start();
+    } catch (const Glib::Error &e) {
+        std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    guint sigint_source_id =
+        g_unix_signal_add(SIGINT, sigint_and_sigterm_callback, main_loop.get());
+    guint sigterm_source_id =
+        g_unix_signal_add(SIGTERM, sigint_and_sigterm_callback, main_loop.get());
+
+    main_loop->run();
+
+    g_source_remove(sigint_source_id);
+    g_source_remove(sigterm_source_id);
+
+    std::uint64_t records = recorder->records();
+    recorder.reset();
+
+    try {
+        writer->close();
+    } catch (const Glib::Error &e) {
+        std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << records << " records written to " << *path << '\n';
+
+    return EXIT_SUCCESS;
+}
@@ -17,6 +17,8 @@ namespace ConnectivityManager::Daemon
         Arguments arguments;
         Glib::OptionGroup main_group("main", "Main Options");
         Glib::OptionContext context;
+        Glib::ustring wifi_access_points_order_str;
+        int main_loop_stall_threshold_ms = static_cast<int>(arguments.main_loop_stall_threshold_ms);
 
         {
             Glib::OptionEntry entry;
@@ -25,6 +27,49 @@ namespace ConnectivityManager::Daemon
             main_group.add_entry(entry, arguments.print_version_and_exit);
         }
 
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("wifi-access-points-order");
+            entry.set_arg_description("id|backend");
+            entry.set_description("Order of Wi-Fi access points on D-Bus (default: id)");
+            main_group.add_entry(entry, wifi_access_points_order_str);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("cache-credentials");
+            entry.set_description("Cache accepted Wi-Fi passwords in locked memory to answer "
+                                  "repeated requests without asking user");
+            main_group.add_entry(entry, arguments.cache_credentials);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("wifi-roaming");
+            entry.set_description("Roam to stronger Wi-Fi access point in same network when signal "
+                                  "of connected access point is weak");
+            main_group.add_entry(entry, arguments.wifi_roaming);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("state-dump-path");
+            entry.set_arg_description("PATH");
+            entry.set_description(Glib::ustring("Where to write internal state dump on SIGUSR1 "
+                                                "(default: ") +
+                                  DEFAULT_STATE_DUMP_PATH + ")");
+            main_group.add_entry_filename(entry, arguments.state_dump_path);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("main-loop-stall-threshold-ms");
+            entry.set_arg_description("MS");
+            entry.set_description("Log main loop stalls longer than this, 0 to disable main loop "
+                                  "monitoring (default: 100)");
+            main_group.add_entry(entry, main_loop_stall_threshold_ms);
+        }
+
         context.set_main_group(main_group);
 
         try {
@@ -39,6 +84,29 @@ namespace ConnectivityManager::Daemon
             return {};
         }
 
+        if (arguments.state_dump_path.empty()) {
+            output << Glib::get_prgname() << ": state dump path can not be empty\n";
+            return {};
+        }
+
+        if (main_loop_stall_threshold_ms < 0) {
+            output << Glib::get_prgname() << ": main loop stall threshold can not be negative\n";
+            return {};
+        }
+
+        arguments.main_loop_stall_threshold_ms =
+            static_cast<std::uint32_t>(main_loop_stall_threshold_ms);
+
+        if (wifi_access_points_order_str.empty() || wifi_access_points_order_str == "id") {
+            arguments.wifi_access_points_order = WiFiAccessPointsOrder::ID;
+        } else if (wifi_access_points_order_str == "backend") {
+            arguments.wifi_access_points_order = WiFiAccessPointsOrder::BACKEND;
+        } else {
+            output << Glib::get_prgname() << ": invalid Wi-Fi access points order \""
+                   << wifi_access_points_order_str << "\"\n";
+            return {};
+        }
+
         return arguments;
     }
 }
@@ -9,16 +9,40 @@
 #ifndef CONNECTIVITY_MANAGER_DAEMON_ARGUMENTS_H
 #define CONNECTIVITY_MANAGER_DAEMON_ARGUMENTS_H
 
+#include <cstdint>
 #include <optional>
 #include <ostream>
+#include <string>
 
 namespace ConnectivityManager::Daemon
 {
     struct Arguments
     {
+        // Order of paths in the WiFiAccessPoints D-Bus property.
+        //
+        // ID: Sorted by access point id, i.e. in the order access points were first seen.
+        // BACKEND: Order preferred by backend (e.g. ConnMan's service order).
+        enum class WiFiAccessPointsOrder
+        {
+            ID,
+            BACKEND
+        };
+
+        // Directory is created by systemd (RuntimeDirectory=) and only accessible by the daemon.
+        static constexpr char DEFAULT_STATE_DUMP_PATH[] = "/run/connectivity-manager/state.json";
+
         static std::optional<Arguments> parse(int argc, char *argv[], std::ostream &output);
 
         bool print_version_and_exit = false;
+        WiFiAccessPointsOrder wifi_access_points_order = WiFiAccessPointsOrder::ID;
+        bool cache_credentials = false; // See CredentialCache.
+        bool wifi_roaming = false;      // See RoamingEngine.
+
+        // Internal state dump is written here on SIGUSR1, see Daemon.
+        std::string state_dump_path = DEFAULT_STATE_DUMP_PATH;
+
+        // Main loop dispatches longer than this are logged, 0 disables MainLoopMonitor.
+        std::uint32_t main_loop_stall_threshold_ms = 100;
     };
 }
 
@@ -15,25 +15,110 @@
 
 #include "config.h"
 #include "daemon/backends/connman_backend.h"
+#include "daemon/metrics_registry.h"
+#include "daemon/tracepoints.h"
 
 namespace ConnectivityManager::Daemon
 {
+    namespace
+    {
+        template <typename Signal, typename... Args>
+        void emit(Signal &signal, Args &&... args)
+        {
+            MetricsRegistry::instance().add(MetricsRegistry::Counter::BACKEND_EVENTS_EMITTED);
+            signal.emit(std::forward<Args>(args)...);
+        }
+
+        template <typename Signal>
+        void emit_access_points_changed(Signal &signal,
+                                        Backend::WiFiAccessPoint::Event event,
+                                        const Backend::WiFiAccessPoint *access_point)
+        {
+            // Args: event (Backend::WiFiAccessPoint::Event), access point id (0 if none).
+            CONNECTIVITY_MANAGER_TRACE(
+                backend_wifi_access_point_changed,
+                static_cast<int>(event),
+                access_point ? access_point->id : Backend::WiFiAccessPoint::ID_EMPTY);
+
+            emit(signal, event, access_point);
+        }
+
+        const char *wifi_status_to_string(Backend::WiFiStatus status)
+        {
+            switch (status) {
+            case Backend::WiFiStatus::UNAVAILABLE:
+                return "unavailable";
+            case Backend::WiFiStatus::DISABLED:
+                return "disabled";
+            case Backend::WiFiStatus::ENABLED:
+                return "enabled";
+            }
+            return "unknown";
+        }
+
+        const char *wifi_security_to_string(Backend::WiFiSecurity security)
+        {
+            switch (security) {
+            case Backend::WiFiSecurity::NONE:
+                return "none";
+            case Backend::WiFiSecurity::WEP:
+                return "wep";
+            case Backend::WiFiSecurity::WPA_PSK:
+                return "wpa-psk";
+            case Backend::WiFiSecurity::WPA_EAP:
+                return "wpa-eap";
+            }
+            return "unknown";
+        }
+    }
+
     Backend::Backend() = default;
 
     Backend::~Backend() = default;
 
-    std::unique_ptr<Backend> Backend::create_default()
+    std::unique_ptr<Backend> Backend::create_default(const Arguments &arguments)
     {
 #if CONNECTIVITY_MANAGER_BACKEND == CONNECTIVITY_MANAGER_BACKEND_CONNMAN
-        return std::make_unique<ConnManBackend>();
+        return std::make_unique<ConnManBackend>(arguments.cache_credentials);
 #else
 #    error "Mising backend in create_backend()."
 #endif
     }
 
+    void Backend::state_dump(StateDump &dump) const
+    {
+        const auto &wifi = state_.wifi;
+
+        dump.object_begin("wifi");
+        dump.value("status", wifi_status_to_string(wifi.status));
+        dump.value("hotspot_enabled", wifi.hotspot_status == WiFiHotspotStatus::ENABLED);
+        dump.value("hotspot_ssid", wifi.hotspot_ssid);
+
+        dump.container("access_points_container",
+                       wifi.access_points.size(),
+                       wifi.access_points.bucket_count());
+        dump.container("access_points_order_container",
+                       wifi.access_points_order.size(),
+                       wifi.access_points_order.capacity());
+
+        dump.array_begin("access_points");
+        for (const auto &[id, access_point] : wifi.access_points) {
+            dump.object_begin();
+            dump.value("id", id);
+            dump.value("ssid", access_point.ssid);
+            dump.value("strength", access_point.strength);
+            dump.value("connected", access_point.connected);
+            dump.value("security", wifi_security_to_string(access_point.security));
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.object_end();
+    }
+
     void Backend::critical_error()
     {
-        signals_.critical_error.emit();
+        emit(signals_.critical_error);
     }
 
     void Backend::wifi_status_set(WiFiStatus status)
@@ -43,7 +128,7 @@ namespace ConnectivityManager::Daemon
         }
 
         state_.wifi.status = status;
-        signals_.wifi.status_changed.emit(status);
+        emit(signals_.wifi.status_changed, status);
     }
 
     Backend::WiFiAccessPoint::Id Backend::wifi_access_point_next_id()
@@ -81,7 +166,9 @@ namespace ConnectivityManager::Daemon
             state_.wifi.access_points.emplace(id, std::move(access_point));
         }
 
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::ADDED_ALL, nullptr);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::ADDED_ALL,
+                                   nullptr);
     }
 
     void Backend::wifi_access_points_remove_all()
@@ -91,8 +178,11 @@ namespace ConnectivityManager::Daemon
         }
 
         state_.wifi.access_points.clear();
+        state_.wifi.access_points_order.clear();
 
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::REMOVED_ALL, nullptr);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::REMOVED_ALL,
+                                   nullptr);
     }
 
     void Backend::wifi_access_point_add(WiFiAccessPoint &&access_point)
@@ -102,8 +192,9 @@ namespace ConnectivityManager::Daemon
 
         auto result = state_.wifi.access_points.emplace(id, std::move(access_point));
 
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::ADDED_ONE,
-                                                 &result.first->second);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::ADDED_ONE,
+                                   &result.first->second);
     }
 
     void Backend::wifi_access_point_remove(const WiFiAccessPoint &access_point)
@@ -116,7 +207,29 @@ namespace ConnectivityManager::Daemon
         const WiFiAccessPoint copy = std::move(i->second);
         state_.wifi.access_points.erase(i);
 
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::REMOVED_ONE, &copy);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::REMOVED_ONE,
+                                   &copy);
+    }
+
+    void Backend::wifi_access_points_order_set(std::vector<WiFiAccessPoint::Id> &&order)
+    {
+        if (state_.wifi.access_points_order == order) {
+            return;
+        }
+
+        state_.wifi.access_points_order = std::move(order);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::ORDER_CHANGED,
+                                   nullptr);
+    }
+
+    void Backend::wifi_scan_finished(bool success, std::uint32_t duration_ms)
+    {
+        MetricsRegistry::instance().add(MetricsRegistry::Latency::SCAN,
+                                        std::uint64_t{duration_ms} * 1000);
+
+        emit(signals_.wifi.scan_finished, success, duration_ms);
     }
 
     void Backend::wifi_access_point_ssid_set(WiFiAccessPoint &access_point, const std::string &ssid)
@@ -126,8 +239,9 @@ namespace ConnectivityManager::Daemon
         }
 
         access_point.ssid = ssid;
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::SSID_CHANGED,
-                                                 &access_point);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::SSID_CHANGED,
+                                   &access_point);
     }
 
     void Backend::wifi_access_point_strength_set(WiFiAccessPoint &access_point,
@@ -138,8 +252,9 @@ namespace ConnectivityManager::Daemon
         }
 
         access_point.strength = strength;
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::STRENGTH_CHANGED,
-                                                 &access_point);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::STRENGTH_CHANGED,
+                                   &access_point);
     }
 
     void Backend::wifi_access_point_connected_set(WiFiAccessPoint &access_point, bool connected)
@@ -149,8 +264,9 @@ namespace ConnectivityManager::Daemon
         }
 
         access_point.connected = connected;
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::CONNECTED_CHANGED,
-                                                 &access_point);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::CONNECTED_CHANGED,
+                                   &access_point);
     }
 
     void Backend::wifi_access_point_security_set(WiFiAccessPoint &access_point,
@@ -161,8 +277,9 @@ namespace ConnectivityManager::Daemon
         }
 
         access_point.security = security;
-        signals_.wifi.access_points_changed.emit(WiFiAccessPoint::Event::SECURITY_CHANGED,
-                                                 &access_point);
+        emit_access_points_changed(signals_.wifi.access_points_changed,
+                                   WiFiAccessPoint::Event::SECURITY_CHANGED,
+                                   &access_point);
     }
 
     void Backend::wifi_hotspot_status_set(WiFiHotspotStatus status)
@@ -172,7 +289,7 @@ namespace ConnectivityManager::Daemon
         }
 
         state_.wifi.hotspot_status = status;
-        signals_.wifi.hotspot_status_changed.emit(status);
+        emit(signals_.wifi.hotspot_status_changed, status);
     }
 
     void Backend::wifi_hotspot_ssid_set(const std::string &ssid)
@@ -182,7 +299,7 @@ namespace ConnectivityManager::Daemon
         }
 
         state_.wifi.hotspot_ssid = ssid;
-        signals_.wifi.hotspot_ssid_changed.emit(ssid);
+        emit(signals_.wifi.hotspot_ssid_changed, ssid);
     }
 
     void Backend::wifi_hotspot_passphrase_set(const Glib::ustring &passphrase)
@@ -192,6 +309,6 @@ namespace ConnectivityManager::Daemon
         }
 
         state_.wifi.hotspot_passphrase = passphrase;
-        signals_.wifi.hotspot_passphrase_changed.emit(passphrase);
+        emit(signals_.wifi.hotspot_passphrase_changed, passphrase);
     }
 }
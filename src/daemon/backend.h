@@ -19,8 +19,12 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "common/credentials.h"
+#include "daemon/arguments.h"
+#include "daemon/connect_trace.h"
+#include "daemon/state_dump.h"
 
 namespace ConnectivityManager::Daemon
 {
@@ -44,8 +48,15 @@ namespace ConnectivityManager::Daemon
     //   when user has replied. If something fails this callback must be called with
     //   Common::Credentials::NONE to notify the backend about the failure.
     //
+    // *_connect() also takes an optional ConnectTrace (may be nullptr) that the backend marks as
+    // the connect request passes through its stages.
+    //
     // = WiFi
     //
+    // wifi_scan() requests a scan for access points. ScanFinished is called when the scan has
+    // finished. A backend may scan on its own as well (e.g. periodically) and may coalesce requests
+    // with scans already in progress. Signals::wifi::scan_finished is emitted for all scans.
+    //
     // WiFiStatus must be set to something other than UNAVAILABLE before calling any of the public
     // virtual wifi_* methods. A backend implementation should not do anything if this rule is not
     // followed and call site should be fixed.
@@ -56,13 +67,20 @@ namespace ConnectivityManager::Daemon
     //
     // Access points are stored in an unordered map (State::wifi::access_points) and are guaranteed
     // to have a unique id that can be used to identify them when e.g. mapping to D-Bus objects.
+    //
+    // If the backend has a notion of preferred order of access points (e.g. ConnMan sorts its
+    // services), State::wifi::access_points_order contains the ids in that order and
+    // WiFiAccessPoint::Event::ORDER_CHANGED is emitted when it changes. The order is set as is by
+    // the concrete backend, no sorting is done in Backend. It may temporarily refer to ids that do
+    // not exist in State::wifi::access_points or lack ids that do, users must handle this.
     class Backend
     {
     public:
         enum class ConnectResult
         {
             SUCCESS,
-            FAILED
+            FAILED,
+            CANCELED
         };
 
         enum class WiFiStatus
@@ -95,6 +113,8 @@ namespace ConnectivityManager::Daemon
                 ADDED_ONE,
                 REMOVED_ONE,
 
+                ORDER_CHANGED,
+
                 SSID_CHANGED,
                 STRENGTH_CHANGED,
                 CONNECTED_CHANGED,
@@ -120,6 +140,7 @@ namespace ConnectivityManager::Daemon
                 WiFiStatus status = WiFiStatus::UNAVAILABLE;
 
                 std::unordered_map<WiFiAccessPoint::Id, WiFiAccessPoint> access_points;
+                std::vector<WiFiAccessPoint::Id> access_points_order;
 
                 WiFiHotspotStatus hotspot_status = WiFiHotspotStatus::DISABLED;
                 std::string hotspot_ssid;
@@ -138,6 +159,8 @@ namespace ConnectivityManager::Daemon
                 sigc::signal<void, WiFiAccessPoint::Event, const WiFiAccessPoint *>
                     access_points_changed;
 
+                sigc::signal<void, bool, std::uint32_t> scan_finished;
+
                 sigc::signal<void, WiFiHotspotStatus> hotspot_status_changed;
                 sigc::signal<void, const std::string &> hotspot_ssid_changed;
                 sigc::signal<void, const Glib::ustring &> hotspot_passphrase_changed;
@@ -146,6 +169,10 @@ namespace ConnectivityManager::Daemon
 
         using ConnectFinished = std::function<void(ConnectResult result)>;
 
+        using ScanFinished = std::function<void(bool success, std::uint32_t duration_ms)>;
+
+        using WiFiHotspotConfigureFinished = std::function<void(bool success)>;
+
         using RequestCredentialsFromUserReply =
             std::function<void(const std::optional<Common::Credentials> &result)>;
 
@@ -161,21 +188,47 @@ namespace ConnectivityManager::Daemon
         Backend &operator=(const Backend &other) = delete;
         Backend &operator=(Backend &&other) = delete;
 
-        static std::unique_ptr<Backend> create_default();
+        static std::unique_ptr<Backend> create_default(const Arguments &arguments);
 
         virtual void wifi_enable() = 0;
         virtual void wifi_disable() = 0;
 
         virtual void wifi_connect(const WiFiAccessPoint &access_point,
                                   ConnectFinished &&finished,
-                                  RequestCredentialsFromUser &&request_credentials) = 0;
+                                  RequestCredentialsFromUser &&request_credentials,
+                                  const std::shared_ptr<ConnectTrace> &trace) = 0;
+        virtual void wifi_connect_hidden(const std::string &ssid,
+                                         WiFiSecurity security,
+                                         ConnectFinished &&finished,
+                                         RequestCredentialsFromUser &&request_credentials,
+                                         const std::shared_ptr<ConnectTrace> &trace) = 0;
+        virtual void wifi_connect_cancel(const WiFiAccessPoint &access_point) = 0;
+
+        // Only one connect to a hidden network per security can be in progress, see
+        // wifi_connect_hidden(), so it is identified by security.
+        virtual void wifi_connect_hidden_cancel(WiFiSecurity security) = 0;
+
         virtual void wifi_disconnect(const WiFiAccessPoint &access_point) = 0;
 
+        virtual void wifi_scan(ScanFinished &&finished) = 0;
+
         virtual void wifi_hotspot_enable() = 0;
         virtual void wifi_hotspot_disable() = 0;
         virtual void wifi_hotspot_change_ssid(const std::string &ssid) = 0;
         virtual void wifi_hotspot_change_passphrase(const Glib::ustring &passphrase) = 0;
 
+        // Sets SSID and passphrase and then enables or disables the hotspot. finished is called
+        // when the hotspot is actually up (or down). If anything fails, previous SSID and
+        // passphrase are restored before finished is called with false.
+        virtual void wifi_hotspot_configure(const std::string &ssid,
+                                            const Glib::ustring &passphrase,
+                                            bool enabled,
+                                            WiFiHotspotConfigureFinished &&finished) = 0;
+
+        // Writes State for the SIGUSR1 state dump. Implementations override this to add their own
+        // internals and call it first.
+        virtual void state_dump(StateDump &dump) const;
+
         const State &state() const
         {
             return state_;
@@ -215,6 +268,10 @@ namespace ConnectivityManager::Daemon
         void wifi_access_point_add(WiFiAccessPoint &&access_point);
         void wifi_access_point_remove(const WiFiAccessPoint &access_point);
 
+        void wifi_access_points_order_set(std::vector<WiFiAccessPoint::Id> &&order);
+
+        void wifi_scan_finished(bool success, std::uint32_t duration_ms);
+
         void wifi_access_point_ssid_set(WiFiAccessPoint &access_point, const std::string &ssid);
         void wifi_access_point_strength_set(WiFiAccessPoint &access_point,
                                             WiFiAccessPoint::Strength strength);
@@ -12,11 +12,13 @@
 #include <giomm.h>
 #include <glibmm.h>
 
+#include <cstdint>
 #include <map>
 #include <optional>
 
 #include "common/credentials.h"
 #include "daemon/backend.h"
+#include "daemon/state_dump.h"
 #include "generated/dbus/connman_stub.h"
 
 namespace ConnectivityManager::Daemon
@@ -27,6 +29,12 @@ namespace ConnectivityManager::Daemon
     // org.freedesktop.DBus.Error.UnknownMethod will be returned for methods that are left out.
     //
     // Exposed on D-Bus under /com/luxoft/ConnectivityManager/ConnManAgent.
+    //
+    // State of registration with ConnMan's manager is set by ConnManBackend with set_state() and
+    // set_registration_failed() except when ConnMan calls Release(). State changes are logged and
+    // counted in Health, the MetricsRegistry AGENT_* counters and gauge and the state dump
+    // to make it possible to tell if the agent is working as expected. Failing to register the
+    // object on the bus counts as a failed registration attempt as well.
     class ConnManAgent : private net::connman::AgentStub
     {
     public:
@@ -39,8 +47,19 @@ namespace ConnectivityManager::Daemon
             REGISTERED_WITH_MANAGER
         };
 
+        struct Health
+        {
+            std::uint64_t registration_attempts = 0;
+            std::uint64_t registration_failures = 0;
+            std::uint64_t consecutive_registration_failures = 0;
+            std::uint64_t releases = 0;
+            Glib::ustring last_error;
+        };
+
         explicit ConnManAgent(Listener &listener);
 
+        static const char *state_to_string(State state);
+
         Glib::ustring object_path() const;
 
         bool register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection);
@@ -54,11 +73,16 @@ namespace ConnectivityManager::Daemon
             return state_;
         }
 
-        void set_state(State state)
+        void set_state(State state);
+        void set_registration_failed(const Glib::ustring &error);
+
+        const Health &health() const
         {
-            state_ = state;
+            return health_;
         }
 
+        void state_dump(StateDump &dump) const;
+
     private:
         using Fields = std::map<Glib::ustring, Glib::VariantBase>;
 
@@ -80,6 +104,7 @@ namespace ConnectivityManager::Daemon
 
         Listener &listener_;
         State state_ = State::NOT_REGISTERED_WITH_MANAGER;
+        Health health_;
     };
 
     // Listener for agent events.
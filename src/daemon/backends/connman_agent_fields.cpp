@@ -0,0 +1,266 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/backends/connman_agent_fields.h"
+
+#include <glibmm.h>
+
+#include <cstdint>
+#include <optional>
+#include <typeinfo>
+#include <vector>
+
+#include "common/string_to_valid_utf8.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        constexpr char FIELD_NAME_HIDDEN_SSID_UTF8[] = "Name";
+        constexpr char FIELD_NAME_HIDDEN_SSID[] = "SSID";
+        constexpr char FIELD_NAME_EAP_USERNAME[] = "Identity";
+        constexpr char FIELD_NAME_PASSPHRASE[] = "Passphrase";
+        constexpr char FIELD_NAME_PREVIOUS_PASSPHRASE[] = "PreviousPassphrase";
+        constexpr char FIELD_NAME_WPS[] = "WPS";
+        constexpr char FIELD_NAME_WISPR_USERNAME[] = "Username";
+        constexpr char FIELD_NAME_WISPR_PASSWORD[] = "Password";
+
+        constexpr char FIELD_ARGUMENT_TYPE[] = "Type";
+        constexpr char FIELD_ARGUMENT_VALUE[] = "Value";
+        // constexpr char FIELD_ARGUMENT_REQUIREMENT[] = "Requirement"; Not checked at the moment.
+        // constexpr char FIELD_ARGUMENT_ALTERNATES[] = "Alternates"; Not checked at the moment.
+
+        constexpr char FIELD_ARGUMENT_TYPE_PSK[] = "psk";
+        constexpr char FIELD_ARGUMENT_TYPE_WEP[] = "wep";
+        constexpr char FIELD_ARGUMENT_TYPE_PASSPHRASE[] = "passphrase";
+        constexpr char FIELD_ARGUMENT_TYPE_RESPONSE[] = "response";
+        constexpr char FIELD_ARGUMENT_TYPE_WPS_PIN[] = "wpspin";
+        constexpr char FIELD_ARGUMENT_TYPE_STRING[] = "string";
+        // constexpr char FIELD_ARGUMENT_TYPE_SSID[] = "ssid"; Not checked at the moment.
+
+        using Arguments = std::map<Glib::ustring, Glib::VariantBase>;
+        using Password = Common::Credentials::Password;
+
+        std::optional<Arguments> arguments_from_variant(const Glib::ustring &field_name,
+                                                        const Glib::VariantBase &variant)
+        {
+            try {
+                return Glib::VariantBase::cast_dynamic<Glib::Variant<Arguments>>(variant).get();
+            } catch (const std::bad_cast &) {
+                g_warning("Received ConnMan agent field %s with arguments of wrong type %s",
+                          field_name.c_str(),
+                          variant.get_type_string().c_str());
+            }
+            return {};
+        }
+
+        Glib::ustring argument_lookup(const Arguments &arguments,
+                                      const Glib::ustring &name,
+                                      const Glib::ustring &default_value)
+        {
+            auto i = arguments.find(name);
+            if (i == arguments.cend()) {
+                return default_value;
+            }
+
+            const Glib::VariantBase &variant = i->second;
+
+            try {
+                return Glib::VariantBase::cast_dynamic<Glib::Variant<Glib::ustring>>(variant).get();
+            } catch (const std::bad_cast &) {
+                g_warning("Received ConnMan agent field argument %s with wrong type %s",
+                          name.c_str(),
+                          variant.get_type_string().c_str());
+            }
+
+            return default_value;
+        }
+
+        std::optional<Password> arguments_to_password(const Glib::ustring &name,
+                                                      const Arguments &arguments)
+        {
+            Password password;
+
+            Glib::ustring type = argument_lookup(arguments, FIELD_ARGUMENT_TYPE, "");
+            if (type.empty()) {
+                g_warning("Received ConnMan agent password field %s without type", name.c_str());
+                return {};
+            }
+
+            if (type == FIELD_ARGUMENT_TYPE_PASSPHRASE || type == FIELD_ARGUMENT_TYPE_RESPONSE ||
+                type == FIELD_ARGUMENT_TYPE_STRING) {
+                password.type = Password::Type::PASSPHRASE;
+            } else if (type == FIELD_ARGUMENT_TYPE_PSK) {
+                password.type = Password::Type::WPA_PSK;
+            } else if (type == FIELD_ARGUMENT_TYPE_WEP) {
+                password.type = Password::Type::WEP_KEY;
+            } else if (type == FIELD_ARGUMENT_TYPE_WPS_PIN) {
+                password.type = Password::Type::WPS_PIN;
+            } else {
+                g_warning("Received ConnMan agent password field %s with unknown type %s",
+                          name.c_str(),
+                          type.c_str());
+                return {};
+            }
+
+            password.value = argument_lookup(arguments, FIELD_ARGUMENT_VALUE, "");
+
+            return password;
+        }
+    }
+
+    std::optional<Common::Credentials> ConnManAgentFields::received_fields_to_credentials(
+        const Fields &received_fields)
+    {
+        Credentials credentials;
+        std::optional<Password> previous_password;
+
+        for (const auto &[name, arguments_variant] : received_fields) {
+            std::optional<Arguments> arguments = arguments_from_variant(name, arguments_variant);
+            if (!arguments) {
+                return {};
+            }
+
+            if (name == FIELD_NAME_HIDDEN_SSID_UTF8 || name == FIELD_NAME_HIDDEN_SSID) {
+                credentials.ssid = argument_lookup(*arguments, FIELD_ARGUMENT_VALUE, "");
+
+            } else if (name == FIELD_NAME_EAP_USERNAME || name == FIELD_NAME_WISPR_USERNAME) {
+                if (credentials.username) {
+                    g_warning("Received ConnMan agent fields with both %s and %s",
+                              FIELD_NAME_EAP_USERNAME,
+                              FIELD_NAME_WISPR_USERNAME);
+                    return {};
+                }
+                credentials.username = argument_lookup(*arguments, FIELD_ARGUMENT_VALUE, "");
+
+            } else if (name == FIELD_NAME_PASSPHRASE || name == FIELD_NAME_WISPR_PASSWORD) {
+                if (credentials.password) {
+                    g_warning("Received ConnMan agent fields with both %s and %s",
+                              FIELD_NAME_PASSPHRASE,
+                              FIELD_NAME_WISPR_PASSWORD);
+                    return {};
+                }
+                credentials.password = arguments_to_password(name, *arguments);
+                if (!credentials.password) {
+                    return {};
+                }
+            } else if (name == FIELD_NAME_PREVIOUS_PASSPHRASE) {
+                previous_password = arguments_to_password(name, *arguments);
+                if (!previous_password) {
+                    return {};
+                }
+            } else if (name == FIELD_NAME_WPS) {
+                credentials.password_alternative = arguments_to_password(name, *arguments);
+
+                if (!credentials.password_alternative ||
+                    credentials.password_alternative->type != Password::Type::WPS_PIN) {
+                    g_warning("Received ConnMan agent WPS field with wrong type");
+                    return {};
+                }
+
+            } else {
+                g_warning("Received unknown ConnMan agent field \"%s\"", name.c_str());
+                return {};
+            }
+        }
+
+        if (credentials.password_alternative) {
+            if (!credentials.password) {
+                g_warning("Received ConnMan agent fields with password alternative field and "
+                          "no password field");
+                return {};
+            }
+
+            if (credentials.password->type == credentials.password_alternative->type) {
+                g_warning("Received ConnMan agent fields with password and password "
+                          "alternative of same type");
+                return {};
+            }
+        }
+
+        if (previous_password) {
+            if (!credentials.password) {
+                g_warning("Received ConnMan agent fields with previous password field and no "
+                          "password field");
+                return {};
+            }
+
+            if (credentials.password->type == previous_password->type) {
+                if (credentials.password->value.empty()) {
+                    credentials.password->value = previous_password->value;
+                }
+            } else if (credentials.password_alternative &&
+                       credentials.password_alternative->type == previous_password->type) {
+                if (credentials.password_alternative->value.empty()) {
+                    credentials.password_alternative->value = previous_password->value;
+                }
+            }
+        }
+
+        return credentials;
+    }
+
+    ConnManAgentFields::Fields ConnManAgentFields::credentials_to_reply_fields(
+        const Credentials &credentials,
+        const Fields &received_fields)
+    {
+        Fields fields;
+
+        auto add_string_reply = [&fields](const Glib::ustring &name, const Glib::ustring &value) {
+            fields.emplace(name, Glib::Variant<Glib::ustring>::create(value));
+        };
+
+        auto add_byte_array_reply = [&fields](const Glib::ustring &name,
+                                              const std::vector<std::uint8_t> &value) {
+            fields.emplace(name, Glib::Variant<std::vector<std::uint8_t>>::create(value));
+        };
+
+        auto was_requested = [&received_fields](const Glib::ustring &name) {
+            return received_fields.find(name) != received_fields.cend();
+        };
+
+        if (credentials.ssid) {
+            Glib::ustring ssid_utf8 = *credentials.ssid;
+            bool utf8_was_requested = was_requested(FIELD_NAME_HIDDEN_SSID_UTF8);
+            bool non_utf8_was_requested = was_requested(FIELD_NAME_HIDDEN_SSID);
+
+            if (ssid_utf8.validate() && utf8_was_requested) {
+                add_string_reply(FIELD_NAME_HIDDEN_SSID_UTF8, ssid_utf8);
+            } else if (non_utf8_was_requested) {
+                add_byte_array_reply(FIELD_NAME_HIDDEN_SSID,
+                                     std::vector<std::uint8_t>(credentials.ssid->begin(),
+                                                               credentials.ssid->end()));
+            } else if (utf8_was_requested) {
+                add_string_reply(FIELD_NAME_HIDDEN_SSID_UTF8,
+                                 Common::string_to_valid_utf8(*credentials.ssid));
+            }
+        }
+
+        if (credentials.username) {
+            if (was_requested(FIELD_NAME_EAP_USERNAME)) {
+                add_string_reply(FIELD_NAME_EAP_USERNAME, *credentials.username);
+            } else if (was_requested(FIELD_NAME_WISPR_USERNAME)) {
+                add_string_reply(FIELD_NAME_WISPR_USERNAME, *credentials.username);
+            }
+        }
+
+        if (credentials.password) {
+            bool wps_reply = credentials.password->type == Password::Type::WPS_PIN &&
+                             was_requested(FIELD_NAME_WPS);
+            if (wps_reply) {
+                add_string_reply(FIELD_NAME_WPS, credentials.password->value);
+            } else if (was_requested(FIELD_NAME_PASSPHRASE)) {
+                add_string_reply(FIELD_NAME_PASSPHRASE, credentials.password->value);
+            } else if (was_requested(FIELD_NAME_WISPR_PASSWORD)) {
+                add_string_reply(FIELD_NAME_WISPR_PASSWORD, credentials.password->value);
+            }
+        }
+
+        return fields;
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_AGENT_FIELDS_H
+#define CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_AGENT_FIELDS_H
+
+#include <glibmm.h>
+
+#include <map>
+#include <optional>
+
+#include "common/credentials.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Conversion between the fields argument of ConnMan's Agent.RequestInput() and
+    // Common::Credentials. Separate from ConnManAgent so it can be tested, benchmarked and fuzzed
+    // without D-Bus (see src/fuzzers/).
+    struct ConnManAgentFields
+    {
+        using Fields = std::map<Glib::ustring, Glib::VariantBase>;
+        using Credentials = Common::Credentials;
+
+        // Map fields received in RequestInput() to a Common::Credentials struct.
+        //
+        // See doc/agent-api.txt for some examples of contents of fields. "Value" argument of
+        // "Passphrase", "Password" and "WPS" is preferred over "PreviousPassphrase".
+        // "PreviousPassphrase" is used if "Value" is not set and the type matches.
+        //
+        // TODO: Maybe be a bit more strict and check "Requirement" and "Alternates" etc. and fail
+        //       if values are not correct. Or? *Sigh* The ConnMan D-Bus API for this is under
+        //       specified in doc/agent-api.txt (have to check code) and so... needlessly
+        //       complicated! *Sigh*
+        static std::optional<Credentials> received_fields_to_credentials(
+            const Fields &received_fields);
+
+        // Map credentials to the fields to reply to RequestInput() with. Only fields that were
+        // requested in received_fields are included.
+        //
+        // TODO: Perhaps SSID handling should be simplified to always send SSID as byte array. Do
+        //       not understand why ConnMan does not always take it as byte array. Do not think
+        //       D-Bus allows non valid UTF-8 strings to be sent over the bus (understandable), but
+        //       that coupled with ConnMan being able to request both UTF-8 and non UTF-8 makes
+        //       it... more complicated than it needs to be. *sigh*
+        static Fields credentials_to_reply_fields(const Credentials &credentials,
+                                                  const Fields &received_fields);
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_AGENT_FIELDS_H
@@ -11,16 +11,38 @@
 #include <giomm.h>
 #include <glibmm.h>
 
+#include <algorithm>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include "common/string_to_valid_utf8.h"
+#include "daemon/main_loop_monitor.h"
 
 namespace ConnectivityManager::Daemon
 {
-    ConnManBackend::ConnManBackend() = default;
+    namespace
+    {
+        constexpr unsigned int AGENT_REGISTER_RETRY_INITIAL_INTERVAL_S = 1;
+        constexpr unsigned int AGENT_REGISTER_RETRY_MAX_INTERVAL_S = 60;
+    }
+
+    ConnManBackend::ConnManBackend(bool cache_credentials)
+    {
+        if (cache_credentials) {
+            credential_cache_.emplace();
+        }
+    }
+
+    ConnManBackend::~ConnManBackend()
+    {
+        agent_register_retry_cancel();
+        wifi_access_points_order_idle_connection_.disconnect();
 
-    ConnManBackend::~ConnManBackend() = default;
+        if (wifi_hotspot_configure_) {
+            wifi_hotspot_configure_->timeout_connection.disconnect();
+        }
+    }
 
     void ConnManBackend::wifi_technology_ready(ConnManTechnology &technology)
     {
@@ -55,6 +77,10 @@ namespace ConnectivityManager::Daemon
 
         wifi_status_set(technology.powered() ? WiFiStatus::ENABLED : WiFiStatus::DISABLED);
         wifi_access_points_add_all(aps_from_services());
+        wifi_access_points_order_update();
+
+        scan_scheduler_connection_update();
+        scan_scheduler_.set_enabled(technology.powered());
 
         wifi_hotspot_status_set(technology.tethering() ? WiFiHotspotStatus::ENABLED :
                                                          WiFiHotspotStatus::DISABLED);
@@ -70,6 +96,13 @@ namespace ConnectivityManager::Daemon
 
         wifi_technology_ = nullptr;
         wifi_service_to_ap_id_.clear();
+        wifi_connected_service_ = nullptr;
+
+        if (wifi_hotspot_configure_) {
+            wifi_hotspot_configure_finish(false);
+        }
+
+        scan_scheduler_.reset();
 
         wifi_access_points_remove_all();
         wifi_hotspot_status_set(WiFiHotspotStatus::DISABLED);
@@ -82,14 +115,17 @@ namespace ConnectivityManager::Daemon
         case ConnManTechnology::PropertyId::POWERED:
             wifi_status_set(wifi_technology_->powered() ? WiFiStatus::ENABLED :
                                                           WiFiStatus::DISABLED);
-            if (wifi_technology_->powered()) {
-                wifi_technology_->scan();
-            }
+            scan_scheduler_.set_enabled(wifi_technology_->powered());
             break;
         case ConnManTechnology::PropertyId::TETHERING:
             wifi_hotspot_status_set(wifi_technology_->tethering() ? WiFiHotspotStatus::ENABLED :
                                                                     WiFiHotspotStatus::DISABLED);
             break;
+        case ConnManTechnology::PropertyId::TETHERING_ACTIVE:
+            if (wifi_hotspot_configure_) {
+                wifi_hotspot_configure_tethering_check();
+            }
+            break;
         case ConnManTechnology::PropertyId::TETHERING_IDENTIFIER:
             wifi_hotspot_ssid_set(wifi_technology_->tethering_identifier());
             break;
@@ -121,7 +157,8 @@ namespace ConnectivityManager::Daemon
 
     void ConnManBackend::wifi_connect(const WiFiAccessPoint &access_point,
                                       ConnectFinished &&finished,
-                                      RequestCredentialsFromUser &&request_credentials)
+                                      RequestCredentialsFromUser &&request_credentials,
+                                      const std::shared_ptr<ConnectTrace> &trace)
     {
         if (!wifi_technology_) {
             finished(ConnectResult::FAILED);
@@ -134,7 +171,75 @@ namespace ConnectivityManager::Daemon
             return;
         }
 
-        service_connect(*service, std::move(finished), std::move(request_credentials));
+        service_connect(*service, std::move(finished), std::move(request_credentials), trace);
+    }
+
+    void ConnManBackend::wifi_connect_hidden(const std::string &ssid,
+                                             WiFiSecurity security,
+                                             ConnectFinished &&finished,
+                                             RequestCredentialsFromUser &&request_credentials,
+                                             const std::shared_ptr<ConnectTrace> &trace)
+    {
+        if (!wifi_technology_) {
+            finished(ConnectResult::FAILED);
+            return;
+        }
+
+        // SSID is given to ConnMan when it requests input after Connect() has been called for the
+        // hidden service.
+        ConnManService *service = service_hidden_with_security(security);
+        if (!service) {
+            g_warning("Can not connect to hidden network \"%s\", no hidden ConnMan service with "
+                      "matching security",
+                      Common::string_to_valid_utf8(ssid).c_str());
+            finished(ConnectResult::FAILED);
+            return;
+        }
+
+        if (connect_queue_.contains(*service)) {
+            // Would be joined with connect for (potentially) another SSID.
+            g_warning("Can not connect to hidden network \"%s\", connect to hidden network with "
+                      "same security in progress",
+                      Common::string_to_valid_utf8(ssid).c_str());
+            finished(ConnectResult::FAILED);
+            return;
+        }
+
+        service_connect(*service, std::move(finished), std::move(request_credentials), trace);
+    }
+
+    void ConnManBackend::wifi_connect_cancel(const WiFiAccessPoint &access_point)
+    {
+        if (!wifi_technology_) {
+            return;
+        }
+
+        ConnManService *service = service_from_wifi_ap(access_point);
+        if (!service) {
+            return;
+        }
+
+        // Pending RequestInput() is answered (canceled) when the queue entry is finished. Connect()
+        // call in flight to ConnMan returns with an error when the service is disconnected.
+        if (connect_queue_.cancel(*service)) {
+            service->disconnect();
+        }
+    }
+
+    void ConnManBackend::wifi_connect_hidden_cancel(WiFiSecurity security)
+    {
+        if (!wifi_technology_) {
+            return;
+        }
+
+        ConnManService *service = service_hidden_with_security(security);
+        if (!service) {
+            return;
+        }
+
+        if (connect_queue_.cancel(*service)) {
+            service->disconnect();
+        }
     }
 
     void ConnManBackend::wifi_disconnect(const WiFiAccessPoint &access_point)
@@ -151,6 +256,16 @@ namespace ConnectivityManager::Daemon
         service->disconnect();
     }
 
+    void ConnManBackend::wifi_scan(ScanFinished &&finished)
+    {
+        if (!wifi_technology_) {
+            finished(false, 0);
+            return;
+        }
+
+        scan_scheduler_.request(std::move(finished));
+    }
+
     void ConnManBackend::wifi_hotspot_enable()
     {
         if (!wifi_technology_) {
@@ -187,6 +302,200 @@ namespace ConnectivityManager::Daemon
         wifi_technology_->set_tethering_passphrase(passphrase);
     }
 
+    void ConnManBackend::wifi_hotspot_configure(const std::string &ssid,
+                                                const Glib::ustring &passphrase,
+                                                bool enabled,
+                                                WiFiHotspotConfigureFinished &&finished)
+    {
+        constexpr unsigned int TIMEOUT_S = 60;
+
+        if (!wifi_technology_) {
+            finished(false);
+            return;
+        }
+
+        if (wifi_hotspot_configure_) {
+            g_warning("Wi-Fi hotspot configuration already in progress");
+            finished(false);
+            return;
+        }
+
+        Glib::ustring identifier = Common::string_to_valid_utf8(ssid);
+
+        WiFiHotspotConfigure &configure = wifi_hotspot_configure_.emplace();
+        configure.id = ++wifi_hotspot_configure_last_id_;
+        configure.enabled = enabled;
+        configure.restart = enabled && wifi_technology_->tethering_active() &&
+                            (identifier != wifi_technology_->tethering_identifier() ||
+                             passphrase != wifi_technology_->tethering_passphrase());
+        configure.settings_pending = 2;
+        configure.previous_identifier = wifi_technology_->tethering_identifier();
+        configure.previous_passphrase = wifi_technology_->tethering_passphrase();
+        configure.finished = std::move(finished);
+        configure.timeout_connection = Glib::signal_timeout().connect_seconds(
+            [this] {
+                g_warning("Timed out configuring Wi-Fi hotspot");
+                wifi_hotspot_configure_finish(false);
+                return false;
+            },
+            TIMEOUT_S);
+
+        // Callbacks may be called directly if value is already set, configure must not be used
+        // after this.
+        std::uint64_t id = configure.id;
+
+        wifi_technology_->set_tethering_identifier(identifier, [this, id](bool success) {
+            wifi_hotspot_configure_setting_finished(id, success);
+        });
+        wifi_technology_->set_tethering_passphrase(passphrase, [this, id](bool success) {
+            wifi_hotspot_configure_setting_finished(id, success);
+        });
+    }
+
+    void ConnManBackend::state_dump(StateDump &dump) const
+    {
+        Backend::state_dump(dump);
+
+        dump.object_begin("connman");
+
+        dump.value("manager_available", manager_.available());
+        dump.value("agent_register_retry_interval_s", agent_register_retry_interval_s_);
+        dump.value("wifi_hotspot_configure_in_progress", wifi_hotspot_configure_.has_value());
+        dump.value("credential_cache_enabled", credential_cache_.has_value());
+
+        dump.container(
+            "technologies_container", technologies_.size(), technologies_.bucket_count());
+        dump.container("services_container", services_.size(), services_.bucket_count());
+        dump.container(
+            "services_order_container", services_order_.size(), services_order_.capacity());
+        dump.container("wifi_service_to_ap_id_container",
+                       wifi_service_to_ap_id_.size(),
+                       wifi_service_to_ap_id_.bucket_count());
+        dump.container("credential_cache_answered_container",
+                       credential_cache_answered_.size(),
+                       credential_cache_answered_.bucket_count());
+
+        dump.array_begin("technologies");
+        for (const auto &[path, technology] : technologies_) {
+            dump.object_begin();
+            dump.value("path", path);
+            technology.state_dump(dump);
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.array_begin("services");
+        for (const auto &[path, service] : services_) {
+            dump.object_begin();
+            dump.value("path", path);
+            service.state_dump(dump);
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.array_begin("wifi_service_to_ap_id");
+        for (const auto &[service, id] : wifi_service_to_ap_id_) {
+            dump.object_begin();
+            dump.value("service", service->name());
+            dump.value("access_point_id", id);
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.object_begin("agent");
+        agent_.state_dump(dump);
+        dump.object_end();
+
+        dump.object_begin("connect_queue");
+        connect_queue_.state_dump(dump);
+        dump.object_end();
+
+        dump.object_end();
+    }
+
+    bool ConnManBackend::wifi_hotspot_configure_is_current(std::uint64_t id) const
+    {
+        return wifi_hotspot_configure_ && wifi_hotspot_configure_->id == id;
+    }
+
+    void ConnManBackend::wifi_hotspot_configure_setting_finished(std::uint64_t id, bool success)
+    {
+        if (!wifi_hotspot_configure_is_current(id)) {
+            return;
+        }
+
+        WiFiHotspotConfigure &configure = *wifi_hotspot_configure_;
+
+        configure.settings_failed = configure.settings_failed || !success;
+
+        if (--configure.settings_pending > 0) {
+            return;
+        }
+
+        if (configure.settings_failed) {
+            wifi_hotspot_configure_finish(false);
+            return;
+        }
+
+        wifi_hotspot_configure_tethering_set(configure.enabled && !configure.restart);
+    }
+
+    void ConnManBackend::wifi_hotspot_configure_tethering_set(bool tethering)
+    {
+        std::uint64_t id = wifi_hotspot_configure_->id;
+
+        wifi_technology_->set_tethering(tethering, [this, id, tethering](bool success) {
+            if (!wifi_hotspot_configure_is_current(id)) {
+                return;
+            }
+
+            if (!success) {
+                wifi_hotspot_configure_finish(false);
+                return;
+            }
+
+            wifi_hotspot_configure_->waiting_for_tethering = tethering;
+            wifi_hotspot_configure_tethering_check();
+        });
+    }
+
+    void ConnManBackend::wifi_hotspot_configure_tethering_check()
+    {
+        WiFiHotspotConfigure &configure = *wifi_hotspot_configure_;
+
+        if (!configure.waiting_for_tethering ||
+            *configure.waiting_for_tethering != wifi_technology_->tethering_active()) {
+            return;
+        }
+
+        bool tethering = *configure.waiting_for_tethering;
+        configure.waiting_for_tethering.reset();
+
+        if (!tethering && configure.restart) {
+            configure.restart = false;
+            wifi_hotspot_configure_tethering_set(true);
+            return;
+        }
+
+        wifi_hotspot_configure_finish(true);
+    }
+
+    void ConnManBackend::wifi_hotspot_configure_finish(bool success)
+    {
+        WiFiHotspotConfigure configure = std::move(*wifi_hotspot_configure_);
+        wifi_hotspot_configure_.reset();
+
+        configure.timeout_connection.disconnect();
+
+        if (!success && wifi_technology_) {
+            g_warning("Failed to configure Wi-Fi hotspot, restoring previous SSID and passphrase");
+            wifi_technology_->set_tethering_identifier(configure.previous_identifier);
+            wifi_technology_->set_tethering_passphrase(configure.previous_passphrase);
+        }
+
+        configure.finished(success);
+    }
+
     void ConnManBackend::manager_proxy_creation_failed()
     {
         critical_error();
@@ -200,10 +509,14 @@ namespace ConnectivityManager::Daemon
             wifi_technology_removed();
 
             connect_queue_.fail_all_and_clear();
+            credential_cache_answered_.clear();
 
             services_.clear();
+            services_order_.clear();
             technologies_.clear();
 
+            agent_register_retry_cancel();
+            agent_register_retry_interval_s_ = 0;
             agent_.set_state(ConnManAgent::State::NOT_REGISTERED_WITH_MANAGER);
         }
     }
@@ -256,29 +569,54 @@ namespace ConnectivityManager::Daemon
         ConnManService &service = i->second;
 
         connect_queue_.remove_service(service);
+        credential_cache_answered_.erase(&service);
 
         if (WiFiAccessPoint *ap = service_to_wifi_ap(service); ap) {
             wifi_service_to_ap_id_.erase(&service);
             wifi_access_point_remove(*ap);
+            wifi_access_points_order_update_when_idle();
+
+            if (&service == wifi_connected_service_) {
+                scan_scheduler_connection_update();
+            }
         }
 
         services_.erase(i);
     }
 
-    void ConnManBackend::manager_register_agent_result(bool success)
+    void ConnManBackend::manager_services_order(
+        const std::vector<Glib::DBusObjectPathString> &paths)
+    {
+        services_order_.clear();
+        services_order_.reserve(paths.size());
+
+        for (const auto &path : paths) {
+            services_order_.emplace_back(path.raw());
+        }
+
+        wifi_access_points_order_update_when_idle();
+    }
+
+    void ConnManBackend::manager_register_agent_result(bool success, const Glib::ustring &error)
     {
         if (success) {
+            agent_register_retry_interval_s_ = 0;
             agent_.set_state(ConnManAgent::State::REGISTERED_WITH_MANAGER);
-            connect_queue_.connect_if_not_empty();
+            connect_queue_.connect_all_queued_up();
         } else {
-            agent_.set_state(ConnManAgent::State::NOT_REGISTERED_WITH_MANAGER);
+            agent_.set_registration_failed(error);
             connect_queue_.fail_all_and_clear();
+            agent_register_retry_schedule();
         }
     }
 
     void ConnManBackend::agent_released()
     {
         connect_queue_.fail_all_and_clear();
+
+        if (manager_.available()) {
+            agent_register();
+        }
     }
 
     void ConnManBackend::agent_request_input(const Glib::DBusObjectPathString &service_path,
@@ -294,6 +632,13 @@ namespace ConnectivityManager::Daemon
 
         ConnManService &service = i->second;
 
+        if (auto password = credential_cache_find(service, credentials); password) {
+            Common::Credentials cached;
+            cached.password = std::move(password);
+            reply(cached);
+            return;
+        }
+
         using Requested = Common::Credentials::Requested;
         Requested requested;
 
@@ -310,14 +655,106 @@ namespace ConnectivityManager::Daemon
         requested.description_id = service.name();
         requested.credentials = std::move(credentials);
 
-        connect_queue_.request_credentials(service, requested, std::move(reply));
+        auto key = credential_cache_key(service);
+        if (!key || !credential_cache_can_answer(requested.credentials)) {
+            connect_queue_.request_credentials(service, requested, std::move(reply));
+            return;
+        }
+
+        auto reply_and_store = [this, cache_key = std::move(*key), reply = std::move(reply)](
+                                   const std::optional<Common::Credentials> &result) {
+            if (result && result->password) {
+                credential_cache_->store(cache_key, *result->password);
+            }
+            reply(result);
+        };
+
+        connect_queue_.request_credentials(service, requested, std::move(reply_and_store));
+    }
+
+    bool ConnManBackend::credential_cache_can_answer(const Common::Credentials &requested)
+    {
+        return requested.password && !requested.ssid && !requested.username;
+    }
+
+    std::optional<CredentialCache::Key> ConnManBackend::credential_cache_key(
+        const ConnManService &service) const
+    {
+        if (!credential_cache_ || !credential_cache_->available() ||
+            service.type() != ConnManService::Type::WIFI || service.name().empty()) {
+            return {};
+        }
+
+        return CredentialCache::Key{service.name().raw(), service.security_to_wifi_security()};
+    }
+
+    std::optional<Common::Credentials::Password> ConnManBackend::credential_cache_find(
+        ConnManService &service,
+        const Common::Credentials &requested)
+    {
+        auto key = credential_cache_key(service);
+        if (!key) {
+            return {};
+        }
+
+        if (credential_cache_answered_.erase(&service) != 0) {
+            // Already answered from cache in this connection attempt, cached password rejected.
+            credential_cache_->evict(*key);
+            return {};
+        }
+
+        if (!credential_cache_can_answer(requested)) {
+            return {};
+        }
+
+        auto password = credential_cache_->find(*key);
+        if (!password || password->type != requested.password->type) {
+            return {};
+        }
+
+        g_debug("Answering ConnMan agent credentials request for \"%s\" from cache",
+                service.name().c_str());
+
+        credential_cache_answered_.insert(&service);
+
+        return password;
+    }
+
+    void ConnManBackend::credential_cache_service_state_changed(ConnManService &service)
+    {
+        auto key = credential_cache_key(service);
+        if (!key) {
+            return;
+        }
+
+        switch (service.state()) {
+        case ConnManService::State::READY:
+        case ConnManService::State::ONLINE:
+            credential_cache_->validate(*key);
+            credential_cache_answered_.erase(&service);
+            break;
+        case ConnManService::State::FAILURE:
+            credential_cache_->evict(*key);
+            credential_cache_answered_.erase(&service);
+            break;
+        case ConnManService::State::IDLE:
+        case ConnManService::State::DISCONNECT:
+            credential_cache_answered_.erase(&service);
+            break;
+        case ConnManService::State::ASSOCIATION:
+        case ConnManService::State::CONFIGURATION:
+            break;
+        }
     }
 
     void ConnManBackend::agent_register()
     {
+        agent_register_retry_cancel();
+
         if (!agent_.registered_object()) {
             if (!agent_.register_object(manager_.dbus_connection())) {
                 connect_queue_.fail_all_and_clear();
+                agent_register_retry_schedule();
                 return;
             }
         }
@@ -328,6 +765,33 @@ namespace ConnectivityManager::Daemon
         }
     }
 
+    void ConnManBackend::agent_register_retry_schedule()
+    {
+        agent_register_retry_cancel();
+
+        if (agent_register_retry_interval_s_ == 0) {
+            agent_register_retry_interval_s_ = AGENT_REGISTER_RETRY_INITIAL_INTERVAL_S;
+        } else {
+            agent_register_retry_interval_s_ = std::min(agent_register_retry_interval_s_ * 2,
+                                                        AGENT_REGISTER_RETRY_MAX_INTERVAL_S);
+        }
+
+        g_warning("Failed to register ConnMan agent, retrying in %u s",
+                  agent_register_retry_interval_s_);
+
+        agent_register_retry_connection_ = Glib::signal_timeout().connect_seconds(
+            [this] {
+                agent_register();
+                return false;
+            },
+            agent_register_retry_interval_s_);
+    }
+
+    void ConnManBackend::agent_register_retry_cancel()
+    {
+        agent_register_retry_connection_.disconnect();
+    }
+
     void ConnManBackend::technology_proxy_created(ConnManTechnology &technology)
     {
         if (technology.type() == ConnManTechnology::Type::WIFI) {
@@ -357,12 +821,18 @@ namespace ConnectivityManager::Daemon
             wifi_service_to_ap_id_.emplace(&service, ap.id);
 
             wifi_access_point_add(std::move(ap));
+            wifi_access_points_order_update_when_idle();
         }
     }
 
     void ConnManBackend::service_property_changed(ConnManService &service,
                                                   ConnManService::PropertyId id)
     {
+        if (id == ConnManService::PropertyId::STATE) {
+            connect_queue_.service_state_changed(service);
+            credential_cache_service_state_changed(service);
+        }
+
         if (WiFiAccessPoint *ap = service_to_wifi_ap(service); ap) {
             switch (id) {
             case ConnManService::PropertyId::NAME:
@@ -373,9 +843,20 @@ namespace ConnectivityManager::Daemon
                 break;
             case ConnManService::PropertyId::STATE:
                 wifi_access_point_connected_set(*ap, service.state_to_connected());
+
+                if (service.state_to_connected()) {
+                    wifi_connected_service_ = &service;
+                    scan_scheduler_.set_connection(true, service.strength());
+                } else if (&service == wifi_connected_service_) {
+                    scan_scheduler_connection_update();
+                }
                 break;
             case ConnManService::PropertyId::STRENGTH:
                 wifi_access_point_strength_set(*ap, service.strength());
+
+                if (&service == wifi_connected_service_) {
+                    scan_scheduler_.set_connection(true, service.strength());
+                }
                 break;
             default:
                 break;
@@ -388,14 +869,48 @@ namespace ConnectivityManager::Daemon
         connect_queue_.connect_finished(service, success);
     }
 
+    void ConnManBackend::scan_scheduler_scan()
+    {
+        if (!wifi_technology_) {
+            scan_scheduler_.scan_finished(false);
+            return;
+        }
+
+        wifi_technology_->scan([this](bool success) { scan_scheduler_.scan_finished(success); });
+    }
+
+    void ConnManBackend::scan_scheduler_scan_finished(bool success, std::uint32_t duration_ms)
+    {
+        wifi_scan_finished(success, duration_ms);
+    }
+
+    void ConnManBackend::scan_scheduler_connection_update()
+    {
+        wifi_connected_service_ = nullptr;
+
+        for (auto &[service, id] : wifi_service_to_ap_id_) {
+            if (service->state_to_connected()) {
+                wifi_connected_service_ = service;
+                scan_scheduler_.set_connection(true, service->strength());
+                return;
+            }
+        }
+
+        scan_scheduler_.set_connection(false, 0);
+    }
+
     void ConnManBackend::service_connect(ConnManService &service,
                                          ConnectFinished &&finished,
-                                         RequestCredentialsFromUser &&request_credentials)
+                                         RequestCredentialsFromUser &&request_credentials,
+                                         const std::shared_ptr<ConnectTrace> &trace)
     {
         bool agent_registered = agent_.state() == ConnManAgent::State::REGISTERED_WITH_MANAGER;
 
-        connect_queue_.enqueue(
-            service, std::move(finished), std::move(request_credentials), agent_registered);
+        connect_queue_.enqueue(service,
+                               std::move(finished),
+                               std::move(request_credentials),
+                               trace,
+                               agent_registered);
 
         if (!agent_registered) {
             agent_register();
@@ -423,4 +938,57 @@ namespace ConnectivityManager::Daemon
 
         return nullptr;
     }
+
+    ConnManService *ConnManBackend::service_hidden_with_security(WiFiSecurity security)
+    {
+        // ConnMan has one service with empty name per security type for hidden networks.
+        for (auto &[path, service] : services_) {
+            if (service.type() == ConnManService::Type::WIFI && service.name().empty() &&
+                service.proxy_created() && service.security_to_wifi_security() == security) {
+                return &service;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void ConnManBackend::wifi_access_points_order_update_when_idle()
+    {
+        if (wifi_access_points_order_idle_connection_.connected()) {
+            return;
+        }
+
+        wifi_access_points_order_idle_connection_ = Glib::signal_idle().connect([this] {
+            wifi_access_points_order_update();
+            return false;
+        });
+    }
+
+    void ConnManBackend::wifi_access_points_order_update()
+    {
+        MainLoopMonitor::Scope scope("ConnManBackend::wifi_access_points_order_update");
+
+        wifi_access_points_order_idle_connection_.disconnect();
+
+        if (!wifi_technology_) {
+            return;
+        }
+
+        std::vector<WiFiAccessPoint::Id> order;
+        order.reserve(wifi_service_to_ap_id_.size());
+
+        for (const std::string &path : services_order_) {
+            auto i = services_.find(path);
+            if (i == services_.cend()) {
+                continue;
+            }
+
+            auto j = wifi_service_to_ap_id_.find(&i->second);
+            if (j != wifi_service_to_ap_id_.cend()) {
+                order.push_back(j->second);
+            }
+        }
+
+        wifi_access_points_order_set(std::move(order));
+    }
 }
@@ -11,16 +11,24 @@
 
 #include <giomm.h>
 #include <glibmm.h>
+#include <sigc++/sigc++.h>
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "daemon/backend.h"
 #include "daemon/backends/connman_agent.h"
 #include "daemon/backends/connman_connect_queue.h"
 #include "daemon/backends/connman_manager.h"
+#include "daemon/backends/connman_scan_scheduler.h"
 #include "daemon/backends/connman_service.h"
 #include "daemon/backends/connman_technology.h"
+#include "daemon/credential_cache.h"
 
 namespace ConnectivityManager::Daemon
 {
@@ -42,6 +50,9 @@ namespace ConnectivityManager::Daemon
     // - ConnManConnectQueue: Queued up connection requests if a connection is requested before
     //   ConnManBackend is ready to call ConnMan or a connection is pending.
     //
+    // - ConnManScanScheduler: Decides when to scan for Wi-Fi access points and coalesces scan
+    //   requests.
+    //
     // ConnManBackend owns a ConnManManager that tries to contact ConnMan on creation and will
     // signal to ConnManBackend when the ConnMan manager is available and disappears (e.g. the
     // ConnMan process is stopped). ConnManManager will request all technologies and services when
@@ -52,12 +63,30 @@ namespace ConnectivityManager::Daemon
     // instances and takes care of mapping ConnMan's technologies and services to Backend.
     //
     // ConnManAgent is registered with ConnMan as soon as ConnMan is available. If registration
-    // fails or ConnMan for some reason deregistered the agent, ConnManBackend will try to register
-    // it again when a connection attempt is made for a service.
+    // fails, registration is retried with a timer using exponential backoff (AGENT_REGISTER_RETRY_*
+    // in connman_backend.cpp). If ConnMan releases the agent, it is registered again directly. A
+    // connection attempt for a service while the agent is not registered also triggers an
+    // immediate registration attempt (cancels pending retry).
+    //
+    // If enabled, passwords entered by user are stored in a CredentialCache and used to answer
+    // ConnMan's RequestInput() directly, without a round trip through ConnManConnectQueue and the
+    // user, once the service has been connected with them. A cached password is evicted if the
+    // service fails to connect or if ConnMan requests input again in the same connection attempt.
+    // Only requests for just a password are cached, not ones that include identity or SSID (e.g.
+    // WPA-EAP and hidden networks) since only the password is stored.
     //
     // If the agent has not been successfully registered with ConnMan when connecting to a service,
-    // the request will be queued up in ConnManConnectQueue. When a result is received from ConnMan
-    // for the agent registration, the queue will be processed in FIFO order.
+    // the request will be queued up in ConnManConnectQueue. When the agent has been registered all
+    // queued up services are connected to at once (concurrently, one ConnMan Connect() call per
+    // service), if registration fails they are all failed. Connects to different services run
+    // concurrently and their results and input requests are routed to the service in question,
+    // see ConnManConnectQueue.
+    //
+    // ConnMan keeps its services sorted in order of preference and always lists all services in
+    // that order in the ServicesChanged signal. The order is stored as is and mapped to
+    // State::wifi::access_points_order. Mapping is deferred to an idle callback since many
+    // services are typically added at once (e.g. when a D-Bus proxy has been created for each
+    // service after GetServices()) and the order only needs to be updated once for all of them.
     //
     // Note that ConnMan uses strings in its D-Bus interface for SSID:s. Problematic since SSID:s
     // may not necessarily be UTF-8 (prior to the 2012 edition of the IEEE 802.11 standard) and it
@@ -68,29 +97,74 @@ namespace ConnectivityManager::Daemon
                                  public ConnManManager::Listener,
                                  public ConnManAgent::Listener,
                                  public ConnManTechnology::Listener,
-                                 public ConnManService::Listener
+                                 public ConnManService::Listener,
+                                 public ConnManScanScheduler::Listener
     {
     public:
-        ConnManBackend();
+        explicit ConnManBackend(bool cache_credentials);
         ~ConnManBackend() final;
 
         void wifi_enable() override;
         void wifi_disable() override;
         void wifi_connect(const WiFiAccessPoint &access_point,
                           ConnectFinished &&finished,
-                          RequestCredentialsFromUser &&request_credentials) override;
+                          RequestCredentialsFromUser &&request_credentials,
+                          const std::shared_ptr<ConnectTrace> &trace) override;
+        void wifi_connect_hidden(const std::string &ssid,
+                                 WiFiSecurity security,
+                                 ConnectFinished &&finished,
+                                 RequestCredentialsFromUser &&request_credentials,
+                                 const std::shared_ptr<ConnectTrace> &trace) override;
+        void wifi_connect_cancel(const WiFiAccessPoint &access_point) override;
+        void wifi_connect_hidden_cancel(WiFiSecurity security) override;
         void wifi_disconnect(const WiFiAccessPoint &access_point) override;
+        void wifi_scan(ScanFinished &&finished) override;
 
         void wifi_hotspot_enable() override;
         void wifi_hotspot_disable() override;
         void wifi_hotspot_change_ssid(const std::string &ssid) override;
         void wifi_hotspot_change_passphrase(const Glib::ustring &passphrase) override;
+        void wifi_hotspot_configure(const std::string &ssid,
+                                    const Glib::ustring &passphrase,
+                                    bool enabled,
+                                    WiFiHotspotConfigureFinished &&finished) override;
+
+        void state_dump(StateDump &dump) const override;
 
     private:
         void wifi_technology_ready(ConnManTechnology &technology);
         void wifi_technology_removed();
         void wifi_technology_property_changed(ConnManTechnology::PropertyId id);
 
+        // State of an ongoing wifi_hotspot_configure(). Only one at a time.
+        //
+        // TetheringIdentifier and TetheringPassphrase are set without waiting for each other.
+        // Tethering is set when both have succeeded. If tethering is already enabled and SSID or
+        // passphrase changes, it is disabled and enabled again (restart) for the change to take
+        // effect. After each Tethering change, waits for ConnMan to report it as done.
+        struct WiFiHotspotConfigure
+        {
+            std::uint64_t id = 0;
+            bool enabled = false;
+            bool restart = false;
+
+            int settings_pending = 0;
+            bool settings_failed = false;
+            std::optional<bool> waiting_for_tethering;
+
+            Glib::ustring previous_identifier;
+            Glib::ustring previous_passphrase;
+
+            WiFiHotspotConfigureFinished finished;
+            sigc::connection timeout_connection;
+        };
+
+        bool wifi_hotspot_configure_is_current(std::uint64_t id) const;
+        void wifi_hotspot_configure_setting_finished(std::uint64_t id, bool success);
+        void wifi_hotspot_configure_tethering_set(bool tethering);
+        void wifi_hotspot_configure_tethering_check();
+        void wifi_hotspot_configure_finish(bool success);
+
         // ConnManManager::Listner overrides and manager related methods.
         void manager_proxy_creation_failed() override;
         void manager_availability_changed(bool available) override;
@@ -102,8 +176,9 @@ namespace ConnectivityManager::Daemon
         void manager_service_add_or_change(const Glib::DBusObjectPathString &path,
                                            const ConnManService::PropertyMap &properties) override;
         void manager_service_remove(const Glib::DBusObjectPathString &path) override;
+        void manager_services_order(const std::vector<Glib::DBusObjectPathString> &paths) override;
 
-        void manager_register_agent_result(bool success) override;
+        void manager_register_agent_result(bool success, const Glib::ustring &error) override;
 
         // ConnManAgent::Listener overrides and agent related methods.
         void agent_released() override;
@@ -111,7 +186,17 @@ namespace ConnectivityManager::Daemon
                                  Common::Credentials &&credentials,
                                  RequestCredentialsFromUserReply &&reply) override;
 
+        static bool credential_cache_can_answer(const Common::Credentials &requested);
+        std::optional<CredentialCache::Key> credential_cache_key(
+            const ConnManService &service) const;
+        std::optional<Common::Credentials::Password> credential_cache_find(
+            ConnManService &service,
+            const Common::Credentials &requested);
+        void credential_cache_service_state_changed(ConnManService &service);
+
         void agent_register();
+        void agent_register_retry_schedule();
+        void agent_register_retry_cancel();
 
         // ConnManTechnology::Listener overrides and technology related methods.
         void technology_proxy_created(ConnManTechnology &technology) override;
@@ -126,21 +211,46 @@ namespace ConnectivityManager::Daemon
 
         void service_connect(ConnManService &service,
                              ConnectFinished &&finished,
-                             RequestCredentialsFromUser &&request_credentials);
+                             RequestCredentialsFromUser &&request_credentials,
+                             const std::shared_ptr<ConnectTrace> &trace);
+
+        // ConnManScanScheduler::Listener overrides and scan related methods.
+        void scan_scheduler_scan() override;
+        void scan_scheduler_scan_finished(bool success, std::uint32_t duration_ms) override;
+
+        // Finds the connected Wi-Fi service by looking through all of them. Only needed when it is
+        // not known, State and Strength changes (frequent) keep wifi_connected_service_ up to date.
+        void scan_scheduler_connection_update();
 
         WiFiAccessPoint *service_to_wifi_ap(ConnManService &service);
         ConnManService *service_from_wifi_ap(const WiFiAccessPoint &ap);
+        ConnManService *service_hidden_with_security(WiFiSecurity security);
+
+        void wifi_access_points_order_update_when_idle();
+        void wifi_access_points_order_update();
 
         ConnManManager manager_{*this};
         ConnManAgent agent_{*this};
+        sigc::connection agent_register_retry_connection_;
+        unsigned int agent_register_retry_interval_s_ = 0;
 
         std::unordered_map<std::string, ConnManTechnology> technologies_;
         std::unordered_map<std::string, ConnManService> services_;
+        std::vector<std::string> services_order_;
 
         ConnManTechnology *wifi_technology_ = nullptr;
         std::unordered_map<ConnManService *, WiFiAccessPoint::Id> wifi_service_to_ap_id_;
+        ConnManService *wifi_connected_service_ = nullptr;
+        sigc::connection wifi_access_points_order_idle_connection_;
+
+        std::optional<WiFiHotspotConfigure> wifi_hotspot_configure_;
+        std::uint64_t wifi_hotspot_configure_last_id_ = 0;
 
         ConnManConnectQueue connect_queue_;
+        std::optional<CredentialCache> credential_cache_;
+        std::unordered_set<const ConnManService *> credential_cache_answered_;
+
+        ConnManScanScheduler scan_scheduler_{*this};
     };
 }
 
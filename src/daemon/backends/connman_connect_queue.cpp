@@ -8,102 +8,216 @@
 
 #include "daemon/backends/connman_connect_queue.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include "daemon/backend.h"
 #include "daemon/backends/connman_service.h"
+#include "daemon/connect_trace.h"
+#include "daemon/metrics_registry.h"
+#include "daemon/tracepoints.h"
 
 namespace ConnectivityManager::Daemon
 {
+    namespace
+    {
+        void trace_transition(const ConnManService &service,
+                              const char *transition,
+                              std::size_t depth)
+        {
+            // Args: service id, service name, transition, queue depth after transition.
+            CONNECTIVITY_MANAGER_TRACE(connman_connect_queue_transition,
+                                       static_cast<const void *>(&service),
+                                       service.name().c_str(),
+                                       transition,
+                                       depth);
+        }
+    }
+
+    ConnManConnectQueue::~ConnManConnectQueue()
+    {
+        waiting_for_online_clear();
+    }
+
     void ConnManConnectQueue::enqueue(ConnManService &service,
                                       Backend::ConnectFinished &&finished,
                                       Backend::RequestCredentialsFromUser &&request_credentials,
-                                      bool connect_if_queue_empty)
+                                      const std::shared_ptr<ConnectTrace> &trace,
+                                      bool agent_registered)
     {
-        bool connect = connect_if_queue_empty && entries_.empty();
+        if (trace) {
+            trace->mark(ConnectTrace::Stage::QUEUED);
+        }
+
+        if (auto i = find(service); i != entries_.end()) {
+            i->finished.emplace_back(std::move(finished));
+
+            if (!i->request_credentials) {
+                i->request_credentials = std::move(request_credentials);
+            }
+
+            trace_transition(service, "coalesced", entries_.size());
 
-        entries_.emplace_back(
-            Entry{&service, false, std::move(finished), std::move(request_credentials)});
+            if (trace) {
+                if (i->connecting) {
+                    trace->mark(ConnectTrace::Stage::AGENT_REGISTERED);
+                    trace->mark(ConnectTrace::Stage::CONNECT_SENT);
+                }
+                i->traces.emplace_back(trace);
+            }
+            return;
+        }
+
+        waiting_for_online_erase(service);
+
+        Entry &entry = entries_.emplace_back();
+        entry.service = &service;
+        entry.finished.emplace_back(std::move(finished));
+        entry.request_credentials = std::move(request_credentials);
+        depth_update();
+        trace_transition(service, "enqueued", entries_.size());
+
+        if (trace) {
+            entry.traces.emplace_back(trace);
+        }
 
-        if (connect) {
-            Entry &entry = entries_.front();
-            entry.connecting = true;
-            entry.service->connect();
+        if (agent_registered) {
+            connect(entry);
         }
     }
 
     void ConnManConnectQueue::remove_service(const ConnManService &service)
     {
-        std::vector<Backend::ConnectFinished> finished_callbacks; // Callbacks can modify entries_.
+        // Also when there is no entry, service is about to be destroyed.
+        waiting_for_online_erase(service);
 
-        for (auto i = entries_.begin(); i != entries_.end();) {
-            if (i->service == &service) {
-                finished_callbacks.emplace_back(std::move(i->finished));
-                i = entries_.erase(i);
-            } else {
-                i++;
-            }
+        auto i = find(service);
+        if (i == entries_.end()) {
+            return;
         }
 
-        for (auto &finished_callback : finished_callbacks) {
-            finished_callback(Backend::ConnectResult::FAILED);
+        Entry entry = std::move(*i); // Callbacks can modify entries_.
+        entries_.erase(i);
+        depth_update();
+        trace_transition(service, "removed", entries_.size());
+
+        finish(entry, Backend::ConnectResult::FAILED);
+    }
+
+    bool ConnManConnectQueue::cancel(const ConnManService &service)
+    {
+        auto i = find(service);
+        if (i == entries_.end()) {
+            return false;
         }
+
+        Entry entry = std::move(*i); // Callbacks can modify entries_.
+        entries_.erase(i);
+        depth_update();
+        trace_transition(service, "canceled", entries_.size());
+
+        ConnectTrace::set_result_all(entry.traces, false);
+
+        finish(entry, Backend::ConnectResult::CANCELED);
+
+        return entry.connecting;
     }
 
     void ConnManConnectQueue::fail_all_and_clear()
     {
+        waiting_for_online_clear();
+
         if (entries_.empty()) {
             return;
         }
 
-        std::deque<Entry> entries_to_fail = std::move(entries_); // Callbacks can modify entries_.
+        Entries entries_to_fail = std::move(entries_); // Callbacks can modify entries_.
+        entries_ = Entries();
+        depth_update();
 
-        for (const auto &entry : entries_to_fail) {
-            entry.finished(Backend::ConnectResult::FAILED);
+        for (Entry &entry : entries_to_fail) {
+            trace_transition(*entry.service, "failed", entries_.size());
+            finish(entry, Backend::ConnectResult::FAILED);
         }
+    }
 
-        entries_ = std::deque<Entry>();
+    void ConnManConnectQueue::connect_all_queued_up()
+    {
+        for (Entry &entry : entries_) {
+            if (!entry.connecting) {
+                connect(entry);
+            }
+        }
     }
 
-    void ConnManConnectQueue::connect_if_not_empty()
+    void ConnManConnectQueue::connect_finished(const ConnManService &service, bool success)
     {
-        if (entries_.empty()) {
+        auto i = find(service);
+        if (i == entries_.end() || !i->connecting) {
+            g_warning("Service finished connecting but no connect pending for it in queue");
             return;
         }
 
-        Entry &entry = entries_.front();
+        Entry entry = std::move(*i);
+        entries_.erase(i);
+        depth_update();
+        trace_transition(service, success ? "connected" : "connect-failed", entries_.size());
+
+        ConnectTrace::mark_all(entry.traces, ConnectTrace::Stage::CONNECT_FINISHED);
+        ConnectTrace::set_result_all(entry.traces, success);
+
+        if (success) {
+            if (service.state_to_connected()) {
+                ConnectTrace::mark_all(entry.traces, ConnectTrace::Stage::READY);
+            }
 
-        if (!entry.connecting) {
-            entry.connecting = true;
-            entry.service->connect();
+            if (service.state() == ConnManService::State::ONLINE) {
+                ConnectTrace::mark_all(entry.traces, ConnectTrace::Stage::ONLINE);
+            } else {
+                waiting_for_online_add(service, entry.traces);
+            }
         }
+
+        finish(entry, success ? Backend::ConnectResult::SUCCESS : Backend::ConnectResult::FAILED);
     }
 
-    void ConnManConnectQueue::connect_finished(const ConnManService &service, bool success)
+    void ConnManConnectQueue::service_state_changed(const ConnManService &service)
     {
-        if (entries_.empty()) {
-            g_warning("Service finished connecting but connect queue is empty");
-            return;
-        }
+        ConnectTrace::Stage stage;
 
-        if (entries_.front().service != &service) {
-            // TODO: So... weird state now? Bring forth the sledge hammer and just
-            //       fail_all_and_clear()? Better than continuing in a world of lies... gets us back
-            //       to sane state faster...? If "single connect at a time" limitation is removed
-            //       (see TODO in connman_connect_queue.h), this will not be a problem since
-            //       "connect finished" will be handled locally in ConnManService and this
-            //       method will not exist.
-            g_warning("Service finished connecting but not first in queue");
+        switch (service.state()) {
+        case ConnManService::State::READY:
+            stage = ConnectTrace::Stage::READY;
+            break;
+        case ConnManService::State::ONLINE:
+            stage = ConnectTrace::Stage::ONLINE;
+            break;
+        case ConnManService::State::IDLE:
+        case ConnManService::State::FAILURE:
+        case ConnManService::State::DISCONNECT:
+            waiting_for_online_erase(service);
+            return;
+        case ConnManService::State::ASSOCIATION:
+        case ConnManService::State::CONFIGURATION:
+        default:
             return;
         }
 
-        Entry entry = std::move(entries_.front());
-        entries_.pop_front();
+        if (auto i = find(service); i != entries_.end()) {
+            ConnectTrace::mark_all(i->traces, stage);
+        }
 
-        entry.finished(success ? Backend::ConnectResult::SUCCESS : Backend::ConnectResult::FAILED);
+        if (auto i = traces_waiting_for_online_.find(&service);
+            i != traces_waiting_for_online_.end()) {
+            ConnectTrace::mark_all(i->second.traces, stage);
 
-        connect_if_not_empty();
+            if (stage == ConnectTrace::Stage::ONLINE) {
+                waiting_for_online_erase(service);
+            }
+        }
     }
 
     void ConnManConnectQueue::request_credentials(
@@ -111,20 +225,123 @@ namespace ConnectivityManager::Daemon
         const Common::Credentials::Requested &requested,
         Backend::RequestCredentialsFromUserReply &&reply) const
     {
-        if (entries_.empty()) {
-            g_warning("Received unexpected credentials request, queue empty");
+        auto i = find(service);
+        if (i == entries_.cend() || !i->connecting) {
+            g_warning("Received unexpected credentials request for service not connecting");
             reply(Common::Credentials::NONE);
             return;
         }
 
-        const Entry &entry = entries_.front();
-
-        if (entry.service != &service) {
-            g_warning("Received unexpected credentials request for service not first in queue");
+        if (!i->request_credentials) {
             reply(Common::Credentials::NONE);
             return;
         }
 
-        entry.request_credentials(requested, std::move(reply));
+        ConnectTrace::mark_all(i->traces, ConnectTrace::Stage::INPUT_REQUESTED);
+
+        i->request_credentials(
+            requested,
+            [traces = i->traces, reply = std::move(reply)](
+                const std::optional<Common::Credentials> &result) {
+                ConnectTrace::mark_all(traces, ConnectTrace::Stage::INPUT_REPLIED);
+                reply(result);
+            });
+    }
+
+    void ConnManConnectQueue::state_dump(StateDump &dump) const
+    {
+        dump.array_begin("entries");
+        for (const Entry &entry : entries_) {
+            dump.object_begin();
+            dump.value("service", entry.service->name());
+            dump.value("connecting", entry.connecting);
+            dump.value("finished_callbacks", entry.finished.size());
+            dump.value("request_credentials", entry.request_credentials ? true : false);
+            dump.value("traces", entry.traces.size());
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.container("traces_waiting_for_online_container",
+                       traces_waiting_for_online_.size(),
+                       traces_waiting_for_online_.bucket_count());
+    }
+
+    void ConnManConnectQueue::waiting_for_online_add(const ConnManService &service,
+                                                     const ConnectTrace::Traces &traces)
+    {
+        if (traces.empty()) {
+            return;
+        }
+
+        WaitingForOnline &waiting = traces_waiting_for_online_[&service];
+        waiting.traces.insert(waiting.traces.end(), traces.cbegin(), traces.cend());
+
+        // Restarted, all traces for the service are finalized at once.
+        waiting.timeout_connection.disconnect();
+        waiting.timeout_connection = Glib::signal_timeout().connect_seconds(
+            [this, &service] {
+                traces_waiting_for_online_.erase(&service);
+                return false;
+            },
+            ONLINE_TIMEOUT_S);
+    }
+
+    void ConnManConnectQueue::waiting_for_online_erase(const ConnManService &service)
+    {
+        auto i = traces_waiting_for_online_.find(&service);
+        if (i == traces_waiting_for_online_.end()) {
+            return;
+        }
+
+        i->second.timeout_connection.disconnect();
+        traces_waiting_for_online_.erase(i);
+    }
+
+    void ConnManConnectQueue::waiting_for_online_clear()
+    {
+        for (auto &[service, waiting] : traces_waiting_for_online_) {
+            waiting.timeout_connection.disconnect();
+        }
+
+        traces_waiting_for_online_.clear();
+    }
+
+    void ConnManConnectQueue::connect(Entry &entry)
+    {
+        entry.connecting = true;
+        trace_transition(*entry.service, "connecting", entries_.size());
+        ConnectTrace::mark_all(entry.traces, ConnectTrace::Stage::AGENT_REGISTERED);
+        ConnectTrace::mark_all(entry.traces, ConnectTrace::Stage::CONNECT_SENT);
+        entry.service->connect();
+    }
+
+    void ConnManConnectQueue::finish(Entry &entry, Backend::ConnectResult result)
+    {
+        for (Backend::ConnectFinished &finished : entry.finished) {
+            finished(result);
+        }
+    }
+
+    void ConnManConnectQueue::depth_update() const
+    {
+        MetricsRegistry::instance().set(MetricsRegistry::Gauge::CONNECT_QUEUE_DEPTH,
+                                        entries_.size());
+    }
+
+    ConnManConnectQueue::Entries::iterator ConnManConnectQueue::find(
+        const ConnManService &service)
+    {
+        return std::find_if(entries_.begin(), entries_.end(), [&](const Entry &entry) {
+            return entry.service == &service;
+        });
+    }
+
+    ConnManConnectQueue::Entries::const_iterator ConnManConnectQueue::find(
+        const ConnManService &service) const
+    {
+        return std::find_if(entries_.cbegin(), entries_.cend(), [&](const Entry &entry) {
+            return entry.service == &service;
+        });
     }
 }
@@ -9,72 +9,123 @@
 #ifndef CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_CONNECT_QUEUE_H
 #define CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_CONNECT_QUEUE_H
 
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
 #include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "common/credentials.h"
 #include "daemon/backend.h"
 #include "daemon/backends/connman_service.h"
+#include "daemon/connect_trace.h"
+#include "daemon/state_dump.h"
 
 namespace ConnectivityManager::Daemon
 {
     // Queue for service connect requests.
     //
     // Needed because agent (ConnManAgent) may not have been registered with ConnMan when a connect
-    // request is received. Requests should be processed in order when agent has been registered.
+    // request is received. Requests are kept in the order received and connects for all queued up
+    // services are started at once when the agent has been registered (connect_all_queued_up()).
+    //
+    // Connect requests for different services are handled concurrently. ConnManService::connect()
+    // is called directly in enqueue() if the agent is registered. Result of connect and credentials
+    // requests from ConnMan are routed to the entry for the service in question.
+    //
+    // There is at most one entry, and one ConnManService::connect() call, per service. Requests for
+    // a service that already has an entry (queued or connecting) join it. All ConnectFinished
+    // callbacks are called in FIFO order when the connect has finished. The
+    // RequestCredentialsFromUser callback of the first request that supplied one is used.
     //
-    // TODO: Only a single connect request is processed at a time now. The thinking was that due to
-    // ConnMan's agent D-Bus API has a Cancel() method that does not mention what service the
-    // Cancel() call is for, only a single connect could be handled at a time. Turns out that maybe
-    // nothing needs to be done in Cancel() in the agent though. See TODO on ConnManAgent::Cancel()
-    // for verifying this. If that is the case the "one pending connect" at a time limitation can be
-    // removed. It probably makes sense to modify it so that:
-    // - Connect requests are only queued up in this class if the agent is not registered with
-    //   ConnMan. If the agent is ready, ConnManService::connect() should be called immediately.
-    //   - Modify ConnManService::Connect() to take Backend::ConnectFinished &&finished and
-    //     Backend::RequestCredentialsFromUser &&request_credentials and store these in
-    //     ConnManService. And invoke when appropriate.
-    //   - ConnManService::Listener::service_connect_finished() can be removed since ConnectFinished
-    //     callbacks are invoked in ConnManService::connect_finish().
-    //   - Probably also makes sense to only store ConnectFinished callback and not invoke the
-    //     service's Connect() method if a Connect() is already pending. (Callbacks should be
-    //     invokes in FIFO order.)
-    //   - Only makes sense to store a single Backend::RequestCredentialsFromUser callback? Perhaps
-    //     make it so that it is optional to pass it as well?
-    // - When agent registration reply is received:
-    //   - if it failed, keep current behavior and call fail_all_and_clear().
-    //   - if success, call ConnManService::connect() for all entries and move out of this queue.
-    // - connect_if_not_empty() should be renamed to connect_all_queued_up() or something...
-    // - connect_finished() and request_credentials() should be removed.
+    // ConnMan's agent API has a Cancel() method that does not say which request it is for. Nothing
+    // needs to be done for it though, see ConnManAgent::Cancel(), so it does not limit the number
+    // of concurrent connects.
+    //
+    // ConnectTrace:s passed to enqueue() are marked as requests pass through the queue. The result
+    // is set when the connect finishes. Stage::READY is marked then if the service is already
+    // connected (READY or ONLINE). Stage::ONLINE is optional, ConnMan may never verify internet
+    // access, so traces of successful connects are only kept for ONLINE_TIMEOUT_S after that (and
+    // only while the service stays connected, see service_state_changed()) to be able to mark
+    // Stage::READY and Stage::ONLINE. When dropped the trace is finalized with the stages reached.
     class ConnManConnectQueue
     {
     public:
+        static constexpr unsigned int ONLINE_TIMEOUT_S = 30;
+
+        ConnManConnectQueue() = default;
+        ~ConnManConnectQueue();
+
+        ConnManConnectQueue(const ConnManConnectQueue &other) = delete;
+        ConnManConnectQueue(ConnManConnectQueue &&other) = delete;
+        ConnManConnectQueue &operator=(const ConnManConnectQueue &other) = delete;
+        ConnManConnectQueue &operator=(ConnManConnectQueue &&other) = delete;
+
         void enqueue(ConnManService &service,
                      Backend::ConnectFinished &&finished,
                      Backend::RequestCredentialsFromUser &&request_credentials,
-                     bool connect_if_queue_empty);
+                     const std::shared_ptr<ConnectTrace> &trace,
+                     bool agent_registered);
+
+        bool contains(const ConnManService &service) const
+        {
+            return find(service) != entries_.cend();
+        }
 
         void remove_service(const ConnManService &service);
 
+        // Returns true if ConnManService::connect() had been called for the canceled entry.
+        bool cancel(const ConnManService &service);
+
         void fail_all_and_clear();
 
-        void connect_if_not_empty();
+        void connect_all_queued_up();
 
         void connect_finished(const ConnManService &service, bool success);
 
+        void service_state_changed(const ConnManService &service);
+
         void request_credentials(const ConnManService &service,
                                  const Common::Credentials::Requested &requested,
                                  Backend::RequestCredentialsFromUserReply &&reply) const;
 
+        void state_dump(StateDump &dump) const;
+
     private:
         struct Entry
         {
             ConnManService *service = nullptr;
             bool connecting = false;
-            Backend::ConnectFinished finished;
+            std::vector<Backend::ConnectFinished> finished;
             Backend::RequestCredentialsFromUser request_credentials;
+            ConnectTrace::Traces traces;
+        };
+
+        using Entries = std::deque<Entry>;
+
+        struct WaitingForOnline
+        {
+            ConnectTrace::Traces traces;
+            sigc::connection timeout_connection;
         };
 
-        std::deque<Entry> entries_;
+        void connect(Entry &entry);
+        static void finish(Entry &entry, Backend::ConnectResult result);
+
+        void depth_update() const;
+
+        void waiting_for_online_add(const ConnManService &service,
+                                    const ConnectTrace::Traces &traces);
+        void waiting_for_online_erase(const ConnManService &service);
+        void waiting_for_online_clear();
+
+        Entries::iterator find(const ConnManService &service);
+        Entries::const_iterator find(const ConnManService &service) const;
+
+        Entries entries_;
+        std::unordered_map<const ConnManService *, WaitingForOnline> traces_waiting_for_online_;
     };
 }
 
@@ -16,6 +16,12 @@ namespace ConnectivityManager::Daemon
     public:
         static constexpr char SERVICE_NAME[] = "net.connman";
         static constexpr char MANAGER_OBJECT_PATH[] = "/";
+
+        // See src/error.c in the ConnMan repo.
+        static constexpr char ERROR_ALREADY_CONNECTED[] = "net.connman.Error.AlreadyConnected";
+        static constexpr char ERROR_IN_PROGRESS[] = "net.connman.Error.InProgress";
+
+        static constexpr char AGENT_ERROR_CANCELED[] = "net.connman.Agent.Error.Canceled";
     };
 }
 
@@ -10,7 +10,13 @@
 
 #include <glibmm.h>
 
+#include <tuple>
+#include <vector>
+
 #include "daemon/backends/connman_dbus.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/metrics_registry.h"
+#include "daemon/tracepoints.h"
 
 namespace ConnectivityManager::Daemon
 {
@@ -50,6 +56,8 @@ namespace ConnectivityManager::Daemon
 
     void ConnManManager::name_owner_changed() const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::name_owner_changed");
+
         bool available = !proxy_->dbusProxy()->get_name_owner().empty();
 
         if (available) {
@@ -62,6 +70,8 @@ namespace ConnectivityManager::Daemon
 
     void ConnManManager::get_technologies_finish(const Glib::RefPtr<Gio::AsyncResult> &result) const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::get_technologies_finish");
+
         TechnologyPropertiesArray array;
 
         try {
@@ -79,16 +89,24 @@ namespace ConnectivityManager::Daemon
     void ConnManManager::technology_added(const Glib::DBusObjectPathString &path,
                                           const ConnManTechnology::PropertyMap &properties) const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::technology_added");
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
         listener_.manager_technology_add(path, properties);
     }
 
     void ConnManManager::technology_removed(const Glib::DBusObjectPathString &path) const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::technology_removed");
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
         listener_.manager_technology_remove(path);
     }
 
     void ConnManManager::get_services_finish(const Glib::RefPtr<Gio::AsyncResult> &result) const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::get_services_finish");
+
         ServicePropertiesArray array;
 
         try {
@@ -101,12 +119,21 @@ namespace ConnectivityManager::Daemon
         for (const auto &[path, properties] : array) {
             listener_.manager_service_add_or_change(path, properties);
         }
+
+        services_order(array);
     }
 
     void ConnManManager::services_changed(
         const ServicePropertiesArray &changed,
         const std::vector<Glib::DBusObjectPathString> &removed) const
     {
+        MainLoopMonitor::Scope scope("ConnManManager::services_changed");
+
+        // Args: number of changed services, number of removed services.
+        CONNECTIVITY_MANAGER_TRACE(
+            connman_manager_services_changed, changed.size(), removed.size());
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
         for (const auto &[path, properties] : changed) {
             listener_.manager_service_add_or_change(path, properties);
         }
@@ -114,6 +141,20 @@ namespace ConnectivityManager::Daemon
         for (const auto &path : removed) {
             listener_.manager_service_remove(path);
         }
+
+        services_order(changed);
+    }
+
+    void ConnManManager::services_order(const ServicePropertiesArray &array) const
+    {
+        std::vector<Glib::DBusObjectPathString> paths;
+        paths.reserve(array.size());
+
+        for (const auto &path_and_properties : array) {
+            paths.emplace_back(std::get<0>(path_and_properties));
+        }
+
+        listener_.manager_services_order(paths);
     }
 
     void ConnManManager::register_agent(const ConnManAgent &agent)
@@ -127,14 +168,16 @@ namespace ConnectivityManager::Daemon
     void ConnManManager::register_agent_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
     {
         bool success = false;
+        Glib::ustring error_message;
 
         try {
             proxy_->RegisterAgent_finish(result);
             success = true;
         } catch (const Glib::Error &error) {
-            g_warning("Failed to register agent with ConnMan Manager: %s", error.what().c_str());
+            error_message = error.what();
+            g_warning("Failed to register agent with ConnMan Manager: %s", error_message.c_str());
         }
 
-        listener_.manager_register_agent_result(success);
+        listener_.manager_register_agent_result(success, error_message);
     }
 }
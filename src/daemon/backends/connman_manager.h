@@ -34,6 +34,11 @@ namespace ConnectivityManager::Daemon
 
         explicit ConnManManager(Listener &listener);
 
+        bool available() const
+        {
+            return proxy_ && !proxy_->dbusProxy()->get_name_owner().empty();
+        }
+
         Glib::RefPtr<Gio::DBus::Connection> dbus_connection() const
         {
             return proxy_->dbusProxy()->get_connection();
@@ -61,6 +66,7 @@ namespace ConnectivityManager::Daemon
         void get_services_finish(const Glib::RefPtr<Gio::AsyncResult> &result) const;
         void services_changed(const ServicePropertiesArray &changed,
                               const std::vector<Glib::DBusObjectPathString> &removed) const;
+        void services_order(const ServicePropertiesArray &array) const;
 
         void register_agent_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
 
@@ -84,7 +90,13 @@ namespace ConnectivityManager::Daemon
     // manager_service_remove() will be called when ConnMan adds/removes technologies and services
     // (+ changes services in some cases, see doc/manager-api.txt).
     //
-    // manager_register_agent_result() will be called when result of register_agent() is returned.
+    // manager_services_order() is called after services have been added/changed/removed with paths
+    // of all services in the order ConnMan prefers them. GetServices() and the ServicesChanged
+    // signal list all services in this order (services that have not changed, but may have moved,
+    // are included with empty property dictionaries) so it is passed on as is without sorting.
+    //
+    // manager_register_agent_result() will be called when result of register_agent() is returned,
+    // error is the D-Bus error message if not successful.
     class ConnManManager::Listener
     {
     public:
@@ -101,8 +113,10 @@ namespace ConnectivityManager::Daemon
             const Glib::DBusObjectPathString &path,
             const ConnManService::PropertyMap &properties) = 0;
         virtual void manager_service_remove(const Glib::DBusObjectPathString &path) = 0;
+        virtual void manager_services_order(
+            const std::vector<Glib::DBusObjectPathString> &paths) = 0;
 
-        virtual void manager_register_agent_result(bool success) = 0;
+        virtual void manager_register_agent_result(bool success, const Glib::ustring &error) = 0;
     };
 }
 
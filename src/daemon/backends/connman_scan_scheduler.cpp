@@ -0,0 +1,201 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/backends/connman_scan_scheduler.h"
+
+#include <glib.h>
+#include <glibmm.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <utility>
+
+namespace ConnectivityManager::Daemon
+{
+    ConnManScanScheduler::ConnManScanScheduler(Listener &listener) : listener_(listener)
+    {
+    }
+
+    ConnManScanScheduler::~ConnManScanScheduler()
+    {
+        timer_connection_.disconnect();
+    }
+
+    void ConnManScanScheduler::count(std::uint64_t &counter,
+                                     MetricsRegistry::Counter metrics_counter)
+    {
+        counter++;
+        MetricsRegistry::instance().add(metrics_counter);
+    }
+
+    ConnManScanScheduler::Seconds ConnManScanScheduler::interval_next(bool connected,
+                                                                      bool strength_stable,
+                                                                      Seconds previous)
+    {
+        if (!connected) {
+            return FAST_INTERVAL;
+        }
+
+        if (!strength_stable || previous < CONNECTED_MIN_INTERVAL) {
+            return CONNECTED_MIN_INTERVAL;
+        }
+
+        return std::min(previous * 2, MAX_INTERVAL);
+    }
+
+    void ConnManScanScheduler::set_enabled(bool enabled)
+    {
+        if (enabled_ == enabled) {
+            return;
+        }
+
+        enabled_ = enabled;
+
+        if (!enabled_) {
+            timer_connection_.disconnect();
+            return;
+        }
+
+        interval_ = interval_next(connected_, false, FAST_INTERVAL);
+
+        if (!in_flight_) {
+            scan_start();
+        }
+    }
+
+    void ConnManScanScheduler::set_connection(bool connected,
+                                              Backend::WiFiAccessPoint::Strength strength)
+    {
+        bool connected_changed = connected_ != connected;
+
+        connected_ = connected;
+        strength_ = strength;
+
+        if (!connected_changed) {
+            return;
+        }
+
+        scanned_while_connected_ = false;
+        interval_ = interval_next(connected_, false, FAST_INTERVAL);
+
+        if (enabled_ && !in_flight_) {
+            timer_start(interval_);
+        }
+    }
+
+    void ConnManScanScheduler::request(Backend::ScanFinished &&finished)
+    {
+        count(counters_.requested, MetricsRegistry::Counter::WIFI_SCANS_REQUESTED);
+
+        if (!enabled_) {
+            finished(false, 0);
+            return;
+        }
+
+        waiting_.emplace_back(std::move(finished));
+
+        if (in_flight_) {
+            count(counters_.coalesced, MetricsRegistry::Counter::WIFI_SCANS_COALESCED);
+            return;
+        }
+
+        scan_start();
+    }
+
+    void ConnManScanScheduler::scan_finished(bool success)
+    {
+        if (!in_flight_) {
+            return;
+        }
+
+        in_flight_ = false;
+
+        gint64 duration_us = g_get_monotonic_time() - in_flight_start_us_;
+        auto duration_ms = static_cast<std::uint32_t>(duration_us / 1000);
+
+        if (!success) {
+            count(counters_.failed, MetricsRegistry::Counter::WIFI_SCANS_FAILED);
+        }
+
+        bool strength_stable =
+            scanned_while_connected_ &&
+            std::abs(static_cast<int>(strength_) - static_cast<int>(strength_at_last_scan_)) <=
+                STRENGTH_STABLE_THRESHOLD;
+
+        scanned_while_connected_ = connected_;
+        strength_at_last_scan_ = strength_;
+        interval_ = interval_next(connected_, strength_stable, interval_);
+
+        g_debug("Wi-Fi scan %s in %" PRIu32 " ms, next in %lld s (%" PRIu64 " requested, %" PRIu64
+                " coalesced, %" PRIu64 " issued, %" PRIu64 " failed)",
+                success ? "finished" : "failed",
+                duration_ms,
+                static_cast<long long>(interval_.count()),
+                counters_.requested,
+                counters_.coalesced,
+                counters_.issued,
+                counters_.failed);
+
+        if (enabled_) {
+            timer_start(interval_);
+        }
+
+        finish_all(success, duration_ms);
+
+        listener_.scan_scheduler_scan_finished(success, duration_ms);
+    }
+
+    void ConnManScanScheduler::reset()
+    {
+        timer_connection_.disconnect();
+
+        enabled_ = false;
+        connected_ = false;
+        scanned_while_connected_ = false;
+        in_flight_ = false;
+        interval_ = FAST_INTERVAL;
+
+        finish_all(false, 0);
+    }
+
+    void ConnManScanScheduler::scan_start()
+    {
+        timer_connection_.disconnect();
+
+        in_flight_ = true;
+        in_flight_start_us_ = g_get_monotonic_time();
+        count(counters_.issued, MetricsRegistry::Counter::WIFI_SCANS_ISSUED);
+
+        listener_.scan_scheduler_scan();
+    }
+
+    void ConnManScanScheduler::timer_start(Seconds interval)
+    {
+        timer_connection_.disconnect();
+
+        timer_connection_ = Glib::signal_timeout().connect_seconds(
+            [this] {
+                if (!in_flight_) {
+                    scan_start();
+                }
+                return false;
+            },
+            static_cast<unsigned int>(interval.count()));
+    }
+
+    void ConnManScanScheduler::finish_all(bool success, std::uint32_t duration_ms)
+    {
+        std::vector<Backend::ScanFinished> waiting = std::move(waiting_);
+        waiting_.clear();
+
+        for (Backend::ScanFinished &finished : waiting) {
+            finished(success, duration_ms);
+        }
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SCAN_SCHEDULER_H
+#define CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SCAN_SCHEDULER_H
+
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "daemon/backend.h"
+#include "daemon/metrics_registry.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Schedules Wi-Fi scans for ConnManBackend.
+    //
+    // Periodic scans are done while enabled (Wi-Fi technology powered). Interval depends on
+    // connection status, see interval_next():
+    //
+    // - Not connected: Scan every FAST_INTERVAL to find networks to connect to quickly.
+    //
+    // - Connected: Start at CONNECTED_MIN_INTERVAL and double the interval (up to MAX_INTERVAL)
+    //   for each scan where the strength of the connected access point has not changed more than
+    //   STRENGTH_STABLE_THRESHOLD since the previous scan, i.e. when probably stationary. Reset to
+    //   CONNECTED_MIN_INTERVAL when strength changes more than that.
+    //
+    // At most one scan is in flight at a time. Scans requested with request() while a scan is in
+    // flight are coalesced into it and finished when it finishes. A requested scan does not wait
+    // for the periodic timer. The timer is restarted when a scan finishes.
+    //
+    // Counters are kept per scheduler (counters()) and added to the WIFI_SCANS_* counters in
+    // MetricsRegistry.
+    //
+    // Listener::scan_scheduler_scan() is called when a scan should be issued and scan_finished()
+    // must be called with the result. reset() must be called if the result will never arrive (e.g.
+    // the technology was removed).
+    class ConnManScanScheduler
+    {
+    public:
+        using Seconds = std::chrono::seconds;
+
+        static constexpr Seconds FAST_INTERVAL{10};
+        static constexpr Seconds CONNECTED_MIN_INTERVAL{30};
+        static constexpr Seconds MAX_INTERVAL{300};
+        static constexpr Backend::WiFiAccessPoint::Strength STRENGTH_STABLE_THRESHOLD = 10;
+
+        struct Counters
+        {
+            std::uint64_t requested = 0; // Requested with request().
+            std::uint64_t coalesced = 0; // Requests that joined a scan already in flight.
+            std::uint64_t issued = 0;    // Scans actually issued to ConnMan.
+            std::uint64_t failed = 0;    // Issued scans that failed.
+        };
+
+        class Listener;
+
+        explicit ConnManScanScheduler(Listener &listener);
+        ~ConnManScanScheduler();
+
+        ConnManScanScheduler(const ConnManScanScheduler &other) = delete;
+        ConnManScanScheduler(ConnManScanScheduler &&other) = delete;
+        ConnManScanScheduler &operator=(const ConnManScanScheduler &other) = delete;
+        ConnManScanScheduler &operator=(ConnManScanScheduler &&other) = delete;
+
+        static Seconds interval_next(bool connected, bool strength_stable, Seconds previous);
+
+        void set_enabled(bool enabled);
+        void set_connection(bool connected, Backend::WiFiAccessPoint::Strength strength);
+
+        void request(Backend::ScanFinished &&finished);
+        void scan_finished(bool success);
+        void reset();
+
+        const Counters &counters() const
+        {
+            return counters_;
+        }
+
+        // Interval used for the next periodic scan and if it is scheduled, mainly for tests.
+        Seconds interval() const
+        {
+            return interval_;
+        }
+
+        bool timer_pending() const
+        {
+            return timer_connection_.connected();
+        }
+
+    private:
+        static void count(std::uint64_t &counter, MetricsRegistry::Counter metrics_counter);
+
+        void scan_start();
+        void timer_start(Seconds interval);
+        void finish_all(bool success, std::uint32_t duration_ms);
+
+        Listener &listener_;
+
+        bool enabled_ = false;
+
+        bool connected_ = false;
+        Backend::WiFiAccessPoint::Strength strength_ = 0;
+        bool scanned_while_connected_ = false;
+        Backend::WiFiAccessPoint::Strength strength_at_last_scan_ = 0;
+
+        bool in_flight_ = false;
+        gint64 in_flight_start_us_ = 0;
+        std::vector<Backend::ScanFinished> waiting_;
+
+        Seconds interval_ = FAST_INTERVAL;
+        sigc::connection timer_connection_;
+
+        Counters counters_;
+    };
+
+    // Listener for scan scheduler events.
+    //
+    // scan_scheduler_scan() is called when a scan should be issued. scan_scheduler_scan_finished()
+    // is called for all finished scans, both periodic and requested.
+    class ConnManScanScheduler::Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        virtual void scan_scheduler_scan() = 0;
+        virtual void scan_scheduler_scan_finished(bool success, std::uint32_t duration_ms) = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SCAN_SCHEDULER_H
@@ -17,12 +17,16 @@
 #include <utility>
 
 #include "daemon/backends/connman_dbus.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/metrics_registry.h"
+#include "daemon/tracepoints.h"
 
 namespace ConnectivityManager::Daemon
 {
     namespace
     {
         constexpr char PROPERTY_NAME_TYPE[] = "Type";
+        constexpr char PROPERTY_NAME_AUTO_CONNECT[] = "AutoConnect";
         constexpr char PROPERTY_NAME_NAME[] = "Name";
         constexpr char PROPERTY_NAME_SECURITY[] = "Security";
         constexpr char PROPERTY_NAME_STATE[] = "State";
@@ -154,6 +158,27 @@ namespace ConnectivityManager::Daemon
             return ConnManService::State::IDLE;
         }
 
+        const char *state_to_string(ConnManService::State state)
+        {
+            switch (state) {
+            case ConnManService::State::IDLE:
+                return STATE_STR_IDLE;
+            case ConnManService::State::FAILURE:
+                return STATE_STR_FAILURE;
+            case ConnManService::State::ASSOCIATION:
+                return STATE_STR_ASSOCIATION;
+            case ConnManService::State::CONFIGURATION:
+                return STATE_STR_CONFIGURATION;
+            case ConnManService::State::READY:
+                return STATE_STR_READY;
+            case ConnManService::State::DISCONNECT:
+                return STATE_STR_DISCONNECT;
+            case ConnManService::State::ONLINE:
+                return STATE_STR_ONLINE;
+            }
+            return "unknown";
+        }
+
         std::optional<ConnManService::State> state_from_string(
             const std::optional<Glib::ustring> &str)
         {
@@ -182,7 +207,10 @@ namespace ConnectivityManager::Daemon
                                             const Glib::ustring &name)
         {
             try {
-                return Glib::VariantBase::cast_dynamic<Glib::Variant<T>>(variant).get();
+                T value = Glib::VariantBase::cast_dynamic<Glib::Variant<T>>(variant).get();
+                MetricsRegistry::instance().add(
+                    MetricsRegistry::Counter::CONNMAN_PROPERTIES_DECODED);
+                return value;
             } catch (const std::bad_cast &) {
                 g_warning("Invalid type %s for ConnMan service property \"%s\"",
                           variant.get_type_string().c_str(),
@@ -217,7 +245,11 @@ namespace ConnectivityManager::Daemon
                                                                         PROPERTY_NAME_STATE,
                                                                         STATE_STR_IDLE))),
         strength_(strength_from_uint8(
-            value_from_property_map<std::uint8_t>(properties, PROPERTY_NAME_STRENGTH, 0)))
+            value_from_property_map<std::uint8_t>(properties, PROPERTY_NAME_STRENGTH, 0))),
+        auto_connect_(*this,
+                      PropertyId::AUTO_CONNECT,
+                      PROPERTY_NAME_AUTO_CONNECT,
+                      value_from_property_map<bool>(properties, PROPERTY_NAME_AUTO_CONNECT, false))
     {
         Proxy::createForBus(Gio::DBus::BUS_TYPE_SYSTEM,
                             Gio::DBus::PROXY_FLAGS_NONE,
@@ -226,13 +258,32 @@ namespace ConnectivityManager::Daemon
                             sigc::mem_fun(*this, &ConnManService::proxy_create_finish));
     }
 
-    ConnManService::~ConnManService() = default;
+    ConnManService::~ConnManService()
+    {
+        connect_in_progress_timeout_connection_.disconnect();
+    }
 
     Glib::ustring ConnManService::log_id_str() const
     {
         return Glib::ustring("ConnMan service \"") + name_ + "\" (" + type_to_string(type_) + ")";
     }
 
+    void ConnManService::state_dump(StateDump &dump) const
+    {
+        dump.value("type", type_to_string(type_));
+        dump.value("name", name_);
+        dump.value("security", security_to_string(security_));
+        dump.value("state", state_to_string(state_));
+        dump.value("strength", strength_);
+        dump.value("auto_connect", auto_connect());
+        dump.value("proxy_created", proxy_created());
+        dump.value("connect_in_progress_waiting", connect_in_progress_waiting_);
+
+        dump.object_begin("settable_properties");
+        auto_connect_.state_dump(dump);
+        dump.object_end();
+    }
+
     void ConnManService::proxy_create_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
     {
         try {
@@ -244,7 +295,12 @@ namespace ConnectivityManager::Daemon
         }
 
         proxy_->PropertyChanged_signal.connect(
-            sigc::mem_fun(*this, &ConnManService::property_changed));
+            [this](const Glib::ustring &property_name, const Glib::VariantBase &value) {
+                MainLoopMonitor::Scope scope("ConnManService::property_changed");
+
+                MetricsRegistry::instance().add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
+                property_changed(property_name, value);
+            });
 
         listener_.service_proxy_created(*this);
     }
@@ -259,6 +315,12 @@ namespace ConnectivityManager::Daemon
     void ConnManService::property_changed(const Glib::ustring &property_name,
                                           const Glib::VariantBase &value)
     {
+        // Args: service id, service name, property name.
+        CONNECTIVITY_MANAGER_TRACE(connman_service_property_changed,
+                                   static_cast<const void *>(this),
+                                   name_.c_str(),
+                                   property_name.c_str());
+
         auto changed = [this](auto &property, PropertyId id, auto received) {
             if (!received || property == *received) {
                 return;
@@ -284,12 +346,16 @@ namespace ConnectivityManager::Daemon
             changed(state_,
                     PropertyId::STATE,
                     state_from_string(value_from_variant<Glib::ustring>(value, property_name)));
+            connect_in_progress_wait_check();
 
         } else if (property_name == PROPERTY_NAME_STRENGTH) {
             changed(strength_,
                     PropertyId::STRENGTH,
                     strength_from_uint8(value_from_variant<std::uint8_t>(value, property_name)));
 
+        } else if (property_name == PROPERTY_NAME_AUTO_CONNECT) {
+            auto_connect_.changed(value_from_variant<bool>(value, property_name));
+
         } else if (property_name == PROPERTY_NAME_TYPE) {
             g_warning("Assumed to be constant property \"%s\" changed for %s",
                       property_name.c_str(),
@@ -300,6 +366,13 @@ namespace ConnectivityManager::Daemon
         }
     }
 
+    void ConnManService::settable_property_changed(PropertyId id)
+    {
+        if (proxy_) {
+            listener_.service_property_changed(*this, id);
+        }
+    }
+
     Backend::WiFiSecurity ConnManService::security_to_wifi_security() const
     {
         for (const Glib::ustring &str : security_) {
@@ -317,36 +390,99 @@ namespace ConnectivityManager::Daemon
         return Backend::WiFiSecurity::NONE;
     }
 
-    void ConnManService::connect()
+    bool ConnManService::auto_connect() const
     {
-        constexpr int TIMEOUT_MS = 5 * 60 * 1000;
+        return auto_connect_.value();
+    }
 
-        proxy_->Connect(sigc::mem_fun(*this, &ConnManService::connect_finish), {}, TIMEOUT_MS);
+    void ConnManService::connect()
+    {
+        proxy_->Connect(
+            sigc::mem_fun(*this, &ConnManService::connect_finish), {}, CONNECT_TIMEOUT_MS);
     }
 
     void ConnManService::connect_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
     {
+        MainLoopMonitor::Scope scope("ConnManService::connect_finish");
+
         bool success = false;
 
         try {
             proxy_->Connect_finish(result);
             success = true;
         } catch (const Glib::Error &e) {
-            // TODO: Need to do some extra checking here.
-            //
-            // - net.connman.Error.AlreadyConnected is returned if already connected. Should
-            //   probably not see that as an error...? Set success to true if this error occurs...?
-            //
-            // - net.connman.Error.InProgress is returned connecting is in progress. See as error?
-            //   Unreasonable to wait for state to change, I think. Perhaps "connecting" needs to be
-            //   propagated upwards so e.g. UI can choose to not connect to a "service" that is
-            //   already "connecting". Still potential for race condition though... should only
-            //   occur if source other than UI connects service and UI tries to connect at the same
-            //   time... so perhaps this particular ConnMan error should just be reported as a
-            //   "Connect() failed" (KISS).
-            g_warning("Failed to connect %s: %s", log_id_str().c_str(), e.what().c_str());
+            Glib::ustring error_name = Gio::DBus::ErrorUtils::get_remote_error(e);
+
+            if (error_name == ConnManDBus::ERROR_ALREADY_CONNECTED) {
+                g_info("Connect %s: already connected", log_id_str().c_str());
+                success = true;
+
+            } else if (error_name == ConnManDBus::ERROR_IN_PROGRESS) {
+                g_info("Connect %s: already in progress, waiting for state change",
+                       log_id_str().c_str());
+                connect_in_progress_wait_start();
+                return;
+
+            } else if (e.matches(G_IO_ERROR, G_IO_ERROR_TIMED_OUT)) {
+                g_warning("Timed out connecting %s, disconnecting", log_id_str().c_str());
+                disconnect();
+
+            } else {
+                g_warning("Failed to connect %s: %s", log_id_str().c_str(), e.what().c_str());
+            }
+        }
+
+        listener_.service_connect_finished(*this, success);
+    }
+
+    void ConnManService::connect_in_progress_wait_start()
+    {
+        connect_in_progress_waiting_ = true;
+
+        // A connect canceled while waiting leaves the timeout connected, restart it.
+        connect_in_progress_timeout_connection_.disconnect();
+        connect_in_progress_timeout_connection_ = Glib::signal_timeout().connect_seconds(
+            [this] {
+                g_warning("Timed out waiting for connect in progress for %s", log_id_str().c_str());
+                connect_in_progress_wait_finish(false);
+                return false;
+            },
+            CONNECT_TIMEOUT_S);
+
+        // The other attempt may have finished while waiting for reply to Connect(). Do not treat
+        // a not connected state as failure here, state change may not have been received yet.
+        if (state_to_connected()) {
+            connect_in_progress_wait_finish(true);
+        }
+    }
+
+    void ConnManService::connect_in_progress_wait_check()
+    {
+        if (!connect_in_progress_waiting_) {
+            return;
         }
 
+        switch (state_) {
+        case State::READY:
+        case State::ONLINE:
+            connect_in_progress_wait_finish(true);
+            break;
+        case State::FAILURE:
+        case State::IDLE:
+        case State::DISCONNECT:
+            connect_in_progress_wait_finish(false);
+            break;
+        case State::ASSOCIATION:
+        case State::CONFIGURATION:
+            break;
+        }
+    }
+
+    void ConnManService::connect_in_progress_wait_finish(bool success)
+    {
+        connect_in_progress_waiting_ = false;
+        connect_in_progress_timeout_connection_.disconnect();
+
         listener_.service_connect_finished(*this, success);
     }
 
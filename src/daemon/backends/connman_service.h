@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "daemon/backend.h"
+#include "daemon/backends/connman_settable_property.h"
+#include "daemon/state_dump.h"
 #include "generated/dbus/connman_proxy.h"
 
 namespace ConnectivityManager::Daemon
@@ -28,13 +30,8 @@ namespace ConnectivityManager::Daemon
     //
     // ConnMan does not use the standard org.freedesktop.DBus.Properties interface. The D-Bus
     // generator can not generate setters, getters and signals for ConnMan's custom properties
-    // interface so it must be handled manually.
-    //
-    // Note: At the moment there is no need for setting service properties. If this changes,
-    // something similar to what is done in ConnManTechnology::SettableProperty has to be done.
-    // Perhaps easiest to copy ConnManTechnology::SettableProperty to ConnManService. A bit of code
-    // repetition but proxy type, id enum etc. are different and making SettableProperty generic
-    // probably adds more complexity than it is worth... ?
+    // interface so it must be handled manually. Trivial for read-only properties but more
+    // complicated for read/write properties. See ConnManSettableProperty.
     class ConnManService : public sigc::trackable
     {
     public:
@@ -42,6 +39,16 @@ namespace ConnectivityManager::Daemon
         using Security = std::vector<Glib::ustring>;
         using Strength = std::uint8_t;
 
+        // Timeout for a connect attempt. Covers ConnMan asking the agent for input (ConnMan's
+        // default InputRequestTimeout is 120 s) and the connect itself.
+        //
+        // Used for the Connect() call, on timeout the service is disconnected so that ConnMan does
+        // not continue an attempt that has been reported failed. Also used when waiting for an
+        // attempt already in progress (see Listener), counted from when ConnMan replied with
+        // InProgress, since that attempt may be waiting for input as well.
+        static constexpr unsigned int CONNECT_TIMEOUT_S = 3 * 60;
+        static constexpr int CONNECT_TIMEOUT_MS = static_cast<int>(CONNECT_TIMEOUT_S) * 1000;
+
         enum class Type
         {
             UNKNOWN,
@@ -64,6 +71,7 @@ namespace ConnectivityManager::Daemon
 
         enum class PropertyId
         {
+            AUTO_CONNECT,
             NAME,
             SECURITY,
             STATE,
@@ -116,12 +124,20 @@ namespace ConnectivityManager::Daemon
             return strength_;
         }
 
+        // Read-only, ConnMan's AutoConnect is tracked but never set by the daemon.
+        bool auto_connect() const;
+
         void connect();
         void disconnect();
 
+        void state_dump(StateDump &dump) const;
+
     private:
         using Proxy = net::connman::ServiceProxy;
 
+        template <typename Owner, typename V>
+        friend class ConnManSettableProperty;
+
         Glib::ustring log_id_str() const;
 
         void proxy_create_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
@@ -129,8 +145,13 @@ namespace ConnectivityManager::Daemon
         void property_changed(const Glib::ustring &property_name, const Glib::VariantBase &value);
 
         void connect_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
+        void connect_in_progress_wait_start();
+        void connect_in_progress_wait_check();
+        void connect_in_progress_wait_finish(bool success);
         void disconnect_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
 
+        void settable_property_changed(PropertyId id);
+
         Listener &listener_;
         Glib::RefPtr<Proxy> proxy_;
 
@@ -140,6 +161,11 @@ namespace ConnectivityManager::Daemon
         Security security_;
         State state_ = State::IDLE;
         Strength strength_ = 0;
+
+        ConnManSettableProperty<ConnManService, bool> auto_connect_;
+
+        bool connect_in_progress_waiting_ = false;
+        sigc::connection connect_in_progress_timeout_connection_;
     };
 
     // Listener for service events.
@@ -156,6 +182,17 @@ namespace ConnectivityManager::Daemon
     // proxy has not been created.
     //
     // service_connect_finished() will be called when result of Connect() is returned from ConnMan.
+    // Errors from ConnMan are classified:
+    //
+    // - net.connman.Error.AlreadyConnected: Success.
+    //
+    // - net.connman.Error.InProgress: Someone else (e.g. ConnMan's auto connect or another client)
+    //   is connecting the service. Joins that attempt and finishes when state reaches ready/online
+    //   (success) or failure/idle/disconnect (failure), or after CONNECT_TIMEOUT_S (failure).
+    //
+    // - No reply within CONNECT_TIMEOUT_MS: Failure, service is disconnected.
+    //
+    // - Anything else: Failure.
     class ConnManService::Listener
     {
     public:
@@ -0,0 +1,326 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SETTABLE_PROPERTY_H
+#define CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SETTABLE_PROPERTY_H
+
+#include <giomm.h>
+#include <glib.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "daemon/metrics_registry.h"
+#include "daemon/state_dump.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Helper for ConnMan properties that are settable. Used by ConnManTechnology and
+    // ConnManService. The daemon does not set any service property (AutoConnect is only tracked),
+    // for services only the handling of received values is used.
+    //
+    // Needed since ConnMan does not use the org.freedesktop.DBus.Properties interface.
+    //
+    // Local value is changed immediately when set (Owner::settable_property_changed() is called).
+    // If ConnMan reports that setting the value failed, local value is reverted to the last known
+    // value received from ConnMan (Owner::settable_property_changed() is called again).
+    //
+    // Up to MAX_IN_FLIGHT SetProperty() calls are sent without waiting for the result of the
+    // previous ones. Replies are not necessarily received in the order calls were sent, ConnMan
+    // defers the reply for e.g. Powered and Tethering until the change is done and may reply to a
+    // later call (e.g. with InProgress) first. Each call is therefore given a sequence number that
+    // is bound to its reply callback and the reply completes that call. A successful reply only
+    // updates the last known value if no later call has succeeded already. If MAX_IN_FLIGHT calls
+    // are in flight when a value is set, it is queued. Setting again replaces the queued value
+    // (coalescing), intermediate values are never sent to ConnMan. If the value set is equal to
+    // the last value in flight, the queued value is dropped.
+    //
+    // If a value is received from ConnMan it is used directly if nothing is in flight or queued.
+    // Otherwise it is applied when all calls have finished. The received value may be due to our
+    // own set call so "property changed" is only signalled if value() actually changed.
+    //
+    // An optional SetFinished callback can be passed to set(). It is called with the result of the
+    // SetProperty() call that sends the value, or with true directly if the value is already set
+    // and nothing is in flight. If the value is dropped or replaced while queued, it is called
+    // with false. Callbacks not yet called when the property is destroyed are dropped.
+    //
+    // Setting fails directly (SetFinished called with false, value unchanged) if Owner has no
+    // D-Bus proxy yet.
+    //
+    // Latency (time from SetProperty() being sent to reply received) is recorded in
+    // MetricsRegistry::Latency::SET_PROPERTY. Per property statistics are logged with g_debug()
+    // and included in the owner's state dump through state_dump().
+    //
+    // Owner must have (can be private if ConnManSettableProperty is a friend):
+    //
+    // - PropertyId enum.
+    // - Glib::RefPtr<> proxy_ with SetProperty() and SetProperty_finish().
+    // - Glib::ustring log_id_str() const.
+    // - void settable_property_changed(PropertyId id).
+    template <typename Owner, typename V>
+    class ConnManSettableProperty : public sigc::trackable
+    {
+    public:
+        using PropertyId = typename Owner::PropertyId;
+
+        static constexpr std::size_t MAX_IN_FLIGHT = 2;
+
+        using SetFinished = std::function<void(bool success)>;
+
+        ConnManSettableProperty(Owner &owner,
+                                PropertyId id,
+                                const Glib::ustring &name,
+                                const V &initial_value) :
+            owner_(owner),
+            id_(id),
+            name_(name),
+            value_(initial_value)
+        {
+        }
+
+        const V &value() const
+        {
+            if (queued_) {
+                return *queued_;
+            }
+
+            if (last_in_flight_pending()) {
+                return in_flight_.back().value;
+            }
+
+            return value_;
+        }
+
+        void state_dump(StateDump &dump) const
+        {
+            dump.object_begin(name_.c_str());
+            dump.value("in_flight", static_cast<std::uint64_t>(in_flight_.size()));
+            dump.value("queued", queued_ ? true : false);
+            dump.value("set_count", stats_.count);
+            dump.value("set_failures", stats_.failures);
+            dump.value("set_last_us", stats_.last_us);
+            dump.value("set_max_us", stats_.max_us);
+            dump.object_end();
+        }
+
+        void set(const V &new_value, SetFinished &&finished = {})
+        {
+            if (!owner_.proxy_) {
+                g_warning("Can not set property \"%s\" for %s, no D-Bus proxy",
+                          name_.c_str(),
+                          owner_.log_id_str().c_str());
+                if (finished) {
+                    finished(false);
+                }
+                return;
+            }
+
+            if (value() == new_value) {
+                set_finished_add(std::move(finished));
+                return;
+            }
+
+            std::vector<SetFinished> dropped;
+
+            if (in_flight_.size() < MAX_IN_FLIGHT) {
+                set_property(new_value);
+            } else if (in_flight_.back().value == new_value) {
+                queued_.reset();
+                dropped = std::exchange(queued_finished_, {});
+            } else {
+                queued_ = new_value;
+                dropped = std::exchange(queued_finished_, {});
+            }
+
+            set_finished_add(std::move(finished));
+
+            owner_.settable_property_changed(id_);
+
+            for (const auto &callback : dropped) {
+                callback(false);
+            }
+        }
+
+        void changed(std::optional<V> received)
+        {
+            if (!received) {
+                return;
+            }
+
+            if (!in_flight_.empty() || queued_) {
+                received_ = std::move(*received);
+            } else if (value_ != *received) {
+                value_ = std::move(*received);
+                owner_.settable_property_changed(id_);
+            }
+        }
+
+    private:
+        struct Stats
+        {
+            std::uint64_t count = 0;
+            std::uint64_t failures = 0;
+            std::int64_t last_us = 0;
+            std::int64_t max_us = 0;
+            std::int64_t total_us = 0;
+        };
+
+        struct InFlight
+        {
+            std::uint64_t sequence;
+            V value;
+            std::int64_t start_us;
+            std::vector<SetFinished> finished;
+        };
+
+        // False if nothing is in flight or if a later call has succeeded already (replies out of
+        // order), value_ is then newer than the value of the last call in flight.
+        bool last_in_flight_pending() const
+        {
+            return !in_flight_.empty() && in_flight_.back().sequence > sequence_last_succeeded_;
+        }
+
+        // Adds callback to whatever carries value(): the queued value, the last value in flight or
+        // (if nothing pending carries it) the current value, in which case it is called directly.
+        void set_finished_add(SetFinished &&finished)
+        {
+            if (!finished) {
+                return;
+            }
+
+            if (queued_) {
+                queued_finished_.push_back(std::move(finished));
+            } else if (last_in_flight_pending()) {
+                in_flight_.back().finished.push_back(std::move(finished));
+            } else {
+                finished(true);
+            }
+        }
+
+        void set_property(const V &value)
+        {
+            std::uint64_t sequence = ++sequence_last_sent_;
+
+            in_flight_.push_back({sequence, value, g_get_monotonic_time(), {}});
+
+            owner_.proxy_->SetProperty(
+                name_,
+                Glib::Variant<V>::create(value),
+                sigc::bind(sigc::mem_fun(*this, &ConnManSettableProperty::set_property_finish),
+                           sequence));
+        }
+
+        void set_property_finish(const Glib::RefPtr<Gio::AsyncResult> &result,
+                                 std::uint64_t sequence)
+        {
+            auto i = std::find_if(in_flight_.begin(), in_flight_.end(), [&](const InFlight &call) {
+                return call.sequence == sequence;
+            });
+
+            if (i == in_flight_.end()) {
+                g_warning("Unexpected reply when setting property \"%s\" for %s",
+                          name_.c_str(),
+                          owner_.log_id_str().c_str());
+                return;
+            }
+
+            const V value_before = value();
+            InFlight finished = std::move(*i);
+            in_flight_.erase(i);
+
+            bool success = false;
+
+            try {
+                owner_.proxy_->SetProperty_finish(result);
+                success = true;
+            } catch (const Glib::Error &e) {
+                g_warning("Failed to set property \"%s\" for %s: %s",
+                          name_.c_str(),
+                          owner_.log_id_str().c_str(),
+                          e.what().c_str());
+            }
+
+            stats_update(finished.start_us, success);
+
+            if (success && finished.sequence > sequence_last_succeeded_) {
+                value_ = std::move(finished.value);
+                sequence_last_succeeded_ = finished.sequence;
+            }
+
+            if (queued_ && in_flight_.size() < MAX_IN_FLIGHT) {
+                V queued = std::move(*queued_);
+                queued_.reset();
+                set_property(queued);
+                in_flight_.back().finished = std::exchange(queued_finished_, {});
+            }
+
+            if (in_flight_.empty() && received_) {
+                value_ = std::move(*received_);
+                received_.reset();
+            }
+
+            if (value() != value_before) {
+                owner_.settable_property_changed(id_);
+            }
+
+            // Last since callbacks may set the property again.
+            for (const auto &callback : finished.finished) {
+                callback(success);
+            }
+        }
+
+        void stats_update(std::int64_t start_us, bool success)
+        {
+            std::int64_t latency_us = g_get_monotonic_time() - start_us;
+
+            stats_.count++;
+            stats_.failures += success ? 0 : 1;
+            stats_.last_us = latency_us;
+            stats_.max_us = std::max(stats_.max_us, latency_us);
+            stats_.total_us += latency_us;
+
+            MetricsRegistry::instance().add(MetricsRegistry::Latency::SET_PROPERTY,
+                                            static_cast<std::uint64_t>(latency_us));
+
+            g_debug("Set property \"%s\" for %s in %" PRId64 " us (max %" PRId64
+                    " us, average %" PRId64 " us, %" PRIu64 " calls, %" PRIu64 " failed)",
+                    name_.c_str(),
+                    owner_.log_id_str().c_str(),
+                    latency_us,
+                    stats_.max_us,
+                    stats_.total_us / static_cast<std::int64_t>(stats_.count),
+                    stats_.count,
+                    stats_.failures);
+        }
+
+        Owner &owner_;
+        const PropertyId id_;
+        const Glib::ustring name_;
+
+        V value_;
+        std::deque<InFlight> in_flight_; // In order sent, replies may complete any of them.
+        std::uint64_t sequence_last_sent_ = 0;
+        std::uint64_t sequence_last_succeeded_ = 0;
+        std::optional<V> queued_;
+        std::vector<SetFinished> queued_finished_;
+        std::optional<V> received_;
+
+        Stats stats_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_BACKENDS_CONNMAN_SETTABLE_PROPERTY_H
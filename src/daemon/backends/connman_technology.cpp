@@ -15,6 +15,8 @@
 #include <utility>
 
 #include "daemon/backends/connman_dbus.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/metrics_registry.h"
 
 namespace ConnectivityManager::Daemon
 {
@@ -72,7 +74,10 @@ namespace ConnectivityManager::Daemon
                                             const Glib::ustring &name)
         {
             try {
-                return Glib::VariantBase::cast_dynamic<Glib::Variant<T>>(variant).get();
+                T value = Glib::VariantBase::cast_dynamic<Glib::Variant<T>>(variant).get();
+                MetricsRegistry::instance().add(
+                    MetricsRegistry::Counter::CONNMAN_PROPERTIES_DECODED);
+                return value;
             } catch (const std::bad_cast &) {
                 g_warning("Invalid type %s for ConnMan technology property \"%s\"",
                           variant.get_type_string().c_str(),
@@ -103,18 +108,26 @@ namespace ConnectivityManager::Daemon
             value_from_property_map<Glib::ustring>(properties, PROPERTY_NAME_TYPE, ""))),
         name_(value_from_property_map<Glib::ustring>(properties, PROPERTY_NAME_NAME, "")),
         connected_(value_from_property_map<bool>(properties, PROPERTY_NAME_CONNECTED, false)),
-        powered_(*this, PropertyId::POWERED, PROPERTY_NAME_POWERED, properties, false),
-        tethering_(*this, PropertyId::TETHERING, PROPERTY_NAME_TETHERING, properties, false),
+        tethering_active_(
+            value_from_property_map<bool>(properties, PROPERTY_NAME_TETHERING, false)),
+        powered_(*this,
+                 PropertyId::POWERED,
+                 PROPERTY_NAME_POWERED,
+                 value_from_property_map<bool>(properties, PROPERTY_NAME_POWERED, false)),
+        tethering_(*this,
+                   PropertyId::TETHERING,
+                   PROPERTY_NAME_TETHERING,
+                   value_from_property_map<bool>(properties, PROPERTY_NAME_TETHERING, false)),
         tethering_identifier_(*this,
                               PropertyId::TETHERING_IDENTIFIER,
                               PROPERTY_NAME_TETHERING_IDENTIFIER,
-                              properties,
-                              ""),
+                              value_from_property_map<Glib::ustring>(
+                                  properties, PROPERTY_NAME_TETHERING_IDENTIFIER, "")),
         tethering_passphrase_(*this,
                               PropertyId::TETHERING_PASSPHRASE,
                               PROPERTY_NAME_TETHERING_PASSPHRASE,
-                              properties,
-                              "")
+                              value_from_property_map<Glib::ustring>(
+                                  properties, PROPERTY_NAME_TETHERING_PASSPHRASE, ""))
     {
         Proxy::createForBus(Gio::DBus::BUS_TYPE_SYSTEM,
                             Gio::DBus::PROXY_FLAGS_NONE,
@@ -131,6 +144,25 @@ namespace ConnectivityManager::Daemon
         return Glib::ustring("ConnMan technology \"") + name_ + "\" (" + type_str + ")";
     }
 
+    void ConnManTechnology::state_dump(StateDump &dump) const
+    {
+        dump.value("type", type_to_string(type_));
+        dump.value("name", name_);
+        dump.value("connected", connected_);
+        dump.value("powered", powered());
+        dump.value("tethering", tethering());
+        dump.value("tethering_active", tethering_active_);
+        dump.value("tethering_identifier", tethering_identifier());
+        dump.value("proxy_created", proxy_ ? true : false);
+
+        dump.object_begin("settable_properties");
+        powered_.state_dump(dump);
+        tethering_.state_dump(dump);
+        tethering_identifier_.state_dump(dump);
+        tethering_passphrase_.state_dump(dump);
+        dump.object_end();
+    }
+
     void ConnManTechnology::proxy_create_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
     {
         try {
@@ -142,7 +174,12 @@ namespace ConnectivityManager::Daemon
         }
 
         proxy_->PropertyChanged_signal.connect(
-            sigc::mem_fun(*this, &ConnManTechnology::property_changed));
+            [this](const Glib::ustring &property_name, const Glib::VariantBase &value) {
+                MainLoopMonitor::Scope scope("ConnManTechnology::property_changed");
+
+                MetricsRegistry::instance().add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
+                property_changed(property_name, value);
+            });
 
         listener_.technology_proxy_created(*this);
     }
@@ -164,16 +201,18 @@ namespace ConnectivityManager::Daemon
                 connected_, PropertyId::CONNECTED, value_from_variant<bool>(value, property_name));
 
         } else if (property_name == PROPERTY_NAME_POWERED) {
-            powered_.changed(value);
+            powered_.changed(value_from_variant<bool>(value, property_name));
 
         } else if (property_name == PROPERTY_NAME_TETHERING) {
-            tethering_.changed(value);
+            auto received = value_from_variant<bool>(value, property_name);
+            tethering_.changed(received);
+            changed(tethering_active_, PropertyId::TETHERING_ACTIVE, received);
 
         } else if (property_name == PROPERTY_NAME_TETHERING_IDENTIFIER) {
-            tethering_identifier_.changed(value);
+            tethering_identifier_.changed(value_from_variant<Glib::ustring>(value, property_name));
 
         } else if (property_name == PROPERTY_NAME_TETHERING_PASSPHRASE) {
-            tethering_passphrase_.changed(value);
+            tethering_passphrase_.changed(value_from_variant<Glib::ustring>(value, property_name));
 
         } else if (property_name == PROPERTY_NAME_TYPE || property_name == PROPERTY_NAME_NAME) {
             g_warning("Assumed to be constant property \"%s\" changed for %s",
@@ -187,6 +226,11 @@ namespace ConnectivityManager::Daemon
         }
     }
 
+    void ConnManTechnology::settable_property_changed(PropertyId id)
+    {
+        listener_.technology_property_changed(*this, id);
+    }
+
     bool ConnManTechnology::powered() const
     {
         return powered_.value();
@@ -202,9 +246,9 @@ namespace ConnectivityManager::Daemon
         return tethering_.value();
     }
 
-    void ConnManTechnology::set_tethering(bool tethering)
+    void ConnManTechnology::set_tethering(bool tethering, SetFinished &&finished)
     {
-        tethering_.set(tethering);
+        tethering_.set(tethering, std::move(finished));
     }
 
     const Glib::ustring &ConnManTechnology::tethering_identifier() const
@@ -212,9 +256,10 @@ namespace ConnectivityManager::Daemon
         return tethering_identifier_.value();
     }
 
-    void ConnManTechnology::set_tethering_identifier(const Glib::ustring &identifier)
+    void ConnManTechnology::set_tethering_identifier(const Glib::ustring &identifier,
+                                                     SetFinished &&finished)
     {
-        tethering_identifier_.set(identifier);
+        tethering_identifier_.set(identifier, std::move(finished));
     }
 
     const Glib::ustring &ConnManTechnology::tethering_passphrase() const
@@ -222,136 +267,38 @@ namespace ConnectivityManager::Daemon
         return tethering_passphrase_.value();
     }
 
-    void ConnManTechnology::set_tethering_passphrase(const Glib::ustring &passphrase)
-    {
-        tethering_passphrase_.set(passphrase);
-    }
-
-    void ConnManTechnology::scan()
-    {
-        proxy_->Scan(sigc::mem_fun(*this, &ConnManTechnology::scan_finish));
-    }
-
-    void ConnManTechnology::scan_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
-    {
-        try {
-            proxy_->Scan_finish(result);
-        } catch (const Glib::Error &e) {
-            g_warning("Failed to scan %s: %s", log_id_str().c_str(), e.what().c_str());
-        }
-    }
-
-    template <typename V>
-    ConnManTechnology::SettableProperty<V>::SettableProperty(ConnManTechnology &technology,
-                                                             PropertyId id,
-                                                             const Glib::ustring &name,
-                                                             const PropertyMap &property_map,
-                                                             const V &default_value) :
-        technology_(technology),
-        id_(id),
-        name_(name),
-        value_(value_from_property_map<V>(property_map, name, default_value))
-    {
-    }
-
-    template <typename V>
-    const V &ConnManTechnology::SettableProperty<V>::value() const
-    {
-        if (queued_) {
-            return *queued_;
-        }
-
-        if (pending_) {
-            return *pending_;
-        }
-
-        return value_;
-    }
-
-    template <typename V>
-    void ConnManTechnology::SettableProperty<V>::set(const V &new_value)
+    void ConnManTechnology::set_tethering_passphrase(const Glib::ustring &passphrase,
+                                                     SetFinished &&finished)
     {
-        if (value() == new_value) {
-            return;
-        }
-
-        if (!pending_) {
-            pending_ = new_value;
-            set_property(*pending_);
-        } else {
-            queued_ = new_value;
-        }
-
-        technology_.listener_.technology_property_changed(technology_, id_);
+        tethering_passphrase_.set(passphrase, std::move(finished));
     }
 
-    template <typename V>
-    void ConnManTechnology::SettableProperty<V>::changed(const Glib::VariantBase &received_variant)
+    void ConnManTechnology::scan(ScanFinished &&finished)
     {
-        auto received = value_from_variant<V>(received_variant, name_);
-        if (!received) {
-            return;
-        }
+        constexpr int TIMEOUT_MS = 60 * 1000;
 
-        if (pending_) {
-            received_ = std::move(*received);
-        } else if (value_ != *received) {
-            value_ = std::move(*received);
-            technology_.listener_.technology_property_changed(technology_, id_);
-        }
+        proxy_->Scan(sigc::bind(sigc::mem_fun(*this, &ConnManTechnology::scan_finish),
+                                std::move(finished)),
+                     {},
+                     TIMEOUT_MS);
     }
 
-    template <typename V>
-    void ConnManTechnology::SettableProperty<V>::set_property(const V &value)
+    void ConnManTechnology::scan_finish(const Glib::RefPtr<Gio::AsyncResult> &result,
+                                        const ScanFinished &finished)
     {
-        technology_.proxy_->SetProperty(
-            name_,
-            Glib::Variant<V>::create(value),
-            sigc::mem_fun(*this, &ConnManTechnology::SettableProperty<V>::set_property_finish));
-    }
+        MainLoopMonitor::Scope scope("ConnManTechnology::scan_finish");
 
-    template <typename V>
-    void ConnManTechnology::SettableProperty<V>::set_property_finish(
-        const Glib::RefPtr<Gio::AsyncResult> &result)
-    {
         bool success = false;
 
         try {
-            technology_.proxy_->SetProperty_finish(result);
+            proxy_->Scan_finish(result);
             success = true;
         } catch (const Glib::Error &e) {
-            g_warning("Failed to set property \"%s\" for %s: %s)",
-                      name_.c_str(),
-                      technology_.log_id_str().c_str(),
-                      e.what().c_str());
-        }
-
-        if (success) {
-            value_ = std::move(*pending_);
-        }
-        pending_.reset();
-
-        if (queued_) {
-            pending_ = std::move(*queued_);
-            queued_.reset();
-            set_property(*pending_);
+            g_warning("Failed to scan %s: %s", log_id_str().c_str(), e.what().c_str());
         }
 
-        if (!pending_) {
-            bool signal_reverted_due_to_failure = !success;
-            bool changed_while_pending = false;
-
-            if (received_) {
-                if (value_ != *received_) {
-                    value_ = std::move(*received_);
-                    changed_while_pending = true;
-                }
-                received_.reset();
-            }
-
-            if (signal_reverted_due_to_failure || changed_while_pending) {
-                technology_.listener_.technology_property_changed(technology_, id_);
-            }
+        if (finished) {
+            finished(success);
         }
     }
 }
@@ -13,9 +13,11 @@
 #include <glibmm.h>
 #include <sigc++/sigc++.h>
 
+#include <functional>
 #include <map>
-#include <optional>
 
+#include "daemon/backends/connman_settable_property.h"
+#include "daemon/state_dump.h"
 #include "generated/dbus/connman_proxy.h"
 
 namespace ConnectivityManager::Daemon
@@ -27,11 +29,13 @@ namespace ConnectivityManager::Daemon
     // ConnMan does not use the standard org.freedesktop.DBus.Properties interface. The D-Bus
     // generator can not generate setters, getters and signals for ConnMan's custom properties
     // interface so it must be handled manually. Trivial for read-only properties but more
-    // complicated for read/write properties. See SettableProperty.
+    // complicated for read/write properties. See ConnManSettableProperty.
     class ConnManTechnology : public sigc::trackable
     {
     public:
         using PropertyMap = std::map<Glib::ustring, Glib::VariantBase>;
+        using ScanFinished = std::function<void(bool success)>;
+        using SetFinished = std::function<void(bool success)>;
 
         enum class Type
         {
@@ -47,6 +51,7 @@ namespace ConnectivityManager::Daemon
             CONNECTED,
             POWERED,
             TETHERING,
+            TETHERING_ACTIVE,
             TETHERING_IDENTIFIER,
             TETHERING_PASSPHRASE
         };
@@ -77,69 +82,32 @@ namespace ConnectivityManager::Daemon
         void set_powered(bool powered);
 
         bool tethering() const;
-        void set_tethering(bool tethering);
+        void set_tethering(bool tethering, SetFinished &&finished = {});
+
+        // Tethering as last reported by ConnMan. Unlike tethering(), not changed when set, so can
+        // be used to know when ConnMan has actually brought tethering up or down.
+        bool tethering_active() const
+        {
+            return tethering_active_;
+        }
 
         const Glib::ustring &tethering_identifier() const;
-        void set_tethering_identifier(const Glib::ustring &identifier);
+        void set_tethering_identifier(const Glib::ustring &identifier,
+                                      SetFinished &&finished = {});
 
         const Glib::ustring &tethering_passphrase() const;
-        void set_tethering_passphrase(const Glib::ustring &passphrase);
+        void set_tethering_passphrase(const Glib::ustring &passphrase,
+                                      SetFinished &&finished = {});
+
+        void scan(ScanFinished &&finished);
 
-        void scan();
+        void state_dump(StateDump &dump) const;
 
     private:
         using Proxy = net::connman::TechnologyProxy;
 
-        // Helper for properties that are settable.
-        //
-        // Needed since ConnMan does not use the org.freedesktop.DBus.Properties interface.
-        //
-        // Local value is changed immediately when set (Listener::technology_property_changed() is
-        // called). If ConnMan reports that setting the value failed, local value is reverted to the
-        // last known value received from ConnMan (Listener::technology_property_changed() is called
-        // again).
-        //
-        // If setting a value in ConnMan is already pending, the new value is queued to be set when
-        // result of pending set is received. If a value has been queued and a set is performed
-        // again, the old queued value will be discarded and never sent to ConnMan. If this turns
-        // out to be a problem, a real queue has to be added.
-        //
-        // If a value is received from ConnMan, it is updated directly "property changed" is
-        // signalled if there is no pending set. If a set is pending, the value is updated when the
-        // set is finished if there is no other value queued. The received value may be due to our
-        // own set call so "property changed" is only signalled internally if the value is different
-        // since otherwise it has already been done for that particular value.
-        //
-        // TODO: Can the logic be simplified? Should be possible to implement current behavior
-        //       without three std::optional:s. Try and see if it simplifies code.
-        // TODO: Add temporary extensive logging and make sure behavior is correct.
-        template <typename V>
-        struct SettableProperty : public sigc::trackable
-        {
-        public:
-            SettableProperty(ConnManTechnology &technology,
-                             PropertyId id,
-                             const Glib::ustring &name,
-                             const PropertyMap &property_map,
-                             const V &default_value);
-
-            const V &value() const;
-            void set(const V &new_value);
-            void changed(const Glib::VariantBase &received_variant);
-
-        private:
-            void set_property(const V &value);
-            void set_property_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
-
-            ConnManTechnology &technology_;
-            const PropertyId id_;
-            const Glib::ustring name_;
-
-            V value_;
-            std::optional<V> pending_;
-            std::optional<V> queued_;
-            std::optional<V> received_;
-        };
+        template <typename Owner, typename V>
+        friend class ConnManSettableProperty;
 
         Glib::ustring log_id_str() const;
 
@@ -147,7 +115,10 @@ namespace ConnectivityManager::Daemon
 
         void property_changed(const Glib::ustring &property_name, const Glib::VariantBase &value);
 
-        void scan_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
+        void scan_finish(const Glib::RefPtr<Gio::AsyncResult> &result,
+                         const ScanFinished &finished);
+
+        void settable_property_changed(PropertyId id);
 
         Listener &listener_;
         Glib::RefPtr<Proxy> proxy_;
@@ -155,12 +126,13 @@ namespace ConnectivityManager::Daemon
         const Type type_ = Type::UNKNOWN;
         const Glib::ustring name_;
         bool connected_ = false;
+        bool tethering_active_ = false;
 
-        SettableProperty<bool> powered_;
+        ConnManSettableProperty<ConnManTechnology, bool> powered_;
 
-        SettableProperty<bool> tethering_;
-        SettableProperty<Glib::ustring> tethering_identifier_;
-        SettableProperty<Glib::ustring> tethering_passphrase_;
+        ConnManSettableProperty<ConnManTechnology, bool> tethering_;
+        ConnManSettableProperty<ConnManTechnology, Glib::ustring> tethering_identifier_;
+        ConnManSettableProperty<ConnManTechnology, Glib::ustring> tethering_passphrase_;
     };
 
     // Listener for technology events.
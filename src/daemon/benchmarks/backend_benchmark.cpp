@@ -0,0 +1,100 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "daemon/backend.h"
+#include "daemon/benchmarks/fake_backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using AccessPoint = Backend::WiFiAccessPoint;
+
+        // Connects listeners slots to access_points_changed, each doing as little as possible, to
+        // measure cost of the sigc fan-out separately from the listeners.
+        void listeners_connect(FakeBackend &backend, std::int64_t listeners)
+        {
+            for (std::int64_t i = 0; i < listeners; i++) {
+                backend.signals().wifi.access_points_changed.connect(
+                    [](AccessPoint::Event event, const AccessPoint *access_point) {
+                        benchmark::DoNotOptimize(event);
+                        benchmark::DoNotOptimize(access_point);
+                    });
+            }
+        }
+
+        // Arguments: Access points, listeners.
+        void backend_access_point_add_remove(benchmark::State &state)
+        {
+            FakeBackend backend;
+            backend.access_points_reset(static_cast<std::uint64_t>(state.range(0)));
+            listeners_connect(backend, state.range(1));
+
+            for (auto _ : state) {
+                AccessPoint access_point = backend.access_point_create();
+                AccessPoint::Id id = access_point.id;
+
+                backend.wifi_access_point_add(std::move(access_point));
+                backend.wifi_access_point_remove(*backend.wifi_access_point_find(id));
+            }
+
+            state.SetItemsProcessed(state.iterations() * 2);
+        }
+
+        // Arguments: Access points, listeners.
+        void backend_access_point_strength_set(benchmark::State &state)
+        {
+            FakeBackend backend;
+            backend.access_points_reset(static_cast<std::uint64_t>(state.range(0)));
+            listeners_connect(backend, state.range(1));
+
+            AccessPoint *access_point = backend.wifi_access_point_find(1);
+            AccessPoint::Strength strength = 0;
+
+            for (auto _ : state) {
+                strength = strength == 100 ? 0 : strength + 1;
+                backend.wifi_access_point_strength_set(*access_point, strength);
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+
+        // Arguments: Access points, listeners.
+        void backend_access_points_add_all(benchmark::State &state)
+        {
+            FakeBackend backend;
+            listeners_connect(backend, state.range(1));
+
+            for (auto _ : state) {
+                backend.access_points_reset(static_cast<std::uint64_t>(state.range(0)));
+            }
+
+            state.SetItemsProcessed(state.iterations() * state.range(0));
+        }
+
+        void backend_arguments(benchmark::internal::Benchmark *benchmark)
+        {
+            for (std::int64_t access_points : {10, 100, 1000}) {
+                for (std::int64_t listeners : {0, 1, 4, 16}) {
+                    benchmark->Args({access_points, listeners});
+                }
+            }
+
+            benchmark->ArgNames({"access_points", "listeners"});
+        }
+    }
+
+    BENCHMARK(backend_access_point_add_remove)->Apply(backend_arguments);
+    BENCHMARK(backend_access_point_strength_set)->Apply(backend_arguments);
+    BENCHMARK(backend_access_points_add_all)->Apply(backend_arguments);
+}
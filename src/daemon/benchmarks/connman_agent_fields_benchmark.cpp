@@ -0,0 +1,122 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+#include <glibmm.h>
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "common/credentials.h"
+#include "daemon/backends/connman_agent_fields.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Arguments = std::map<Glib::ustring, Glib::VariantBase>;
+        using Credentials = Common::Credentials;
+        using Fields = ConnManAgentFields::Fields;
+        using Password = Credentials::Password;
+
+        Glib::VariantBase field(const Glib::ustring &type,
+                                const Glib::ustring &requirement,
+                                const std::optional<Glib::ustring> &value = {})
+        {
+            Arguments arguments = {
+                {"Type", Glib::Variant<Glib::ustring>::create(type)},
+                {"Requirement", Glib::Variant<Glib::ustring>::create(requirement)}};
+
+            if (value) {
+                arguments.emplace("Value", Glib::Variant<Glib::ustring>::create(*value));
+            }
+
+            return Glib::Variant<Arguments>::create(arguments);
+        }
+
+        // Combinations of fields sent by ConnMan in RequestInput(), see doc/agent-api.txt in the
+        // ConnMan repo. Indexed by benchmark argument.
+        struct Scenario
+        {
+            const char *name;
+            Fields fields;
+            Credentials credentials; // Reply from user.
+        };
+
+        std::vector<Scenario> scenarios_create()
+        {
+            Credentials psk;
+            psk.password = Password{Password::Type::WPA_PSK, "passphrase"};
+
+            Credentials hidden = psk;
+            hidden.ssid = "hidden";
+
+            Credentials eap;
+            eap.username = "username";
+            eap.password = Password{Password::Type::PASSPHRASE, "password"};
+
+            return {
+                {"psk", {{"Passphrase", field("psk", "mandatory")}}, psk},
+                {"psk-previous",
+                 {{"Passphrase", field("psk", "mandatory")},
+                  {"PreviousPassphrase", field("psk", "informational", "previous")}},
+                 psk},
+                {"psk-wps",
+                 {{"Passphrase", field("psk", "mandatory")}, {"WPS", field("wpspin", "alternate")}},
+                 psk},
+                {"hidden-psk",
+                 {{"Name", field("string", "mandatory")},
+                  {"SSID", field("ssid", "alternate")},
+                  {"Passphrase", field("psk", "mandatory")}},
+                 hidden},
+                {"eap",
+                 {{"Identity", field("string", "mandatory")},
+                  {"Passphrase", field("passphrase", "mandatory")}},
+                 eap}};
+        }
+
+        const Scenario &scenario(const benchmark::State &state)
+        {
+            static const std::vector<Scenario> scenarios = scenarios_create();
+            return scenarios.at(static_cast<std::size_t>(state.range(0)));
+        }
+
+        // Arguments: Scenario.
+        void connman_agent_fields_to_credentials(benchmark::State &state)
+        {
+            const Scenario &s = scenario(state);
+            state.SetLabel(s.name);
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(
+                    ConnManAgentFields::received_fields_to_credentials(s.fields));
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+
+        // Arguments: Scenario.
+        void connman_agent_credentials_to_reply_fields(benchmark::State &state)
+        {
+            const Scenario &s = scenario(state);
+            state.SetLabel(s.name);
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(
+                    ConnManAgentFields::credentials_to_reply_fields(s.credentials, s.fields));
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+    }
+
+    BENCHMARK(connman_agent_fields_to_credentials)->DenseRange(0, 4);
+    BENCHMARK(connman_agent_credentials_to_reply_fields)->DenseRange(0, 4);
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+#include <glibmm.h>
+
+#include "common/credentials.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Credentials = Common::Credentials;
+        using Password = Credentials::Password;
+
+        // All values set, the most work for both directions.
+        Credentials credentials_create()
+        {
+            Credentials credentials;
+            credentials.ssid = "hidden";
+            credentials.username = "username";
+            credentials.password = Password{Password::Type::WPA_PSK, "passphrase"};
+            credentials.password_alternative = Password{Password::Type::WPS_PIN, "12345670"};
+            return credentials;
+        }
+
+        void credentials_to_dbus_value(benchmark::State &state)
+        {
+            Credentials credentials = credentials_create();
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(Credentials::to_dbus_value(credentials));
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+
+        void credentials_from_dbus_value(benchmark::State &state)
+        {
+            Credentials::DBusValue dbus_value = Credentials::to_dbus_value(credentials_create());
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(Credentials::from_dbus_value(dbus_value));
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+    }
+
+    BENCHMARK(credentials_to_dbus_value);
+    BENCHMARK(credentials_from_dbus_value);
+}
@@ -0,0 +1,194 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/dbus.h"
+#include "daemon/arguments.h"
+#include "daemon/backend.h"
+#include "daemon/benchmarks/fake_backend.h"
+#include "daemon/dbus_service.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // DBusService with a FakeBackend, owning its name on the system bus. main() points the system
+    // bus at the session bus, "meson benchmark" runs the benchmarks on a private one. ready() is
+    // false if there is no bus or the name could not be acquired.
+    class DBusServiceHarness
+    {
+    public:
+        static constexpr unsigned int NAME_TIMEOUT_MS = 5 * 1000;
+
+        DBusServiceHarness(std::uint64_t access_points,
+                           Arguments::WiFiAccessPointsOrder order) :
+            main_loop_(Glib::MainLoop::create()),
+            dbus_service_(main_loop_, backend_, order)
+        {
+            backend_.access_points_reset(access_points);
+
+            if (Glib::getenv("DBUS_SYSTEM_BUS_ADDRESS").empty()) {
+                return;
+            }
+
+            dbus_service_.own_name();
+            ready_ = name_wait();
+        }
+
+        DBusServiceHarness(const DBusServiceHarness &other) = delete;
+        DBusServiceHarness(DBusServiceHarness &&other) = delete;
+        DBusServiceHarness &operator=(const DBusServiceHarness &other) = delete;
+        DBusServiceHarness &operator=(DBusServiceHarness &&other) = delete;
+
+        bool ready() const
+        {
+            return ready_;
+        }
+
+        FakeBackend &backend()
+        {
+            return backend_;
+        }
+
+        std::vector<Glib::DBusObjectPathString> wifi_access_point_paths_sorted() const
+        {
+            return dbus_service_.wifi_access_point_paths_sorted();
+        }
+
+    private:
+        bool name_wait()
+        {
+            std::optional<bool> appeared;
+
+            guint watch_id = Gio::DBus::watch_name(
+                Gio::DBus::BUS_TYPE_SYSTEM,
+                Common::DBus::MANAGER_SERVICE_NAME,
+                [&appeared](const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                            const Glib::ustring & /*name*/,
+                            const Glib::ustring & /*name_owner*/) { appeared = true; });
+
+            sigc::connection timeout = Glib::signal_timeout().connect(
+                [&appeared] {
+                    appeared = false;
+                    return false;
+                },
+                NAME_TIMEOUT_MS);
+
+            while (!appeared) {
+                main_loop_->get_context()->iteration(true);
+            }
+
+            timeout.disconnect();
+            Gio::DBus::unwatch_name(watch_id);
+
+            return *appeared;
+        }
+
+        Glib::RefPtr<Glib::MainLoop> main_loop_;
+        FakeBackend backend_;
+        DBusService dbus_service_;
+        bool ready_ = false;
+    };
+
+    namespace
+    {
+        using AccessPoint = Backend::WiFiAccessPoint;
+
+        Arguments::WiFiAccessPointsOrder order_argument(const benchmark::State &state)
+        {
+            return state.range(1) == 0 ? Arguments::WiFiAccessPointsOrder::ID :
+                                         Arguments::WiFiAccessPointsOrder::BACKEND;
+        }
+
+        // Backend change through BackendSignalHandler to a PropertiesChanged signal being sent.
+        //
+        // Arguments: Access points, order (0 = ID, 1 = BACKEND).
+        void dbus_service_access_point_strength_set(benchmark::State &state)
+        {
+            DBusServiceHarness harness(static_cast<std::uint64_t>(state.range(0)),
+                                       order_argument(state));
+            if (!harness.ready()) {
+                state.SkipWithError("No bus or failed to acquire name");
+                return;
+            }
+
+            AccessPoint *access_point = harness.backend().wifi_access_point_find(1);
+            AccessPoint::Strength strength = 0;
+
+            for (auto _ : state) {
+                strength = strength == 100 ? 0 : strength + 1;
+                harness.backend().wifi_access_point_strength_set(*access_point, strength);
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+
+        // Object creation and registration plus update of the WiFiAccessPoints property.
+        //
+        // Arguments: Access points, order (0 = ID, 1 = BACKEND).
+        void dbus_service_access_point_add_remove(benchmark::State &state)
+        {
+            DBusServiceHarness harness(static_cast<std::uint64_t>(state.range(0)),
+                                       order_argument(state));
+            if (!harness.ready()) {
+                state.SkipWithError("No bus or failed to acquire name");
+                return;
+            }
+
+            FakeBackend &backend = harness.backend();
+
+            for (auto _ : state) {
+                AccessPoint access_point = backend.access_point_create();
+                AccessPoint::Id id = access_point.id;
+
+                backend.wifi_access_point_add(std::move(access_point));
+                backend.wifi_access_point_remove(*backend.wifi_access_point_find(id));
+            }
+
+            state.SetItemsProcessed(state.iterations() * 2);
+        }
+
+        // Arguments: Access points, order (0 = ID, 1 = BACKEND).
+        void dbus_service_wifi_access_point_paths_sorted(benchmark::State &state)
+        {
+            DBusServiceHarness harness(static_cast<std::uint64_t>(state.range(0)),
+                                       order_argument(state));
+            if (!harness.ready()) {
+                state.SkipWithError("No bus or failed to acquire name");
+                return;
+            }
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(harness.wifi_access_point_paths_sorted());
+            }
+
+            state.SetItemsProcessed(state.iterations() * state.range(0));
+        }
+
+        void dbus_service_arguments(benchmark::internal::Benchmark *benchmark)
+        {
+            for (std::int64_t access_points : {10, 100, 1000}) {
+                for (std::int64_t order : {0, 1}) {
+                    benchmark->Args({access_points, order});
+                }
+            }
+
+            benchmark->ArgNames({"access_points", "order"});
+        }
+    }
+
+    BENCHMARK(dbus_service_access_point_strength_set)->Apply(dbus_service_arguments);
+    BENCHMARK(dbus_service_access_point_add_remove)->Apply(dbus_service_arguments);
+    BENCHMARK(dbus_service_wifi_access_point_paths_sorted)->Apply(dbus_service_arguments);
+}
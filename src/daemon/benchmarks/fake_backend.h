@@ -0,0 +1,145 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_BENCHMARKS_FAKE_BACKEND_H
+#define CONNECTIVITY_MANAGER_DAEMON_BENCHMARKS_FAKE_BACKEND_H
+
+#include <glibmm.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "daemon/backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Backend without an actual backend behind it. Makes the protected state setters public so
+    // benchmarks can drive Backend state changes, and the signals they emit, directly.
+    class FakeBackend : public Backend
+    {
+    public:
+        FakeBackend() = default;
+
+        FakeBackend(const FakeBackend &other) = delete;
+        FakeBackend(FakeBackend &&other) = delete;
+        FakeBackend &operator=(const FakeBackend &other) = delete;
+        FakeBackend &operator=(FakeBackend &&other) = delete;
+
+        using Backend::wifi_access_point_add;
+        using Backend::wifi_access_point_connected_set;
+        using Backend::wifi_access_point_find;
+        using Backend::wifi_access_point_next_id;
+        using Backend::wifi_access_point_remove;
+        using Backend::wifi_access_point_security_set;
+        using Backend::wifi_access_point_ssid_set;
+        using Backend::wifi_access_point_strength_set;
+        using Backend::wifi_access_points_add_all;
+        using Backend::wifi_access_points_order_set;
+        using Backend::wifi_access_points_remove_all;
+        using Backend::wifi_status_set;
+
+        WiFiAccessPoint access_point_create()
+        {
+            WiFiAccessPoint access_point;
+            access_point.id = wifi_access_point_next_id();
+            access_point.ssid = "ap-" + std::to_string(access_point.id);
+            access_point.strength = static_cast<WiFiAccessPoint::Strength>(access_point.id % 101);
+            access_point.security = WiFiSecurity::WPA_PSK;
+            return access_point;
+        }
+
+        // Enables Wi-Fi and replaces all access points with count new ones. Order is set to
+        // reverse id order so it differs from the order of State::wifi::access_points.
+        void access_points_reset(std::uint64_t count)
+        {
+            wifi_status_set(WiFiStatus::ENABLED);
+
+            std::vector<WiFiAccessPoint> access_points;
+            std::vector<WiFiAccessPoint::Id> order;
+
+            for (std::uint64_t i = 0; i < count; i++) {
+                access_points.push_back(access_point_create());
+                order.insert(order.begin(), access_points.back().id);
+            }
+
+            wifi_access_points_add_all(std::move(access_points));
+            wifi_access_points_order_set(std::move(order));
+        }
+
+        void wifi_enable() override
+        {
+        }
+
+        void wifi_disable() override
+        {
+        }
+
+        void wifi_connect(const WiFiAccessPoint & /*access_point*/,
+                          ConnectFinished &&finished,
+                          RequestCredentialsFromUser && /*request_credentials*/,
+                          const std::shared_ptr<ConnectTrace> & /*trace*/) override
+        {
+            finished(ConnectResult::FAILED);
+        }
+
+        void wifi_connect_hidden(const std::string & /*ssid*/,
+                                 WiFiSecurity /*security*/,
+                                 ConnectFinished &&finished,
+                                 RequestCredentialsFromUser && /*request_credentials*/,
+                                 const std::shared_ptr<ConnectTrace> & /*trace*/) override
+        {
+            finished(ConnectResult::FAILED);
+        }
+
+        void wifi_connect_cancel(const WiFiAccessPoint & /*access_point*/) override
+        {
+        }
+
+        void wifi_connect_hidden_cancel(WiFiSecurity /*security*/) override
+        {
+        }
+
+        void wifi_disconnect(const WiFiAccessPoint & /*access_point*/) override
+        {
+        }
+
+        void wifi_scan(ScanFinished &&finished) override
+        {
+            finished(false, 0);
+        }
+
+        void wifi_hotspot_enable() override
+        {
+        }
+
+        void wifi_hotspot_disable() override
+        {
+        }
+
+        void wifi_hotspot_change_ssid(const std::string & /*ssid*/) override
+        {
+        }
+
+        void wifi_hotspot_change_passphrase(const Glib::ustring & /*passphrase*/) override
+        {
+        }
+
+        void wifi_hotspot_configure(const std::string & /*ssid*/,
+                                    const Glib::ustring & /*passphrase*/,
+                                    bool /*enabled*/,
+                                    WiFiHotspotConfigureFinished &&finished) override
+        {
+            finished(false);
+        }
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_BENCHMARKS_FAKE_BACKEND_H
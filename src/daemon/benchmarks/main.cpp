@@ -0,0 +1,44 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <clocale>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    std::setlocale(LC_ALL, "");
+
+    Glib::init();
+    Gio::init();
+
+    // DBusService uses the system bus, run it on the session bus (private one from
+    // dbus-run-session when run by "meson benchmark"). Benchmarks needing a bus are skipped if
+    // there is none.
+    std::string bus_address = Glib::getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (!bus_address.empty()) {
+        Glib::setenv("DBUS_SYSTEM_BUS_ADDRESS", bus_address);
+    } else {
+        Glib::unsetenv("DBUS_SYSTEM_BUS_ADDRESS");
+    }
+
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <benchmark/benchmark.h>
+#include <glibmm.h>
+
+#include "daemon/backend.h"
+#include "daemon/dbus_objects/wifi_access_point.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        Glib::DBusObjectPathString access_point_path(Backend::WiFiAccessPoint::Id id)
+        {
+            Backend::WiFiAccessPoint backend_ap;
+            backend_ap.id = id;
+
+            return Glib::DBusObjectPathString(WiFiAccessPoint(backend_ap).object_path());
+        }
+
+        void wifi_access_point_object_path_to_id(benchmark::State &state)
+        {
+            Glib::DBusObjectPathString path = access_point_path(123456);
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(WiFiAccessPoint::object_path_to_id(path));
+            }
+        }
+
+        void wifi_access_point_object_path_to_id_invalid(benchmark::State &state)
+        {
+            Glib::DBusObjectPathString path("/com/luxoft/ConnectivityManager/Other/1");
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(WiFiAccessPoint::object_path_to_id(path));
+            }
+        }
+
+        void wifi_access_point_object_path(benchmark::State &state)
+        {
+            Backend::WiFiAccessPoint backend_ap;
+            backend_ap.id = 123456;
+            WiFiAccessPoint access_point(backend_ap);
+
+            for (auto _ : state) {
+                benchmark::DoNotOptimize(access_point.object_path());
+            }
+        }
+    }
+
+    BENCHMARK(wifi_access_point_object_path_to_id);
+    BENCHMARK(wifi_access_point_object_path_to_id_invalid);
+    BENCHMARK(wifi_access_point_object_path);
+}
@@ -0,0 +1,150 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/connect_trace.h"
+
+#include <glib.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "daemon/metrics_registry.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        std::size_t stage_index(ConnectTrace::Stage stage)
+        {
+            return static_cast<std::size_t>(stage);
+        }
+    }
+
+    ConnectTrace::ConnectTrace(std::string target,
+                               std::shared_ptr<ConnectStageLatencies> latencies) :
+        target_(std::move(target)),
+        latencies_(std::move(latencies))
+    {
+        mark(Stage::RECEIVED);
+    }
+
+    ConnectTrace::~ConnectTrace()
+    {
+        std::string stages;
+
+        for (std::size_t i = 1; i < STAGE_COUNT; i++) {
+            auto stage = static_cast<Stage>(i);
+            auto latency = latency_us(stage);
+
+            if (!latency) {
+                continue;
+            }
+
+            if (latencies_) {
+                latencies_->add(stage, *latency);
+            }
+
+            stages += ' ';
+            stages += stage_to_string(stage);
+            stages += "_us=";
+            stages += std::to_string(*latency);
+        }
+
+        const char *result = !success_ ? "unknown" : *success_ ? "success" : "failure";
+
+        g_info("Connect trace: target=%s result=%s%s", target_.c_str(), result, stages.c_str());
+    }
+
+    const char *ConnectTrace::stage_to_string(Stage stage)
+    {
+        switch (stage) {
+        case Stage::RECEIVED:
+            return "received";
+        case Stage::QUEUED:
+            return "queued";
+        case Stage::AGENT_REGISTERED:
+            return "agent_registered";
+        case Stage::CONNECT_SENT:
+            return "connect_sent";
+        case Stage::INPUT_REQUESTED:
+            return "input_requested";
+        case Stage::INPUT_REPLIED:
+            return "input_replied";
+        case Stage::CONNECT_FINISHED:
+            return "connect_finished";
+        case Stage::READY:
+            return "ready";
+        case Stage::ONLINE:
+            return "online";
+        case Stage::COUNT:
+            break;
+        }
+        return "unknown";
+    }
+
+    void ConnectTrace::mark_all(const Traces &traces, Stage stage)
+    {
+        for (const auto &trace : traces) {
+            trace->mark(stage);
+        }
+    }
+
+    void ConnectTrace::set_result_all(const Traces &traces, bool success)
+    {
+        for (const auto &trace : traces) {
+            trace->set_result(success);
+        }
+    }
+
+    void ConnectTrace::mark(Stage stage)
+    {
+        auto &timestamp = timestamps_us_[stage_index(stage)];
+
+        if (!timestamp) {
+            timestamp = g_get_monotonic_time();
+        }
+    }
+
+    void ConnectTrace::set_result(bool success)
+    {
+        if (success_) {
+            return;
+        }
+
+        success_ = success;
+
+        if (const auto &received = timestamps_us_[stage_index(Stage::RECEIVED)]; received) {
+            MetricsRegistry::instance().add(
+                MetricsRegistry::Latency::CONNECT,
+                static_cast<std::uint64_t>(g_get_monotonic_time() - *received));
+        }
+    }
+
+    std::optional<std::uint64_t> ConnectTrace::latency_us(Stage stage) const
+    {
+        const auto &received = timestamps_us_[stage_index(Stage::RECEIVED)];
+        const auto &timestamp = timestamps_us_[stage_index(stage)];
+
+        if (!received || !timestamp) {
+            return {};
+        }
+
+        return static_cast<std::uint64_t>(*timestamp - *received);
+    }
+
+    void ConnectStageLatencies::add(ConnectTrace::Stage stage, std::uint64_t latency_us)
+    {
+        histograms_[stage_index(stage)].add(latency_us);
+    }
+
+    const Histogram &ConnectStageLatencies::histogram(ConnectTrace::Stage stage) const
+    {
+        return histograms_[stage_index(stage)];
+    }
+}
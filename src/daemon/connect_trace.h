@@ -0,0 +1,98 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_CONNECT_TRACE_H
+#define CONNECTIVITY_MANAGER_DAEMON_CONNECT_TRACE_H
+
+#include <glib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "daemon/histogram.h"
+
+namespace ConnectivityManager::Daemon
+{
+    class ConnectStageLatencies;
+
+    // Timestamps for the stages of a single connect request.
+    //
+    // Created when a connect request is received and passed along (as std::shared_ptr) to
+    // everything involved in connecting. Each stage is marked with mark() the first time it is
+    // reached. Not all stages are reached for every connect (e.g. no input is requested if
+    // credentials are already known by the backend).
+    //
+    // When the last reference is dropped, the latency from RECEIVED to each reached stage is added
+    // to ConnectStageLatencies and a structured log line with all stages is written (g_info()).
+    class ConnectTrace
+    {
+    public:
+        enum class Stage
+        {
+            RECEIVED,         // Connect request received from client.
+            QUEUED,           // Queued up in backend.
+            AGENT_REGISTERED, // Backend ready to connect (e.g. ConnMan agent registered).
+            CONNECT_SENT,     // Connect request sent to backend service (e.g. ConnMan).
+            INPUT_REQUESTED,  // Credentials requested from user.
+            INPUT_REPLIED,    // User replied to credentials request.
+            CONNECT_FINISHED, // Result of connect received from backend service.
+            READY,            // Connected.
+            ONLINE,           // Connected and online (internet access verified).
+
+            COUNT // Number of enumerators above, not a stage.
+        };
+
+        static constexpr auto STAGE_COUNT = static_cast<std::size_t>(Stage::COUNT);
+
+        using Traces = std::vector<std::shared_ptr<ConnectTrace>>;
+
+        ConnectTrace(std::string target, std::shared_ptr<ConnectStageLatencies> latencies);
+        ~ConnectTrace();
+
+        ConnectTrace(const ConnectTrace &other) = delete;
+        ConnectTrace(ConnectTrace &&other) = delete;
+        ConnectTrace &operator=(const ConnectTrace &other) = delete;
+        ConnectTrace &operator=(ConnectTrace &&other) = delete;
+
+        static const char *stage_to_string(Stage stage);
+
+        static void mark_all(const Traces &traces, Stage stage);
+        static void set_result_all(const Traces &traces, bool success);
+
+        void mark(Stage stage);
+        void set_result(bool success);
+
+        std::optional<std::uint64_t> latency_us(Stage stage) const;
+
+    private:
+        const std::string target_;
+        std::shared_ptr<ConnectStageLatencies> latencies_;
+
+        std::array<std::optional<gint64>, STAGE_COUNT> timestamps_us_;
+        std::optional<bool> success_;
+    };
+
+    // Histograms of latency (in microseconds) from ConnectTrace::Stage::RECEIVED to each stage.
+    class ConnectStageLatencies
+    {
+    public:
+        void add(ConnectTrace::Stage stage, std::uint64_t latency_us);
+
+        const Histogram &histogram(ConnectTrace::Stage stage) const;
+
+    private:
+        std::array<Histogram, ConnectTrace::STAGE_COUNT> histograms_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_CONNECT_TRACE_H
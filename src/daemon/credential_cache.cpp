@@ -0,0 +1,182 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/credential_cache.h"
+
+#include <glib.h>
+#include <glibmm.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace ConnectivityManager::Daemon
+{
+    CredentialCache::CredentialCache()
+    {
+        const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t size = MAX_ENTRIES * SLOT_SIZE;
+
+        memory_size_ = ((size + page_size - 1) / page_size) * page_size;
+
+        void *memory =
+            mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            g_warning("Failed to allocate memory for credential cache: %s", std::strerror(errno));
+            return;
+        }
+
+        if (mlock(memory, memory_size_) != 0) {
+            g_warning("Failed to lock memory for credential cache, cache disabled: %s",
+                      std::strerror(errno));
+            munmap(memory, memory_size_);
+            return;
+        }
+
+#ifdef MADV_DONTDUMP
+        madvise(memory, memory_size_, MADV_DONTDUMP);
+#endif
+
+        memory_ = static_cast<char *>(memory);
+    }
+
+    CredentialCache::~CredentialCache()
+    {
+        if (!memory_) {
+            return;
+        }
+
+        explicit_bzero(memory_, memory_size_);
+        munlock(memory_, memory_size_);
+        munmap(memory_, memory_size_);
+    }
+
+    std::size_t CredentialCache::size() const
+    {
+        std::size_t size = 0;
+
+        for (const auto &entry : entries_) {
+            size += entry ? 1 : 0;
+        }
+
+        return size;
+    }
+
+    std::optional<Common::Credentials::Password> CredentialCache::find(const Key &key)
+    {
+        auto index = index_of(key);
+        if (!index) {
+            return {};
+        }
+
+        Entry &entry = *entries_[*index];
+        if (!entry.valid) {
+            return {};
+        }
+
+        entry.last_used = ++use_counter_;
+
+        Common::Credentials::Password password;
+        password.type = entry.type;
+        password.value = std::string(slot(*index), entry.size);
+
+        return password;
+    }
+
+    void CredentialCache::store(const Key &key, const Common::Credentials::Password &password)
+    {
+        if (!memory_) {
+            return;
+        }
+
+        const std::string &value = password.value.raw();
+
+        if (value.empty() || value.size() > SLOT_SIZE) {
+            evict(key);
+            return;
+        }
+
+        std::size_t index = index_of(key).value_or(index_to_store_in());
+
+        if (entries_[index]) {
+            evict_index(index);
+        }
+
+        std::memcpy(slot(index), value.data(), value.size());
+
+        Entry &entry = entries_[index].emplace();
+        entry.key = key;
+        entry.type = password.type;
+        entry.size = value.size();
+        entry.last_used = ++use_counter_;
+    }
+
+    void CredentialCache::validate(const Key &key)
+    {
+        if (auto index = index_of(key); index) {
+            entries_[*index]->valid = true;
+        }
+    }
+
+    void CredentialCache::evict(const Key &key)
+    {
+        if (auto index = index_of(key); index) {
+            evict_index(*index);
+        }
+    }
+
+    void CredentialCache::clear()
+    {
+        for (std::size_t i = 0; i < MAX_ENTRIES; i++) {
+            if (entries_[i]) {
+                evict_index(i);
+            }
+        }
+    }
+
+    std::optional<std::size_t> CredentialCache::index_of(const Key &key) const
+    {
+        for (std::size_t i = 0; i < MAX_ENTRIES; i++) {
+            if (entries_[i] && entries_[i]->key == key) {
+                return i;
+            }
+        }
+
+        return {};
+    }
+
+    std::size_t CredentialCache::index_to_store_in() const
+    {
+        std::size_t least_recently_used = 0;
+
+        for (std::size_t i = 0; i < MAX_ENTRIES; i++) {
+            if (!entries_[i]) {
+                return i;
+            }
+
+            if (entries_[i]->last_used < entries_[least_recently_used]->last_used) {
+                least_recently_used = i;
+            }
+        }
+
+        return least_recently_used;
+    }
+
+    char *CredentialCache::slot(std::size_t index) const
+    {
+        return memory_ + index * SLOT_SIZE;
+    }
+
+    void CredentialCache::evict_index(std::size_t index)
+    {
+        explicit_bzero(slot(index), SLOT_SIZE);
+        entries_[index].reset();
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_CREDENTIAL_CACHE_H
+#define CONNECTIVITY_MANAGER_DAEMON_CREDENTIAL_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "common/credentials.h"
+#include "daemon/backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // In-memory cache of Wi-Fi passwords, keyed by SSID and security.
+    //
+    // Used by backends to answer repeated credential requests (e.g. ConnMan asking again for a
+    // passphrase it has already accepted) without a round trip to the user. Only enabled if
+    // requested on the command line (Arguments::cache_credentials).
+    //
+    // A password is stored when the user replies to a request but is not returned by find() until
+    // validate() has been called, i.e. until the backend has seen that the password works.
+    // evict() should be called if a cached password is rejected.
+    //
+    // Passwords are stored in a single mmap():ed area that is locked with mlock() (never swapped
+    // out) and excluded from core dumps. Slots are zeroed with explicit_bzero() when evicted and
+    // when the cache is destroyed. Least recently used entry is evicted when full. If locked
+    // memory can not be allocated, the cache is unavailable and nothing is stored.
+    //
+    // Note that the password is copied to regular heap memory when returned by find() (and when
+    // received from the user) since Common::Credentials uses Glib::ustring.
+    class CredentialCache
+    {
+    public:
+        static constexpr std::size_t MAX_ENTRIES = 16;
+        static constexpr std::size_t SLOT_SIZE = 256;
+
+        struct Key
+        {
+            std::string ssid;
+            Backend::WiFiSecurity security = Backend::WiFiSecurity::NONE;
+
+            bool operator==(const Key &other) const
+            {
+                return ssid == other.ssid && security == other.security;
+            }
+        };
+
+        CredentialCache();
+        ~CredentialCache();
+
+        CredentialCache(const CredentialCache &other) = delete;
+        CredentialCache(CredentialCache &&other) = delete;
+        CredentialCache &operator=(const CredentialCache &other) = delete;
+        CredentialCache &operator=(CredentialCache &&other) = delete;
+
+        bool available() const
+        {
+            return memory_ != nullptr;
+        }
+
+        std::size_t size() const;
+
+        std::optional<Common::Credentials::Password> find(const Key &key);
+
+        void store(const Key &key, const Common::Credentials::Password &password);
+        void validate(const Key &key);
+        void evict(const Key &key);
+        void clear();
+
+    private:
+        struct Entry
+        {
+            Key key;
+            Common::Credentials::Password::Type type{};
+            std::size_t size = 0;
+            bool valid = false;
+            std::uint64_t last_used = 0;
+        };
+
+        std::optional<std::size_t> index_of(const Key &key) const;
+        std::size_t index_to_store_in() const;
+        char *slot(std::size_t index) const;
+        void evict_index(std::size_t index);
+
+        char *memory_ = nullptr;
+        std::size_t memory_size_ = 0;
+
+        std::array<std::optional<Entry>, MAX_ENTRIES> entries_;
+        std::uint64_t use_counter_ = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_CREDENTIAL_CACHE_H
@@ -11,12 +11,21 @@
 #include <glib-unix.h>
 #include <glib.h>
 #include <glibmm.h>
+#include <malloc.h>
+#include <unistd.h>
 
 #include <cassert>
 #include <csignal>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
 #include <utility>
 
+#include "daemon/metrics_registry.h"
+#include "daemon/state_dump.h"
+
 namespace ConnectivityManager::Daemon
 {
     namespace
@@ -32,13 +41,52 @@ namespace ConnectivityManager::Daemon
             static_cast<Daemon *>(daemon)->reload_config();
             return G_SOURCE_CONTINUE;
         }
+
+        gboolean sigusr1_callback(void *daemon)
+        {
+            static_cast<Daemon *>(daemon)->dump_state();
+            return G_SOURCE_CONTINUE;
+        }
+
+        // Statistics from the allocator as XML, see malloc_info(3). Empty if not available.
+        std::string malloc_info_xml()
+        {
+#ifdef __GLIBC__
+            char *buffer = nullptr;
+            std::size_t size = 0;
+
+            FILE *stream = open_memstream(&buffer, &size);
+            if (!stream) {
+                return {};
+            }
+
+            malloc_info(0, stream);
+            std::fclose(stream);
+
+            std::string xml(buffer, size);
+            std::free(buffer);
+
+            return xml;
+#else
+            return {};
+#endif
+        }
     }
 
-    Daemon::Daemon(std::unique_ptr<Backend> &&backend) :
+    Daemon::Daemon(std::unique_ptr<Backend> &&backend, const Arguments &arguments) :
+        state_dump_path_(arguments.state_dump_path),
         backend_(std::move(backend)),
-        dbus_service_(main_loop_, *backend_)
+        dbus_service_(main_loop_, *backend_, arguments.wifi_access_points_order)
     {
         backend_->signals().critical_error.connect([&] { main_loop_->quit(); });
+
+        if (arguments.main_loop_stall_threshold_ms > 0) {
+            main_loop_monitor_.emplace(arguments.main_loop_stall_threshold_ms);
+        }
+
+        if (arguments.wifi_roaming) {
+            roaming_engine_.emplace(*backend_);
+        }
     }
 
     Daemon::~Daemon()
@@ -70,16 +118,84 @@ namespace ConnectivityManager::Daemon
     {
     }
 
+    void Daemon::dump_state()
+    {
+        if (state_dump_writing_) {
+            g_warning("Already writing state dump to %s, ignoring SIGUSR1",
+                      state_dump_path_.c_str());
+            return;
+        }
+
+        gint64 start_us = g_get_monotonic_time();
+
+        StateDump dump;
+
+        dump.value("pid", static_cast<std::int64_t>(getpid()));
+        dump.value("monotonic_time_us", start_us);
+        dump.value("real_time_us", g_get_real_time());
+
+        dump.object_begin("backend");
+        backend_->state_dump(dump);
+        dump.object_end();
+
+        dump.object_begin("dbus_service");
+        dbus_service_.state_dump(dump);
+        dump.object_end();
+
+        dump.object_begin("metrics");
+        MetricsRegistry::instance().state_dump(dump);
+        dump.object_end();
+
+        dump.value("malloc_info", malloc_info_xml());
+
+        dump.object_begin("main_loop");
+        dump.value("running", main_loop_->is_running());
+        if (main_loop_monitor_) {
+            main_loop_monitor_->state_dump(dump);
+        }
+        dump.value("dump_build_us", g_get_monotonic_time() - start_us);
+        dump.object_end();
+
+        std::string json = dump.finish();
+
+        state_dump_writing_ = true;
+
+        auto file = Gio::File::create_for_path(state_dump_path_);
+
+        file->replace_contents_bytes_async(
+            [this, file](const Glib::RefPtr<Gio::AsyncResult> &result) {
+                state_dump_writing_ = false;
+
+                try {
+                    file->replace_contents_finish(result);
+                } catch (const Glib::Error &e) {
+                    g_warning("Failed to write state dump to %s: %s",
+                              state_dump_path_.c_str(),
+                              e.what().c_str());
+                    return;
+                }
+
+                g_info("Wrote state dump to %s", state_dump_path_.c_str());
+            },
+            Glib::Bytes::create(json.data(), json.size()),
+            {},
+            false,
+            Gio::FILE_CREATE_PRIVATE);
+    }
+
     bool Daemon::register_signal_handlers()
     {
-        assert(sigint_source_id_ == 0 && sigterm_source_id_ == 0 && sighup_source_id_ == 0);
+        assert(sigint_source_id_ == 0 && sigterm_source_id_ == 0 && sighup_source_id_ == 0 &&
+               sigusr1_source_id_ == 0);
 
         // g_unix_signal_add() is not wrapped in glibmm, use id:s even if it is a bit error prone.
         sigint_source_id_ = g_unix_signal_add(SIGINT, sigint_and_sigterm_callback, this);
         sigterm_source_id_ = g_unix_signal_add(SIGTERM, sigint_and_sigterm_callback, this);
         sighup_source_id_ = g_unix_signal_add(SIGHUP, sighup_callback, this);
+        sigusr1_source_id_ = g_unix_signal_add(SIGUSR1, sigusr1_callback, this);
 
-        bool success = sigint_source_id_ != 0 && sigterm_source_id_ != 0 && sighup_source_id_ != 0;
+        bool success = sigint_source_id_ != 0 && sigterm_source_id_ != 0 &&
+                       sighup_source_id_ != 0 && sigusr1_source_id_ != 0;
 
         if (!success) {
             unregister_signal_handlers();
@@ -104,5 +220,10 @@ namespace ConnectivityManager::Daemon
             g_source_remove(sighup_source_id_);
             sighup_source_id_ = 0;
         }
+
+        if (sigusr1_source_id_ != 0) {
+            g_source_remove(sigusr1_source_id_);
+            sigusr1_source_id_ = 0;
+        }
     }
 }
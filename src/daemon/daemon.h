@@ -12,17 +12,31 @@
 #include <glibmm.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 
+#include "daemon/arguments.h"
 #include "daemon/backend.h"
 #include "daemon/dbus_service.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/roaming_engine.h"
 
 namespace ConnectivityManager::Daemon
 {
+    // Owns backend and D-Bus service and runs the main loop.
+    //
+    // The main loop is monitored for stalls by a MainLoopMonitor unless disabled on the command
+    // line (Arguments::main_loop_stall_threshold_ms).
+    //
+    // SIGINT and SIGTERM quit, SIGHUP reloads config and SIGUSR1 writes a JSON dump of internal
+    // state (see StateDump) to Arguments::state_dump_path for inspecting a daemon in the field.
+    // The dump is built synchronously, which only walks containers and is cheap, and then written
+    // to file asynchronously so the main loop is not blocked by file I/O. The file is replaced
+    // atomically and is only readable by the owner.
     class Daemon
     {
     public:
-        explicit Daemon(std::unique_ptr<Backend> &&backend);
+        Daemon(std::unique_ptr<Backend> &&backend, const Arguments &arguments);
         ~Daemon();
 
         Daemon(const Daemon &other) = delete;
@@ -34,20 +48,28 @@ namespace ConnectivityManager::Daemon
         void quit() const;
 
         void reload_config() const;
+        void dump_state();
 
     private:
         bool register_signal_handlers();
         void unregister_signal_handlers();
 
         Glib::RefPtr<Glib::MainLoop> main_loop_ = Glib::MainLoop::create();
+        std::optional<MainLoopMonitor> main_loop_monitor_;
 
         guint sigint_source_id_ = 0;
         guint sigterm_source_id_ = 0;
         guint sighup_source_id_ = 0;
+        guint sigusr1_source_id_ = 0;
+
+        const std::string state_dump_path_;
+        bool state_dump_writing_ = false;
 
         std::unique_ptr<Backend> backend_;
 
         DBusService dbus_service_;
+
+        std::optional<RoamingEngine> roaming_engine_;
     };
 }
 
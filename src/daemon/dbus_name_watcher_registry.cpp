@@ -0,0 +1,82 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/dbus_name_watcher_registry.h"
+
+#include <vector>
+
+namespace ConnectivityManager::Daemon
+{
+    DBusNameWatcherRegistry::Handle DBusNameWatcherRegistry::watch(
+        const Glib::RefPtr<Gio::DBus::Connection> &connection,
+        const Glib::ustring &name,
+        NameVanished &&name_vanished)
+    {
+        auto [i, inserted] = names_.try_emplace(name.raw());
+
+        if (inserted) {
+            i->second.watcher =
+                DBusNameWatcher(connection,
+                                name,
+                                [this, name](const auto & /*connection*/, const auto & /*name*/) {
+                                    name_vanished(name);
+                                });
+        }
+
+        std::uint64_t id = ++last_id_;
+        i->second.callbacks.emplace(id, std::move(name_vanished));
+
+        return Handle(this, name, id);
+    }
+
+    void DBusNameWatcherRegistry::release(const Glib::ustring &name, std::uint64_t id)
+    {
+        auto i = names_.find(name.raw());
+        if (i == names_.end()) {
+            return;
+        }
+
+        i->second.callbacks.erase(id);
+
+        if (i->second.callbacks.empty()) {
+            names_.erase(i);
+        }
+    }
+
+    void DBusNameWatcherRegistry::name_vanished(Glib::ustring name)
+    {
+        auto i = names_.find(name.raw());
+        if (i == names_.end()) {
+            return;
+        }
+
+        // Callbacks may release handles (including their own), which may remove the name and the
+        // underlying watcher. Name is a copy and each callback is looked up again before calling.
+        std::vector<std::uint64_t> ids;
+        ids.reserve(i->second.callbacks.size());
+
+        for (const auto &[id, callback] : i->second.callbacks) {
+            ids.push_back(id);
+        }
+
+        for (std::uint64_t id : ids) {
+            auto name_i = names_.find(name.raw());
+            if (name_i == names_.end()) {
+                return;
+            }
+
+            auto callback_i = name_i->second.callbacks.find(id);
+            if (callback_i == name_i->second.callbacks.end()) {
+                continue;
+            }
+
+            NameVanished callback = callback_i->second;
+            callback();
+        }
+    }
+}
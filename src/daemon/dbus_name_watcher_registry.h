@@ -0,0 +1,129 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_DBUS_NAME_WATCHER_REGISTRY_H
+#define CONNECTIVITY_MANAGER_DAEMON_DBUS_NAME_WATCHER_REGISTRY_H
+
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "daemon/dbus_name_watcher.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Shares one DBusNameWatcher per name on the bus between everything that needs to know when a
+    // client disappears (e.g. pending Connect() calls and cached UserInputAgent proxies).
+    //
+    // Each DBusNameWatcher adds a match rule to the bus and a callback in GDBus. Watching the
+    // sender once per request would make that cost grow with the number of requests instead of
+    // the number of clients.
+    //
+    // watch() returns a Handle. The name is watched as long as at least one Handle for it exists.
+    // When the name vanishes, the callback of every Handle for it is called. Handles must not
+    // outlive the registry.
+    class DBusNameWatcherRegistry
+    {
+    public:
+        using NameVanished = std::function<void()>;
+
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            Handle(const Handle &other) = delete;
+
+            Handle(Handle &&other) noexcept :
+                registry_(std::exchange(other.registry_, nullptr)),
+                name_(std::move(other.name_)),
+                id_(std::exchange(other.id_, 0))
+            {
+            }
+
+            ~Handle()
+            {
+                release();
+            }
+
+            Handle &operator=(const Handle &other) = delete;
+
+            Handle &operator=(Handle &&other) noexcept
+            {
+                if (this != &other) {
+                    release();
+                    registry_ = std::exchange(other.registry_, nullptr);
+                    name_ = std::move(other.name_);
+                    id_ = std::exchange(other.id_, 0);
+                }
+                return *this;
+            }
+
+        private:
+            friend class DBusNameWatcherRegistry;
+
+            Handle(DBusNameWatcherRegistry *registry, Glib::ustring name, std::uint64_t id) :
+                registry_(registry),
+                name_(std::move(name)),
+                id_(id)
+            {
+            }
+
+            void release()
+            {
+                if (registry_) {
+                    registry_->release(name_, id_);
+                    registry_ = nullptr;
+                }
+            }
+
+            DBusNameWatcherRegistry *registry_ = nullptr;
+            Glib::ustring name_;
+            std::uint64_t id_ = 0;
+        };
+
+        DBusNameWatcherRegistry() = default;
+
+        DBusNameWatcherRegistry(const DBusNameWatcherRegistry &other) = delete;
+        DBusNameWatcherRegistry(DBusNameWatcherRegistry &&other) = delete;
+        DBusNameWatcherRegistry &operator=(const DBusNameWatcherRegistry &other) = delete;
+        DBusNameWatcherRegistry &operator=(DBusNameWatcherRegistry &&other) = delete;
+
+        Handle watch(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                     const Glib::ustring &name,
+                     NameVanished &&name_vanished);
+
+        std::size_t watched_names() const
+        {
+            return names_.size();
+        }
+
+    private:
+        struct Name
+        {
+            DBusNameWatcher watcher;
+            std::map<std::uint64_t, NameVanished> callbacks; // Ordered by id, i.e. watch() order.
+        };
+
+        void release(const Glib::ustring &name, std::uint64_t id);
+
+        void name_vanished(Glib::ustring name);
+
+        std::unordered_map<std::string, Name> names_;
+        std::uint64_t last_id_ = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_DBUS_NAME_WATCHER_REGISTRY_H
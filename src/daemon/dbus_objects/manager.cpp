@@ -11,15 +11,25 @@
 #include <giomm.h>
 #include <glibmm.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "common/credentials.h"
 #include "daemon/dbus_objects/wifi_access_point.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/metrics_registry.h"
 
 namespace ConnectivityManager::Daemon
 {
-    Manager::Manager(Backend &backend) : backend_(backend)
+    Manager::Manager(Backend &backend,
+                     std::shared_ptr<ConnectStageLatencies> connect_stage_latencies) :
+        backend_(backend),
+        connect_stage_latencies_(std::move(connect_stage_latencies))
     {
     }
 
@@ -35,37 +45,47 @@ namespace ConnectivityManager::Daemon
         wifi_.hotspot_passphrase = state.wifi.hotspot_passphrase;
     }
 
+    void Manager::state_dump(StateDump &dump) const
+    {
+        dump.container("wifi_access_points_container",
+                       wifi_.access_points.size(),
+                       wifi_.access_points.capacity());
+
+        dump.object_begin("pending_connects");
+        pending_connects_.state_dump(dump);
+        dump.object_end();
+    }
+
     void Manager::Connect(const Glib::DBusObjectPathString &object,
                           const Glib::DBusObjectPathString &user_input_agent,
                           MethodInvocation &invocation)
     {
-        if (pending_connects_.object_already_connecting(object)) {
-            // TODO: This limitation can be removed.
-            //
-            // Only here now due to object path being used as key to lookup pending connections.
-            // Could e.g. have PendingConnect::add() return a unique "token" (std::uint64_t
-            // incremented for each add()) and use that as key instead of Glib::DBusObjectPathString
-            // in PendingConnects::map_. Bind token by value into lambdas below in this method
-            // instead of object path.
-            invocation.ret(Gio::DBus::Error(
-                Gio::DBus::Error::FAILED,
-                "Can not connect \"" + object +
-                    "\", already connecting (limitation will be removed in future version"));
-            return;
-        }
+        MainLoopMonitor::Scope scope("Manager::Connect");
+
+        MetricsRegistry::instance().method_called(MetricsRegistry::Method::CONNECT);
 
         if (auto backend_ap = wifi_backend_ap_from_object_path(object); backend_ap) {
-            pending_connects_.add(object, invocation, user_input_agent);
+            auto trace = std::make_shared<ConnectTrace>(object, connect_stage_latencies_);
+            auto token = pending_connects_.add(object, invocation, user_input_agent, {});
+
+            Backend::RequestCredentialsFromUser request_credentials;
+
+            if (!user_input_agent.empty() && user_input_agent != "/") {
+                request_credentials = [this, token, object](
+                                          const Common::Credentials::Requested &requested,
+                                          Backend::RequestCredentialsFromUserReply &&callback) {
+                    pending_connects_.request_credentials(
+                        token, object, requested, std::move(callback));
+                };
+            }
 
             backend_.wifi_connect(
                 *backend_ap,
-                [this, object](Backend::ConnectResult result) {
-                    pending_connects_.finished(object, result);
+                [this, token](Backend::ConnectResult result) {
+                    pending_connects_.finished(token, result);
                 },
-                [this, object](const Common::Credentials::Requested &requested,
-                               Backend::RequestCredentialsFromUserReply &&callback) {
-                    pending_connects_.request_credentials(object, requested, std::move(callback));
-                });
+                std::move(request_credentials),
+                trace);
 
             return;
         }
@@ -74,8 +94,131 @@ namespace ConnectivityManager::Daemon
                                         "Can not connect \"" + object + "\", unknown object"));
     }
 
+    void Manager::ConnectWithCredentials(const Glib::DBusObjectPathString &object,
+                                         const Common::Credentials::DBusValue &credentials,
+                                         MethodInvocation &invocation)
+    {
+        MainLoopMonitor::Scope scope("Manager::ConnectWithCredentials");
+
+        MetricsRegistry::instance().method_called(
+            MetricsRegistry::Method::CONNECT_WITH_CREDENTIALS);
+
+        std::optional<Common::Credentials> parsed =
+            credentials.empty() ? Common::Credentials() :
+                                  Common::Credentials::from_dbus_value(credentials);
+        if (!parsed) {
+            invocation.ret(
+                Gio::DBus::Error(Gio::DBus::Error::INVALID_ARGS, "Invalid credentials"));
+            return;
+        }
+
+        bool hidden = object == "/";
+        const Backend::WiFiAccessPoint *backend_ap = nullptr;
+
+        if (hidden) {
+            if (!parsed->ssid || parsed->ssid->empty()) {
+                invocation.ret(Gio::DBus::Error(Gio::DBus::Error::INVALID_ARGS,
+                                                "SSID required to connect to hidden network"));
+                return;
+            }
+        } else {
+            backend_ap = wifi_backend_ap_from_object_path(object);
+            if (!backend_ap) {
+                invocation.ret(Gio::DBus::Error(Gio::DBus::Error::INVALID_ARGS,
+                                                "Can not connect \"" + object +
+                                                    "\", unknown object"));
+                return;
+            }
+        }
+
+        auto trace = std::make_shared<ConnectTrace>(
+            hidden ? "hidden:" + *parsed->ssid : object.raw(), connect_stage_latencies_);
+        auto token = pending_connects_.add(object, invocation, {}, *parsed);
+
+        auto finished = [this, token](Backend::ConnectResult result) {
+            pending_connects_.finished(token, result);
+        };
+
+        auto request_credentials = [this, token, object](
+                                       const Common::Credentials::Requested &requested,
+                                       Backend::RequestCredentialsFromUserReply &&callback) {
+            pending_connects_.request_credentials(token, object, requested, std::move(callback));
+        };
+
+        if (hidden) {
+            backend_.wifi_connect_hidden(*parsed->ssid,
+                                         wifi_security_from_credentials(*parsed),
+                                         std::move(finished),
+                                         std::move(request_credentials),
+                                         trace);
+        } else {
+            backend_.wifi_connect(
+                *backend_ap, std::move(finished), std::move(request_credentials), trace);
+        }
+    }
+
+    void Manager::CancelConnect(const Glib::DBusObjectPathString &object,
+                                MethodInvocation &invocation)
+    {
+        MainLoopMonitor::Scope scope("Manager::CancelConnect");
+
+        MetricsRegistry::instance().method_called(MetricsRegistry::Method::CANCEL_CONNECT);
+
+        Glib::ustring sender = invocation.getMessage()->get_sender();
+
+        if (object == "/") {
+            // Connects to hidden networks are never joined and Backend has one connect in
+            // progress per security for them, see Backend::wifi_connect_hidden_cancel().
+            std::vector<Common::Credentials> hidden =
+                pending_connects_.credentials_supplied(sender, object);
+
+            if (hidden.empty()) {
+                invocation.ret(Gio::DBus::Error(Gio::DBus::Error::INVALID_ARGS,
+                                                "Can not cancel connect to hidden network, no "
+                                                "connect pending"));
+                return;
+            }
+
+            pending_connects_.cancel(sender, object);
+
+            for (const Common::Credentials &credentials : hidden) {
+                backend_.wifi_connect_hidden_cancel(wifi_security_from_credentials(credentials));
+            }
+
+            invocation.ret();
+            return;
+        }
+
+        auto backend_ap = wifi_backend_ap_from_object_path(object);
+        if (!backend_ap) {
+            invocation.ret(Gio::DBus::Error(Gio::DBus::Error::INVALID_ARGS,
+                                            "Can not cancel connect \"" + object +
+                                                "\", unknown object"));
+            return;
+        }
+
+        std::size_t canceled = pending_connects_.cancel(sender, object);
+
+        if (pending_connects_.contains(object)) {
+            if (canceled == 0) {
+                invocation.ret(Gio::DBus::Error(Gio::DBus::Error::ACCESS_DENIED,
+                                                "Can not cancel connect \"" + object +
+                                                    "\", requested by another client"));
+                return;
+            }
+        } else {
+            backend_.wifi_connect_cancel(*backend_ap);
+        }
+
+        invocation.ret();
+    }
+
     void Manager::Disconnect(const Glib::DBusObjectPathString &object, MethodInvocation &invocation)
     {
+        MainLoopMonitor::Scope scope("Manager::Disconnect");
+
+        MetricsRegistry::instance().method_called(MetricsRegistry::Method::DISCONNECT);
+
         if (auto backend_ap = wifi_backend_ap_from_object_path(object); backend_ap) {
             backend_.wifi_disconnect(*backend_ap);
             invocation.ret();
@@ -86,12 +229,59 @@ namespace ConnectivityManager::Daemon
                                         "Can not disconnect \"" + object + "\", unknown object"));
     }
 
+    void Manager::Scan(MethodInvocation &invocation)
+    {
+        MainLoopMonitor::Scope scope("Manager::Scan");
+
+        MetricsRegistry::instance().method_called(MetricsRegistry::Method::SCAN);
+
+        if (!backend_.wifi_enabled()) {
+            invocation.ret(
+                Gio::DBus::Error(Gio::DBus::Error::FAILED, "Can not scan, WiFi not enabled"));
+            return;
+        }
+
+        backend_.wifi_scan([invocation](bool success, std::uint32_t /*duration_ms*/) mutable {
+            if (success) {
+                invocation.ret();
+            } else {
+                invocation.ret(Gio::DBus::Error(Gio::DBus::Error::FAILED, "Scan failed"));
+            }
+        });
+    }
+
+    void Manager::ConfigureHotspot(const std::string &ssid,
+                                   const Glib::ustring &passphrase,
+                                   bool enabled,
+                                   MethodInvocation &invocation)
+    {
+        MainLoopMonitor::Scope scope("Manager::ConfigureHotspot");
+
+        MetricsRegistry::instance().method_called(MetricsRegistry::Method::CONFIGURE_HOTSPOT);
+
+        if (!backend_.wifi_available()) {
+            invocation.ret(Gio::DBus::Error(Gio::DBus::Error::FAILED,
+                                            "Can not configure hotspot, WiFi not available"));
+            return;
+        }
+
+        backend_.wifi_hotspot_configure(
+            ssid, passphrase, enabled, [invocation](bool success) mutable {
+                if (success) {
+                    invocation.ret();
+                } else {
+                    invocation.ret(Gio::DBus::Error(Gio::DBus::Error::FAILED,
+                                                    "Failed to configure hotspot"));
+                }
+            });
+    }
+
     bool Manager::WiFiAvailable_setHandler(bool value)
     {
         bool changed = wifi_.available != value;
         wifi_.available = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     bool Manager::WiFiAvailable_get()
@@ -118,7 +308,7 @@ namespace ConnectivityManager::Daemon
             }
         }
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     bool Manager::WiFiEnabled_get()
@@ -131,7 +321,7 @@ namespace ConnectivityManager::Daemon
         bool changed = wifi_.access_points != value;
         wifi_.access_points = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     std::vector<Glib::DBusObjectPathString> Manager::WiFiAccessPoints_get()
@@ -158,7 +348,7 @@ namespace ConnectivityManager::Daemon
             }
         }
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     bool Manager::WiFiHotspotEnabled_get()
@@ -180,7 +370,7 @@ namespace ConnectivityManager::Daemon
             backend_.wifi_hotspot_change_ssid(value);
         }
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     std::string Manager::WiFiHotspotSSID_get()
@@ -203,7 +393,7 @@ namespace ConnectivityManager::Daemon
             backend_.wifi_hotspot_change_passphrase(value);
         }
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     Glib::ustring Manager::WiFiHotspotPassphrase_get()
@@ -211,6 +401,48 @@ namespace ConnectivityManager::Daemon
         return wifi_.hotspot_passphrase;
     }
 
+    Backend::WiFiSecurity Manager::wifi_security_from_credentials(
+        const Common::Credentials &credentials)
+    {
+        using Type = Common::Credentials::Password::Type;
+
+        if (!credentials.password) {
+            return Backend::WiFiSecurity::NONE;
+        }
+
+        switch (credentials.password->type) {
+        case Type::WEP_KEY:
+            return Backend::WiFiSecurity::WEP;
+        case Type::PASSPHRASE:
+            return credentials.username ? Backend::WiFiSecurity::WPA_EAP :
+                                          Backend::WiFiSecurity::WPA_PSK;
+        case Type::WPA_PSK:
+        case Type::WPS_PIN:
+            break;
+        }
+
+        return Backend::WiFiSecurity::WPA_PSK;
+    }
+
+    Glib::ustring Manager::credentials_missing(const Common::Credentials &requested,
+                                               const Common::Credentials &supplied)
+    {
+        Glib::ustring missing;
+
+        auto check = [&missing](bool is_missing, const char *name) {
+            if (is_missing) {
+                missing += (missing.empty() ? "" : ", ") + Glib::ustring(name);
+            }
+        };
+
+        check(requested.ssid && !supplied.ssid, "ssid");
+        check(requested.username && !supplied.username, "username");
+        check((requested.password || requested.password_alternative) && !supplied.password,
+              "password");
+
+        return missing;
+    }
+
     const Backend::WiFiAccessPoint *Manager::wifi_backend_ap_from_object_path(
         const Glib::DBusObjectPathString &path) const
     {
@@ -229,74 +461,158 @@ namespace ConnectivityManager::Daemon
         return &i->second;
     }
 
-    void Manager::PendingConnects::add(const Glib::DBusObjectPathString &object,
-                                       MethodInvocation &invocation,
-                                       const Glib::DBusObjectPathString &user_input_agent_path)
+    Manager::PendingConnects::Token Manager::PendingConnects::add(
+        const Glib::DBusObjectPathString &object,
+        MethodInvocation &invocation,
+        const Glib::DBusObjectPathString &user_input_agent_path,
+        const std::optional<Common::Credentials> &credentials_supplied)
     {
+        Token token = ++last_token_;
         PendingConnect pending;
 
+        pending.object = object;
         pending.invocation = invocation;
+        pending.credentials_supplied = credentials_supplied;
 
+        pending.user_input_agent_sender = invocation.getMessage()->get_sender();
         pending.user_input_agent_path = user_input_agent_path;
-        pending.user_input_agent_name_watcher =
-            DBusNameWatcher(invocation.getMessage()->get_connection(),
-                            invocation.getMessage()->get_sender(),
-                            [this, object](const auto & /*connection*/, const auto & /*name*/) {
-                                user_input_agent_proxy_name_disappeared(object);
-                            });
+        pending.user_input_agent_name_watch =
+            name_watchers_.watch(invocation.getMessage()->get_connection(),
+                                 invocation.getMessage()->get_sender(),
+                                 [this, token] { user_input_agent_proxy_name_disappeared(token); });
+
+        map_.emplace(token, std::move(pending));
+        MetricsRegistry::instance().set(MetricsRegistry::Gauge::PENDING_CONNECTS, map_.size());
 
-        map_.emplace(object, std::move(pending));
+        return token;
     }
 
-    bool Manager::PendingConnects::object_already_connecting(
-        const Glib::DBusObjectPathString &object) const
+    void Manager::PendingConnects::state_dump(StateDump &dump) const
     {
-        return map_.find(object) != map_.cend();
+        dump.container("map_container", map_.size(), map_.bucket_count());
+
+        dump.array_begin("connects");
+        for (const auto &[token, pending] : map_) {
+            dump.object_begin();
+            dump.value("token", token);
+            dump.value("object", pending.object);
+            dump.value("user_input_agent_sender", pending.user_input_agent_sender);
+            dump.value("user_input_agent_path", pending.user_input_agent_path);
+            dump.value("credentials_supplied", pending.credentials_supplied ? true : false);
+            dump.value("waiting_for_credentials", pending.credentials_reply ? true : false);
+            dump.object_end();
+        }
+        dump.array_end();
+
+        dump.array_begin("user_input_agents");
+        for (const auto &[key, agent] : user_input_agents_) {
+            dump.object_begin();
+            dump.value("sender", key.first);
+            dump.value("path", key.second);
+            dump.value("proxy_created", agent.proxy ? true : false);
+            dump.value("waiting_for_proxy", agent.waiting_for_proxy.size());
+            dump.object_end();
+        }
+        dump.array_end();
     }
 
-    Manager::PendingConnects::PendingConnect *Manager::PendingConnects::find(
-        const Glib::DBusObjectPathString &object)
+    Manager::PendingConnects::PendingConnect *Manager::PendingConnects::find(Token token)
     {
-        auto i = map_.find(object);
+        auto i = map_.find(token);
         return i == map_.cend() ? nullptr : &i->second;
     }
 
-    void Manager::PendingConnects::remove(const Glib::DBusObjectPathString &object)
+    void Manager::PendingConnects::remove(Token token)
     {
-        map_.erase(object);
+        map_.erase(token);
+        MetricsRegistry::instance().set(MetricsRegistry::Gauge::PENDING_CONNECTS, map_.size());
     }
 
-    void Manager::PendingConnects::finished(const Glib::DBusObjectPathString &object,
-                                            Backend::ConnectResult result)
+    void Manager::PendingConnects::finished(Token token, Backend::ConnectResult result)
     {
-        PendingConnect *pending = find(object);
+        PendingConnect *pending = find(token);
         if (!pending) {
             return;
         }
 
-        if (result == Backend::ConnectResult::SUCCESS) {
+        switch (result) {
+        case Backend::ConnectResult::SUCCESS:
             pending->invocation->ret();
-        } else {
-            pending->invocation->ret(
-                Gio::DBus::Error(Gio::DBus::Error::FAILED, "Failed to connect to " + object));
+            break;
+        case Backend::ConnectResult::FAILED:
+            if (pending->error.empty()) {
+                pending->error = "Failed to connect to " + pending->object;
+            }
+            pending->invocation->ret(Gio::DBus::Error(Gio::DBus::Error::FAILED, pending->error));
+            break;
+        case Backend::ConnectResult::CANCELED:
+            pending->invocation->ret(Gio::DBus::Error(Gio::DBus::Error::FAILED,
+                                                      "Connect to " + pending->object +
+                                                          " was canceled"));
+            break;
         }
 
-        if (pending->credentials_reply) {
-            pending->credentials_reply(Common::Credentials::NONE);
-            pending->credentials_reply = nullptr;
+        credentials_reply_none(token);
+
+        remove(token);
+    }
+
+    std::size_t Manager::PendingConnects::cancel(const Glib::ustring &sender,
+                                                 const Glib::DBusObjectPathString &object)
+    {
+        std::vector<Token> tokens;
+
+        for (const auto &[token, pending] : map_) {
+            if (pending.user_input_agent_sender == sender && pending.object == object) {
+                tokens.push_back(token);
+            }
         }
 
-        remove(object);
+        for (Token token : tokens) {
+            credentials_hand_over(token);
+            finished(token, Backend::ConnectResult::CANCELED);
+        }
+
+        return tokens.size();
+    }
+
+    bool Manager::PendingConnects::contains(const Glib::DBusObjectPathString &object) const
+    {
+        return std::any_of(map_.cbegin(), map_.cend(), [&object](const auto &token_and_pending) {
+            return token_and_pending.second.object == object;
+        });
+    }
+
+    std::vector<Common::Credentials> Manager::PendingConnects::credentials_supplied(
+        const Glib::ustring &sender,
+        const Glib::DBusObjectPathString &object) const
+    {
+        std::vector<Common::Credentials> supplied;
+
+        for (const auto &[token, pending] : map_) {
+            if (pending.user_input_agent_sender == sender && pending.object == object &&
+                pending.credentials_supplied) {
+                supplied.push_back(*pending.credentials_supplied);
+            }
+        }
+
+        return supplied;
     }
 
     void Manager::PendingConnects::request_credentials(
+        Token token,
         const Glib::DBusObjectPathString &object,
         const Common::Credentials::Requested &requested,
         Backend::RequestCredentialsFromUserReply &&callback)
     {
-        PendingConnect *pending = find(object);
+        PendingConnect *pending = find(token);
+
+        if (!pending || !credentials_can_answer(*pending)) {
+            token = credentials_substitute(token, object);
+            pending = find(token);
+        }
 
-        if (!pending || pending->user_input_agent_path.empty()) {
+        if (!pending) {
             callback(Common::Credentials::NONE);
             return;
         }
@@ -304,27 +620,181 @@ namespace ConnectivityManager::Daemon
         pending->credentials_requested = requested;
         pending->credentials_reply = std::move(callback);
 
+        credentials_request_start(token);
+    }
+
+    bool Manager::PendingConnects::credentials_can_answer(const PendingConnect &pending)
+    {
+        return pending.credentials_supplied ||
+               (!pending.user_input_agent_path.empty() && pending.user_input_agent_path != "/");
+    }
+
+    Manager::PendingConnects::Token Manager::PendingConnects::credentials_substitute(
+        Token token,
+        const Glib::DBusObjectPathString &object) const
+    {
+        if (object == "/") {
+            return 0;
+        }
+
+        auto from = map_.find(token);
+
+        for (const auto &[other_token, other] : map_) {
+            if (other_token == token || other.object != object || other.credentials_reply ||
+                !credentials_can_answer(other)) {
+                continue;
+            }
+
+            // Same UserInputAgent would fail the same way.
+            if (from != map_.cend() &&
+                from->second.user_input_agent_sender == other.user_input_agent_sender &&
+                from->second.user_input_agent_path == other.user_input_agent_path &&
+                !other.credentials_supplied) {
+                continue;
+            }
+
+            return other_token;
+        }
+
+        return 0;
+    }
+
+    void Manager::PendingConnects::credentials_hand_over(Token token)
+    {
+        PendingConnect *pending = find(token);
+        if (!pending || !pending->credentials_reply) {
+            return;
+        }
+
+        Token substitute_token = credentials_substitute(token, pending->object);
+        PendingConnect *substitute = find(substitute_token);
+
+        if (!substitute) {
+            credentials_reply_none(token);
+            return;
+        }
+
+        substitute->credentials_requested = std::move(pending->credentials_requested);
+        substitute->credentials_reply = std::move(pending->credentials_reply);
+        pending->credentials_reply = nullptr;
+
+        credentials_request_start(substitute_token);
+    }
+
+    void Manager::PendingConnects::credentials_request_start(Token token)
+    {
+        PendingConnect *pending = find(token);
+
+        if (pending->credentials_supplied) {
+            Glib::ustring missing = credentials_missing(
+                pending->credentials_requested.credentials, *pending->credentials_supplied);
+
+            if (!missing.empty()) {
+                pending->error = "Credentials required to connect but not supplied: " + missing;
+                credentials_reply_none(token);
+                return;
+            }
+
+            Common::Credentials credentials = *pending->credentials_supplied;
+            Backend::RequestCredentialsFromUserReply reply = std::move(pending->credentials_reply);
+            pending->credentials_reply = nullptr;
+
+            reply(credentials);
+            return;
+        }
+
+        UserInputAgentKey key{pending->user_input_agent_sender, pending->user_input_agent_path};
+        auto [i, inserted] = user_input_agents_.try_emplace(key);
+        UserInputAgent &agent = i->second;
+
+        if (agent.proxy) {
+            credentials_request_send(token, agent.proxy);
+            return;
+        }
+
+        agent.waiting_for_proxy.push_back(token);
+
+        if (!inserted) {
+            return; // Proxy creation already in progress.
+        }
+
+        agent.name_watch =
+            name_watchers_.watch(pending->invocation->getMessage()->get_connection(),
+                                 key.first,
+                                 [this, key] { user_input_agent_name_vanished(key); });
+
         UserInputAgentProxy::createForBus(
             Gio::DBus::BUS_TYPE_SYSTEM,
-            Gio::DBus::PROXY_FLAGS_NONE,
-            pending->invocation->getMessage()->get_sender(),
-            pending->user_input_agent_path,
-            [this, object](const auto &result) { user_input_agent_proxy_ready(object, result); });
+            Gio::DBus::PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                Gio::DBus::PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+            key.first,
+            key.second,
+            [this, key](const auto &result) { user_input_agent_proxy_ready(key, result); });
+    }
+
+    void Manager::PendingConnects::credentials_reply_none(Token token)
+    {
+        PendingConnect *pending = find(token);
+
+        if (pending && pending->credentials_reply) {
+            pending->credentials_reply(Common::Credentials::NONE);
+            pending->credentials_reply = nullptr;
+        }
     }
 
-    void Manager::PendingConnects::user_input_agent_proxy_name_disappeared(
-        const Glib::DBusObjectPathString &object)
+    void Manager::PendingConnects::credentials_request_send(
+        Token token,
+        const Glib::RefPtr<UserInputAgentProxy> &proxy)
     {
-        PendingConnect *pending = find(object);
+        PendingConnect *pending = find(token);
+        if (!pending || !pending->credentials_reply) {
+            return;
+        }
+
+        constexpr int REQUEST_TIMEOUT_MS = 5 * 60 * 1000;
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::CREDENTIALS_REQUESTS);
+
+        proxy->RequestCredentials(
+            pending->credentials_requested.description_type,
+            pending->credentials_requested.description_id,
+            Common::Credentials::to_dbus_value(pending->credentials_requested.credentials),
+            [this, token, proxy](const auto &request_result) {
+                credentials_reply_received(token, proxy, request_result);
+            },
+            {},
+            REQUEST_TIMEOUT_MS);
+    }
+
+    void Manager::PendingConnects::user_input_agent_proxy_name_disappeared(Token token)
+    {
+        PendingConnect *pending = find(token);
         if (!pending) {
             return;
         }
 
         pending->user_input_agent_path.clear();
+
+        credentials_hand_over(token);
+    }
+
+    void Manager::PendingConnects::user_input_agent_name_vanished(const UserInputAgentKey &key)
+    {
+        auto i = user_input_agents_.find(key);
+        if (i == user_input_agents_.end()) {
+            return;
+        }
+
+        std::vector<Token> waiting = std::move(i->second.waiting_for_proxy);
+        user_input_agents_.erase(i);
+
+        for (Token token : waiting) {
+            credentials_hand_over(token);
+        }
     }
 
     void Manager::PendingConnects::user_input_agent_proxy_ready(
-        const Glib::DBusObjectPathString &object,
+        const UserInputAgentKey &key,
         const Glib::RefPtr<Gio::AsyncResult> &result)
     {
         Glib::RefPtr<UserInputAgentProxy> proxy;
@@ -332,51 +802,53 @@ namespace ConnectivityManager::Daemon
         try {
             proxy = UserInputAgentProxy::createForBusFinish(result);
         } catch (const Glib::Error &e) {
-            g_warning("Failed to create UserInputAgentProxy for %s: %s",
-                      object.c_str(),
+            g_warning("Failed to create UserInputAgentProxy for %s at %s: %s",
+                      key.second.c_str(),
+                      key.first.c_str(),
                       e.what().c_str());
         }
 
-        PendingConnect *pending = find(object);
-        if (!pending) {
+        auto i = user_input_agents_.find(key);
+        if (i == user_input_agents_.end()) {
             return;
         }
 
+        std::vector<Token> waiting = std::move(i->second.waiting_for_proxy);
+
         if (!proxy) {
-            if (pending->credentials_reply) {
-                pending->credentials_reply(Common::Credentials::NONE);
-                pending->credentials_reply = nullptr;
+            user_input_agents_.erase(i);
+
+            for (Token token : waiting) {
+                credentials_hand_over(token);
             }
             return;
         }
 
-        constexpr int REQUEST_TIMEOUT_MS = 5 * 60 * 1000;
+        i->second.proxy = proxy;
 
-        proxy->RequestCredentials(
-            pending->credentials_requested.description_type,
-            pending->credentials_requested.description_id,
-            Common::Credentials::to_dbus_value(pending->credentials_requested.credentials),
-            [this, object, proxy](const auto &request_result) {
-                credentials_reply_received(object, proxy, request_result);
-            },
-            {},
-            REQUEST_TIMEOUT_MS);
+        for (Token token : waiting) {
+            credentials_request_send(token, proxy);
+        }
     }
 
     void Manager::PendingConnects::credentials_reply_received(
-        const Glib::DBusObjectPathString &object,
+        Token token,
         const Glib::RefPtr<UserInputAgentProxy> &proxy,
         const Glib::RefPtr<Gio::AsyncResult> &result)
     {
+        MainLoopMonitor::Scope scope("Manager::PendingConnects::credentials_reply_received");
+
+        PendingConnect *pending = find(token);
         Common::Credentials::DBusValue dbus_value;
 
         try {
             proxy->RequestCredentials_finish(dbus_value, result);
         } catch (const Glib::Error &e) {
-            g_warning("RequestCredentials() for %s failed: %s", object.c_str(), e.what().c_str());
+            g_warning("RequestCredentials() for %s failed: %s",
+                      pending ? pending->object.c_str() : "<finished connect>",
+                      e.what().c_str());
         }
 
-        PendingConnect *pending = find(object);
         if (!pending || !pending->credentials_reply) {
             return;
         }
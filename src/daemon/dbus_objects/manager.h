@@ -12,14 +12,21 @@
 #include <giomm.h>
 #include <glibmm.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/credentials.h"
 #include "daemon/backend.h"
-#include "daemon/dbus_name_watcher.h"
+#include "daemon/connect_trace.h"
+#include "daemon/dbus_name_watcher_registry.h"
+#include "daemon/state_dump.h"
 #include "generated/dbus/connectivity_manager_proxy.h"
 #include "generated/dbus/connectivity_manager_stub.h"
 
@@ -28,10 +35,12 @@ namespace ConnectivityManager::Daemon
     class Manager : public com::luxoft::ConnectivityManagerStub
     {
     public:
-        explicit Manager(Backend &backend);
+        Manager(Backend &backend, std::shared_ptr<ConnectStageLatencies> connect_stage_latencies);
 
         void sync_with_backend(std::vector<Glib::DBusObjectPathString> &&wifi_access_points);
 
+        void state_dump(StateDump &dump) const;
+
     private:
         // Information stored for calls to Connect().
         //
@@ -39,66 +48,158 @@ namespace ConnectivityManager::Daemon
         // fails. MethodInvocation is stored so it can be used when Backend returns with result.
         // Also stores path to com.luxoft.ConnectivityManager.UserInputAgent object provided by
         // client in Connect() call and monitors if client disappears from the bus.
+        //
+        // Each call is identified by a token returned from add() since several calls may be
+        // pending for the same object (Backend joins them).
+        //
+        // UserInputAgent proxies are cached per (sender, path) and reused for all credential
+        // requests, also for later Connect() calls from the same client. Proxies are created
+        // without loading properties or connecting signals (the interface has neither) so creating
+        // one does not require a round trip to the client. Cached proxies are dropped when the
+        // sender disappears from the bus.
+        //
+        // The sender is watched through DBusNameWatcherRegistry, so all pending connects and
+        // cached proxies for a client share one watch on the bus.
+        //
+        // cancel() finishes the pending connects of one sender for an object as canceled, the
+        // Backend connect may still be in progress for others (see contains()).
+        //
+        // Backend joins connects for the same object and only calls the RequestCredentialsFromUser
+        // callback of one of them. A credentials request is therefore answered by another pending
+        // connect for the object if the one it was made for can not answer it (canceled, no
+        // UserInputAgent or client disappeared), also when this happens while it is in progress
+        // (see credentials_hand_over()). Connects to hidden networks ("/") are never joined.
         class PendingConnects
         {
         public:
-            PendingConnects() = default;
+            using Token = std::uint64_t;
+
+            explicit PendingConnects(DBusNameWatcherRegistry &name_watchers) :
+                name_watchers_(name_watchers)
+            {
+            }
 
             PendingConnects(const PendingConnects &other) = delete;
             PendingConnects(PendingConnects &&other) = delete;
             PendingConnects &operator=(const PendingConnects &other) = delete;
             PendingConnects &operator=(PendingConnects &&other) = delete;
 
-            void add(const Glib::DBusObjectPathString &object,
-                     MethodInvocation &invocation,
-                     const Glib::DBusObjectPathString &user_input_agent_path);
+            // Credentials requests are answered with credentials_supplied if set, otherwise
+            // through the UserInputAgent at user_input_agent_path.
+            Token add(const Glib::DBusObjectPathString &object,
+                      MethodInvocation &invocation,
+                      const Glib::DBusObjectPathString &user_input_agent_path,
+                      const std::optional<Common::Credentials> &credentials_supplied);
 
-            bool object_already_connecting(const Glib::DBusObjectPathString &object) const;
+            void finished(Token token, Backend::ConnectResult result);
 
-            void finished(const Glib::DBusObjectPathString &object, Backend::ConnectResult result);
+            // Returns number of pending connects canceled.
+            std::size_t cancel(const Glib::ustring &sender,
+                               const Glib::DBusObjectPathString &object);
 
-            void request_credentials(const Glib::DBusObjectPathString &object,
+            bool contains(const Glib::DBusObjectPathString &object) const;
+
+            // Returns credentials supplied to the pending connects of one sender for an object.
+            std::vector<Common::Credentials> credentials_supplied(
+                const Glib::ustring &sender,
+                const Glib::DBusObjectPathString &object) const;
+
+            void request_credentials(Token token,
+                                     const Glib::DBusObjectPathString &object,
                                      const Common::Credentials::Requested &requested,
                                      Backend::RequestCredentialsFromUserReply &&callback);
 
+            void state_dump(StateDump &dump) const;
+
         private:
             using UserInputAgentProxy = com::luxoft::ConnectivityManager::UserInputAgentProxy;
 
+            using UserInputAgentKey = std::pair<Glib::ustring, Glib::DBusObjectPathString>;
+
             struct PendingConnect
             {
+                Glib::DBusObjectPathString object;
                 std::optional<MethodInvocation> invocation;
 
+                Glib::ustring user_input_agent_sender;
                 Glib::DBusObjectPathString user_input_agent_path;
-                DBusNameWatcher user_input_agent_name_watcher;
+                DBusNameWatcherRegistry::Handle user_input_agent_name_watch;
 
+                std::optional<Common::Credentials> credentials_supplied;
                 Common::Credentials::Requested credentials_requested;
                 Backend::RequestCredentialsFromUserReply credentials_reply;
+
+                Glib::ustring error;
             };
 
-            PendingConnect *find(const Glib::DBusObjectPathString &object);
+            struct UserInputAgent
+            {
+                Glib::RefPtr<UserInputAgentProxy> proxy; // Null until created.
+                std::vector<Token> waiting_for_proxy;
+                DBusNameWatcherRegistry::Handle name_watch;
+            };
 
-            void remove(const Glib::DBusObjectPathString &object);
+            PendingConnect *find(Token token);
 
-            void user_input_agent_proxy_name_disappeared(const Glib::DBusObjectPathString &object);
+            void remove(Token token);
 
-            void user_input_agent_proxy_ready(const Glib::DBusObjectPathString &object,
+            static bool credentials_can_answer(const PendingConnect &pending);
+
+            // Returns another pending connect for the object that can answer a credentials request
+            // and is not answering one already, 0 if none.
+            Token credentials_substitute(Token token,
+                                         const Glib::DBusObjectPathString &object) const;
+
+            // Moves the credentials request of token to credentials_substitute(), replies NONE
+            // if there is no substitute.
+            void credentials_hand_over(Token token);
+
+            void credentials_reply_none(Token token);
+            void credentials_request_start(Token token);
+            void credentials_request_send(Token token,
+                                          const Glib::RefPtr<UserInputAgentProxy> &proxy);
+
+            void user_input_agent_proxy_name_disappeared(Token token);
+
+            void user_input_agent_name_vanished(const UserInputAgentKey &key);
+
+            void user_input_agent_proxy_ready(const UserInputAgentKey &key,
                                               const Glib::RefPtr<Gio::AsyncResult> &result);
 
-            void credentials_reply_received(const Glib::DBusObjectPathString &object,
+            void credentials_reply_received(Token token,
                                             const Glib::RefPtr<UserInputAgentProxy> &proxy,
                                             const Glib::RefPtr<Gio::AsyncResult> &result);
 
         private:
-            std::unordered_map<std::string, PendingConnect> map_;
+            DBusNameWatcherRegistry &name_watchers_;
+
+            std::unordered_map<Token, PendingConnect> map_;
+            Token last_token_ = 0;
+
+            std::map<UserInputAgentKey, UserInputAgent> user_input_agents_;
         };
 
         void Connect(const Glib::DBusObjectPathString &object,
                      const Glib::DBusObjectPathString &user_input_agent,
                      MethodInvocation &invocation) override;
 
+        void ConnectWithCredentials(const Glib::DBusObjectPathString &object,
+                                    const Common::Credentials::DBusValue &credentials,
+                                    MethodInvocation &invocation) override;
+
+        void CancelConnect(const Glib::DBusObjectPathString &object,
+                           MethodInvocation &invocation) override;
+
         void Disconnect(const Glib::DBusObjectPathString &object,
                         MethodInvocation &invocation) override;
 
+        void Scan(MethodInvocation &invocation) override;
+
+        void ConfigureHotspot(const std::string &ssid,
+                              const Glib::ustring &passphrase,
+                              bool enabled,
+                              MethodInvocation &invocation) override;
+
         bool WiFiAvailable_setHandler(bool value) override;
         bool WiFiAvailable_get() override;
 
@@ -118,10 +219,19 @@ namespace ConnectivityManager::Daemon
         bool WiFiHotspotPassphrase_setHandler(const Glib::ustring &value) override;
         Glib::ustring WiFiHotspotPassphrase_get() override;
 
+        static Backend::WiFiSecurity wifi_security_from_credentials(
+            const Common::Credentials &credentials);
+
+        // Returns names (as in the D-Bus value) of requested credentials missing in supplied,
+        // empty if all are supplied.
+        static Glib::ustring credentials_missing(const Common::Credentials &requested,
+                                                 const Common::Credentials &supplied);
+
         const Backend::WiFiAccessPoint *wifi_backend_ap_from_object_path(
             const Glib::DBusObjectPathString &path) const;
 
         Backend &backend_;
+        std::shared_ptr<ConnectStageLatencies> connect_stage_latencies_;
 
         struct
         {
@@ -136,7 +246,8 @@ namespace ConnectivityManager::Daemon
             Glib::ustring hotspot_passphrase;
         } wifi_;
 
-        PendingConnects pending_connects_;
+        DBusNameWatcherRegistry name_watchers_; // Must outlive handles in pending_connects_.
+        PendingConnects pending_connects_{name_watchers_};
     };
 }
 
@@ -0,0 +1,92 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/dbus_objects/metrics.h"
+
+#include <glibmm.h>
+
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "daemon/histogram.h"
+#include "daemon/metrics_registry.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using HistogramValue = std::tuple<guint64, guint64, guint64, std::vector<guint64>>;
+
+        HistogramValue histogram_to_value(const Histogram &histogram)
+        {
+            const Histogram::Buckets &buckets = histogram.buckets();
+
+            return std::make_tuple(histogram.count(),
+                                   histogram.sum(),
+                                   histogram.max(),
+                                   std::vector<guint64>(buckets.cbegin(), buckets.cend()));
+        }
+    }
+
+    Metrics::Metrics(std::shared_ptr<const ConnectStageLatencies> connect_stage_latencies) :
+        connect_stage_latencies_(std::move(connect_stage_latencies))
+    {
+    }
+
+    void Metrics::GetConnectStageLatencies(MethodInvocation &invocation)
+    {
+        std::map<Glib::ustring, HistogramValue> latencies;
+
+        for (std::size_t i = 0; i < ConnectTrace::STAGE_COUNT; i++) {
+            auto stage = static_cast<ConnectTrace::Stage>(i);
+
+            latencies.emplace(ConnectTrace::stage_to_string(stage),
+                              histogram_to_value(connect_stage_latencies_->histogram(stage)));
+        }
+
+        invocation.ret(latencies);
+    }
+
+    void Metrics::GetMetrics(MethodInvocation &invocation)
+    {
+        using Registry = MetricsRegistry;
+
+        const Registry &registry = Registry::instance();
+
+        std::map<Glib::ustring, guint64> counters;
+        std::map<Glib::ustring, guint64> gauges;
+        std::map<Glib::ustring, guint64> method_calls;
+        std::map<Glib::ustring, HistogramValue> latencies;
+
+        for (std::size_t i = 0; i < Registry::COUNTER_COUNT; i++) {
+            auto counter = static_cast<Registry::Counter>(i);
+            counters.emplace(Registry::counter_to_string(counter), registry.value(counter));
+        }
+
+        for (std::size_t i = 0; i < Registry::GAUGE_COUNT; i++) {
+            auto gauge = static_cast<Registry::Gauge>(i);
+            gauges.emplace(Registry::gauge_to_string(gauge), registry.value(gauge));
+        }
+
+        for (std::size_t i = 0; i < Registry::METHOD_COUNT; i++) {
+            auto method = static_cast<Registry::Method>(i);
+            method_calls.emplace(Registry::method_to_string(method), registry.calls(method));
+        }
+
+        for (std::size_t i = 0; i < Registry::LATENCY_COUNT; i++) {
+            auto latency = static_cast<Registry::Latency>(i);
+            latencies.emplace(Registry::latency_to_string(latency),
+                              histogram_to_value(registry.histogram(latency)));
+        }
+
+        invocation.ret(counters, gauges, method_calls, latencies);
+    }
+}
@@ -0,0 +1,39 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_DBUS_OBJECTS_METRICS_H
+#define CONNECTIVITY_MANAGER_DAEMON_DBUS_OBJECTS_METRICS_H
+
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <memory>
+
+#include "daemon/connect_trace.h"
+#include "generated/dbus/connectivity_manager_stub.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Implementation of com.luxoft.ConnectivityManager.Metrics D-Bus interface.
+    //
+    // Exposed on bus under Common::DBus::METRICS_OBJECT_PATH. Connect stage latencies are owned by
+    // DBusService, everything returned by GetMetrics() comes from MetricsRegistry.
+    class Metrics : public com::luxoft::ConnectivityManager::MetricsStub
+    {
+    public:
+        explicit Metrics(std::shared_ptr<const ConnectStageLatencies> connect_stage_latencies);
+
+    private:
+        void GetConnectStageLatencies(MethodInvocation &invocation) override;
+        void GetMetrics(MethodInvocation &invocation) override;
+
+        std::shared_ptr<const ConnectStageLatencies> connect_stage_latencies_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_DBUS_OBJECTS_METRICS_H
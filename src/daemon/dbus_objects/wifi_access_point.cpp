@@ -15,6 +15,7 @@
 
 #include "common/dbus.h"
 #include "common/string_to_uint64.h"
+#include "daemon/metrics_registry.h"
 
 namespace ConnectivityManager::Daemon
 {
@@ -74,7 +75,7 @@ namespace ConnectivityManager::Daemon
         bool changed = ssid_ != value;
         ssid_ = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     std::string WiFiAccessPoint::SSID_get()
@@ -87,7 +88,7 @@ namespace ConnectivityManager::Daemon
         bool changed = strength_ != value;
         strength_ = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     guchar WiFiAccessPoint::Strength_get()
@@ -100,7 +101,7 @@ namespace ConnectivityManager::Daemon
         bool changed = connected_ != value;
         connected_ = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     bool WiFiAccessPoint::Connected_get()
@@ -118,7 +119,7 @@ namespace ConnectivityManager::Daemon
         bool changed = security_ != value;
         security_ = value;
 
-        return changed;
+        return MetricsRegistry::instance().dbus_property_set(changed);
     }
 
     Glib::ustring WiFiAccessPoint::Security_get()
@@ -12,16 +12,62 @@
 #include <glibmm.h>
 
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <unordered_set>
 
 #include "common/dbus.h"
+#include "daemon/main_loop_monitor.h"
+#include "daemon/metrics_registry.h"
+#include "daemon/tracepoints.h"
 
 namespace ConnectivityManager::Daemon
 {
-    DBusService::DBusService(const Glib::RefPtr<Glib::MainLoop> &main_loop, Backend &backend) :
+    namespace
+    {
+        // Fires backend_signal_handler_begin/end probes around a BackendSignalHandler method.
+        class HandlerTrace
+        {
+        public:
+            explicit HandlerTrace(const char *handler,
+                                  const Backend::WiFiAccessPoint *access_point = nullptr,
+                                  int event = -1) :
+                handler_(handler)
+            {
+                // Args: handler name, access point event (-1 if none), access point id (0 if
+                //       none).
+                CONNECTIVITY_MANAGER_TRACE(
+                    backend_signal_handler_begin,
+                    handler_,
+                    event,
+                    access_point ? access_point->id : Backend::WiFiAccessPoint::ID_EMPTY);
+            }
+
+            ~HandlerTrace()
+            {
+                // Args: handler name.
+                CONNECTIVITY_MANAGER_TRACE(backend_signal_handler_end, handler_);
+            }
+
+            HandlerTrace(const HandlerTrace &other) = delete;
+            HandlerTrace(HandlerTrace &&other) = delete;
+            HandlerTrace &operator=(const HandlerTrace &other) = delete;
+            HandlerTrace &operator=(HandlerTrace &&other) = delete;
+
+        private:
+            const char *const handler_;
+        };
+    }
+
+    DBusService::DBusService(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                             Backend &backend,
+                             Arguments::WiFiAccessPointsOrder wifi_access_points_order) :
         main_loop_(main_loop),
         backend_(backend),
-        manager_(backend)
+        wifi_access_points_order_(wifi_access_points_order),
+        connect_stage_latencies_(std::make_shared<ConnectStageLatencies>()),
+        manager_(backend, connect_stage_latencies_),
+        metrics_(connect_stage_latencies_)
     {
     }
 
@@ -55,9 +101,25 @@ namespace ConnectivityManager::Daemon
         connection_id_ = 0;
     }
 
+    void DBusService::state_dump(StateDump &dump) const
+    {
+        dump.value("bus_acquired", connection_ ? true : false);
+        dump.value("listening_to_backend", backend_signal_handler_.has_value());
+
+        // Manager and Metrics are exported together with the access points once bus is acquired.
+        dump.value("exported_objects", connection_ ? wifi_access_points_.size() + 2 : 0);
+        dump.value("exported_wifi_access_points", wifi_access_points_.size());
+
+        dump.object_begin("manager");
+        manager_.state_dump(dump);
+        dump.object_end();
+    }
+
     void DBusService::bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
                                    const Glib::ustring & /*name*/)
     {
+        MainLoopMonitor::Scope scope("DBusService::bus_acquired");
+
         connection_ = connection;
 
         backend_signal_handler_.emplace(*this);
@@ -73,6 +135,11 @@ namespace ConnectivityManager::Daemon
             main_loop_->quit();
             return;
         }
+
+        if (metrics_.register_object(connection_, Common::DBus::METRICS_OBJECT_PATH) == 0) {
+            main_loop_->quit();
+            return;
+        }
     }
 
     void DBusService::name_acquired(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
@@ -90,6 +157,9 @@ namespace ConnectivityManager::Daemon
 
     bool DBusService::wifi_access_points_create_all_and_register_on_bus()
     {
+        MainLoopMonitor::Scope scope(
+            "DBusService::wifi_access_points_create_all_and_register_on_bus");
+
         assert(connection_);
 
         wifi_access_points_.clear();
@@ -112,27 +182,44 @@ namespace ConnectivityManager::Daemon
     std::vector<Glib::DBusObjectPathString> DBusService::wifi_access_point_paths_sorted() const
     {
         std::vector<Glib::DBusObjectPathString> paths;
+        paths.reserve(wifi_access_points_.size());
+
+        // TODO: Sorted in order suitable to present to user, by strength etc. when order is ID.
+        //
+        // Stored in std::map with id as key so paths are sorted by id for
+        // Arguments::WiFiAccessPointsOrder::ID. Sorting, if added, should be done in Backend and
+        // reported through Backend::State::wifi::access_points_order (as done for BACKEND) so it
+        // is easy to test and does not leak which events affect order out of Backend.
+
+        if (wifi_access_points_order_ == Arguments::WiFiAccessPointsOrder::BACKEND) {
+            for (WiFiAccessPoint::Id id : backend_.state().wifi.access_points_order) {
+                auto i = wifi_access_points_.find(id);
+                if (i != wifi_access_points_.cend()) {
+                    paths.emplace_back(i->second->object_path());
+                }
+            }
+
+            if (paths.size() == wifi_access_points_.size()) {
+                return paths;
+            }
+
+            // Backend order not up to date (e.g. access point just added). Append missing at end.
+            const auto &order = backend_.state().wifi.access_points_order;
+            std::unordered_set<WiFiAccessPoint::Id> ordered(order.cbegin(), order.cend());
+
+            for (const auto &[id, access_point] : wifi_access_points_) {
+                if (ordered.count(id) == 0) {
+                    paths.emplace_back(access_point->object_path());
+                }
+            }
+
+            return paths;
+        }
 
         for (const auto &key_value : wifi_access_points_) {
             paths.emplace_back(key_value.second->object_path());
         }
 
-        // TODO: Sorted in order suitable to present to user, by strength etc.
-        //
-        // Stored in std::map with id as key so paths are sorted by id now.
-        //
-        // Have "std::vector<WiFiAccessPoint::Id> wifi.access_points_sorted" in Backend::State (or
-        // pointers to elements in wifi.access_points, elements will not move). If in Backend it
-        // will be easier to test. Could also add e.g. a "SORT_ORDER_CHANGED" entry in
-        // Backend::WiFiAccessPoint::Event and only update paths property when that event is
-        // received instead of listening to all events that may change order (prevents abstraction
-        // leak... if logic changes, e.g. another field affects order, one would have to listen to
-        // extra events outside of Backend, better with explicit "sort order changed" event).
-        //
-        // If sorting should be handled in DBusService, property must be set on more
-        // Backend::WiFiAccessPoint::Event:s than now. But, leaning towards handling sorting in
-        // Backend as mentioned above so unit tests can be added for it more easily.
-
         return paths;
     }
 
@@ -147,6 +234,9 @@ namespace ConnectivityManager::Daemon
         signals.wifi.access_points_changed.connect(
             sigc::mem_fun(*this, &BackendSignalHandler::wifi_access_points_changed));
 
+        signals.wifi.scan_finished.connect(
+            sigc::mem_fun(*this, &BackendSignalHandler::wifi_scan_finished));
+
         signals.wifi.hotspot_status_changed.connect(
             sigc::mem_fun(*this, &BackendSignalHandler::wifi_hotspot_status_changed));
 
@@ -159,6 +249,9 @@ namespace ConnectivityManager::Daemon
 
     void DBusService::BackendSignalHandler::wifi_status_changed(Backend::WiFiStatus status) const
     {
+        MainLoopMonitor::Scope scope("DBusService::BackendSignalHandler::wifi_status_changed");
+        HandlerTrace trace("wifi_status_changed");
+
         service_.manager_.WiFiAvailable_set(status != Backend::WiFiStatus::UNAVAILABLE);
         service_.manager_.WiFiEnabled_set(status == Backend::WiFiStatus::ENABLED);
     }
@@ -167,6 +260,10 @@ namespace ConnectivityManager::Daemon
         Backend::WiFiAccessPoint::Event event,
         const Backend::WiFiAccessPoint *access_point) const
     {
+        MainLoopMonitor::Scope scope(
+            "DBusService::BackendSignalHandler::wifi_access_points_changed");
+        HandlerTrace trace("wifi_access_points_changed", access_point, static_cast<int>(event));
+
         bool update_aps_property = false;
 
         switch (event) {
@@ -192,6 +289,11 @@ namespace ConnectivityManager::Daemon
             update_aps_property = true;
             break;
 
+        case Backend::WiFiAccessPoint::Event::ORDER_CHANGED:
+            update_aps_property = service_.wifi_access_points_order_ ==
+                                  Arguments::WiFiAccessPointsOrder::BACKEND;
+            break;
+
         case Backend::WiFiAccessPoint::Event::SSID_CHANGED:
             service_.wifi_access_points_[access_point->id]->SSID_set(access_point->ssid);
             break;
@@ -214,20 +316,36 @@ namespace ConnectivityManager::Daemon
         }
     }
 
+    void DBusService::BackendSignalHandler::wifi_scan_finished(bool success,
+                                                               std::uint32_t duration_ms) const
+    {
+        MainLoopMonitor::Scope scope("DBusService::BackendSignalHandler::wifi_scan_finished");
+        HandlerTrace trace("wifi_scan_finished");
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::DBUS_SIGNALS_SENT);
+        service_.manager_.ScanFinished_signal.emit(success, duration_ms);
+    }
+
     void DBusService::BackendSignalHandler::wifi_hotspot_status_changed(
         Backend::WiFiHotspotStatus status) const
     {
+        HandlerTrace trace("wifi_hotspot_status_changed");
+
         service_.manager_.WiFiHotspotEnabled_set(status == Backend::WiFiHotspotStatus::ENABLED);
     }
 
     void DBusService::BackendSignalHandler::wifi_hotspot_ssid_changed(const std::string &ssid) const
     {
+        HandlerTrace trace("wifi_hotspot_ssid_changed");
+
         service_.manager_.WiFiHotspotSSID_set(ssid);
     }
 
     void DBusService::BackendSignalHandler::wifi_hotspot_passphrase_changed(
         const Glib::ustring &passphrase) const
     {
+        HandlerTrace trace("wifi_hotspot_passphrase_changed");
+
         service_.manager_.WiFiHotspotPassphrase_set(passphrase);
     }
 }
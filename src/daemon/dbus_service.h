@@ -12,22 +12,29 @@
 #include <glibmm.h>
 #include <sigc++/sigc++.h>
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "daemon/arguments.h"
 #include "daemon/backend.h"
+#include "daemon/connect_trace.h"
 #include "daemon/dbus_objects/manager.h"
+#include "daemon/dbus_objects/metrics.h"
 #include "daemon/dbus_objects/wifi_access_point.h"
+#include "daemon/state_dump.h"
 
 namespace ConnectivityManager::Daemon
 {
     class DBusService
     {
     public:
-        DBusService(const Glib::RefPtr<Glib::MainLoop> &main_loop, Backend &backend);
+        DBusService(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                    Backend &backend,
+                    Arguments::WiFiAccessPointsOrder wifi_access_points_order);
         ~DBusService();
 
         DBusService(const DBusService &other) = delete;
@@ -38,7 +45,11 @@ namespace ConnectivityManager::Daemon
         void own_name();
         void unown_name();
 
+        void state_dump(StateDump &dump) const;
+
     private:
+        friend class DBusServiceHarness; // For benchmarks, see benchmarks/.
+
         // Helper for listening to backend signals that disconnects automatically when destroyed.
         //
         // Stored in an std::optional to handle the fact that DBusService should not listen to
@@ -53,6 +64,7 @@ namespace ConnectivityManager::Daemon
             void wifi_status_changed(Backend::WiFiStatus status) const;
             void wifi_access_points_changed(Backend::WiFiAccessPoint::Event event,
                                             const Backend::WiFiAccessPoint *access_point) const;
+            void wifi_scan_finished(bool success, std::uint32_t duration_ms) const;
 
             void wifi_hotspot_status_changed(Backend::WiFiHotspotStatus status) const;
             void wifi_hotspot_ssid_changed(const std::string &ssid) const;
@@ -76,10 +88,15 @@ namespace ConnectivityManager::Daemon
         Backend &backend_;
         std::optional<BackendSignalHandler> backend_signal_handler_;
 
+        const Arguments::WiFiAccessPointsOrder wifi_access_points_order_;
+
         guint connection_id_ = 0;
         Glib::RefPtr<Gio::DBus::Connection> connection_;
 
+        std::shared_ptr<ConnectStageLatencies> connect_stage_latencies_;
+
         Manager manager_;
+        Metrics metrics_;
         std::map<WiFiAccessPoint::Id, std::unique_ptr<WiFiAccessPoint>> wifi_access_points_;
     };
 }
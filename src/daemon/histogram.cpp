@@ -0,0 +1,75 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ConnectivityManager::Daemon
+{
+    std::size_t Histogram::bucket_index(std::uint64_t value)
+    {
+        std::size_t index = 0;
+
+        while (value > 0) {
+            value >>= 1;
+            index++;
+        }
+
+        return std::min(index, BUCKET_COUNT - 1);
+    }
+
+    std::uint64_t Histogram::bucket_upper_bound(std::size_t index)
+    {
+        if (index == 0) {
+            return 0;
+        }
+
+        if (index >= BUCKET_COUNT - 1) {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+
+        return (std::uint64_t(1) << index) - 1;
+    }
+
+    void Histogram::add(std::uint64_t value)
+    {
+        count_++;
+        sum_ += value;
+        max_ = std::max(max_, value);
+        buckets_[bucket_index(value)]++;
+    }
+
+    std::uint64_t Histogram::percentile(double percentile) const
+    {
+        if (count_ == 0) {
+            return 0;
+        }
+
+        percentile = std::clamp(percentile, 0.0, 100.0);
+
+        auto rank = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * double(count_)));
+        rank = std::max(rank, std::uint64_t(1));
+
+        std::uint64_t seen = 0;
+
+        for (std::size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets_[i];
+
+            if (seen >= rank) {
+                return std::min(bucket_upper_bound(i), max_);
+            }
+        }
+
+        return max_;
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_HISTOGRAM_H
+#define CONNECTIVITY_MANAGER_DAEMON_HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ConnectivityManager::Daemon
+{
+    // Histogram with fixed power of two buckets.
+    //
+    // Bucket 0 counts values equal to 0 and bucket i (i > 0) counts values in [2^(i-1), 2^i). The
+    // last bucket also counts all values larger than that. Cheap enough to add values to on every
+    // event of interest and small enough to export over D-Bus as is.
+    class Histogram
+    {
+    public:
+        static constexpr std::size_t BUCKET_COUNT = 40;
+
+        using Buckets = std::array<std::uint64_t, BUCKET_COUNT>;
+
+        static std::size_t bucket_index(std::uint64_t value);
+        static std::uint64_t bucket_upper_bound(std::size_t index);
+
+        void add(std::uint64_t value);
+
+        // Upper bound of bucket containing the value at percentile (0-100). 0 if empty.
+        std::uint64_t percentile(double percentile) const;
+
+        std::uint64_t count() const
+        {
+            return count_;
+        }
+
+        std::uint64_t sum() const
+        {
+            return sum_;
+        }
+
+        std::uint64_t max() const
+        {
+            return max_;
+        }
+
+        const Buckets &buckets() const
+        {
+            return buckets_;
+        }
+
+    private:
+        std::uint64_t count_ = 0;
+        std::uint64_t sum_ = 0;
+        std::uint64_t max_ = 0;
+        Buckets buckets_{};
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_HISTOGRAM_H
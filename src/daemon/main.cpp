@@ -43,7 +43,7 @@ int main(int argc, char *argv[])
         return EXIT_SUCCESS;
     }
 
-    Daemon daemon(Backend::create_default());
+    Daemon daemon(Backend::create_default(*arguments), *arguments);
 
     return daemon.run();
 }
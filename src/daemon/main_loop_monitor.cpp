@@ -0,0 +1,145 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/main_loop_monitor.h"
+
+#include <glib.h>
+#include <glibmm.h>
+
+#include <cassert>
+#include <cinttypes>
+
+#include "daemon/metrics_registry.h"
+
+namespace ConnectivityManager::Daemon
+{
+    MainLoopMonitor *MainLoopMonitor::instance_ = nullptr;
+
+    MainLoopMonitor::Scope::Scope(const char *name) :
+        monitor_(instance_),
+        name_(name),
+        start_us_(monitor_ ? g_get_monotonic_time() : 0)
+    {
+    }
+
+    MainLoopMonitor::Scope::~Scope()
+    {
+        if (monitor_) {
+            monitor_->scope_finished(name_, g_get_monotonic_time() - start_us_);
+        }
+    }
+
+    MainLoopMonitor::MainLoopMonitor(std::uint32_t stall_threshold_ms) :
+        stall_threshold_us_(gint64{stall_threshold_ms} * 1000)
+    {
+        assert(!instance_);
+        instance_ = this;
+
+        GMainContext *context = g_main_context_default();
+        previous_poll_ = g_main_context_get_poll_func(context);
+        g_main_context_set_poll_func(context, poll);
+
+        lag_expected_us_ = g_get_monotonic_time() + gint64{LAG_INTERVAL_MS} * 1000;
+        lag_timeout_connection_ = Glib::signal_timeout().connect(
+            sigc::mem_fun(*this, &MainLoopMonitor::lag_timeout),
+            LAG_INTERVAL_MS,
+            Glib::PRIORITY_HIGH);
+    }
+
+    MainLoopMonitor::~MainLoopMonitor()
+    {
+        lag_timeout_connection_.disconnect();
+        g_main_context_set_poll_func(g_main_context_default(), previous_poll_);
+        instance_ = nullptr;
+    }
+
+    void MainLoopMonitor::state_dump(StateDump &dump) const
+    {
+        using Latency = MetricsRegistry::Latency;
+
+        const MetricsRegistry &registry = MetricsRegistry::instance();
+        const Histogram &dispatch = registry.histogram(Latency::MAIN_LOOP_DISPATCH);
+        const Histogram &lag = registry.histogram(Latency::MAIN_LOOP_LAG);
+
+        dump.value("stall_threshold_us", stall_threshold_us_);
+        dump.value("dispatches", dispatch.count());
+        dump.value("dispatch_max_us", dispatch.max());
+        dump.value("lag_max_us", lag.max());
+        dump.value("lag_p99_us", lag.percentile(99));
+        dump.value("stalls", stalls_);
+        dump.value("last_stall_callback", last_stall_callback_ ? last_stall_callback_ : "");
+        dump.value("last_stall_us", last_stall_us_);
+    }
+
+    gint MainLoopMonitor::poll(GPollFD *fds, guint nfds, gint timeout)
+    {
+        MainLoopMonitor *monitor = instance_;
+
+        monitor->dispatch_finished(g_get_monotonic_time());
+
+        gint result = monitor->previous_poll_(fds, nfds, timeout);
+
+        monitor->dispatch_start_us_ = g_get_monotonic_time();
+        monitor->dispatch_stall_reported_ = false;
+
+        return result;
+    }
+
+    void MainLoopMonitor::dispatch_finished(gint64 now_us)
+    {
+        if (dispatch_start_us_ == 0) {
+            return; // First iteration.
+        }
+
+        gint64 duration_us = now_us - dispatch_start_us_;
+
+        MetricsRegistry::instance().add(MetricsRegistry::Latency::MAIN_LOOP_DISPATCH,
+                                        static_cast<std::uint64_t>(duration_us));
+
+        if (duration_us >= stall_threshold_us_ && !dispatch_stall_reported_) {
+            stall(nullptr, duration_us);
+        }
+    }
+
+    void MainLoopMonitor::scope_finished(const char *name, gint64 duration_us)
+    {
+        if (duration_us >= stall_threshold_us_ && !dispatch_stall_reported_) {
+            stall(name, duration_us);
+        }
+    }
+
+    void MainLoopMonitor::stall(const char *callback, gint64 duration_us)
+    {
+        dispatch_stall_reported_ = true;
+
+        stalls_++;
+        last_stall_callback_ = callback;
+        last_stall_us_ = duration_us;
+
+        MetricsRegistry::instance().add(MetricsRegistry::Counter::MAIN_LOOP_STALLS);
+
+        if (callback) {
+            g_warning("Main loop stalled for %" PRId64 " ms in %s", duration_us / 1000, callback);
+        } else {
+            g_warning("Main loop stalled for %" PRId64 " ms (unattributed)", duration_us / 1000);
+        }
+    }
+
+    bool MainLoopMonitor::lag_timeout()
+    {
+        gint64 now_us = g_get_monotonic_time();
+        gint64 lag_us = now_us - lag_expected_us_;
+
+        MetricsRegistry::instance().add(MetricsRegistry::Latency::MAIN_LOOP_LAG,
+                                        static_cast<std::uint64_t>(lag_us > 0 ? lag_us : 0));
+
+        lag_expected_us_ = now_us + gint64{LAG_INTERVAL_MS} * 1000;
+
+        return true;
+    }
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_MAIN_LOOP_MONITOR_H
+#define CONNECTIVITY_MANAGER_DAEMON_MAIN_LOOP_MONITOR_H
+
+#include <glib.h>
+#include <sigc++/sigc++.h>
+
+#include <cstdint>
+
+#include "daemon/state_dump.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Monitors how responsive the default main context is. Everything in the daemon runs there, so
+    // a slow callback delays all D-Bus calls and ConnMan signals queued up behind it.
+    //
+    // Two things are measured and added to MetricsRegistry:
+    //
+    // - Dispatch time (Latency::MAIN_LOOP_DISPATCH): Wall time from poll() returning until the
+    //   next poll(), i.e. time spent dispatching all sources that were ready in one main loop
+    //   iteration. Measured by wrapping the context's poll function since GLib has no hook around
+    //   dispatch of individual sources.
+    //
+    // - Lag (Latency::MAIN_LOOP_LAG): How late a G_PRIORITY_HIGH timer that fires every
+    //   LAG_INTERVAL_MS is dispatched compared to when it should have been.
+    //
+    // A dispatch that takes longer than the stall threshold is counted as a stall
+    // (Counter::MAIN_LOOP_STALLS) and logged with the name of the callback responsible. Callbacks
+    // are named by creating a Scope at their start. The innermost Scope that alone took longer than
+    // the threshold gets the blame, so nested Scope:s narrow down where time was spent. Stalls
+    // outside of any Scope are logged as unattributed.
+    //
+    // There can only be one MainLoopMonitor at a time (the poll function has no user data). Scope
+    // does nothing if there is none.
+    class MainLoopMonitor
+    {
+    public:
+        static constexpr unsigned int LAG_INTERVAL_MS = 1000;
+
+        class Scope
+        {
+        public:
+            explicit Scope(const char *name);
+            ~Scope();
+
+            Scope(const Scope &other) = delete;
+            Scope(Scope &&other) = delete;
+            Scope &operator=(const Scope &other) = delete;
+            Scope &operator=(Scope &&other) = delete;
+
+        private:
+            MainLoopMonitor *const monitor_;
+            const char *const name_;
+            const gint64 start_us_;
+        };
+
+        explicit MainLoopMonitor(std::uint32_t stall_threshold_ms);
+        ~MainLoopMonitor();
+
+        MainLoopMonitor(const MainLoopMonitor &other) = delete;
+        MainLoopMonitor(MainLoopMonitor &&other) = delete;
+        MainLoopMonitor &operator=(const MainLoopMonitor &other) = delete;
+        MainLoopMonitor &operator=(MainLoopMonitor &&other) = delete;
+
+        std::uint64_t stalls() const
+        {
+            return stalls_;
+        }
+
+        // Name of callback responsible for last stall, null if none or unattributed.
+        const char *last_stall_callback() const
+        {
+            return last_stall_callback_;
+        }
+
+        void state_dump(StateDump &dump) const;
+
+    private:
+        static gint poll(GPollFD *fds, guint nfds, gint timeout);
+
+        void dispatch_finished(gint64 now_us);
+        void scope_finished(const char *name, gint64 duration_us);
+        void stall(const char *callback, gint64 duration_us);
+
+        bool lag_timeout();
+
+        static MainLoopMonitor *instance_;
+
+        const gint64 stall_threshold_us_;
+        GPollFunc previous_poll_ = nullptr;
+
+        gint64 dispatch_start_us_ = 0;
+        bool dispatch_stall_reported_ = false;
+
+        sigc::connection lag_timeout_connection_;
+        gint64 lag_expected_us_ = 0;
+
+        std::uint64_t stalls_ = 0;
+        const char *last_stall_callback_ = nullptr;
+        gint64 last_stall_us_ = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_MAIN_LOOP_MONITOR_H
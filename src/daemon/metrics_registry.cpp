@@ -0,0 +1,149 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/metrics_registry.h"
+
+#include <cstddef>
+
+namespace ConnectivityManager::Daemon
+{
+    MetricsRegistry &MetricsRegistry::instance()
+    {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    const char *MetricsRegistry::counter_to_string(Counter counter)
+    {
+        switch (counter) {
+        case Counter::CONNMAN_SIGNALS_RECEIVED:
+            return "connman_signals_received";
+        case Counter::CONNMAN_PROPERTIES_DECODED:
+            return "connman_properties_decoded";
+        case Counter::BACKEND_EVENTS_EMITTED:
+            return "backend_events_emitted";
+        case Counter::DBUS_SIGNALS_SENT:
+            return "dbus_signals_sent";
+        case Counter::CREDENTIALS_REQUESTS:
+            return "credentials_requests";
+        case Counter::MAIN_LOOP_STALLS:
+            return "main_loop_stalls";
+        case Counter::WIFI_SCANS_REQUESTED:
+            return "wifi_scans_requested";
+        case Counter::WIFI_SCANS_COALESCED:
+            return "wifi_scans_coalesced";
+        case Counter::WIFI_SCANS_ISSUED:
+            return "wifi_scans_issued";
+        case Counter::WIFI_SCANS_FAILED:
+            return "wifi_scans_failed";
+        case Counter::AGENT_REGISTRATIONS:
+            return "connman_agent_registrations";
+        case Counter::AGENT_REGISTRATION_FAILURES:
+            return "connman_agent_registration_failures";
+        case Counter::AGENT_RELEASES:
+            return "connman_agent_releases";
+        case Counter::COUNT:
+            break;
+        }
+        return "unknown";
+    }
+
+    const char *MetricsRegistry::gauge_to_string(Gauge gauge)
+    {
+        switch (gauge) {
+        case Gauge::CONNECT_QUEUE_DEPTH:
+            return "connect_queue_depth";
+        case Gauge::PENDING_CONNECTS:
+            return "pending_connects";
+        case Gauge::AGENT_REGISTERED:
+            return "connman_agent_registered";
+        case Gauge::COUNT:
+            break;
+        }
+        return "unknown";
+    }
+
+    const char *MetricsRegistry::method_to_string(Method method)
+    {
+        switch (method) {
+        case Method::CONNECT:
+            return "Connect";
+        case Method::CONNECT_WITH_CREDENTIALS:
+            return "ConnectWithCredentials";
+        case Method::CANCEL_CONNECT:
+            return "CancelConnect";
+        case Method::DISCONNECT:
+            return "Disconnect";
+        case Method::SCAN:
+            return "Scan";
+        case Method::CONFIGURE_HOTSPOT:
+            return "ConfigureHotspot";
+        case Method::COUNT:
+            break;
+        }
+        return "unknown";
+    }
+
+    const char *MetricsRegistry::latency_to_string(Latency latency)
+    {
+        switch (latency) {
+        case Latency::CONNECT:
+            return "connect";
+        case Latency::SET_PROPERTY:
+            return "set_property";
+        case Latency::SCAN:
+            return "scan";
+        case Latency::MAIN_LOOP_DISPATCH:
+            return "main_loop_dispatch";
+        case Latency::MAIN_LOOP_LAG:
+            return "main_loop_lag";
+        case Latency::COUNT:
+            break;
+        }
+        return "unknown";
+    }
+
+    void MetricsRegistry::state_dump(StateDump &dump) const
+    {
+        dump.object_begin("counters");
+        for (std::size_t i = 0; i < COUNTER_COUNT; i++) {
+            auto counter = static_cast<Counter>(i);
+            dump.value(counter_to_string(counter), value(counter));
+        }
+        dump.object_end();
+
+        dump.object_begin("gauges");
+        for (std::size_t i = 0; i < GAUGE_COUNT; i++) {
+            auto gauge = static_cast<Gauge>(i);
+            dump.value(gauge_to_string(gauge), value(gauge));
+        }
+        dump.object_end();
+
+        dump.object_begin("method_calls");
+        for (std::size_t i = 0; i < METHOD_COUNT; i++) {
+            auto method = static_cast<Method>(i);
+            dump.value(method_to_string(method), calls(method));
+        }
+        dump.object_end();
+
+        dump.object_begin("latencies_us");
+        for (std::size_t i = 0; i < LATENCY_COUNT; i++) {
+            auto latency = static_cast<Latency>(i);
+            const Histogram &values = histogram(latency);
+
+            dump.object_begin(latency_to_string(latency));
+            dump.value("count", values.count());
+            dump.value("sum", values.sum());
+            dump.value("max", values.max());
+            dump.value("p50", values.percentile(50));
+            dump.value("p99", values.percentile(99));
+            dump.object_end();
+        }
+        dump.object_end();
+    }
+}
@@ -0,0 +1,163 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_METRICS_REGISTRY_H
+#define CONNECTIVITY_MANAGER_DAEMON_METRICS_REGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "daemon/histogram.h"
+#include "daemon/state_dump.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Counters, gauges and latency histograms exported through the Metrics D-Bus interface.
+    //
+    // There is one registry for the daemon, reached through instance(), since values are recorded
+    // in many places that otherwise have nothing in common (ConnMan objects, Backend, D-Bus
+    // objects). Everything is stored in fixed size arrays indexed by the enums below so recording
+    // is an increment or Histogram::add(), without allocation or lookup, and can be left on in
+    // production. Not thread-safe, only used from the main loop like the rest of the daemon.
+    //
+    // Latencies are in microseconds.
+    class MetricsRegistry
+    {
+    public:
+        enum class Counter
+        {
+            CONNMAN_SIGNALS_RECEIVED,    // Signals from ConnMan (PropertyChanged etc.).
+            CONNMAN_PROPERTIES_DECODED,  // ConnMan property values decoded from variants.
+            BACKEND_EVENTS_EMITTED,      // Emissions of Backend::Signals.
+            DBUS_SIGNALS_SENT,           // Signals, including PropertiesChanged, sent by daemon.
+            CREDENTIALS_REQUESTS,        // RequestCredentials() calls to user input agents.
+            MAIN_LOOP_STALLS,            // Dispatches over threshold, see MainLoopMonitor.
+            WIFI_SCANS_REQUESTED,        // Scans requested, see ConnManScanScheduler.
+            WIFI_SCANS_COALESCED,        // Requested scans joined with a scan in flight.
+            WIFI_SCANS_ISSUED,           // Scans issued to ConnMan, periodic and requested.
+            WIFI_SCANS_FAILED,           // Issued scans that failed.
+            AGENT_REGISTRATIONS,         // Agent registrations started, see ConnManAgent.
+            AGENT_REGISTRATION_FAILURES, // Registrations that failed (object or manager).
+            AGENT_RELEASES,              // Release() calls from ConnMan.
+
+            COUNT // Number of enumerators above, not a counter.
+        };
+
+        enum class Gauge
+        {
+            CONNECT_QUEUE_DEPTH, // Services queued up or connecting in backend.
+            PENDING_CONNECTS,    // Connect method calls not yet replied to.
+            AGENT_REGISTERED,    // 1 if agent is registered with ConnMan, else 0.
+
+            COUNT // Number of enumerators above, not a gauge.
+        };
+
+        enum class Method
+        {
+            CONNECT,
+            CONNECT_WITH_CREDENTIALS,
+            CANCEL_CONNECT,
+            DISCONNECT,
+            SCAN,
+            CONFIGURE_HOTSPOT,
+
+            COUNT // Number of enumerators above, not a method.
+        };
+
+        enum class Latency
+        {
+            CONNECT,            // Connect request received until result is known.
+            SET_PROPERTY,       // ConnMan SetProperty() sent until reply received.
+            SCAN,               // Wi-Fi scan started until finished.
+            MAIN_LOOP_DISPATCH, // Time to dispatch one main loop iteration, see MainLoopMonitor.
+            MAIN_LOOP_LAG,      // Delay of high priority timer, see MainLoopMonitor.
+
+            COUNT // Number of enumerators above, not a latency.
+        };
+
+        static constexpr auto COUNTER_COUNT = static_cast<std::size_t>(Counter::COUNT);
+        static constexpr auto GAUGE_COUNT = static_cast<std::size_t>(Gauge::COUNT);
+        static constexpr auto METHOD_COUNT = static_cast<std::size_t>(Method::COUNT);
+        static constexpr auto LATENCY_COUNT = static_cast<std::size_t>(Latency::COUNT);
+
+        MetricsRegistry() = default;
+
+        MetricsRegistry(const MetricsRegistry &other) = delete;
+        MetricsRegistry(MetricsRegistry &&other) = delete;
+        MetricsRegistry &operator=(const MetricsRegistry &other) = delete;
+        MetricsRegistry &operator=(MetricsRegistry &&other) = delete;
+
+        static MetricsRegistry &instance();
+
+        static const char *counter_to_string(Counter counter);
+        static const char *gauge_to_string(Gauge gauge);
+        static const char *method_to_string(Method method);
+        static const char *latency_to_string(Latency latency);
+
+        void add(Counter counter, std::uint64_t n = 1)
+        {
+            counters_[static_cast<std::size_t>(counter)] += n;
+        }
+
+        void set(Gauge gauge, std::uint64_t value)
+        {
+            gauges_[static_cast<std::size_t>(gauge)] = value;
+        }
+
+        void method_called(Method method)
+        {
+            method_calls_[static_cast<std::size_t>(method)]++;
+        }
+
+        // For *_setHandler() in D-Bus objects. The generated stubs emit PropertiesChanged when the
+        // handler returns true, so count a sent signal if changed. Returns changed.
+        bool dbus_property_set(bool changed)
+        {
+            if (changed) {
+                add(Counter::DBUS_SIGNALS_SENT);
+            }
+            return changed;
+        }
+
+        void add(Latency latency, std::uint64_t latency_us)
+        {
+            latencies_[static_cast<std::size_t>(latency)].add(latency_us);
+        }
+
+        std::uint64_t value(Counter counter) const
+        {
+            return counters_[static_cast<std::size_t>(counter)];
+        }
+
+        std::uint64_t value(Gauge gauge) const
+        {
+            return gauges_[static_cast<std::size_t>(gauge)];
+        }
+
+        std::uint64_t calls(Method method) const
+        {
+            return method_calls_[static_cast<std::size_t>(method)];
+        }
+
+        const Histogram &histogram(Latency latency) const
+        {
+            return latencies_[static_cast<std::size_t>(latency)];
+        }
+
+        void state_dump(StateDump &dump) const;
+
+    private:
+        std::array<std::uint64_t, COUNTER_COUNT> counters_{};
+        std::array<std::uint64_t, GAUGE_COUNT> gauges_{};
+        std::array<std::uint64_t, METHOD_COUNT> method_calls_{};
+        std::array<Histogram, LATENCY_COUNT> latencies_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_METRICS_REGISTRY_H
@@ -0,0 +1,114 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/roaming_engine.h"
+
+#include <glib.h>
+
+#include <cinttypes>
+
+namespace ConnectivityManager::Daemon
+{
+    RoamingEngine::RoamingEngine(Backend &backend) : backend_(backend)
+    {
+        backend_.signals().wifi.access_points_changed.connect(
+            sigc::mem_fun(*this, &RoamingEngine::access_points_changed));
+
+        add_all();
+    }
+
+    void RoamingEngine::access_points_changed(Backend::WiFiAccessPoint::Event event,
+                                              const Backend::WiFiAccessPoint *access_point)
+    {
+        using Event = Backend::WiFiAccessPoint::Event;
+
+        switch (event) {
+        case Event::ADDED_ALL:
+            add_all();
+            break;
+
+        case Event::REMOVED_ALL:
+            policy_.clear();
+            break;
+
+        case Event::ADDED_ONE:
+        case Event::SSID_CHANGED:
+        case Event::SECURITY_CHANGED:
+            policy_.add(*access_point, g_get_monotonic_time());
+            break;
+
+        case Event::REMOVED_ONE:
+            policy_.remove(access_point->id);
+            break;
+
+        case Event::STRENGTH_CHANGED:
+            policy_.strength_changed(access_point->id, access_point->strength);
+            roam_if_needed();
+            break;
+
+        case Event::CONNECTED_CHANGED:
+            policy_.connected_changed(
+                access_point->id, access_point->connected, g_get_monotonic_time());
+            roam_if_needed();
+            break;
+
+        case Event::ORDER_CHANGED:
+            break;
+        }
+    }
+
+    void RoamingEngine::add_all()
+    {
+        policy_.clear();
+
+        for (const auto &[id, access_point] : backend_.state().wifi.access_points) {
+            policy_.add(access_point, g_get_monotonic_time());
+        }
+    }
+
+    void RoamingEngine::roam_if_needed()
+    {
+        if (roaming_) {
+            return;
+        }
+
+        gint64 now_us = g_get_monotonic_time();
+
+        auto id = policy_.candidate(now_us);
+        if (!id) {
+            return;
+        }
+
+        const auto &access_points = backend_.state().wifi.access_points;
+
+        auto i = access_points.find(*id);
+        if (i == access_points.cend()) {
+            return;
+        }
+
+        g_info("Roaming to Wi-Fi access point %" PRIu64 " (\"%s\", smoothed strength %u)",
+               *id,
+               i->second.ssid.c_str(),
+               static_cast<unsigned int>(policy_.smoothed_strength(*id).value_or(0)));
+
+        roaming_ = true;
+        policy_.roam_started(now_us);
+
+        backend_.wifi_connect(
+            i->second,
+            [this](Backend::ConnectResult result) {
+                roaming_ = false;
+
+                if (result != Backend::ConnectResult::SUCCESS) {
+                    g_warning("Failed to roam to stronger Wi-Fi access point");
+                }
+            },
+            {},
+            nullptr);
+    }
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_ROAMING_ENGINE_H
+#define CONNECTIVITY_MANAGER_DAEMON_ROAMING_ENGINE_H
+
+#include <sigc++/sigc++.h>
+
+#include "daemon/backend.h"
+#include "daemon/roaming_policy.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Roams to a stronger Wi-Fi access point in the background. Only created if enabled on the
+    // command line (Arguments::wifi_roaming).
+    //
+    // Feeds Backend access point signals to a RoamingPolicy and connects to the candidate it
+    // returns, if any, whenever strength or connection status changes. Connects are done without
+    // a way to request credentials from the user, so only access points the backend already has
+    // credentials for can be roamed to. At most one roaming connect is in flight at a time.
+    class RoamingEngine : public sigc::trackable
+    {
+    public:
+        explicit RoamingEngine(Backend &backend);
+
+        RoamingEngine(const RoamingEngine &other) = delete;
+        RoamingEngine(RoamingEngine &&other) = delete;
+        RoamingEngine &operator=(const RoamingEngine &other) = delete;
+        RoamingEngine &operator=(RoamingEngine &&other) = delete;
+
+    private:
+        void access_points_changed(Backend::WiFiAccessPoint::Event event,
+                                   const Backend::WiFiAccessPoint *access_point);
+
+        void add_all();
+        void roam_if_needed();
+
+        Backend &backend_;
+        RoamingPolicy policy_;
+        bool roaming_ = false;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_ROAMING_ENGINE_H
@@ -0,0 +1,123 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/roaming_policy.h"
+
+namespace ConnectivityManager::Daemon
+{
+    void RoamingPolicy::add(const Backend::WiFiAccessPoint &access_point, gint64 now_us)
+    {
+        remove(access_point.id);
+
+        AccessPoint &added = access_points_[access_point.id];
+        added.network = {access_point.ssid, access_point.security};
+        added.smoothed_strength_x100 = access_point.strength * 100;
+
+        networks_[added.network].insert(access_point.id);
+
+        if (access_point.connected) {
+            connected_changed(access_point.id, true, now_us);
+        }
+    }
+
+    void RoamingPolicy::remove(Id id)
+    {
+        auto i = access_points_.find(id);
+        if (i == access_points_.end()) {
+            return;
+        }
+
+        auto network = networks_.find(i->second.network);
+        network->second.erase(id);
+        if (network->second.empty()) {
+            networks_.erase(network);
+        }
+
+        access_points_.erase(i);
+
+        if (connected_ == id) {
+            connected_.reset();
+        }
+    }
+
+    void RoamingPolicy::clear()
+    {
+        access_points_.clear();
+        networks_.clear();
+        connected_.reset();
+    }
+
+    void RoamingPolicy::strength_changed(Id id, Strength strength)
+    {
+        auto i = access_points_.find(id);
+        if (i == access_points_.end()) {
+            return;
+        }
+
+        int &smoothed = i->second.smoothed_strength_x100;
+        smoothed += (strength * 100 - smoothed) * SMOOTHING_WEIGHT_PERCENT / 100;
+    }
+
+    void RoamingPolicy::connected_changed(Id id, bool connected, gint64 now_us)
+    {
+        if (connected) {
+            if (connected_ != id) {
+                connected_ = id;
+                connected_since_us_ = now_us;
+            }
+        } else if (connected_ == id) {
+            connected_.reset();
+        }
+    }
+
+    void RoamingPolicy::roam_started(gint64 now_us)
+    {
+        last_roam_us_ = now_us;
+    }
+
+    std::optional<RoamingPolicy::Id> RoamingPolicy::candidate(gint64 now_us) const
+    {
+        if (!connected_ || now_us - connected_since_us_ < DWELL_TIME_US) {
+            return {};
+        }
+
+        if (last_roam_us_ && now_us - *last_roam_us_ < DWELL_TIME_US) {
+            return {};
+        }
+
+        const AccessPoint &current = access_points_.at(*connected_);
+
+        if (current.smoothed_strength_x100 >= TRIGGER_STRENGTH * 100) {
+            return {};
+        }
+
+        std::optional<Id> best;
+        int best_strength_x100 = current.smoothed_strength_x100 + HYSTERESIS * 100;
+
+        for (Id id : networks_.at(current.network)) {
+            int strength_x100 = access_points_.at(id).smoothed_strength_x100;
+
+            if (id != *connected_ && strength_x100 >= best_strength_x100) {
+                best = id;
+                best_strength_x100 = strength_x100;
+            }
+        }
+
+        return best;
+    }
+
+    std::optional<RoamingPolicy::Strength> RoamingPolicy::smoothed_strength(Id id) const
+    {
+        auto i = access_points_.find(id);
+        if (i == access_points_.end()) {
+            return {};
+        }
+
+        return static_cast<Strength>((i->second.smoothed_strength_x100 + 50) / 100);
+    }
+}
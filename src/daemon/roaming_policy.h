@@ -0,0 +1,83 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_ROAMING_POLICY_H
+#define CONNECTIVITY_MANAGER_DAEMON_ROAMING_POLICY_H
+
+#include <glib.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "daemon/backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    // Decides when to roam from the connected Wi-Fi access point to a stronger one. Used by
+    // RoamingEngine, kept free of Backend signals and timers so it is easy to test.
+    //
+    // Strength is smoothed per access point with an exponentially weighted moving average
+    // (SMOOTHING_WEIGHT_PERCENT is the weight of a new sample) to not react on single dips.
+    //
+    // Candidates are access points with the same SSID and security as the connected one, i.e.
+    // ones the backend should have credentials for. They are indexed on (SSID, security) so
+    // finding a candidate only looks at access points in the same network.
+    //
+    // candidate() returns the strongest candidate if all of the following holds:
+    //
+    // - Smoothed strength of the connected access point is below TRIGGER_STRENGTH.
+    // - Smoothed strength of the candidate is at least HYSTERESIS above the connected one.
+    // - Connected for at least DWELL_TIME_US and no roam started within DWELL_TIME_US (together
+    //   with the hysteresis this prevents ping-pong between two access points).
+    class RoamingPolicy
+    {
+    public:
+        using Id = Backend::WiFiAccessPoint::Id;
+        using Strength = Backend::WiFiAccessPoint::Strength;
+
+        static constexpr Strength TRIGGER_STRENGTH = 35;
+        static constexpr Strength HYSTERESIS = 15;
+        static constexpr gint64 DWELL_TIME_US = 30 * G_USEC_PER_SEC;
+        static constexpr int SMOOTHING_WEIGHT_PERCENT = 30;
+
+        void add(const Backend::WiFiAccessPoint &access_point, gint64 now_us);
+        void remove(Id id);
+        void clear();
+
+        void strength_changed(Id id, Strength strength);
+        void connected_changed(Id id, bool connected, gint64 now_us);
+
+        void roam_started(gint64 now_us);
+
+        std::optional<Id> candidate(gint64 now_us) const;
+
+        std::optional<Strength> smoothed_strength(Id id) const;
+
+    private:
+        using NetworkKey = std::pair<std::string, Backend::WiFiSecurity>;
+
+        struct AccessPoint
+        {
+            NetworkKey network;
+            int smoothed_strength_x100 = 0; // Fixed point, strength * 100.
+        };
+
+        std::unordered_map<Id, AccessPoint> access_points_;
+        std::map<NetworkKey, std::unordered_set<Id>> networks_;
+
+        std::optional<Id> connected_;
+        gint64 connected_since_us_ = 0;
+        std::optional<gint64> last_roam_us_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_ROAMING_POLICY_H
@@ -0,0 +1,148 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/state_dump.h"
+
+#include <cassert>
+#include <cstdio>
+#include <utility>
+
+namespace ConnectivityManager::Daemon
+{
+    StateDump::StateDump()
+    {
+        object_begin();
+    }
+
+    void StateDump::object_begin(const char *name)
+    {
+        separator_and_name(name);
+        json_ += '{';
+        first_in_scope_.push_back(true);
+    }
+
+    void StateDump::object_end()
+    {
+        assert(!first_in_scope_.empty());
+        first_in_scope_.pop_back();
+        json_ += '}';
+    }
+
+    void StateDump::array_begin(const char *name)
+    {
+        separator_and_name(name);
+        json_ += '[';
+        first_in_scope_.push_back(true);
+    }
+
+    void StateDump::array_end()
+    {
+        assert(!first_in_scope_.empty());
+        first_in_scope_.pop_back();
+        json_ += ']';
+    }
+
+    void StateDump::value(const char *name, const std::string &value)
+    {
+        separator_and_name(name);
+        json_ += '"';
+        json_ += escape(value);
+        json_ += '"';
+    }
+
+    void StateDump::value(const char *name, const char *value)
+    {
+        this->value(name, std::string(value));
+    }
+
+    void StateDump::value(const char *name, std::uint64_t value)
+    {
+        separator_and_name(name);
+        json_ += std::to_string(value);
+    }
+
+    void StateDump::value(const char *name, std::int64_t value)
+    {
+        separator_and_name(name);
+        json_ += std::to_string(value);
+    }
+
+    void StateDump::value(const char *name, bool value)
+    {
+        separator_and_name(name);
+        json_ += value ? "true" : "false";
+    }
+
+    void StateDump::container(const char *name, std::size_t size, std::size_t capacity)
+    {
+        object_begin(name);
+        value("size", static_cast<std::uint64_t>(size));
+        value("capacity", static_cast<std::uint64_t>(capacity));
+        object_end();
+    }
+
+    std::string StateDump::finish()
+    {
+        object_end();
+        assert(first_in_scope_.empty());
+
+        json_ += '\n';
+
+        return std::move(json_);
+    }
+
+    std::string StateDump::escape(const std::string &str)
+    {
+        std::string escaped;
+        escaped.reserve(str.size());
+
+        for (char c : str) {
+            switch (c) {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[7];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+                break;
+            }
+        }
+
+        return escaped;
+    }
+
+    void StateDump::separator_and_name(const char *name)
+    {
+        if (!first_in_scope_.empty()) {
+            if (!first_in_scope_.back()) {
+                json_ += ',';
+            }
+            first_in_scope_.back() = false;
+        }
+
+        if (name) {
+            json_ += '"';
+            json_ += escape(name);
+            json_ += "\":";
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_STATE_DUMP_H
+#define CONNECTIVITY_MANAGER_DAEMON_STATE_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ConnectivityManager::Daemon
+{
+    // Minimal JSON writer for the internal state dump written on SIGUSR1 (see Daemon).
+    //
+    // Objects that have state worth inspecting in the field implement a state_dump(StateDump &)
+    // method that writes their members with the methods below. Names are only used inside objects
+    // and must be null inside arrays. Only does what the dump needs, no validation of nesting
+    // except assertions.
+    //
+    // Sizes of containers are written with container() as {"size": n, "capacity": n} where
+    // capacity is capacity() for vectors and bucket_count() for unordered containers, to make it
+    // possible to spot containers that have grown and never shrunk.
+    class StateDump
+    {
+    public:
+        StateDump();
+
+        void object_begin(const char *name = nullptr);
+        void object_end();
+
+        void array_begin(const char *name = nullptr);
+        void array_end();
+
+        void value(const char *name, const std::string &value);
+        void value(const char *name, const char *value);
+        void value(const char *name, std::uint64_t value);
+        void value(const char *name, std::int64_t value);
+        void value(const char *name, bool value);
+
+        void value(const char *name, unsigned int value)
+        {
+            this->value(name, static_cast<std::uint64_t>(value));
+        }
+
+        void value(const char *name, int value)
+        {
+            this->value(name, static_cast<std::int64_t>(value));
+        }
+
+        void container(const char *name, std::size_t size, std::size_t capacity);
+
+        // Finishes the outermost object and returns the JSON document.
+        std::string finish();
+
+        static std::string escape(const std::string &str);
+
+    private:
+        void separator_and_name(const char *name);
+
+        std::string json_;
+        std::vector<bool> first_in_scope_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_STATE_DUMP_H
@@ -0,0 +1,21 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/tracepoints.h"
+
+#if CONNECTIVITY_MANAGER_USDT
+
+// Semaphores are incremented by tracers when attaching to a probe. Must be in the .probes section
+// and have C linkage (from the declarations in tracepoints.h) since the SDT notes refer to them by
+// symbol name.
+#define CONNECTIVITY_MANAGER_TRACEPOINT_SEMAPHORE_DEFINE(name)                                     \
+    __attribute__((section(".probes"))) unsigned short connectivity_manager_##name##_semaphore = 0;
+
+CONNECTIVITY_MANAGER_TRACEPOINTS(CONNECTIVITY_MANAGER_TRACEPOINT_SEMAPHORE_DEFINE)
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_DAEMON_TRACEPOINTS_H
+#define CONNECTIVITY_MANAGER_DAEMON_TRACEPOINTS_H
+
+#include <glib.h>
+
+#include "config.h"
+
+// Static user space tracepoints (USDT, SystemTap SDT probes) on hot paths in the daemon. Used to
+// measure latencies with e.g. bpftrace in production without rebuilding, see README.md.
+//
+// All probes have the provider "connectivity_manager" and the time from g_get_monotonic_time()
+// (microseconds) as first argument (arg0). Remaining arguments are listed where each probe is
+// fired. Pointers to objects (e.g. ConnManService) are passed as ids to correlate probes with
+// each other and strings are passed as const char *.
+//
+// Probes use semaphores so arguments are only evaluated when a tracer is attached, when not
+// attached the cost is a test of a global and a nop. When built without sys/sdt.h (meson option
+// "usdt") CONNECTIVITY_MANAGER_TRACE() generates no code, but its arguments are still compiled, so
+// they must be valid in both configurations.
+//
+// New probes must be added to CONNECTIVITY_MANAGER_TRACEPOINTS since every probe needs a
+// semaphore defined in tracepoints.cpp.
+
+// clang-format off
+#define CONNECTIVITY_MANAGER_TRACEPOINTS(X)     \
+    X(backend_signal_handler_begin)             \
+    X(backend_signal_handler_end)               \
+    X(backend_wifi_access_point_changed)        \
+    X(connman_agent_request_input)              \
+    X(connman_agent_request_input_reply)        \
+    X(connman_connect_queue_transition)         \
+    X(connman_manager_services_changed)         \
+    X(connman_service_property_changed)
+// clang-format on
+
+#if CONNECTIVITY_MANAGER_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define CONNECTIVITY_MANAGER_TRACEPOINT_SEMAPHORE_DECLARE(name)                                    \
+    extern "C" unsigned short connectivity_manager_##name##_semaphore;
+
+CONNECTIVITY_MANAGER_TRACEPOINTS(CONNECTIVITY_MANAGER_TRACEPOINT_SEMAPHORE_DECLARE)
+
+#define CONNECTIVITY_MANAGER_TRACE(name, ...)                                                      \
+    do {                                                                                           \
+        if (__builtin_expect(connectivity_manager_##name##_semaphore, 0)) {                        \
+            STAP_PROBEV(connectivity_manager, name, g_get_monotonic_time(), __VA_ARGS__);          \
+        }                                                                                          \
+    } while (false)
+
+#else
+
+namespace ConnectivityManager::Daemon::Tracepoints
+{
+    // Keeps arguments type checked and variables only used by probes "used" when built without
+    // USDT support. Never called.
+    template <typename... Args>
+    inline void unused(const Args &... /*args*/)
+    {
+    }
+}
+
+#define CONNECTIVITY_MANAGER_TRACE(name, ...)                                                      \
+    do {                                                                                           \
+        if (false) {                                                                               \
+            ConnectivityManager::Daemon::Tracepoints::unused(__VA_ARGS__);                         \
+        }                                                                                          \
+    } while (false)
+
+#endif
+
+#endif // CONNECTIVITY_MANAGER_DAEMON_TRACEPOINTS_H
@@ -57,4 +57,105 @@ namespace ConnectivityManager::Daemon
         ASSERT_TRUE(arguments.has_value());
         EXPECT_TRUE(arguments->print_version_and_exit);
     }
+
+    TEST(Arguments, WiFiAccessPointsOrderDefaultsToId)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_EQ(Arguments::WiFiAccessPointsOrder::ID, arguments->wifi_access_points_order);
+    }
+
+    TEST(Arguments, WiFiAccessPointsOrderValidValues)
+    {
+        std::optional<Arguments> id = parse({ARGV0, "--wifi-access-points-order=id"});
+        std::optional<Arguments> backend = parse({ARGV0, "--wifi-access-points-order=backend"});
+
+        ASSERT_TRUE(id.has_value());
+        EXPECT_EQ(Arguments::WiFiAccessPointsOrder::ID, id->wifi_access_points_order);
+
+        ASSERT_TRUE(backend.has_value());
+        EXPECT_EQ(Arguments::WiFiAccessPointsOrder::BACKEND, backend->wifi_access_points_order);
+    }
+
+    TEST(Arguments, WiFiAccessPointsOrderInvalidValueFails)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--wifi-access-points-order=strength"});
+
+        EXPECT_FALSE(arguments.has_value());
+    }
+
+    TEST(Arguments, CacheCredentialsDefaultsToOff)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_FALSE(arguments->cache_credentials);
+    }
+
+    TEST(Arguments, CacheCredentialsArgumentSetsCacheCredentials)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--cache-credentials"});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_TRUE(arguments->cache_credentials);
+    }
+
+    TEST(Arguments, WiFiRoamingDefaultsToOff)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_FALSE(arguments->wifi_roaming);
+    }
+
+    TEST(Arguments, WiFiRoamingArgumentSetsWiFiRoaming)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--wifi-roaming"});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_TRUE(arguments->wifi_roaming);
+    }
+
+    TEST(Arguments, StateDumpPathDefaultsToDefaultPath)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_EQ(arguments->state_dump_path, Arguments::DEFAULT_STATE_DUMP_PATH);
+    }
+
+    TEST(Arguments, StateDumpPathArgumentSetsStateDumpPath)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--state-dump-path=/run/cm.json"});
+
+        ASSERT_TRUE(arguments.has_value());
+        EXPECT_EQ(arguments->state_dump_path, "/run/cm.json");
+    }
+
+    TEST(Arguments, MainLoopStallThresholdArgumentSetsThreshold)
+    {
+        std::optional<Arguments> zero = parse({ARGV0, "--main-loop-stall-threshold-ms=0"});
+        std::optional<Arguments> ms = parse({ARGV0, "--main-loop-stall-threshold-ms=250"});
+
+        ASSERT_TRUE(zero.has_value());
+        EXPECT_EQ(zero->main_loop_stall_threshold_ms, 0U);
+
+        ASSERT_TRUE(ms.has_value());
+        EXPECT_EQ(ms->main_loop_stall_threshold_ms, 250U);
+    }
+
+    TEST(Arguments, MainLoopStallThresholdNegativeFails)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--main-loop-stall-threshold-ms=-1"});
+
+        EXPECT_FALSE(arguments.has_value());
+    }
+
+    TEST(Arguments, StateDumpPathEmptyFails)
+    {
+        std::optional<Arguments> arguments = parse({ARGV0, "--state-dump-path="});
+
+        EXPECT_FALSE(arguments.has_value());
+    }
 }
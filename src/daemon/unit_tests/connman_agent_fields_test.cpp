@@ -0,0 +1,277 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/backends/connman_agent_fields.h"
+
+#include <glibmm.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/credentials.h"
+#include "common/scoped_silent_log_handler.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Arguments = std::map<Glib::ustring, Glib::VariantBase>;
+        using Credentials = Common::Credentials;
+        using Fields = ConnManAgentFields::Fields;
+        using Password = Credentials::Password;
+
+        // Field as sent by ConnMan, see doc/agent-api.txt in the ConnMan repo.
+        Glib::VariantBase field(const Glib::ustring &type,
+                                const Glib::ustring &requirement = "mandatory",
+                                const std::optional<Glib::ustring> &value = {})
+        {
+            Arguments arguments = {
+                {"Type", Glib::Variant<Glib::ustring>::create(type)},
+                {"Requirement", Glib::Variant<Glib::ustring>::create(requirement)}};
+
+            if (value) {
+                arguments.emplace("Value", Glib::Variant<Glib::ustring>::create(*value));
+            }
+
+            return Glib::Variant<Arguments>::create(arguments);
+        }
+
+        std::optional<Credentials> to_credentials(const Fields &fields)
+        {
+            return ConnManAgentFields::received_fields_to_credentials(fields);
+        }
+
+        std::optional<Credentials> to_credentials_silent(const Fields &fields)
+        {
+            Common::ScopedSilentLogHandler log_handler;
+            return ConnManAgentFields::received_fields_to_credentials(fields);
+        }
+
+        template <typename T>
+        T reply_value(const Fields &reply, const Glib::ustring &name)
+        {
+            return Glib::VariantBase::cast_dynamic<Glib::Variant<T>>(reply.at(name)).get();
+        }
+    }
+
+    TEST(ConnManAgentFields, PskPassphrase)
+    {
+        auto credentials = to_credentials({{"Passphrase", field("psk")}});
+
+        ASSERT_TRUE(credentials);
+        ASSERT_TRUE(credentials->password);
+        EXPECT_EQ(credentials->password->type, Password::Type::WPA_PSK);
+        EXPECT_EQ(credentials->password->value, "");
+        EXPECT_FALSE(credentials->password_alternative);
+        EXPECT_FALSE(credentials->ssid);
+        EXPECT_FALSE(credentials->username);
+    }
+
+    TEST(ConnManAgentFields, PasswordTypes)
+    {
+        const std::vector<std::pair<Glib::ustring, Password::Type>> types = {
+            {"psk", Password::Type::WPA_PSK},
+            {"wep", Password::Type::WEP_KEY},
+            {"passphrase", Password::Type::PASSPHRASE},
+            {"response", Password::Type::PASSPHRASE},
+            {"string", Password::Type::PASSPHRASE},
+            {"wpspin", Password::Type::WPS_PIN}};
+
+        for (const auto &[type, expected] : types) {
+            auto credentials = to_credentials({{"Passphrase", field(type)}});
+
+            ASSERT_TRUE(credentials) << type;
+            EXPECT_EQ(credentials->password->type, expected) << type;
+        }
+    }
+
+    TEST(ConnManAgentFields, PreviousPassphraseUsedAsDefault)
+    {
+        auto credentials = to_credentials({{"Passphrase", field("psk")},
+                                           {"PreviousPassphrase",
+                                            field("psk", "informational", "previous")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->password->value, "previous");
+    }
+
+    TEST(ConnManAgentFields, PassphraseValuePreferredOverPreviousPassphrase)
+    {
+        auto credentials = to_credentials({{"Passphrase", field("psk", "mandatory", "current")},
+                                           {"PreviousPassphrase",
+                                            field("psk", "informational", "previous")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->password->value, "current");
+    }
+
+    TEST(ConnManAgentFields, PreviousPassphraseOfOtherTypeIgnored)
+    {
+        auto credentials = to_credentials({{"Passphrase", field("psk")},
+                                           {"PreviousPassphrase",
+                                            field("wep", "informational", "previous")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->password->value, "");
+    }
+
+    TEST(ConnManAgentFields, WPSAlternative)
+    {
+        auto credentials =
+            to_credentials({{"Passphrase", field("psk")}, {"WPS", field("wpspin", "alternate")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->password->type, Password::Type::WPA_PSK);
+        ASSERT_TRUE(credentials->password_alternative);
+        EXPECT_EQ(credentials->password_alternative->type, Password::Type::WPS_PIN);
+    }
+
+    TEST(ConnManAgentFields, PreviousWPSPinUsedForAlternative)
+    {
+        auto credentials = to_credentials({{"Passphrase", field("psk")},
+                                           {"WPS", field("wpspin", "alternate")},
+                                           {"PreviousPassphrase",
+                                            field("wpspin", "informational", "12345670")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->password->value, "");
+        EXPECT_EQ(credentials->password_alternative->value, "12345670");
+    }
+
+    TEST(ConnManAgentFields, HiddenNetwork)
+    {
+        auto credentials = to_credentials({{"Name", field("string")},
+                                           {"SSID", field("ssid", "alternate")},
+                                           {"Passphrase", field("psk")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->ssid, "");
+        EXPECT_TRUE(credentials->password);
+    }
+
+    TEST(ConnManAgentFields, EAPIdentity)
+    {
+        auto credentials =
+            to_credentials({{"Identity", field("string")}, {"Passphrase", field("passphrase")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_EQ(credentials->username, "");
+        EXPECT_EQ(credentials->password->type, Password::Type::PASSPHRASE);
+    }
+
+    TEST(ConnManAgentFields, WISPrUsernameAndPassword)
+    {
+        auto credentials =
+            to_credentials({{"Username", field("string")}, {"Password", field("passphrase")}});
+
+        ASSERT_TRUE(credentials);
+        EXPECT_TRUE(credentials->username);
+        EXPECT_EQ(credentials->password->type, Password::Type::PASSPHRASE);
+    }
+
+    TEST(ConnManAgentFields, InvalidFieldsRejected)
+    {
+        const std::vector<Fields> invalid = {
+            {{"Unknown", field("string")}},
+            {{"Passphrase", Glib::Variant<Glib::ustring>::create("not arguments")}},
+            {{"Passphrase", field("unknown")}},
+            {{"Passphrase", Glib::Variant<Arguments>::create({})}},
+            {{"Identity", field("string")}, {"Username", field("string")}},
+            {{"Passphrase", field("psk")}, {"Password", field("passphrase")}},
+            {{"WPS", field("wpspin")}},
+            {{"Passphrase", field("psk")}, {"WPS", field("psk", "alternate")}},
+            {{"Passphrase", field("wpspin")}, {"WPS", field("wpspin", "alternate")}},
+            {{"PreviousPassphrase", field("psk", "informational", "previous")}}};
+
+        for (const Fields &fields : invalid) {
+            EXPECT_FALSE(to_credentials_silent(fields)) << fields.begin()->first;
+        }
+    }
+
+    TEST(ConnManAgentFields, ReplyOnlyContainsRequestedFields)
+    {
+        Credentials credentials;
+        credentials.ssid = "ssid";
+        credentials.username = "username";
+        credentials.password = Password{Password::Type::WPA_PSK, "passphrase"};
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Passphrase", field("psk")}});
+
+        ASSERT_EQ(reply.size(), 1U);
+        EXPECT_EQ(reply_value<Glib::ustring>(reply, "Passphrase"), "passphrase");
+    }
+
+    TEST(ConnManAgentFields, ReplySSIDAsStringIfValidUTF8)
+    {
+        Credentials credentials;
+        credentials.ssid = "hidden";
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Name", field("string")}, {"SSID", field("ssid", "alternate")}});
+
+        ASSERT_EQ(reply.size(), 1U);
+        EXPECT_EQ(reply_value<Glib::ustring>(reply, "Name"), "hidden");
+    }
+
+    TEST(ConnManAgentFields, ReplySSIDAsByteArrayIfNotValidUTF8)
+    {
+        Credentials credentials;
+        credentials.ssid = std::string("\xff\xfe", 2);
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Name", field("string")}, {"SSID", field("ssid", "alternate")}});
+
+        ASSERT_EQ(reply.size(), 1U);
+        EXPECT_EQ(reply_value<std::vector<std::uint8_t>>(reply, "SSID"),
+                  std::vector<std::uint8_t>({0xff, 0xfe}));
+    }
+
+    TEST(ConnManAgentFields, ReplySSIDMadeValidUTF8IfOnlyNameRequested)
+    {
+        Credentials credentials;
+        credentials.ssid = std::string("\xff\xfe", 2);
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Name", field("string")}});
+
+        ASSERT_EQ(reply.size(), 1U);
+        EXPECT_TRUE(reply_value<Glib::ustring>(reply, "Name").validate());
+    }
+
+    TEST(ConnManAgentFields, ReplyWPSPin)
+    {
+        Credentials credentials;
+        credentials.password = Password{Password::Type::WPS_PIN, "12345670"};
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Passphrase", field("psk")}, {"WPS", field("wpspin", "alternate")}});
+
+        ASSERT_EQ(reply.size(), 1U);
+        EXPECT_EQ(reply_value<Glib::ustring>(reply, "WPS"), "12345670");
+    }
+
+    TEST(ConnManAgentFields, ReplyWISPr)
+    {
+        Credentials credentials;
+        credentials.username = "username";
+        credentials.password = Password{Password::Type::PASSPHRASE, "password"};
+
+        Fields reply = ConnManAgentFields::credentials_to_reply_fields(
+            credentials, {{"Username", field("string")}, {"Password", field("passphrase")}});
+
+        ASSERT_EQ(reply.size(), 2U);
+        EXPECT_EQ(reply_value<Glib::ustring>(reply, "Username"), "username");
+        EXPECT_EQ(reply_value<Glib::ustring>(reply, "Password"), "password");
+    }
+}
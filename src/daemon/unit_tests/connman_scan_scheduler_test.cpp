@@ -0,0 +1,238 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/backends/connman_scan_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "daemon/metrics_registry.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Seconds = ConnManScanScheduler::Seconds;
+
+        constexpr Seconds FAST = ConnManScanScheduler::FAST_INTERVAL;
+        constexpr Seconds CONNECTED_MIN = ConnManScanScheduler::CONNECTED_MIN_INTERVAL;
+        constexpr Seconds MAX = ConnManScanScheduler::MAX_INTERVAL;
+
+        Seconds next(bool connected, bool strength_stable, Seconds previous)
+        {
+            return ConnManScanScheduler::interval_next(connected, strength_stable, previous);
+        }
+
+        class ListenerMock : public ConnManScanScheduler::Listener
+        {
+        public:
+            void scan_scheduler_scan() override
+            {
+                scans++;
+            }
+
+            void scan_scheduler_scan_finished(bool success, std::uint32_t /*duration_ms*/) override
+            {
+                finished.push_back(success);
+            }
+
+            int scans = 0;
+            std::vector<bool> finished;
+        };
+
+        class ConnManScanSchedulerTest : public testing::Test
+        {
+        protected:
+            // Enables the scheduler and finishes the scan started when enabled.
+            void enable()
+            {
+                scheduler_.set_enabled(true);
+                scheduler_.scan_finished(true);
+                listener_.scans = 0;
+                listener_.finished.clear();
+            }
+
+            void request()
+            {
+                scheduler_.request([this](bool success, std::uint32_t /*duration_ms*/) {
+                    requests_finished_.push_back(success);
+                });
+            }
+
+            ListenerMock listener_;
+            ConnManScanScheduler scheduler_{listener_};
+            std::vector<bool> requests_finished_;
+        };
+    }
+
+    TEST(ConnManScanScheduler, NotConnectedScansFast)
+    {
+        EXPECT_EQ(next(false, false, FAST), FAST);
+        EXPECT_EQ(next(false, true, FAST), FAST);
+        EXPECT_EQ(next(false, true, MAX), FAST);
+    }
+
+    TEST(ConnManScanScheduler, ConnectedStartsAtConnectedMin)
+    {
+        EXPECT_EQ(next(true, false, FAST), CONNECTED_MIN);
+        EXPECT_EQ(next(true, true, FAST), CONNECTED_MIN);
+    }
+
+    TEST(ConnManScanScheduler, ConnectedAndStableBacksOffToMax)
+    {
+        Seconds interval = CONNECTED_MIN;
+
+        interval = next(true, true, interval);
+        EXPECT_EQ(interval, CONNECTED_MIN * 2);
+
+        interval = next(true, true, interval);
+        EXPECT_EQ(interval, CONNECTED_MIN * 4);
+
+        for (int i = 0; i < 10; i++) {
+            interval = next(true, true, interval);
+        }
+        EXPECT_EQ(interval, MAX);
+    }
+
+    TEST(ConnManScanScheduler, ConnectedAndStrengthChangedResetsBackoff)
+    {
+        EXPECT_EQ(next(true, false, MAX), CONNECTED_MIN);
+        EXPECT_EQ(next(true, false, CONNECTED_MIN * 4), CONNECTED_MIN);
+    }
+
+    TEST_F(ConnManScanSchedulerTest, EnablingScansAndDisablingStopsTimer)
+    {
+        scheduler_.set_enabled(true);
+        EXPECT_EQ(listener_.scans, 1);
+        EXPECT_FALSE(scheduler_.timer_pending());
+
+        scheduler_.scan_finished(true);
+        EXPECT_EQ(listener_.finished, std::vector<bool>({true}));
+        EXPECT_TRUE(scheduler_.timer_pending());
+
+        scheduler_.set_enabled(false);
+        EXPECT_FALSE(scheduler_.timer_pending());
+    }
+
+    TEST_F(ConnManScanSchedulerTest, RequestWhileDisabledFails)
+    {
+        request();
+
+        EXPECT_EQ(listener_.scans, 0);
+        EXPECT_EQ(requests_finished_, std::vector<bool>({false}));
+        EXPECT_EQ(scheduler_.counters().requested, 1U);
+        EXPECT_EQ(scheduler_.counters().issued, 0U);
+    }
+
+    TEST_F(ConnManScanSchedulerTest, ConcurrentRequestsAreCoalesced)
+    {
+        enable();
+
+        request();
+        request();
+        request();
+
+        EXPECT_EQ(listener_.scans, 1);
+        EXPECT_FALSE(scheduler_.timer_pending());
+        EXPECT_TRUE(requests_finished_.empty());
+
+        scheduler_.scan_finished(true);
+
+        EXPECT_EQ(requests_finished_, std::vector<bool>({true, true, true}));
+        EXPECT_EQ(listener_.finished, std::vector<bool>({true}));
+        EXPECT_EQ(scheduler_.counters().requested, 3U);
+        EXPECT_EQ(scheduler_.counters().coalesced, 2U);
+        EXPECT_EQ(scheduler_.counters().issued, 2U);
+    }
+
+    TEST_F(ConnManScanSchedulerTest, FailedScanFailsAllRequests)
+    {
+        enable();
+
+        request();
+        request();
+        scheduler_.scan_finished(false);
+
+        EXPECT_EQ(requests_finished_, std::vector<bool>({false, false}));
+        EXPECT_EQ(scheduler_.counters().failed, 1U);
+        EXPECT_TRUE(scheduler_.timer_pending());
+    }
+
+    TEST_F(ConnManScanSchedulerTest, CountersAreAddedToMetricsRegistry)
+    {
+        using Counter = MetricsRegistry::Counter;
+
+        const MetricsRegistry &registry = MetricsRegistry::instance();
+        std::uint64_t requested = registry.value(Counter::WIFI_SCANS_REQUESTED);
+        std::uint64_t coalesced = registry.value(Counter::WIFI_SCANS_COALESCED);
+        std::uint64_t issued = registry.value(Counter::WIFI_SCANS_ISSUED);
+        std::uint64_t failed = registry.value(Counter::WIFI_SCANS_FAILED);
+
+        enable();
+        request();
+        request();
+        scheduler_.scan_finished(false);
+
+        EXPECT_EQ(registry.value(Counter::WIFI_SCANS_REQUESTED), requested + 2);
+        EXPECT_EQ(registry.value(Counter::WIFI_SCANS_COALESCED), coalesced + 1);
+        EXPECT_EQ(registry.value(Counter::WIFI_SCANS_ISSUED), issued + 2);
+        EXPECT_EQ(registry.value(Counter::WIFI_SCANS_FAILED), failed + 1);
+    }
+
+    TEST_F(ConnManScanSchedulerTest, TimerIsRescheduledWhenConnectionChanges)
+    {
+        enable();
+        EXPECT_EQ(scheduler_.interval(), FAST);
+
+        scheduler_.set_connection(true, 50);
+        EXPECT_EQ(scheduler_.interval(), CONNECTED_MIN);
+        EXPECT_TRUE(scheduler_.timer_pending());
+
+        scheduler_.set_connection(false, 0);
+        EXPECT_EQ(scheduler_.interval(), FAST);
+        EXPECT_TRUE(scheduler_.timer_pending());
+    }
+
+    TEST_F(ConnManScanSchedulerTest, StableStrengthBacksOffAndChangeResets)
+    {
+        enable();
+        scheduler_.set_connection(true, 50);
+
+        // First scan while connected has nothing to compare strength with.
+        request();
+        scheduler_.scan_finished(true);
+        EXPECT_EQ(scheduler_.interval(), CONNECTED_MIN);
+
+        request();
+        scheduler_.scan_finished(true);
+        EXPECT_EQ(scheduler_.interval(), CONNECTED_MIN * 2);
+
+        scheduler_.set_connection(true, 50 + ConnManScanScheduler::STRENGTH_STABLE_THRESHOLD + 1);
+        request();
+        scheduler_.scan_finished(true);
+        EXPECT_EQ(scheduler_.interval(), CONNECTED_MIN);
+        EXPECT_TRUE(scheduler_.timer_pending());
+    }
+
+    TEST_F(ConnManScanSchedulerTest, ResetFailsRequestInFlight)
+    {
+        enable();
+        request();
+
+        scheduler_.reset();
+
+        EXPECT_EQ(requests_finished_, std::vector<bool>({false}));
+        EXPECT_FALSE(scheduler_.timer_pending());
+
+        // Result arriving after reset is ignored.
+        scheduler_.scan_finished(true);
+        EXPECT_TRUE(listener_.finished.empty());
+    }
+}
@@ -0,0 +1,266 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/backends/connman_settable_property.h"
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "common/scoped_silent_log_handler.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        // Stands in for a generated ConnMan proxy. SetProperty() calls are kept until reply().
+        class FakeProxy
+        {
+        public:
+            struct Call
+            {
+                Glib::ustring name;
+                Glib::ustring value;
+                Gio::SlotAsyncReady slot;
+            };
+
+            void SetProperty(const Glib::ustring &name,
+                             const Glib::VariantBase &value,
+                             const Gio::SlotAsyncReady &slot)
+            {
+                auto string_value = Glib::VariantBase::cast_dynamic<Glib::Variant<Glib::ustring>>(
+                    value);
+                calls.push_back({name, string_value.get(), slot});
+            }
+
+            void SetProperty_finish(const Glib::RefPtr<Gio::AsyncResult> & /*result*/) const
+            {
+                if (!reply_success_) {
+                    throw Gio::DBus::Error(Gio::DBus::Error::FAILED, "Set failed");
+                }
+            }
+
+            void reply(std::size_t call, bool success)
+            {
+                Glib::RefPtr<Gio::AsyncResult> result;
+
+                reply_success_ = success;
+                calls.at(call).slot(result);
+            }
+
+            std::vector<Call> calls;
+
+        private:
+            bool reply_success_ = true;
+        };
+
+        // Owner as described in ConnManSettableProperty, proxy_ can be set to nullptr.
+        class FakeOwner
+        {
+        public:
+            enum class PropertyId
+            {
+                NAME
+            };
+
+            Glib::ustring log_id_str() const
+            {
+                return "fake owner";
+            }
+
+            void settable_property_changed(PropertyId /*id*/)
+            {
+                changed++;
+            }
+
+            FakeProxy *proxy_ = nullptr;
+            int changed = 0;
+        };
+
+        using Property = ConnManSettableProperty<FakeOwner, Glib::ustring>;
+
+        class ConnManSettablePropertyTest : public testing::Test
+        {
+        protected:
+            ConnManSettablePropertyTest()
+            {
+                owner_.proxy_ = &proxy_;
+            }
+
+            // Returns a SetFinished callback that stores the result in result.
+            static Property::SetFinished store(std::optional<bool> &result)
+            {
+                return [&result](bool success) { result = success; };
+            }
+
+            FakeProxy proxy_;
+            FakeOwner owner_;
+            Property property_{owner_, FakeOwner::PropertyId::NAME, "Name", "a"};
+        };
+    }
+
+    TEST_F(ConnManSettablePropertyTest, SetSendsValueAndSignalsChanged)
+    {
+        std::optional<bool> finished;
+
+        property_.set("b", store(finished));
+
+        ASSERT_EQ(proxy_.calls.size(), 1U);
+        EXPECT_EQ(proxy_.calls[0].name, "Name");
+        EXPECT_EQ(proxy_.calls[0].value, "b");
+        EXPECT_EQ(property_.value(), "b");
+        EXPECT_EQ(owner_.changed, 1);
+        EXPECT_FALSE(finished);
+
+        proxy_.reply(0, true);
+
+        EXPECT_EQ(property_.value(), "b");
+        EXPECT_EQ(owner_.changed, 1);
+        ASSERT_TRUE(finished);
+        EXPECT_TRUE(*finished);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, OutOfOrderRepliesKeepLastSentValue)
+    {
+        std::optional<bool> first_finished;
+        std::optional<bool> second_finished;
+
+        property_.set("b", store(first_finished));
+        property_.set("c", store(second_finished));
+        ASSERT_EQ(proxy_.calls.size(), 2U);
+
+        proxy_.reply(1, true);
+
+        EXPECT_EQ(property_.value(), "c");
+        ASSERT_TRUE(second_finished);
+        EXPECT_TRUE(*second_finished);
+        EXPECT_FALSE(first_finished);
+
+        proxy_.reply(0, true);
+
+        EXPECT_EQ(property_.value(), "c");
+        ASSERT_TRUE(first_finished);
+        EXPECT_TRUE(*first_finished);
+        EXPECT_EQ(owner_.changed, 2);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, SetWhileMaxInFlightIsQueuedAndSentWhenCallFinishes)
+    {
+        property_.set("b");
+        property_.set("c");
+        property_.set("d");
+
+        ASSERT_EQ(proxy_.calls.size(), Property::MAX_IN_FLIGHT);
+        EXPECT_EQ(property_.value(), "d");
+
+        proxy_.reply(0, true);
+
+        ASSERT_EQ(proxy_.calls.size(), 3U);
+        EXPECT_EQ(proxy_.calls[2].value, "d");
+    }
+
+    TEST_F(ConnManSettablePropertyTest, QueuedValueReplacedThenDropped)
+    {
+        std::optional<bool> replaced_finished;
+        std::optional<bool> dropped_finished;
+        std::optional<bool> last_finished;
+
+        property_.set("b");
+        property_.set("c");
+        property_.set("d", store(replaced_finished));
+
+        property_.set("e", store(dropped_finished));
+
+        ASSERT_TRUE(replaced_finished);
+        EXPECT_FALSE(*replaced_finished);
+        EXPECT_EQ(property_.value(), "e");
+
+        // Same as last value in flight, nothing left to send.
+        property_.set("c", store(last_finished));
+
+        ASSERT_TRUE(dropped_finished);
+        EXPECT_FALSE(*dropped_finished);
+        EXPECT_EQ(property_.value(), "c");
+        EXPECT_FALSE(last_finished);
+
+        proxy_.reply(0, true);
+        proxy_.reply(1, true);
+
+        EXPECT_EQ(proxy_.calls.size(), 2U);
+        EXPECT_EQ(property_.value(), "c");
+        ASSERT_TRUE(last_finished);
+        EXPECT_TRUE(*last_finished);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, FailureRevertsAndLaterSuccessSets)
+    {
+        Common::ScopedSilentLogHandler silent_log_handler;
+        std::optional<bool> failed_finished;
+        std::optional<bool> succeeded_finished;
+
+        property_.set("b", store(failed_finished));
+        proxy_.reply(0, false);
+
+        EXPECT_EQ(property_.value(), "a");
+        EXPECT_EQ(owner_.changed, 2);
+        ASSERT_TRUE(failed_finished);
+        EXPECT_FALSE(*failed_finished);
+
+        property_.set("c", store(succeeded_finished));
+        proxy_.reply(1, true);
+
+        EXPECT_EQ(property_.value(), "c");
+        EXPECT_EQ(owner_.changed, 3);
+        ASSERT_TRUE(succeeded_finished);
+        EXPECT_TRUE(*succeeded_finished);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, ReceivedValueWhileInFlightAppliedWhenAllFinished)
+    {
+        property_.set("b");
+        property_.set("c");
+
+        property_.changed(Glib::ustring("x"));
+        EXPECT_EQ(property_.value(), "c");
+
+        proxy_.reply(0, true);
+        EXPECT_EQ(property_.value(), "c");
+
+        proxy_.reply(1, true);
+        EXPECT_EQ(property_.value(), "x");
+        EXPECT_EQ(owner_.changed, 3);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, ReceivedOwnValueIsNotSignalled)
+    {
+        property_.set("b");
+        property_.changed(Glib::ustring("b"));
+        proxy_.reply(0, true);
+
+        EXPECT_EQ(property_.value(), "b");
+        EXPECT_EQ(owner_.changed, 1);
+    }
+
+    TEST_F(ConnManSettablePropertyTest, SetWithoutProxyFails)
+    {
+        Common::ScopedSilentLogHandler silent_log_handler;
+        std::optional<bool> finished;
+
+        owner_.proxy_ = nullptr;
+        property_.set("b", store(finished));
+
+        EXPECT_EQ(property_.value(), "a");
+        EXPECT_EQ(owner_.changed, 0);
+        ASSERT_TRUE(finished);
+        EXPECT_FALSE(*finished);
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/credential_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+
+#include "common/credentials.h"
+#include "daemon/backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Password = Common::Credentials::Password;
+
+        CredentialCache::Key key(const std::string &ssid,
+                                 Backend::WiFiSecurity security = Backend::WiFiSecurity::WPA_PSK)
+        {
+            return {ssid, security};
+        }
+
+        Password password(const Glib::ustring &value, Password::Type type = Password::Type::WPA_PSK)
+        {
+            Password password;
+            password.type = type;
+            password.value = value;
+            return password;
+        }
+    }
+
+    class CredentialCacheTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            ASSERT_TRUE(cache_.available()) << "Locked memory not available (RLIMIT_MEMLOCK?)";
+        }
+
+        CredentialCache cache_;
+    };
+
+    TEST_F(CredentialCacheTest, StoredPasswordNotFoundUntilValidated)
+    {
+        cache_.store(key("ssid"), password("secret"));
+
+        EXPECT_FALSE(cache_.find(key("ssid")).has_value());
+
+        cache_.validate(key("ssid"));
+        auto found = cache_.find(key("ssid"));
+
+        ASSERT_TRUE(found.has_value());
+        EXPECT_EQ(found->value, "secret");
+        EXPECT_EQ(found->type, Password::Type::WPA_PSK);
+    }
+
+    TEST_F(CredentialCacheTest, KeyIncludesSecurity)
+    {
+        cache_.store(key("ssid", Backend::WiFiSecurity::WPA_PSK), password("secret"));
+        cache_.validate(key("ssid", Backend::WiFiSecurity::WPA_PSK));
+
+        EXPECT_FALSE(cache_.find(key("ssid", Backend::WiFiSecurity::WEP)).has_value());
+    }
+
+    TEST_F(CredentialCacheTest, StoreReplacesAndInvalidates)
+    {
+        cache_.store(key("ssid"), password("old"));
+        cache_.validate(key("ssid"));
+        cache_.store(key("ssid"), password("new"));
+
+        EXPECT_FALSE(cache_.find(key("ssid")).has_value());
+        EXPECT_EQ(cache_.size(), 1U);
+
+        cache_.validate(key("ssid"));
+
+        EXPECT_EQ(cache_.find(key("ssid"))->value, "new");
+    }
+
+    TEST_F(CredentialCacheTest, Evict)
+    {
+        cache_.store(key("ssid"), password("secret"));
+        cache_.validate(key("ssid"));
+        cache_.evict(key("ssid"));
+
+        EXPECT_FALSE(cache_.find(key("ssid")).has_value());
+        EXPECT_EQ(cache_.size(), 0U);
+    }
+
+    TEST_F(CredentialCacheTest, TooLongPasswordNotStored)
+    {
+        cache_.store(key("ssid"), password(std::string(CredentialCache::SLOT_SIZE + 1, 'x')));
+
+        EXPECT_EQ(cache_.size(), 0U);
+    }
+
+    TEST_F(CredentialCacheTest, LeastRecentlyUsedEvictedWhenFull)
+    {
+        for (std::size_t i = 0; i < CredentialCache::MAX_ENTRIES; i++) {
+            cache_.store(key(std::to_string(i)), password("secret"));
+            cache_.validate(key(std::to_string(i)));
+        }
+
+        cache_.find(key("0"));
+        cache_.store(key("new"), password("secret"));
+
+        EXPECT_EQ(cache_.size(), CredentialCache::MAX_ENTRIES);
+        EXPECT_TRUE(cache_.find(key("0")).has_value());
+        EXPECT_FALSE(cache_.find(key("1")).has_value());
+    }
+}
@@ -0,0 +1,244 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/dbus_name_watcher_registry.h"
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+
+// Like the Manager tests these need a bus and do nothing unless run on the private one (i.e.
+// CM_TEST_PRIVATE_BUS is set). Names watched are unique names of client connections, which vanish
+// when the client connection is closed.
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Handle = DBusNameWatcherRegistry::Handle;
+
+        constexpr unsigned int TIMEOUT_MS = 5 * 1000;
+
+        // Iterates the default main context until done() returns true or TIMEOUT_MS has passed.
+        bool iterate_until(const std::function<bool()> &done)
+        {
+            bool timed_out = false;
+
+            sigc::connection timeout = Glib::signal_timeout().connect(
+                [&timed_out] {
+                    timed_out = true;
+                    return false;
+                },
+                TIMEOUT_MS);
+
+            while (!done() && !timed_out) {
+                Glib::MainContext::get_default()->iteration(true);
+            }
+
+            timeout.disconnect();
+
+            return done();
+        }
+
+        class DBusNameWatcherRegistryTest : public testing::Test
+        {
+        protected:
+            void SetUp() override
+            {
+                if (Glib::getenv("CM_TEST_PRIVATE_BUS").empty()) {
+                    return;
+                }
+
+                Gio::init();
+
+                connection_ = connect();
+            }
+
+            void TearDown() override
+            {
+                if (connection_) {
+                    connection_->close_sync();
+                }
+            }
+
+            bool ready() const
+            {
+                return bool(connection_);
+            }
+
+            static Glib::RefPtr<Gio::DBus::Connection> connect()
+            {
+                return Gio::DBus::Connection::create_for_address_sync(
+                    Glib::getenv("DBUS_SESSION_BUS_ADDRESS"),
+                    Gio::DBus::CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                        Gio::DBus::CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION);
+            }
+
+            Handle watch(const Glib::RefPtr<Gio::DBus::Connection> &client, int &vanished)
+            {
+                return registry_.watch(connection_, client->get_unique_name(), [&vanished] {
+                    vanished++;
+                });
+            }
+
+            Glib::RefPtr<Gio::DBus::Connection> connection_;
+            DBusNameWatcherRegistry registry_;
+        };
+    }
+
+    TEST_F(DBusNameWatcherRegistryTest, HandlesForSameNameShareWatch)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        auto client = connect();
+        int first_vanished = 0;
+        int second_vanished = 0;
+
+        Handle first = watch(client, first_vanished);
+        Handle second = watch(client, second_vanished);
+
+        EXPECT_EQ(registry_.watched_names(), 1U);
+
+        client->close_sync();
+
+        ASSERT_TRUE(iterate_until([&] { return first_vanished == 1 && second_vanished == 1; }));
+        EXPECT_EQ(registry_.watched_names(), 1U);
+    }
+
+    TEST_F(DBusNameWatcherRegistryTest, LastHandleReleasesWatch)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        auto released_client = connect();
+        auto other_client = connect();
+        int released_vanished = 0;
+        int other_vanished = 0;
+
+        Handle first = watch(released_client, released_vanished);
+        Handle second = watch(released_client, released_vanished);
+
+        first = Handle();
+        EXPECT_EQ(registry_.watched_names(), 1U);
+
+        second = Handle();
+        EXPECT_EQ(registry_.watched_names(), 0U);
+
+        // Signals are dispatched in order, other client vanishing last means released client's
+        // vanishing has been seen too (had it still been watched).
+        Handle other = watch(other_client, other_vanished);
+
+        released_client->close_sync();
+        other_client->close_sync();
+
+        ASSERT_TRUE(iterate_until([&other_vanished] { return other_vanished == 1; }));
+        EXPECT_EQ(released_vanished, 0);
+    }
+
+    TEST_F(DBusNameWatcherRegistryTest, HandleReleasedInsideVanishedCallback)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        auto client = connect();
+        int first_vanished = 0;
+        int second_vanished = 0;
+        int third_vanished = 0;
+        Handle first;
+        Handle second;
+        Handle third;
+
+        // Called first (watch() order), releases itself and second.
+        first = registry_.watch(connection_, client->get_unique_name(), [&] {
+            first_vanished++;
+            first = Handle();
+            second = Handle();
+        });
+        second = watch(client, second_vanished);
+        third = watch(client, third_vanished);
+
+        client->close_sync();
+
+        ASSERT_TRUE(iterate_until([&third_vanished] { return third_vanished == 1; }));
+        EXPECT_EQ(first_vanished, 1);
+        EXPECT_EQ(second_vanished, 0);
+        EXPECT_EQ(registry_.watched_names(), 1U);
+
+        third = Handle();
+        EXPECT_EQ(registry_.watched_names(), 0U);
+    }
+
+    TEST_F(DBusNameWatcherRegistryTest, AllHandlesReleasedInsideVanishedCallback)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        auto client = connect();
+        int first_vanished = 0;
+        int second_vanished = 0;
+        Handle first;
+        Handle second;
+
+        // Removes the name, and its DBusNameWatcher, while the watcher's callback is running.
+        first = registry_.watch(connection_, client->get_unique_name(), [&] {
+            first_vanished++;
+            first = Handle();
+            second = Handle();
+        });
+        second = watch(client, second_vanished);
+
+        client->close_sync();
+
+        ASSERT_TRUE(iterate_until([&first_vanished] { return first_vanished == 1; }));
+        EXPECT_EQ(second_vanished, 0);
+        EXPECT_EQ(registry_.watched_names(), 0U);
+    }
+
+    TEST_F(DBusNameWatcherRegistryTest, MovedHandleKeepsWatch)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        auto client = connect();
+        auto other_client = connect();
+        int vanished = 0;
+        int other_vanished = 0;
+
+        Handle handle = watch(client, vanished);
+        Handle moved(std::move(handle));
+
+        handle = Handle();
+        EXPECT_EQ(registry_.watched_names(), 1U);
+
+        // Move assignment releases the handle assigned to.
+        Handle other = watch(other_client, other_vanished);
+        EXPECT_EQ(registry_.watched_names(), 2U);
+
+        other = std::move(moved);
+        EXPECT_EQ(registry_.watched_names(), 1U);
+
+        client->close_sync();
+
+        ASSERT_TRUE(iterate_until([&vanished] { return vanished == 1; }));
+
+        other = Handle();
+        EXPECT_EQ(registry_.watched_names(), 0U);
+
+        other_client->close_sync();
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+
+namespace ConnectivityManager::Daemon
+{
+    TEST(Histogram, BucketIndex)
+    {
+        EXPECT_EQ(Histogram::bucket_index(0), 0U);
+        EXPECT_EQ(Histogram::bucket_index(1), 1U);
+        EXPECT_EQ(Histogram::bucket_index(2), 2U);
+        EXPECT_EQ(Histogram::bucket_index(3), 2U);
+        EXPECT_EQ(Histogram::bucket_index(4), 3U);
+        EXPECT_EQ(Histogram::bucket_index(1023), 10U);
+        EXPECT_EQ(Histogram::bucket_index(1024), 11U);
+    }
+
+    TEST(Histogram, LargeValuesEndUpInLastBucket)
+    {
+        EXPECT_EQ(Histogram::bucket_index(std::numeric_limits<std::uint64_t>::max()),
+                  Histogram::BUCKET_COUNT - 1);
+    }
+
+    TEST(Histogram, EmptyHasZeroPercentile)
+    {
+        Histogram histogram;
+
+        EXPECT_EQ(histogram.count(), 0U);
+        EXPECT_EQ(histogram.percentile(50), 0U);
+    }
+
+    TEST(Histogram, AddUpdatesCountSumMaxAndBuckets)
+    {
+        Histogram histogram;
+
+        histogram.add(0);
+        histogram.add(5);
+        histogram.add(6);
+        histogram.add(100);
+
+        EXPECT_EQ(histogram.count(), 4U);
+        EXPECT_EQ(histogram.sum(), 111U);
+        EXPECT_EQ(histogram.max(), 100U);
+        EXPECT_EQ(histogram.buckets()[0], 1U);
+        EXPECT_EQ(histogram.buckets()[3], 2U);
+        EXPECT_EQ(histogram.buckets()[7], 1U);
+    }
+
+    TEST(Histogram, PercentileIsBucketUpperBoundLimitedByMax)
+    {
+        Histogram histogram;
+
+        for (int i = 0; i < 99; i++) {
+            histogram.add(10);
+        }
+        histogram.add(1000);
+
+        EXPECT_EQ(histogram.percentile(50), 15U);
+        EXPECT_EQ(histogram.percentile(99), 15U);
+        EXPECT_EQ(histogram.percentile(100), 1000U);
+    }
+}
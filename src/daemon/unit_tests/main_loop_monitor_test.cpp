@@ -0,0 +1,87 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/main_loop_monitor.h"
+
+#include <glib.h>
+#include <glibmm.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        constexpr std::uint32_t STALL_THRESHOLD_MS = 20;
+        constexpr gulong STALL_US = 2 * STALL_THRESHOLD_MS * 1000;
+
+        // Runs callback from an idle source and iterates until the iteration after it, so the
+        // dispatch it was part of has finished as well.
+        void dispatch(const sigc::slot<void> &callback)
+        {
+            auto context = Glib::MainContext::get_default();
+
+            Glib::signal_idle().connect_once(callback);
+
+            context->iteration(false);
+            context->iteration(false);
+        }
+    }
+
+    TEST(MainLoopMonitor, FastCallbackIsNoStall)
+    {
+        MainLoopMonitor monitor(STALL_THRESHOLD_MS);
+
+        dispatch([] { MainLoopMonitor::Scope scope("fast"); });
+
+        EXPECT_EQ(monitor.stalls(), 0U);
+    }
+
+    TEST(MainLoopMonitor, SlowScopeIsBlamed)
+    {
+        MainLoopMonitor monitor(STALL_THRESHOLD_MS);
+
+        dispatch([] {
+            MainLoopMonitor::Scope scope("slow");
+            g_usleep(STALL_US);
+        });
+
+        ASSERT_EQ(monitor.stalls(), 1U);
+        ASSERT_NE(monitor.last_stall_callback(), nullptr);
+        EXPECT_EQ(std::string(monitor.last_stall_callback()), "slow");
+    }
+
+    TEST(MainLoopMonitor, InnermostSlowScopeIsBlamed)
+    {
+        MainLoopMonitor monitor(STALL_THRESHOLD_MS);
+
+        dispatch([] {
+            MainLoopMonitor::Scope outer("outer");
+            {
+                MainLoopMonitor::Scope inner("inner");
+                g_usleep(STALL_US);
+            }
+        });
+
+        ASSERT_EQ(monitor.stalls(), 1U);
+        ASSERT_NE(monitor.last_stall_callback(), nullptr);
+        EXPECT_EQ(std::string(monitor.last_stall_callback()), "inner");
+    }
+
+    TEST(MainLoopMonitor, SlowDispatchOutsideScopeIsUnattributed)
+    {
+        MainLoopMonitor monitor(STALL_THRESHOLD_MS);
+
+        dispatch([] { g_usleep(STALL_US); });
+
+        EXPECT_EQ(monitor.stalls(), 1U);
+        EXPECT_EQ(monitor.last_stall_callback(), nullptr);
+    }
+}
@@ -0,0 +1,530 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/dbus_objects/manager.h"
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/credentials.h"
+#include "common/dbus.h"
+#include "daemon/arguments.h"
+#include "daemon/backend.h"
+#include "daemon/dbus_objects/wifi_access_point.h"
+#include "daemon/dbus_service.h"
+#include "generated/dbus/connectivity_manager_stub.h"
+
+// Manager tests need a bus. "meson test" runs them on a private one (CM_TEST_PRIVATE_BUS is set),
+// used as both system bus for DBusService and bus for the clients. Without it they do nothing.
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using Credentials = Common::Credentials;
+
+        constexpr unsigned int TIMEOUT_MS = 5 * 1000;
+
+        constexpr char MANAGER_INTERFACE[] = "com.luxoft.ConnectivityManager";
+        constexpr char USER_INPUT_AGENT_PATH[] = "/com/luxoft/ConnectivityManager/Test/Agent";
+
+        // Iterates the default main context until done() returns true or TIMEOUT_MS has passed.
+        bool iterate_until(const std::function<bool()> &done)
+        {
+            bool timed_out = false;
+
+            sigc::connection timeout = Glib::signal_timeout().connect(
+                [&timed_out] {
+                    timed_out = true;
+                    return false;
+                },
+                TIMEOUT_MS);
+
+            while (!done() && !timed_out) {
+                Glib::MainContext::get_default()->iteration(true);
+            }
+
+            timeout.disconnect();
+
+            return done();
+        }
+
+        Credentials passphrase(const Glib::ustring &value)
+        {
+            Credentials credentials;
+            credentials.password = Credentials::Password{Credentials::Password::Type::PASSPHRASE,
+                                                         value};
+            return credentials;
+        }
+
+        // Backend with one access point that joins connects like ConnManConnectQueue does, all
+        // ConnectFinished callbacks are kept but only the first RequestCredentialsFromUser.
+        class JoiningBackend : public Backend
+        {
+        public:
+            JoiningBackend()
+            {
+                wifi_status_set(WiFiStatus::ENABLED);
+
+                WiFiAccessPoint access_point;
+                access_point.id = wifi_access_point_next_id();
+                access_point.ssid = "ap";
+                access_point.security = WiFiSecurity::WPA_PSK;
+                access_point_id_ = access_point.id;
+
+                wifi_access_point_add(std::move(access_point));
+            }
+
+            const WiFiAccessPoint &access_point()
+            {
+                return *wifi_access_point_find(access_point_id_);
+            }
+
+            std::size_t connects() const
+            {
+                return finished_.size();
+            }
+
+            void request_credentials(RequestCredentialsFromUserReply &&reply)
+            {
+                Credentials::Requested requested;
+                requested.description_type = Credentials::Requested::TYPE_WIRELESS_NETWORK;
+                requested.description_id = "ap";
+                requested.credentials = passphrase("");
+
+                request_credentials_(requested, std::move(reply));
+            }
+
+            void finish_all(ConnectResult result)
+            {
+                std::vector<ConnectFinished> finished = std::move(finished_);
+                finished_.clear();
+                request_credentials_ = nullptr;
+
+                for (ConnectFinished &callback : finished) {
+                    callback(result);
+                }
+            }
+
+            std::vector<WiFiSecurity> hidden_canceled;
+
+            void wifi_enable() override
+            {
+            }
+
+            void wifi_disable() override
+            {
+            }
+
+            void wifi_connect(const WiFiAccessPoint & /*access_point*/,
+                              ConnectFinished &&finished,
+                              RequestCredentialsFromUser &&request_credentials,
+                              const std::shared_ptr<ConnectTrace> & /*trace*/) override
+            {
+                finished_.emplace_back(std::move(finished));
+
+                if (!request_credentials_) {
+                    request_credentials_ = std::move(request_credentials);
+                }
+            }
+
+            void wifi_connect_hidden(const std::string & /*ssid*/,
+                                     WiFiSecurity /*security*/,
+                                     ConnectFinished &&finished,
+                                     RequestCredentialsFromUser &&request_credentials,
+                                     const std::shared_ptr<ConnectTrace> & /*trace*/) override
+            {
+                finished_.emplace_back(std::move(finished));
+                request_credentials_ = std::move(request_credentials);
+            }
+
+            void wifi_connect_cancel(const WiFiAccessPoint & /*access_point*/) override
+            {
+                finish_all(ConnectResult::CANCELED);
+            }
+
+            void wifi_connect_hidden_cancel(WiFiSecurity security) override
+            {
+                hidden_canceled.push_back(security);
+                finish_all(ConnectResult::CANCELED);
+            }
+
+            void wifi_disconnect(const WiFiAccessPoint & /*access_point*/) override
+            {
+            }
+
+            void wifi_scan(ScanFinished &&finished) override
+            {
+                finished(false, 0);
+            }
+
+            void wifi_hotspot_enable() override
+            {
+            }
+
+            void wifi_hotspot_disable() override
+            {
+            }
+
+            void wifi_hotspot_change_ssid(const std::string & /*ssid*/) override
+            {
+            }
+
+            void wifi_hotspot_change_passphrase(const Glib::ustring & /*passphrase*/) override
+            {
+            }
+
+            void wifi_hotspot_configure(const std::string & /*ssid*/,
+                                        const Glib::ustring & /*passphrase*/,
+                                        bool /*enabled*/,
+                                        WiFiHotspotConfigureFinished &&finished) override
+            {
+                finished(false);
+            }
+
+        private:
+            WiFiAccessPoint::Id access_point_id_ = WiFiAccessPoint::ID_EMPTY;
+            std::vector<ConnectFinished> finished_;
+            RequestCredentialsFromUser request_credentials_;
+        };
+
+        // UserInputAgent that keeps requests unanswered until reply() is called.
+        class UserInputAgent : public com::luxoft::ConnectivityManager::UserInputAgentStub
+        {
+        public:
+            std::size_t requests() const
+            {
+                return invocations_.size();
+            }
+
+            void reply(const Credentials &credentials)
+            {
+                invocations_.back().ret(Credentials::to_dbus_value(credentials));
+            }
+
+        private:
+            void RequestCredentials(const Glib::ustring & /*description_type*/,
+                                    const Glib::ustring & /*description_id*/,
+                                    const Credentials::DBusValue & /*requested*/,
+                                    MethodInvocation &invocation) override
+            {
+                invocations_.push_back(invocation);
+            }
+
+            std::vector<MethodInvocation> invocations_;
+        };
+
+        // Client with its own connection (unique name) on the bus and a UserInputAgent.
+        class Client
+        {
+        public:
+            explicit Client(const std::string &address) :
+                connection_(Gio::DBus::Connection::create_for_address_sync(
+                    address,
+                    Gio::DBus::CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                        Gio::DBus::CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION))
+            {
+                agent_.register_object(connection_, USER_INPUT_AGENT_PATH);
+            }
+
+            UserInputAgent &agent()
+            {
+                return agent_;
+            }
+
+            void connect(const Glib::ustring &object)
+            {
+                call("Connect",
+                     {object_path(object), object_path(USER_INPUT_AGENT_PATH)},
+                     connect_);
+            }
+
+            void connect_with_credentials(const Glib::ustring &object,
+                                          const Credentials &credentials)
+            {
+                call("ConnectWithCredentials",
+                     {object_path(object),
+                      Glib::Variant<Credentials::DBusValue>::create(
+                          Credentials::to_dbus_value(credentials))},
+                     connect_);
+            }
+
+            void cancel_connect(const Glib::ustring &object)
+            {
+                call("CancelConnect", {object_path(object)}, cancel_connect_);
+            }
+
+            // Drops off the bus, like a client that exits.
+            void disconnect()
+            {
+                connection_->close_sync();
+            }
+
+            // Empty until the call has returned, then true if it succeeded.
+            const std::optional<bool> &connect_result() const
+            {
+                return connect_;
+            }
+
+            const std::optional<bool> &cancel_connect_result() const
+            {
+                return cancel_connect_;
+            }
+
+        private:
+            static Glib::VariantBase object_path(const Glib::ustring &path)
+            {
+                return Glib::Variant<Glib::DBusObjectPathString>::create(
+                    Glib::DBusObjectPathString(path));
+            }
+
+            void call(const Glib::ustring &method,
+                      const std::vector<Glib::VariantBase> &arguments,
+                      std::optional<bool> &result)
+            {
+                result.reset();
+
+                connection_->call(
+                    Common::DBus::MANAGER_OBJECT_PATH,
+                    MANAGER_INTERFACE,
+                    method,
+                    Glib::VariantContainerBase::create_tuple(arguments),
+                    [this, &result](const Glib::RefPtr<Gio::AsyncResult> &async_result) {
+                        try {
+                            connection_->call_finish(async_result);
+                            result = true;
+                        } catch (const Glib::Error &) {
+                            result = false;
+                        }
+                    },
+                    Common::DBus::MANAGER_SERVICE_NAME);
+            }
+
+            Glib::RefPtr<Gio::DBus::Connection> connection_;
+            UserInputAgent agent_;
+
+            std::optional<bool> connect_;
+            std::optional<bool> cancel_connect_;
+        };
+
+        // DBusService and JoiningBackend are shared by all tests since the D-Bus name and objects
+        // are registered on the (shared) system bus connection.
+        class ManagerTest : public testing::Test
+        {
+        protected:
+            static void SetUpTestCase()
+            {
+                if (Glib::getenv("CM_TEST_PRIVATE_BUS").empty()) {
+                    return;
+                }
+
+                Gio::init();
+
+                address_ = Glib::getenv("DBUS_SESSION_BUS_ADDRESS");
+                Glib::setenv("DBUS_SYSTEM_BUS_ADDRESS", address_);
+
+                backend_ = std::make_unique<JoiningBackend>();
+                dbus_service_ = std::make_unique<DBusService>(
+                    Glib::MainLoop::create(), *backend_, Arguments::WiFiAccessPointsOrder::ID);
+                dbus_service_->own_name();
+
+                bool appeared = false;
+                guint watch_id = Gio::DBus::watch_name(
+                    Gio::DBus::BUS_TYPE_SYSTEM,
+                    Common::DBus::MANAGER_SERVICE_NAME,
+                    [&appeared](const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                const Glib::ustring & /*name*/,
+                                const Glib::ustring & /*name_owner*/) { appeared = true; });
+
+                ready_ = iterate_until([&appeared] { return appeared; });
+
+                Gio::DBus::unwatch_name(watch_id);
+            }
+
+            static void TearDownTestCase()
+            {
+                dbus_service_.reset();
+                backend_.reset();
+            }
+
+            void TearDown() override
+            {
+                if (backend_) {
+                    backend_->finish_all(Backend::ConnectResult::FAILED);
+                }
+            }
+
+            static bool ready()
+            {
+                return ready_;
+            }
+
+            static JoiningBackend &backend()
+            {
+                return *backend_;
+            }
+
+            static const std::string &address()
+            {
+                return address_;
+            }
+
+            static Glib::ustring access_point_path()
+            {
+                return WiFiAccessPoint(backend_->access_point()).object_path();
+            }
+
+        private:
+            static inline std::string address_;
+            static inline std::unique_ptr<JoiningBackend> backend_;
+            static inline std::unique_ptr<DBusService> dbus_service_;
+            static inline bool ready_ = false;
+        };
+    }
+
+    TEST_F(ManagerTest, CredentialsRequestHandedOverWhenJoinedConnectCanceled)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        Client first(address());
+        Client second(address());
+
+        first.connect(access_point_path());
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 1; }));
+        second.connect(access_point_path());
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 2; }));
+
+        std::optional<std::optional<Credentials>> reply;
+        backend().request_credentials(
+            [&reply](const std::optional<Credentials> &result) { reply = result; });
+        ASSERT_TRUE(iterate_until([&first] { return first.agent().requests() == 1; }));
+
+        first.cancel_connect(access_point_path());
+        ASSERT_TRUE(iterate_until([&] {
+            return first.connect_result() && first.cancel_connect_result() &&
+                   second.agent().requests() == 1;
+        }));
+        EXPECT_FALSE(*first.connect_result());
+        EXPECT_TRUE(*first.cancel_connect_result());
+        EXPECT_FALSE(reply);
+
+        second.agent().reply(passphrase("secret"));
+        ASSERT_TRUE(iterate_until([&reply] { return reply.has_value(); }));
+        ASSERT_TRUE(*reply);
+        ASSERT_TRUE((*reply)->password);
+        EXPECT_EQ((*reply)->password->value, "secret");
+
+        backend().finish_all(Backend::ConnectResult::SUCCESS);
+        ASSERT_TRUE(iterate_until([&second] { return second.connect_result().has_value(); }));
+        EXPECT_TRUE(*second.connect_result());
+    }
+
+    TEST_F(ManagerTest, CredentialsRequestHandedOverWhenClientDisappears)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        Client first(address());
+        Client second(address());
+
+        first.connect(access_point_path());
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 1; }));
+        second.connect(access_point_path());
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 2; }));
+
+        std::optional<std::optional<Credentials>> reply;
+        backend().request_credentials(
+            [&reply](const std::optional<Credentials> &result) { reply = result; });
+        ASSERT_TRUE(iterate_until([&first] { return first.agent().requests() == 1; }));
+
+        first.disconnect();
+        ASSERT_TRUE(iterate_until([&second] { return second.agent().requests() == 1; }));
+        EXPECT_FALSE(reply);
+
+        second.agent().reply(passphrase("secret"));
+        ASSERT_TRUE(iterate_until([&reply] { return reply.has_value(); }));
+        ASSERT_TRUE(*reply);
+    }
+
+    TEST_F(ManagerTest, CredentialsRequestAnsweredWithSuppliedCredentialsOfJoinedConnect)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        Client first(address());
+        Client second(address());
+
+        first.connect(access_point_path());
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 1; }));
+        second.connect_with_credentials(access_point_path(), passphrase("supplied"));
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 2; }));
+
+        first.cancel_connect(access_point_path());
+        ASSERT_TRUE(iterate_until([&first] { return first.cancel_connect_result().has_value(); }));
+
+        std::optional<std::optional<Credentials>> reply;
+        backend().request_credentials(
+            [&reply](const std::optional<Credentials> &result) { reply = result; });
+        ASSERT_TRUE(iterate_until([&reply] { return reply.has_value(); }));
+        ASSERT_TRUE(*reply);
+        ASSERT_TRUE((*reply)->password);
+        EXPECT_EQ((*reply)->password->value, "supplied");
+        EXPECT_EQ(first.agent().requests(), 0U);
+    }
+
+    TEST_F(ManagerTest, HiddenConnectCanBeCanceled)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        Client client(address());
+
+        Credentials credentials = passphrase("secret");
+        credentials.ssid = "hidden";
+
+        client.connect_with_credentials("/", credentials);
+        ASSERT_TRUE(iterate_until([] { return backend().connects() == 1; }));
+
+        client.cancel_connect("/");
+        ASSERT_TRUE(iterate_until([&client] {
+            return client.connect_result() && client.cancel_connect_result();
+        }));
+        EXPECT_FALSE(*client.connect_result());
+        EXPECT_TRUE(*client.cancel_connect_result());
+        ASSERT_EQ(backend().hidden_canceled.size(), 1U);
+        EXPECT_EQ(backend().hidden_canceled.front(), Backend::WiFiSecurity::WPA_PSK);
+    }
+
+    TEST_F(ManagerTest, CancelHiddenConnectFailsWithoutPendingConnect)
+    {
+        if (!ready()) {
+            return;
+        }
+
+        Client client(address());
+
+        client.cancel_connect("/");
+        ASSERT_TRUE(
+            iterate_until([&client] { return client.cancel_connect_result().has_value(); }));
+        EXPECT_FALSE(*client.cancel_connect_result());
+    }
+}
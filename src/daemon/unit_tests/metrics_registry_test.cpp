@@ -0,0 +1,103 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/metrics_registry.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <set>
+#include <string>
+
+namespace ConnectivityManager::Daemon
+{
+    TEST(MetricsRegistry, StartsAtZero)
+    {
+        MetricsRegistry registry;
+
+        EXPECT_EQ(registry.value(MetricsRegistry::Counter::DBUS_SIGNALS_SENT), 0U);
+        EXPECT_EQ(registry.value(MetricsRegistry::Gauge::PENDING_CONNECTS), 0U);
+        EXPECT_EQ(registry.calls(MetricsRegistry::Method::SCAN), 0U);
+        EXPECT_EQ(registry.histogram(MetricsRegistry::Latency::CONNECT).count(), 0U);
+    }
+
+    TEST(MetricsRegistry, CountersAreAdded)
+    {
+        MetricsRegistry registry;
+
+        registry.add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED);
+        registry.add(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED, 4);
+
+        EXPECT_EQ(registry.value(MetricsRegistry::Counter::CONNMAN_SIGNALS_RECEIVED), 5U);
+        EXPECT_EQ(registry.value(MetricsRegistry::Counter::BACKEND_EVENTS_EMITTED), 0U);
+    }
+
+    TEST(MetricsRegistry, GaugesAreSet)
+    {
+        MetricsRegistry registry;
+
+        registry.set(MetricsRegistry::Gauge::CONNECT_QUEUE_DEPTH, 3);
+        registry.set(MetricsRegistry::Gauge::CONNECT_QUEUE_DEPTH, 1);
+
+        EXPECT_EQ(registry.value(MetricsRegistry::Gauge::CONNECT_QUEUE_DEPTH), 1U);
+    }
+
+    TEST(MetricsRegistry, MethodCallsAreCounted)
+    {
+        MetricsRegistry registry;
+
+        registry.method_called(MetricsRegistry::Method::CONNECT);
+        registry.method_called(MetricsRegistry::Method::CONNECT);
+
+        EXPECT_EQ(registry.calls(MetricsRegistry::Method::CONNECT), 2U);
+        EXPECT_EQ(registry.calls(MetricsRegistry::Method::DISCONNECT), 0U);
+    }
+
+    TEST(MetricsRegistry, LatenciesAreAddedToHistogram)
+    {
+        MetricsRegistry registry;
+
+        registry.add(MetricsRegistry::Latency::SCAN, 1000);
+        registry.add(MetricsRegistry::Latency::SCAN, 3000);
+
+        const Histogram &histogram = registry.histogram(MetricsRegistry::Latency::SCAN);
+        EXPECT_EQ(histogram.count(), 2U);
+        EXPECT_EQ(histogram.sum(), 4000U);
+        EXPECT_EQ(histogram.max(), 3000U);
+    }
+
+    TEST(MetricsRegistry, DBusPropertySetCountsSignalIfChanged)
+    {
+        MetricsRegistry registry;
+
+        EXPECT_FALSE(registry.dbus_property_set(false));
+        EXPECT_TRUE(registry.dbus_property_set(true));
+
+        EXPECT_EQ(registry.value(MetricsRegistry::Counter::DBUS_SIGNALS_SENT), 1U);
+    }
+
+    TEST(MetricsRegistry, NamesAreUnique)
+    {
+        std::set<std::string> counters;
+        for (std::size_t i = 0; i < MetricsRegistry::COUNTER_COUNT; i++) {
+            counters.insert(
+                MetricsRegistry::counter_to_string(static_cast<MetricsRegistry::Counter>(i)));
+        }
+
+        std::set<std::string> methods;
+        for (std::size_t i = 0; i < MetricsRegistry::METHOD_COUNT; i++) {
+            methods.insert(
+                MetricsRegistry::method_to_string(static_cast<MetricsRegistry::Method>(i)));
+        }
+
+        EXPECT_EQ(counters.size(), MetricsRegistry::COUNTER_COUNT);
+        EXPECT_EQ(counters.count("unknown"), 0U);
+        EXPECT_EQ(methods.size(), MetricsRegistry::METHOD_COUNT);
+        EXPECT_EQ(methods.count("unknown"), 0U);
+    }
+}
@@ -0,0 +1,130 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/roaming_policy.h"
+
+#include <glib.h>
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+
+#include "daemon/backend.h"
+
+namespace ConnectivityManager::Daemon
+{
+    namespace
+    {
+        using AccessPoint = Backend::WiFiAccessPoint;
+
+        constexpr gint64 AFTER_DWELL = RoamingPolicy::DWELL_TIME_US;
+
+        AccessPoint access_point(AccessPoint::Id id,
+                                 AccessPoint::Strength strength,
+                                 bool connected = false,
+                                 const std::string &ssid = "depot")
+        {
+            AccessPoint ap;
+            ap.id = id;
+            ap.ssid = ssid;
+            ap.strength = strength;
+            ap.connected = connected;
+            ap.security = Backend::WiFiSecurity::WPA_PSK;
+            return ap;
+        }
+    }
+
+    TEST(RoamingPolicy, NoCandidateWhenNotConnected)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 10), 0);
+        policy.add(access_point(2, 90), 0);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL).has_value());
+    }
+
+    TEST(RoamingPolicy, StrongerAccessPointWithSameNetworkIsCandidate)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 10, true), 0);
+        policy.add(access_point(2, 60), 0);
+        policy.add(access_point(3, 80), 0);
+
+        EXPECT_EQ(policy.candidate(AFTER_DWELL), std::optional<AccessPoint::Id>(3));
+    }
+
+    TEST(RoamingPolicy, OtherNetworksAreNotCandidates)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 10, true), 0);
+        policy.add(access_point(2, 90, false, "other"), 0);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL).has_value());
+    }
+
+    TEST(RoamingPolicy, NoCandidateAboveTriggerStrength)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, RoamingPolicy::TRIGGER_STRENGTH, true), 0);
+        policy.add(access_point(2, 100), 0);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL).has_value());
+    }
+
+    TEST(RoamingPolicy, CandidateMustExceedHysteresis)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 20, true), 0);
+        policy.add(access_point(2, 20 + RoamingPolicy::HYSTERESIS - 1), 0);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL).has_value());
+    }
+
+    TEST(RoamingPolicy, DwellTimeAfterConnectAndRoam)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 10, true), 0);
+        policy.add(access_point(2, 80), 0);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL - 1).has_value());
+        EXPECT_TRUE(policy.candidate(AFTER_DWELL).has_value());
+
+        policy.roam_started(AFTER_DWELL);
+
+        EXPECT_FALSE(policy.candidate(2 * AFTER_DWELL - 1).has_value());
+        EXPECT_TRUE(policy.candidate(2 * AFTER_DWELL).has_value());
+    }
+
+    TEST(RoamingPolicy, StrengthIsSmoothed)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 80, true), 0);
+        policy.strength_changed(1, 0);
+
+        EXPECT_EQ(policy.smoothed_strength(1), std::optional<AccessPoint::Strength>(56));
+    }
+
+    TEST(RoamingPolicy, RemovedAccessPointIsNotCandidate)
+    {
+        RoamingPolicy policy;
+
+        policy.add(access_point(1, 10, true), 0);
+        policy.add(access_point(2, 80), 0);
+        policy.remove(2);
+
+        EXPECT_FALSE(policy.candidate(AFTER_DWELL).has_value());
+        EXPECT_FALSE(policy.smoothed_strength(2).has_value());
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "daemon/state_dump.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+namespace ConnectivityManager::Daemon
+{
+    TEST(StateDump, EmptyIsEmptyObject)
+    {
+        StateDump dump;
+
+        EXPECT_EQ(dump.finish(), "{}\n");
+    }
+
+    TEST(StateDump, Values)
+    {
+        StateDump dump;
+
+        dump.value("string", "abc");
+        dump.value("unsigned", std::uint64_t{18446744073709551615U});
+        dump.value("signed", std::int64_t{-1});
+        dump.value("bool", true);
+
+        EXPECT_EQ(dump.finish(),
+                  R"({"string":"abc","unsigned":18446744073709551615,"signed":-1,"bool":true})"
+                  "\n");
+    }
+
+    TEST(StateDump, NestedObjectsAndArrays)
+    {
+        StateDump dump;
+
+        dump.array_begin("array");
+        dump.object_begin();
+        dump.value("a", 1);
+        dump.object_end();
+        dump.object_begin();
+        dump.object_end();
+        dump.array_end();
+        dump.object_begin("object");
+        dump.array_begin("empty");
+        dump.array_end();
+        dump.object_end();
+
+        EXPECT_EQ(dump.finish(), R"({"array":[{"a":1},{}],"object":{"empty":[]}})"
+                                 "\n");
+    }
+
+    TEST(StateDump, Container)
+    {
+        StateDump dump;
+
+        dump.container("map", 3, 13);
+
+        EXPECT_EQ(dump.finish(), R"({"map":{"size":3,"capacity":13}})"
+                                 "\n");
+    }
+
+    TEST(StateDump, StringsAreEscaped)
+    {
+        EXPECT_EQ(StateDump::escape("a\"b\\c\nd\te"), R"(a\"b\\c\nd\te)");
+        EXPECT_EQ(StateDump::escape(std::string("\x01", 1)), R"(\u0001)");
+    }
+}
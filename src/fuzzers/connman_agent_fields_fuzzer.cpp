@@ -0,0 +1,61 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <glibmm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "common/credentials.h"
+#include "common/scoped_silent_log_handler.h"
+#include "daemon/backends/connman_agent_fields.h"
+#include "fuzzers/fuzz_input.h"
+
+namespace
+{
+    using ConnManAgentFields = ConnectivityManager::Daemon::ConnManAgentFields;
+    using Credentials = ConnectivityManager::Common::Credentials;
+}
+
+extern "C" int LLVMFuzzerInitialize(int * /*argc*/, char *** /*argv*/)
+{
+    Glib::init();
+    return 0;
+}
+
+// Input: Fields argument of RequestInput(), see ConnectivityManager::Fuzzers::dictionary_parse().
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+    ConnectivityManager::Common::ScopedSilentLogHandler log_handler;
+
+    std::optional<ConnManAgentFields::Fields> fields =
+        ConnectivityManager::Fuzzers::dictionary_parse(data, size);
+    if (!fields) {
+        return 0;
+    }
+
+    std::optional<Credentials> credentials =
+        ConnManAgentFields::received_fields_to_credentials(*fields);
+    if (!credentials) {
+        return 0;
+    }
+
+    // ConnMan only accepts replies with fields it asked for.
+    ConnManAgentFields::Fields reply =
+        ConnManAgentFields::credentials_to_reply_fields(*credentials, *fields);
+
+    for (const auto &[name, value] : reply) {
+        if (fields->find(name) == fields->cend()) {
+            std::abort();
+        }
+    }
+
+    return 0;
+}
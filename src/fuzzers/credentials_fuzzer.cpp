@@ -0,0 +1,72 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <glibmm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "common/credentials.h"
+#include "common/scoped_silent_log_handler.h"
+#include "fuzzers/fuzz_input.h"
+
+namespace
+{
+    using Credentials = ConnectivityManager::Common::Credentials;
+    using Password = Credentials::Password;
+
+    bool equal(const std::optional<Password> &a, const std::optional<Password> &b)
+    {
+        if (!a || !b) {
+            return !a && !b;
+        }
+
+        return a->type == b->type && a->value == b->value;
+    }
+
+    bool equal(const Credentials &a, const Credentials &b)
+    {
+        return a.ssid == b.ssid && a.username == b.username && equal(a.password, b.password) &&
+               equal(a.password_alternative, b.password_alternative);
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int * /*argc*/, char *** /*argv*/)
+{
+    Glib::init();
+    return 0;
+}
+
+// Input: Credentials D-Bus value, see ConnectivityManager::Fuzzers::dictionary_parse().
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+    ConnectivityManager::Common::ScopedSilentLogHandler log_handler;
+
+    std::optional<Credentials::DBusValue> dbus_value =
+        ConnectivityManager::Fuzzers::dictionary_parse(data, size);
+    if (!dbus_value) {
+        return 0;
+    }
+
+    std::optional<Credentials> credentials = Credentials::from_dbus_value(*dbus_value);
+    if (!credentials) {
+        return 0;
+    }
+
+    // Everything accepted must survive a round trip unchanged.
+    std::optional<Credentials> converted =
+        Credentials::from_dbus_value(Credentials::to_dbus_value(*credentials));
+
+    if (!converted || !equal(*credentials, *converted)) {
+        std::abort();
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "fuzzers/fuzz_input.h"
+
+#include <glib.h>
+
+namespace ConnectivityManager::Fuzzers
+{
+    std::optional<Dictionary> dictionary_parse(const std::uint8_t *data, std::size_t size)
+    {
+        const auto *text = reinterpret_cast<const gchar *>(data);
+
+        if (!g_utf8_validate(text, static_cast<gssize>(size), nullptr)) {
+            return {};
+        }
+
+        GVariant *variant =
+            g_variant_parse(G_VARIANT_TYPE_VARDICT, text, text + size, nullptr, nullptr);
+        if (variant == nullptr) {
+            return {};
+        }
+
+        Dictionary dictionary;
+        GVariantIter iter;
+        const gchar *key = nullptr;
+        GVariant *value = nullptr;
+
+        g_variant_iter_init(&iter, variant);
+        while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+            dictionary.insert_or_assign(key, Glib::VariantBase(value)); // Takes reference.
+        }
+
+        g_variant_unref(variant);
+
+        return dictionary;
+    }
+}
@@ -0,0 +1,30 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_FUZZERS_FUZZ_INPUT_H
+#define CONNECTIVITY_MANAGER_FUZZERS_FUZZ_INPUT_H
+
+#include <glibmm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace ConnectivityManager::Fuzzers
+{
+    using Dictionary = std::map<Glib::ustring, Glib::VariantBase>;
+
+    // Parses fuzzer input as an a{sv} in GVariant text format, e.g.
+    // {'Passphrase': <{'Type': <'psk'>}>}, the type of both ConnMan agent fields and credentials
+    // D-Bus values. Text keeps the seed corpus readable and every parsed value is one that could
+    // be received over D-Bus. Values are unboxed like in the generated D-Bus stubs.
+    std::optional<Dictionary> dictionary_parse(const std::uint8_t *data, std::size_t size);
+}
+
+#endif // CONNECTIVITY_MANAGER_FUZZERS_FUZZ_INPUT_H
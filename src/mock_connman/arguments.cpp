@@ -0,0 +1,126 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/arguments.h"
+
+#include <glibmm.h>
+
+#include "common/string_to_uint64.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    std::optional<Arguments> Arguments::parse(int argc, char *argv[], std::ostream &output)
+    {
+        Arguments arguments;
+        Glib::OptionGroup main_group("main", "Main Options");
+        Glib::OptionContext context;
+        Glib::ustring services_str;
+        Glib::ustring passphrase_str;
+        Glib::ustring connect_step_ms_str;
+        std::string script_path;
+        std::string replay_path;
+        bool replay_fast = false;
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("services");
+            entry.set_arg_description("COUNT");
+            entry.set_description("Number of Wi-Fi services (security psk) to add at start");
+            main_group.add_entry(entry, services_str);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("passphrase");
+            entry.set_arg_description("PASSPHRASE");
+            entry.set_description("Passphrase required by services (default: passphrase)");
+            main_group.add_entry(entry, passphrase_str);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("connect-step-ms");
+            entry.set_arg_description("MS");
+            entry.set_description("Time in each service state while connecting (default: 100)");
+            main_group.add_entry(entry, connect_step_ms_str);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("script");
+            entry.set_arg_description("FILE");
+            entry.set_description("Script with commands to run after start");
+            main_group.add_entry_filename(entry, script_path);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("replay");
+            entry.set_arg_description("FILE");
+            entry.set_description("Replay capture recorded by connman-recorder instead of mocking");
+            main_group.add_entry_filename(entry, replay_path);
+        }
+
+        {
+            Glib::OptionEntry entry;
+            entry.set_long_name("replay-fast");
+            entry.set_description("Replay as fast as possible instead of with recorded timing");
+            main_group.add_entry(entry, replay_fast);
+        }
+
+        context.set_main_group(main_group);
+
+        try {
+            context.parse(argc, argv);
+        } catch (const Glib::Error &error) {
+            output << Glib::get_prgname() << ": " << error.what() << '\n';
+            return {};
+        }
+
+        if (argc > 1) {
+            output << Glib::get_prgname() << ": unknown argument \"" << argv[1] << "\"\n";
+            return {};
+        }
+
+        if (!services_str.empty()) {
+            auto services = Common::string_to_uint64(services_str);
+            if (!services) {
+                output << Glib::get_prgname() << ": invalid service count \"" << services_str
+                       << "\"\n";
+                return {};
+            }
+            arguments.services = *services;
+        }
+
+        if (!passphrase_str.empty()) {
+            arguments.passphrase = passphrase_str;
+        }
+
+        if (!connect_step_ms_str.empty()) {
+            auto connect_step_ms = Common::string_to_uint64(connect_step_ms_str);
+            if (!connect_step_ms) {
+                output << Glib::get_prgname() << ": invalid connect step time \""
+                       << connect_step_ms_str << "\"\n";
+                return {};
+            }
+            arguments.connect_step_ms = *connect_step_ms;
+        }
+
+        if (!replay_path.empty() && (arguments.services != 0 || !script_path.empty())) {
+            output << Glib::get_prgname() << ": --replay can not be used with --services or "
+                   << "--script\n";
+            return {};
+        }
+
+        arguments.script_path = script_path;
+        arguments.replay_path = replay_path;
+        arguments.replay_fast = replay_fast;
+
+        return arguments;
+    }
+}
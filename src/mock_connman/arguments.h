@@ -0,0 +1,32 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_ARGUMENTS_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_ARGUMENTS_H
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace ConnectivityManager::MockConnMan
+{
+    struct Arguments
+    {
+        static std::optional<Arguments> parse(int argc, char *argv[], std::ostream &output);
+
+        std::uint64_t services = 0; // Wi-Fi services (security psk) added at start.
+        std::string passphrase = "passphrase";
+        std::uint64_t connect_step_ms = 100; // Time in each state while connecting.
+        std::string script_path;             // See Script.
+        std::string replay_path;             // See Capture, replaces mock services if set.
+        bool replay_fast = false;            // Replay without recorded timing.
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_ARGUMENTS_H
@@ -0,0 +1,186 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/capture.h"
+
+#include <glib.h>
+
+#include <cstring>
+#include <utility>
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        constexpr guchar TYPE_SIGNAL = 's';
+        constexpr guchar TYPE_METHOD_REPLY = 'r';
+
+        // Converts between host byte order and little endian, same operation in both directions.
+        Glib::VariantBase little_endian(const Glib::VariantBase &variant)
+        {
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+            return Glib::VariantBase(g_variant_byteswap(variant.gobj()));
+#else
+            return variant;
+#endif
+        }
+
+        Glib::VariantBase record_to_variant(const Capture::Record &record)
+        {
+            guchar type = record.type == Capture::Record::Type::SIGNAL ? TYPE_SIGNAL
+                                                                        : TYPE_METHOD_REPLY;
+
+            // Replies without return values have no body.
+            GVariant *body = record.body ? record.body.gobj() : g_variant_new_tuple(nullptr, 0);
+
+            return Glib::VariantBase(g_variant_new(Capture::RECORD_TYPE,
+                                                   static_cast<guint64>(record.time_us),
+                                                   type,
+                                                   record.path.c_str(),
+                                                   record.interface.c_str(),
+                                                   record.member.c_str(),
+                                                   body));
+        }
+
+        std::optional<Capture::Record> record_from_variant(const Glib::VariantBase &variant)
+        {
+            guint64 time_us = 0;
+            guchar type = 0;
+            const char *path = nullptr;
+            const char *interface = nullptr;
+            const char *member = nullptr;
+            GVariant *body = nullptr;
+
+            g_variant_get(
+                variant.gobj(), "(ty&s&s&sv)", &time_us, &type, &path, &interface, &member, &body);
+
+            Capture::Record record;
+            record.time_us = time_us;
+            record.path = path;
+            record.interface = interface;
+            record.member = member;
+            record.body = Glib::VariantContainerBase(body); // Takes reference from g_variant_get().
+
+            if (type == TYPE_SIGNAL) {
+                record.type = Capture::Record::Type::SIGNAL;
+            } else if (type == TYPE_METHOD_REPLY) {
+                record.type = Capture::Record::Type::METHOD_REPLY;
+            } else {
+                return {};
+            }
+
+            if (!g_variant_is_of_type(record.body.gobj(), G_VARIANT_TYPE_TUPLE)) {
+                return {};
+            }
+
+            return record;
+        }
+
+        // Reads exactly size bytes. False if end of stream is reached first.
+        bool read_all(const Glib::RefPtr<Gio::InputStream> &stream, void *data, std::size_t size)
+        {
+            gsize bytes_read = 0;
+            return stream->read_all(data, size, bytes_read) && bytes_read == size;
+        }
+    }
+
+    Capture::Writer::Writer(const std::string &path)
+    {
+        stream_ = Gio::ConverterOutputStream::create(
+            Gio::File::create_for_path(path)->replace(),
+            Gio::ZlibCompressor::create(Gio::ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+
+        write_all(MAGIC, sizeof(MAGIC) - 1);
+    }
+
+    Capture::Writer::~Writer()
+    {
+        if (!stream_->is_closed()) {
+            try {
+                stream_->close();
+            } catch (const Glib::Error &e) {
+                g_warning("Failed to close capture: %s", e.what().c_str());
+            }
+        }
+    }
+
+    void Capture::Writer::write(const Record &record)
+    {
+        Glib::VariantBase variant = little_endian(record_to_variant(record));
+        auto size = static_cast<std::uint32_t>(variant.get_size());
+
+        guint32 size_le = GUINT32_TO_LE(size);
+        write_all(&size_le, sizeof(size_le));
+        write_all(variant.get_data(), size);
+    }
+
+    void Capture::Writer::close()
+    {
+        stream_->close();
+    }
+
+    void Capture::Writer::write_all(const void *data, std::size_t size)
+    {
+        gsize bytes_written = 0;
+        stream_->write_all(data, size, bytes_written);
+    }
+
+    std::optional<Capture> Capture::load(const std::string &path, std::ostream &errors)
+    {
+        Capture capture;
+
+        try {
+            Glib::RefPtr<Gio::InputStream> stream = Gio::ConverterInputStream::create(
+                Gio::File::create_for_path(path)->read(),
+                Gio::ZlibDecompressor::create(Gio::ZLIB_COMPRESSOR_FORMAT_GZIP));
+
+            char magic[sizeof(MAGIC) - 1];
+            if (!read_all(stream, magic, sizeof(magic)) ||
+                std::memcmp(magic, MAGIC, sizeof(magic)) != 0) {
+                errors << path << ": not a ConnMan capture\n";
+                return {};
+            }
+
+            std::vector<guint8> buffer;
+            guint32 size_le = 0;
+
+            while (read_all(stream, &size_le, sizeof(size_le))) {
+                std::uint32_t size = GUINT32_FROM_LE(size_le);
+                if (size > RECORD_SIZE_MAX) {
+                    errors << path << ": record " << capture.records.size() << " too large\n";
+                    return {};
+                }
+
+                buffer.resize(size);
+                if (!read_all(stream, buffer.data(), size)) {
+                    errors << path << ": truncated at record " << capture.records.size() << '\n';
+                    return {};
+                }
+
+                // Not trusted, GVariant handles invalid data by returning default values.
+                GBytes *bytes = g_bytes_new(buffer.data(), size);
+                Glib::VariantBase variant(
+                    g_variant_new_from_bytes(G_VARIANT_TYPE(RECORD_TYPE), bytes, FALSE));
+                g_bytes_unref(bytes);
+
+                std::optional<Record> record = record_from_variant(little_endian(variant));
+                if (!record) {
+                    errors << path << ": invalid record " << capture.records.size() << '\n';
+                    return {};
+                }
+
+                capture.records.push_back(std::move(*record));
+            }
+        } catch (const Glib::Error &e) {
+            errors << path << ": " << e.what() << '\n';
+            return {};
+        }
+
+        return capture;
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_H
+
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Capture of ConnMan D-Bus traffic, recorded by connman-recorder (see src/connman_recorder/)
+    // and replayed by CaptureReplayer.
+    //
+    // A capture is a sequence of records, each a signal emitted by ConnMan or a reply to a method
+    // call (GetTechnologies() and GetServices() of the manager) with the time since the start of
+    // the capture. Bodies are kept as the D-Bus message body (a tuple) so that no information is
+    // lost and new signals need no changes here.
+    //
+    // File format: gzip compressed stream of MAGIC followed by records, each a 32-bit little
+    // endian size followed by a GVariant of type RECORD_TYPE in little endian serialized form.
+    struct Capture
+    {
+        static constexpr char MAGIC[] = "connman-capture-1\n";
+        static constexpr char RECORD_TYPE[] = "(tysssv)"; // Time, type, path, interface, member.
+        static constexpr std::uint32_t RECORD_SIZE_MAX = 64 * 1024 * 1024;
+
+        struct Record
+        {
+            enum class Type
+            {
+                SIGNAL,
+                METHOD_REPLY
+            };
+
+            std::uint64_t time_us = 0; // Since start of capture.
+            Type type = Type::SIGNAL;
+            Glib::ustring path;
+            Glib::ustring interface;
+            Glib::ustring member; // Signal or method name.
+            Glib::VariantContainerBase body;
+        };
+
+        // Writes records to a file as they are captured. Throws Glib::Error on failure.
+        class Writer
+        {
+        public:
+            explicit Writer(const std::string &path);
+            ~Writer();
+
+            Writer(const Writer &other) = delete;
+            Writer(Writer &&other) = delete;
+            Writer &operator=(const Writer &other) = delete;
+            Writer &operator=(Writer &&other) = delete;
+
+            void write(const Record &record);
+
+            // Must be called to finish the compressed stream, data may be lost otherwise.
+            void close();
+
+        private:
+            void write_all(const void *data, std::size_t size);
+
+            Glib::RefPtr<Gio::OutputStream> stream_;
+        };
+
+        static std::optional<Capture> load(const std::string &path, std::ostream &errors);
+
+        std::vector<Record> records;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_H
@@ -0,0 +1,233 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/capture_replayer.h"
+
+#include <cinttypes>
+#include <stdexcept>
+#include <typeinfo>
+#include <utility>
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    CaptureReplayer::CaptureReplayer(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                                     Capture &&capture,
+                                     bool fast) :
+        main_loop_(main_loop),
+        capture_(std::move(capture)),
+        fast_(fast),
+        replay_start_slot_(sigc::mem_fun(*this, &CaptureReplayer::replay_start))
+    {
+    }
+
+    CaptureReplayer::~CaptureReplayer()
+    {
+        replay_connection_.disconnect();
+
+        unown_name();
+    }
+
+    void CaptureReplayer::own_name()
+    {
+        if (connection_id_ != 0) {
+            return;
+        }
+
+        connection_id_ = Gio::DBus::own_name(Gio::DBus::BUS_TYPE_SYSTEM,
+                                             ConnManDBus::SERVICE_NAME,
+                                             sigc::mem_fun(*this, &CaptureReplayer::bus_acquired),
+                                             sigc::mem_fun(*this, &CaptureReplayer::name_acquired),
+                                             sigc::mem_fun(*this, &CaptureReplayer::name_lost));
+    }
+
+    void CaptureReplayer::unown_name()
+    {
+        if (connection_id_ == 0) {
+            return;
+        }
+
+        manager_.reset();
+
+        Gio::DBus::unown_name(connection_id_);
+        connection_id_ = 0;
+    }
+
+    void CaptureReplayer::bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                                       const Glib::ustring & /*name*/)
+    {
+        connection_ = connection;
+
+        manager_.emplace(*this);
+
+        if (!manager_->register_object(connection_)) {
+            main_loop_->quit();
+        }
+    }
+
+    void CaptureReplayer::name_acquired(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                        const Glib::ustring &name)
+    {
+        g_info("Acquired name %s on the bus, replaying %zu records",
+               name.c_str(),
+               capture_.records.size());
+    }
+
+    void CaptureReplayer::name_lost(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                    const Glib::ustring &name)
+    {
+        g_warning("Lost or unable to acquire name %s on the bus", name.c_str());
+        main_loop_->quit();
+    }
+
+    const Capture::Record *CaptureReplayer::reply_find(const char *member) const
+    {
+        for (const Capture::Record &record : capture_.records) {
+            if (record.type == Capture::Record::Type::METHOD_REPLY && record.member == member) {
+                return &record;
+            }
+        }
+
+        return nullptr;
+    }
+
+    CaptureReplayer::PropertiesArray CaptureReplayer::reply_properties_array(
+        const char *member) const
+    {
+        const Capture::Record *record = reply_find(member);
+        if (!record) {
+            g_warning("No reply to %s() in capture", member);
+            return {};
+        }
+
+        try {
+            Glib::VariantBase array;
+            record->body.get_child(array, 0);
+            return Glib::VariantBase::cast_dynamic<Glib::Variant<PropertiesArray>>(array).get();
+        } catch (const std::bad_cast &) {
+            g_warning("Unexpected type of reply to %s() in capture: %s",
+                      member,
+                      record->body.get_type_string().c_str());
+        } catch (const std::out_of_range &) {
+            g_warning("Empty reply to %s() in capture", member);
+        }
+
+        return {};
+    }
+
+    void CaptureReplayer::replay_start()
+    {
+        if (replay_started_) {
+            return;
+        }
+
+        replay_started_ = true;
+
+        // Signals before the GetServices() reply are already part of the state returned by
+        // GetTechnologies() and GetServices().
+        if (const Capture::Record *reply = reply_find("GetServices")) {
+            replay_next_ = static_cast<std::size_t>(reply - capture_.records.data()) + 1;
+            replay_base_time_us_ = reply->time_us;
+        }
+
+        replay_start_us_ = g_get_monotonic_time();
+
+        if (fast_) {
+            replay_connection_ =
+                Glib::signal_idle().connect(sigc::mem_fun(*this, &CaptureReplayer::replay_next));
+        } else {
+            replay_next();
+        }
+    }
+
+    bool CaptureReplayer::replay_next()
+    {
+        auto elapsed_us = static_cast<std::uint64_t>(g_get_monotonic_time() - replay_start_us_);
+        std::size_t emitted = 0;
+
+        for (; replay_next_ < capture_.records.size(); replay_next_++) {
+            const Capture::Record &record = capture_.records[replay_next_];
+
+            if (record.type != Capture::Record::Type::SIGNAL) {
+                continue;
+            }
+
+            if (fast_) {
+                if (emitted == FAST_BATCH_SIZE) {
+                    return true;
+                }
+            } else {
+                std::uint64_t offset_us = record.time_us > replay_base_time_us_
+                                              ? record.time_us - replay_base_time_us_
+                                              : 0;
+
+                if (offset_us > elapsed_us) {
+                    std::uint64_t delay_ms = (offset_us - elapsed_us + 999) / 1000;
+                    replay_connection_ = Glib::signal_timeout().connect(
+                        sigc::mem_fun(*this, &CaptureReplayer::replay_next),
+                        static_cast<unsigned int>(delay_ms));
+                    return false;
+                }
+            }
+
+            replay_emit(record);
+            emitted++;
+        }
+
+        g_info("Replay finished, %" PRIu64 " signals emitted", replay_emitted_);
+
+        return false;
+    }
+
+    void CaptureReplayer::replay_emit(const Capture::Record &record)
+    {
+        try {
+            connection_->emit_signal(record.path, record.interface, record.member, "", record.body);
+            replay_emitted_++;
+        } catch (const Glib::Error &e) {
+            g_warning("Failed to emit %s.%s on %s: %s",
+                      record.interface.c_str(),
+                      record.member.c_str(),
+                      record.path.c_str(),
+                      e.what().c_str());
+        }
+    }
+
+    MockManager::PropertiesArray CaptureReplayer::manager_technologies() const
+    {
+        return reply_properties_array("GetTechnologies");
+    }
+
+    MockManager::PropertiesArray CaptureReplayer::manager_services() const
+    {
+        // Replay starts when the daemon has the initial state. Called from an idle handler since
+        // the reply to GetServices() must be sent before the first signal.
+        Glib::signal_idle().connect_once(replay_start_slot_);
+
+        return reply_properties_array("GetServices");
+    }
+
+    void CaptureReplayer::manager_register_agent(const Glib::ustring &sender,
+                                                 const Glib::DBusObjectPathString &path,
+                                                 MockManager::MethodInvocation &invocation)
+    {
+        g_info("Agent %s registered by %s, agents are not used when replaying",
+               path.c_str(),
+               sender.c_str());
+
+        invocation.ret();
+    }
+
+    void CaptureReplayer::manager_unregister_agent(const Glib::ustring & /*sender*/,
+                                                   const Glib::DBusObjectPathString & /*path*/,
+                                                   MockManager::MethodInvocation &invocation)
+    {
+        invocation.ret();
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_REPLAYER_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_REPLAYER_H
+
+#include <giomm.h>
+#include <glib.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "mock_connman/capture.h"
+#include "mock_connman/mock_manager.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Replays a Capture as ConnMan on the system bus, used instead of MockConnMan by mock-connman
+    // --replay to run the daemon against traffic recorded in the field.
+    //
+    // GetTechnologies() and GetServices() are answered with the first recorded replies, which
+    // is the state of ConnMan when the capture started. Once the daemon has called GetServices(),
+    // the signals recorded after that reply are emitted in order, either with the recorded timing
+    // (relative to the reply) or, if fast, as fast as possible in batches of FAST_BATCH_SIZE per
+    // main loop iteration. Signals recorded before the reply are skipped since the state already
+    // contains them.
+    //
+    // Only the manager object exists on the bus. Agents can register but are never called and
+    // method calls to services and technologies fail, the replay is for traffic from ConnMan to
+    // the daemon, not the other way around.
+    class CaptureReplayer : private MockManager::Listener
+    {
+    public:
+        static constexpr std::size_t FAST_BATCH_SIZE = 100;
+
+        CaptureReplayer(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                        Capture &&capture,
+                        bool fast);
+        ~CaptureReplayer() override;
+
+        CaptureReplayer(const CaptureReplayer &other) = delete;
+        CaptureReplayer(CaptureReplayer &&other) = delete;
+        CaptureReplayer &operator=(const CaptureReplayer &other) = delete;
+        CaptureReplayer &operator=(CaptureReplayer &&other) = delete;
+
+        void own_name();
+        void unown_name();
+
+    private:
+        using PropertiesArray = MockManager::PropertiesArray;
+
+        void bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                          const Glib::ustring &name);
+        void name_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                           const Glib::ustring &name);
+        void name_lost(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                       const Glib::ustring &name);
+
+        const Capture::Record *reply_find(const char *member) const;
+        PropertiesArray reply_properties_array(const char *member) const;
+
+        void replay_start();
+        bool replay_next();
+        void replay_emit(const Capture::Record &record);
+
+        // MockManager::Listener
+        PropertiesArray manager_technologies() const override;
+        PropertiesArray manager_services() const override;
+        void manager_register_agent(const Glib::ustring &sender,
+                                    const Glib::DBusObjectPathString &path,
+                                    MockManager::MethodInvocation &invocation) override;
+        void manager_unregister_agent(const Glib::ustring &sender,
+                                      const Glib::DBusObjectPathString &path,
+                                      MockManager::MethodInvocation &invocation) override;
+
+        Glib::RefPtr<Glib::MainLoop> main_loop_;
+        const Capture capture_;
+        const bool fast_;
+
+        guint connection_id_ = 0;
+        Glib::RefPtr<Gio::DBus::Connection> connection_;
+        std::optional<MockManager> manager_;
+
+        sigc::slot<void> replay_start_slot_;
+        bool replay_started_ = false;
+        std::size_t replay_next_ = 0;
+        std::uint64_t replay_base_time_us_ = 0; // Capture time corresponding to replay_start_us_.
+        gint64 replay_start_us_ = 0;
+        std::uint64_t replay_emitted_ = 0;
+        sigc::connection replay_connection_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_CAPTURE_REPLAYER_H
@@ -0,0 +1,34 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_CONNMAN_DBUS_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_CONNMAN_DBUS_H
+
+namespace ConnectivityManager::MockConnMan
+{
+    class ConnManDBus
+    {
+    public:
+        static constexpr char SERVICE_NAME[] = "net.connman";
+        static constexpr char MANAGER_OBJECT_PATH[] = "/";
+        static constexpr char MANAGER_INTERFACE[] = "net.connman.Manager";
+        static constexpr char WIFI_TECHNOLOGY_OBJECT_PATH[] = "/net/connman/technology/wifi";
+        static constexpr char SERVICE_OBJECT_PATH_PREFIX[] = "/net/connman/service/";
+
+        // See src/error.c in the ConnMan repo.
+        static constexpr char ERROR_ALREADY_CONNECTED[] = "net.connman.Error.AlreadyConnected";
+        static constexpr char ERROR_ALREADY_EXISTS[] = "net.connman.Error.AlreadyExists";
+        static constexpr char ERROR_IN_PROGRESS[] = "net.connman.Error.InProgress";
+        static constexpr char ERROR_INVALID_ARGUMENTS[] = "net.connman.Error.InvalidArguments";
+        static constexpr char ERROR_INVALID_PROPERTY[] = "net.connman.Error.InvalidProperty";
+        static constexpr char ERROR_NOT_REGISTERED[] = "net.connman.Error.NotRegistered";
+        static constexpr char ERROR_OPERATION_ABORTED[] = "net.connman.Error.OperationAborted";
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_CONNMAN_DBUS_H
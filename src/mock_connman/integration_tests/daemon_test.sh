@@ -0,0 +1,65 @@
+#!/bin/sh
+#
+# Copyright (C) 2019 Luxoft Sweden AB
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# SPDX-License-Identifier: MPL-2.0
+
+# Runs the daemon against mock-connman on a private bus and checks basic
+# operations with cmcli. Re-executes itself in dbus-run-session, the private
+# bus is used as system bus through DBUS_SYSTEM_BUS_ADDRESS.
+
+if [ $# -ne 4 ]; then
+    echo "Usage: $0 <bus_config> <daemon> <mock_connman> <cmcli>"
+    exit 1
+fi
+
+if [ -z "$CM_TEST_PRIVATE_BUS" ]; then
+    CM_TEST_PRIVATE_BUS=1 exec dbus-run-session --config-file="$1" -- "$0" "$@"
+fi
+
+export DBUS_SYSTEM_BUS_ADDRESS=$DBUS_SESSION_BUS_ADDRESS
+
+daemon=$2
+mock_connman=$3
+cmcli=$4
+
+service_count=20
+passphrase=secret
+
+"$mock_connman" --services $service_count --passphrase $passphrase --connect-step-ms 10 &
+mock_connman_pid=$!
+
+"$daemon" &
+daemon_pid=$!
+
+trap 'kill $daemon_pid $mock_connman_pid 2>/dev/null' EXIT
+
+fail() {
+    echo "FAIL: $1"
+    exit 1
+}
+
+access_point_count() {
+    "$cmcli" wifi status 2>/dev/null | grep -c " mock-"
+}
+
+# Up to 10 s for the daemon to pick up all services.
+tries=0
+while [ "$(access_point_count)" != "$service_count" ]; do
+    tries=$((tries + 1))
+    [ $tries -lt 100 ] || fail "expected $service_count access points"
+    sleep 0.1
+done
+
+"$cmcli" wifi connect -s mock-1 -p $passphrase || fail "connect with correct passphrase"
+"$cmcli" wifi status | grep -q "\*  mock-1 (" || fail "mock-1 not connected"
+
+"$cmcli" wifi connect -s mock-2 -p wrong && fail "connect with wrong passphrase succeeded"
+
+"$cmcli" wifi disconnect -s mock-1 || fail "disconnect"
+
+echo "PASS"
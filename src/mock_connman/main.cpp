@@ -0,0 +1,104 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <clocale>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "mock_connman/arguments.h"
+#include "mock_connman/capture.h"
+#include "mock_connman/capture_replayer.h"
+#include "mock_connman/mock_connman.h"
+#include "mock_connman/script.h"
+
+namespace
+{
+    using Arguments = ConnectivityManager::MockConnMan::Arguments;
+    using Capture = ConnectivityManager::MockConnMan::Capture;
+    using CaptureReplayer = ConnectivityManager::MockConnMan::CaptureReplayer;
+    using MockConnMan = ConnectivityManager::MockConnMan::MockConnMan;
+    using Script = ConnectivityManager::MockConnMan::Script;
+
+    std::optional<Script> script_load(const std::string &path)
+    {
+        if (path.empty()) {
+            return Script();
+        }
+
+        std::string text;
+
+        try {
+            text = Glib::file_get_contents(path);
+        } catch (const Glib::FileError &e) {
+            std::cerr << Glib::get_prgname() << ": " << e.what() << '\n';
+            return {};
+        }
+
+        std::optional<Script> script = Script::parse(text, std::cerr);
+        if (!script) {
+            std::cerr << Glib::get_prgname() << ": invalid script " << path << '\n';
+        }
+
+        return script;
+    }
+
+    int replay(const Arguments &arguments)
+    {
+        std::optional<Capture> capture = Capture::load(arguments.replay_path, std::cerr);
+        if (!capture) {
+            return EXIT_FAILURE;
+        }
+
+        Glib::RefPtr<Glib::MainLoop> main_loop = Glib::MainLoop::create();
+        CaptureReplayer replayer(main_loop, std::move(*capture), arguments.replay_fast);
+
+        replayer.own_name();
+
+        main_loop->run();
+
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::setlocale(LC_ALL, "");
+
+    Glib::init();
+    Gio::init();
+
+    std::optional<Arguments> arguments = Arguments::parse(argc, argv, std::cout);
+    if (!arguments) {
+        return EXIT_FAILURE;
+    }
+
+    if (!arguments->replay_path.empty()) {
+        return replay(*arguments);
+    }
+
+    std::optional<Script> script = script_load(arguments->script_path);
+    if (!script) {
+        return EXIT_FAILURE;
+    }
+
+    Glib::RefPtr<Glib::MainLoop> main_loop = Glib::MainLoop::create();
+    MockConnMan mock_connman(main_loop, *arguments);
+
+    mock_connman.run_script(std::move(*script));
+    mock_connman.own_name();
+
+    main_loop->run();
+
+    return EXIT_SUCCESS;
+}
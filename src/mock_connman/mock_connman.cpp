@@ -0,0 +1,519 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/mock_connman.h"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <utility>
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    MockConnMan::MockConnMan(const Glib::RefPtr<Glib::MainLoop> &main_loop,
+                             const Arguments &arguments) :
+        main_loop_(main_loop),
+        passphrase_(arguments.passphrase),
+        connect_step_ms_(arguments.connect_step_ms)
+    {
+        services_add(arguments.services, "psk");
+    }
+
+    MockConnMan::~MockConnMan()
+    {
+        restart_connection_.disconnect();
+        script_wait_connection_.disconnect();
+        storm_connection_.disconnect();
+
+        unown_name();
+    }
+
+    void MockConnMan::own_name()
+    {
+        if (connection_id_ != 0) {
+            return;
+        }
+
+        connection_id_ = Gio::DBus::own_name(Gio::DBus::BUS_TYPE_SYSTEM,
+                                             ConnManDBus::SERVICE_NAME,
+                                             sigc::mem_fun(*this, &MockConnMan::bus_acquired),
+                                             sigc::mem_fun(*this, &MockConnMan::name_acquired),
+                                             sigc::mem_fun(*this, &MockConnMan::name_lost));
+    }
+
+    void MockConnMan::unown_name()
+    {
+        if (connection_id_ == 0) {
+            return;
+        }
+
+        objects_destroy();
+
+        Gio::DBus::unown_name(connection_id_);
+        connection_id_ = 0;
+    }
+
+    void MockConnMan::run_script(Script &&script)
+    {
+        script_ = std::move(script);
+        script_next_ = 0;
+        script_started_ = false;
+    }
+
+    void MockConnMan::services_add(std::uint64_t count, const Glib::ustring &security)
+    {
+        std::uniform_int_distribution<int> strength_distribution(0, 100);
+        std::unordered_set<const MockService *> added;
+
+        for (std::uint64_t i = 0; i < count; i++) {
+            std::string number = std::to_string(++last_service_number_);
+
+            ServiceConfig config;
+            config.path = Glib::DBusObjectPathString(ConnManDBus::SERVICE_OBJECT_PATH_PREFIX +
+                                                     ("wifi_mock_" + number + "_managed_") +
+                                                     security.raw());
+            config.name = "mock-" + number;
+            config.security = security;
+            config.strength = static_cast<std::uint8_t>(strength_distribution(random_));
+
+            service_configs_.push_back(config);
+
+            if (!manager_) {
+                continue;
+            }
+
+            services_.push_back(service_create(config));
+
+            if (!services_.back()->register_object(connection_)) {
+                g_warning("Failed to register service %s", config.path.c_str());
+            }
+
+            added.insert(services_.back().get());
+        }
+
+        if (manager_ && !added.empty()) {
+            services_changed_emit(added, {});
+        }
+    }
+
+    void MockConnMan::services_remove(std::uint64_t count)
+    {
+        std::vector<Glib::DBusObjectPathString> removed;
+
+        for (std::uint64_t i = 0; i < count && !service_configs_.empty(); i++) {
+            removed.push_back(service_configs_.back().path);
+            service_configs_.pop_back();
+
+            if (!services_.empty()) {
+                services_.pop_back();
+            }
+        }
+
+        if (manager_ && !removed.empty()) {
+            services_changed_emit({}, removed);
+            technology_connected_update();
+        }
+    }
+
+    void MockConnMan::strength_storm(std::uint64_t rate_hz, std::uint64_t duration_ms)
+    {
+        storm_rate_hz_ = rate_hz;
+        storm_budget_ = 0;
+        storm_end_us_ = g_get_monotonic_time() + static_cast<gint64>(duration_ms) * 1000;
+
+        if (!storm_connection_.connected()) {
+            storm_connection_ = Glib::signal_timeout().connect(
+                sigc::mem_fun(*this, &MockConnMan::strength_storm_tick), STORM_TICK_MS);
+        }
+    }
+
+    void MockConnMan::service_connect(std::uint64_t index)
+    {
+        if (index >= services_.size()) {
+            g_warning("Can not connect service %" PRIu64 ", no such service", index);
+            return;
+        }
+
+        services_[index]->connect();
+    }
+
+    void MockConnMan::service_set_strength(std::uint64_t index, std::uint8_t strength)
+    {
+        if (index >= services_.size()) {
+            g_warning("Can not set strength of service %" PRIu64 ", no such service", index);
+            return;
+        }
+
+        service_configs_[index].strength = strength;
+        services_[index]->set_strength(strength);
+    }
+
+    void MockConnMan::set_passphrase(const Glib::ustring &passphrase)
+    {
+        passphrase_ = passphrase;
+    }
+
+    void MockConnMan::restart()
+    {
+        if (restart_connection_.connected()) {
+            return;
+        }
+
+        g_info("Restarting, down for %u ms", RESTART_DOWN_TIME_MS);
+
+        unown_name();
+
+        restart_connection_ = Glib::signal_timeout().connect(
+            [this] {
+                own_name();
+                return false;
+            },
+            RESTART_DOWN_TIME_MS);
+    }
+
+    std::optional<std::uint8_t> MockConnMan::service_strength(std::uint64_t index) const
+    {
+        if (index >= service_configs_.size()) {
+            return {};
+        }
+
+        return service_configs_[index].strength;
+    }
+
+    void MockConnMan::bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                                   const Glib::ustring & /*name*/)
+    {
+        connection_ = connection;
+
+        if (!objects_create_and_register()) {
+            main_loop_->quit();
+        }
+    }
+
+    void MockConnMan::name_acquired(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                    const Glib::ustring &name)
+    {
+        g_info("Acquired name %s on the bus", name.c_str());
+
+        if (!script_started_) {
+            script_started_ = true;
+            script_next();
+        }
+    }
+
+    void MockConnMan::name_lost(const Glib::RefPtr<Gio::DBus::Connection> & /*connection*/,
+                                const Glib::ustring &name)
+    {
+        g_warning("Lost or unable to acquire name %s on the bus", name.c_str());
+        main_loop_->quit();
+    }
+
+    bool MockConnMan::objects_create_and_register()
+    {
+        manager_.emplace(*this);
+        technology_.emplace();
+
+        for (const ServiceConfig &config : service_configs_) {
+            services_.push_back(service_create(config));
+        }
+
+        bool success = manager_->register_object(connection_) &&
+                       technology_->register_object(connection_);
+
+        for (const auto &service : services_) {
+            success = success && service->register_object(connection_);
+        }
+
+        if (!success) {
+            g_warning("Failed to register ConnMan objects on the bus");
+        }
+
+        return success;
+    }
+
+    void MockConnMan::objects_destroy()
+    {
+        agent_forget();
+
+        services_.clear();
+        technology_.reset();
+        manager_.reset();
+    }
+
+    std::unique_ptr<MockService> MockConnMan::service_create(const ServiceConfig &config)
+    {
+        return std::make_unique<MockService>(
+            *this, config.path, config.name, config.security, config.strength, connect_step_ms_);
+    }
+
+    MockService *MockConnMan::service_find(const Glib::DBusObjectPathString &path)
+    {
+        auto i = std::find_if(services_.begin(), services_.end(), [&](const auto &service) {
+            return service->path() == path;
+        });
+
+        return i == services_.end() ? nullptr : i->get();
+    }
+
+    void MockConnMan::services_changed_emit(
+        const std::unordered_set<const MockService *> &added,
+        const std::vector<Glib::DBusObjectPathString> &removed)
+    {
+        // Like ConnMan, changed contains all services in order but only properties of new ones.
+        PropertiesArray changed;
+
+        for (bool connected : {true, false}) {
+            for (const auto &service : services_) {
+                if (service->connected() == connected) {
+                    changed.emplace_back(service->path(),
+                                         added.count(service.get()) != 0 ? service->properties() :
+                                                                           PropertyMap());
+                }
+            }
+        }
+
+        manager_->services_changed(changed, removed);
+    }
+
+    void MockConnMan::script_next()
+    {
+        using Type = Script::Command::Type;
+
+        while (script_next_ < script_.commands.size()) {
+            const Script::Command &command = script_.commands[script_next_++];
+
+            switch (command.type) {
+            case Type::ADD_SERVICES:
+                services_add(command.value, command.text);
+                break;
+
+            case Type::REMOVE_SERVICES:
+                services_remove(command.value);
+                break;
+
+            case Type::STORM:
+                strength_storm(command.value, command.duration_ms);
+                break;
+
+            case Type::CONNECT:
+                service_connect(command.value);
+                break;
+
+            case Type::PASSPHRASE:
+                set_passphrase(command.text);
+                break;
+
+            case Type::RESTART:
+                restart();
+                break;
+
+            case Type::WAIT:
+                script_wait_connection_ = Glib::signal_timeout().connect(
+                    [this] {
+                        script_next();
+                        return false;
+                    },
+                    static_cast<unsigned int>(command.value));
+                return;
+
+            case Type::QUIT:
+                main_loop_->quit();
+                return;
+            }
+        }
+    }
+
+    bool MockConnMan::strength_storm_tick()
+    {
+        if (g_get_monotonic_time() >= storm_end_us_) {
+            return false;
+        }
+
+        storm_budget_ += storm_rate_hz_ * STORM_TICK_MS;
+        std::uint64_t changes = storm_budget_ / 1000;
+        storm_budget_ %= 1000;
+
+        if (services_.empty()) {
+            return true;
+        }
+
+        std::uniform_int_distribution<std::size_t> index_distribution(0, services_.size() - 1);
+        std::uniform_int_distribution<int> strength_distribution(0, 100);
+
+        for (std::uint64_t i = 0; i < changes; i++) {
+            std::size_t index = index_distribution(random_);
+            auto strength = static_cast<std::uint8_t>(strength_distribution(random_));
+
+            service_set_strength(index, strength);
+        }
+
+        return true;
+    }
+
+    MockManager::PropertiesArray MockConnMan::manager_technologies() const
+    {
+        return {{ConnManDBus::WIFI_TECHNOLOGY_OBJECT_PATH, technology_->properties()}};
+    }
+
+    MockManager::PropertiesArray MockConnMan::manager_services() const
+    {
+        PropertiesArray array;
+
+        for (bool connected : {true, false}) {
+            for (const auto &service : services_) {
+                if (service->connected() == connected) {
+                    array.emplace_back(service->path(), service->properties());
+                }
+            }
+        }
+
+        return array;
+    }
+
+    void MockConnMan::manager_register_agent(const Glib::ustring &sender,
+                                             const Glib::DBusObjectPathString &path,
+                                             MockManager::MethodInvocation &invocation)
+    {
+        if (!agent_.sender.empty()) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_ALREADY_EXISTS,
+                                                       "Agent already registered");
+            return;
+        }
+
+        agent_.sender = sender;
+        agent_.path = path;
+        agent_.watch_id = Gio::DBus::watch_name(
+            connection_,
+            sender,
+            Gio::DBus::SlotNameAppeared(),
+            [this](const auto & /*connection*/, const auto & /*name*/) { agent_forget(); });
+
+        AgentProxy::createForBus(Gio::DBus::BUS_TYPE_SYSTEM,
+                                 Gio::DBus::PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                                     Gio::DBus::PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+                                 sender,
+                                 path,
+                                 sigc::mem_fun(*this, &MockConnMan::agent_proxy_create_finish));
+
+        g_info("Agent %s registered by %s", path.c_str(), sender.c_str());
+
+        invocation.ret();
+    }
+
+    void MockConnMan::manager_unregister_agent(const Glib::ustring &sender,
+                                               const Glib::DBusObjectPathString &path,
+                                               MockManager::MethodInvocation &invocation)
+    {
+        if (agent_.sender != sender || agent_.path != path) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_NOT_REGISTERED,
+                                                       "Agent not registered");
+            return;
+        }
+
+        agent_forget();
+
+        invocation.ret();
+    }
+
+    void MockConnMan::service_request_input(MockService &service, const PropertyMap &fields)
+    {
+        constexpr int REQUEST_INPUT_TIMEOUT_MS = 2 * 60 * 1000;
+
+        if (!agent_.proxy) {
+            g_info("No agent to request input from for %s", service.path().c_str());
+            service.input_received(MockService::Input::CANCELED);
+            return;
+        }
+
+        auto finished = sigc::bind(sigc::mem_fun(*this, &MockConnMan::agent_request_input_finish),
+                                   service.path(),
+                                   agent_.proxy);
+
+        agent_.proxy->RequestInput(
+            service.path(), fields, finished, {}, REQUEST_INPUT_TIMEOUT_MS);
+    }
+
+    void MockConnMan::service_state_changed(MockService & /*service*/)
+    {
+        technology_connected_update();
+        services_changed_emit({}, {});
+    }
+
+    void MockConnMan::technology_connected_update()
+    {
+        technology_->set_connected(
+            std::any_of(services_.cbegin(), services_.cend(), [](const auto &service) {
+                return service->connected();
+            }));
+    }
+
+    void MockConnMan::agent_forget()
+    {
+        if (agent_.watch_id != 0) {
+            Gio::DBus::unwatch_name(agent_.watch_id);
+        }
+
+        agent_.sender.clear();
+        agent_.path.clear();
+        agent_.proxy.reset();
+        agent_.watch_id = 0;
+    }
+
+    void MockConnMan::agent_proxy_create_finish(const Glib::RefPtr<Gio::AsyncResult> &result)
+    {
+        Glib::RefPtr<AgentProxy> proxy;
+
+        try {
+            proxy = AgentProxy::createForBusFinish(result);
+        } catch (const Glib::Error &e) {
+            g_warning("Failed to create agent proxy: %s", e.what().c_str());
+            return;
+        }
+
+        // Agent may have been unregistered, or another one registered, while creating proxy.
+        if (agent_.sender == proxy->dbusProxy()->get_name() &&
+            agent_.path == proxy->dbusProxy()->get_object_path()) {
+            agent_.proxy = proxy;
+        }
+    }
+
+    void MockConnMan::agent_request_input_finish(const Glib::RefPtr<Gio::AsyncResult> &result,
+                                                 const Glib::DBusObjectPathString &service_path,
+                                                 const Glib::RefPtr<AgentProxy> &proxy)
+    {
+        auto input = MockService::Input::CANCELED;
+
+        try {
+            std::map<Glib::ustring, Glib::VariantBase> values;
+            proxy->RequestInput_finish(values, result);
+
+            input = MockService::Input::REJECTED;
+
+            auto i = values.find("Passphrase");
+            if (i != values.cend() &&
+                Glib::VariantBase::cast_dynamic<Glib::Variant<Glib::ustring>>(i->second).get() ==
+                    passphrase_) {
+                input = MockService::Input::ACCEPTED;
+            }
+        } catch (const Glib::Error &e) {
+            g_info("Input request for %s failed: %s", service_path.c_str(), e.what().c_str());
+        } catch (const std::bad_cast &) {
+            g_info("Input request for %s returned passphrase of wrong type", service_path.c_str());
+        }
+
+        if (MockService *service = service_find(service_path); service) {
+            service->input_received(input);
+        }
+    }
+}
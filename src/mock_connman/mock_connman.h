@@ -0,0 +1,169 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_CONNMAN_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_CONNMAN_H
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "generated/dbus/connman_proxy.h"
+#include "mock_connman/arguments.h"
+#include "mock_connman/mock_manager.h"
+#include "mock_connman/mock_service.h"
+#include "mock_connman/mock_technology.h"
+#include "mock_connman/script.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Mock ConnMan for tests and benchmarks of the daemon without Wi-Fi hardware.
+    //
+    // Owns net.connman on the system bus. Meant to be run on a private bus together with the
+    // daemon by pointing DBUS_SYSTEM_BUS_ADDRESS at it (see integration_tests/). Implements the
+    // parts of the manager, technology and service interfaces in data/net.connman.xml that the
+    // daemon uses and calls RequestInput() in the registered net.connman.Agent when connecting to
+    // a service without stored credentials. Only a Wi-Fi technology is exposed.
+    //
+    // State is changed with the methods below, normally from a Script. restart() drops the name
+    // and all objects and comes back after RESTART_DOWN_TIME_MS with the same services (but no
+    // agent), as a restarted ConnMan would.
+    class MockConnMan : public sigc::trackable,
+                        private MockManager::Listener,
+                        private MockService::Listener
+    {
+    public:
+        static constexpr unsigned int RESTART_DOWN_TIME_MS = 500;
+        static constexpr unsigned int STORM_TICK_MS = 10;
+
+        MockConnMan(const Glib::RefPtr<Glib::MainLoop> &main_loop, const Arguments &arguments);
+        ~MockConnMan();
+
+        MockConnMan(const MockConnMan &other) = delete;
+        MockConnMan(MockConnMan &&other) = delete;
+        MockConnMan &operator=(const MockConnMan &other) = delete;
+        MockConnMan &operator=(MockConnMan &&other) = delete;
+
+        void own_name();
+        void unown_name();
+
+        void run_script(Script &&script);
+
+        void services_add(std::uint64_t count, const Glib::ustring &security);
+        void services_remove(std::uint64_t count);
+        void strength_storm(std::uint64_t rate_hz, std::uint64_t duration_ms);
+        void service_connect(std::uint64_t index);
+        void service_set_strength(std::uint64_t index, std::uint8_t strength);
+        void set_passphrase(const Glib::ustring &passphrase);
+        void restart();
+
+        bool strength_storm_running() const
+        {
+            return storm_connection_.connected();
+        }
+
+        std::optional<std::uint8_t> service_strength(std::uint64_t index) const;
+
+    private:
+        using AgentProxy = net::connman::AgentProxy;
+        using PropertyMap = MockService::PropertyMap;
+        using PropertiesArray = MockManager::PropertiesArray;
+
+        struct ServiceConfig
+        {
+            Glib::DBusObjectPathString path;
+            Glib::ustring name;
+            Glib::ustring security;
+            std::uint8_t strength = 0;
+        };
+
+        void bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                          const Glib::ustring &name);
+        void name_acquired(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                           const Glib::ustring &name);
+        void name_lost(const Glib::RefPtr<Gio::DBus::Connection> &connection,
+                       const Glib::ustring &name);
+
+        bool objects_create_and_register();
+        void objects_destroy();
+
+        std::unique_ptr<MockService> service_create(const ServiceConfig &config);
+        MockService *service_find(const Glib::DBusObjectPathString &path);
+        void services_changed_emit(const std::unordered_set<const MockService *> &added,
+                                   const std::vector<Glib::DBusObjectPathString> &removed);
+
+        void technology_connected_update();
+
+        void script_next();
+        bool strength_storm_tick();
+
+        // MockManager::Listener
+        PropertiesArray manager_technologies() const override;
+        PropertiesArray manager_services() const override;
+        void manager_register_agent(const Glib::ustring &sender,
+                                    const Glib::DBusObjectPathString &path,
+                                    MockManager::MethodInvocation &invocation) override;
+        void manager_unregister_agent(const Glib::ustring &sender,
+                                      const Glib::DBusObjectPathString &path,
+                                      MockManager::MethodInvocation &invocation) override;
+
+        // MockService::Listener
+        void service_request_input(MockService &service, const PropertyMap &fields) override;
+        void service_state_changed(MockService &service) override;
+
+        void agent_forget();
+        void agent_proxy_create_finish(const Glib::RefPtr<Gio::AsyncResult> &result);
+        void agent_request_input_finish(const Glib::RefPtr<Gio::AsyncResult> &result,
+                                        const Glib::DBusObjectPathString &service_path,
+                                        const Glib::RefPtr<AgentProxy> &proxy);
+
+        Glib::RefPtr<Glib::MainLoop> main_loop_;
+        Glib::ustring passphrase_;
+        const std::uint64_t connect_step_ms_;
+
+        guint connection_id_ = 0;
+        Glib::RefPtr<Gio::DBus::Connection> connection_;
+        sigc::connection restart_connection_;
+
+        std::optional<MockManager> manager_;
+        std::optional<MockTechnology> technology_;
+
+        std::vector<ServiceConfig> service_configs_;
+        std::vector<std::unique_ptr<MockService>> services_; // Same order, empty while down.
+        std::uint64_t last_service_number_ = 0;
+
+        struct
+        {
+            Glib::ustring sender;
+            Glib::DBusObjectPathString path;
+            Glib::RefPtr<AgentProxy> proxy;
+            guint watch_id = 0;
+        } agent_;
+
+        Script script_;
+        std::size_t script_next_ = 0;
+        bool script_started_ = false;
+        sigc::connection script_wait_connection_;
+
+        sigc::connection storm_connection_;
+        std::uint64_t storm_rate_hz_ = 0;
+        std::uint64_t storm_budget_ = 0;
+        gint64 storm_end_us_ = 0;
+        std::mt19937 random_; // Default seed, storms are reproducible.
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_CONNMAN_H
@@ -0,0 +1,51 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/mock_manager.h"
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    MockManager::MockManager(Listener &listener) : listener_(listener)
+    {
+    }
+
+    bool MockManager::register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection)
+    {
+        return ManagerStub::register_object(connection, ConnManDBus::MANAGER_OBJECT_PATH) != 0;
+    }
+
+    void MockManager::services_changed(const PropertiesArray &changed,
+                                       const std::vector<Glib::DBusObjectPathString> &removed)
+    {
+        ServicesChanged_signal.emit(changed, removed);
+    }
+
+    void MockManager::GetTechnologies(MethodInvocation &invocation)
+    {
+        invocation.ret(listener_.manager_technologies());
+    }
+
+    void MockManager::GetServices(MethodInvocation &invocation)
+    {
+        invocation.ret(listener_.manager_services());
+    }
+
+    void MockManager::RegisterAgent(const Glib::DBusObjectPathString &path,
+                                    MethodInvocation &invocation)
+    {
+        listener_.manager_register_agent(invocation.getMessage()->get_sender(), path, invocation);
+    }
+
+    void MockManager::UnregisterAgent(const Glib::DBusObjectPathString &path,
+                                      MethodInvocation &invocation)
+    {
+        listener_.manager_unregister_agent(invocation.getMessage()->get_sender(), path, invocation);
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_MANAGER_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_MANAGER_H
+
+#include <giomm.h>
+#include <glibmm.h>
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "generated/dbus/connman_stub.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Mock of ConnMan's manager object. See doc/manager-api.txt in the ConnMan repo.
+    //
+    // All state is kept by Listener (MockConnMan), this class only handles D-Bus.
+    class MockManager : private net::connman::ManagerStub
+    {
+    public:
+        using MethodInvocation = net::connman::ManagerStub::MethodInvocation;
+        using PropertyMap = std::map<Glib::ustring, Glib::VariantBase>;
+        using PropertiesArray = std::vector<std::tuple<Glib::DBusObjectPathString, PropertyMap>>;
+
+        class Listener;
+
+        explicit MockManager(Listener &listener);
+
+        MockManager(const MockManager &other) = delete;
+        MockManager(MockManager &&other) = delete;
+        MockManager &operator=(const MockManager &other) = delete;
+        MockManager &operator=(MockManager &&other) = delete;
+
+        bool register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection);
+
+        void services_changed(const PropertiesArray &changed,
+                              const std::vector<Glib::DBusObjectPathString> &removed);
+
+    private:
+        void GetTechnologies(MethodInvocation &invocation) override;
+        void GetServices(MethodInvocation &invocation) override;
+
+        void RegisterAgent(const Glib::DBusObjectPathString &path,
+                           MethodInvocation &invocation) override;
+        void UnregisterAgent(const Glib::DBusObjectPathString &path,
+                             MethodInvocation &invocation) override;
+
+        Listener &listener_;
+    };
+
+    class MockManager::Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        virtual PropertiesArray manager_technologies() const = 0;
+        virtual PropertiesArray manager_services() const = 0;
+
+        virtual void manager_register_agent(const Glib::ustring &sender,
+                                            const Glib::DBusObjectPathString &path,
+                                            MethodInvocation &invocation) = 0;
+        virtual void manager_unregister_agent(const Glib::ustring &sender,
+                                              const Glib::DBusObjectPathString &path,
+                                              MethodInvocation &invocation) = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_MANAGER_H
@@ -0,0 +1,250 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/mock_service.h"
+
+#include <string>
+#include <vector>
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        constexpr char STATE_IDLE[] = "idle";
+        constexpr char STATE_FAILURE[] = "failure";
+        constexpr char STATE_ASSOCIATION[] = "association";
+        constexpr char STATE_CONFIGURATION[] = "configuration";
+        constexpr char STATE_READY[] = "ready";
+        constexpr char STATE_ONLINE[] = "online";
+
+        using StringVariant = Glib::Variant<Glib::ustring>;
+
+        Glib::VariantBase field(const char *type)
+        {
+            std::map<Glib::ustring, Glib::VariantBase> arguments = {
+                {"Type", StringVariant::create(type)},
+                {"Requirement", StringVariant::create("mandatory")}};
+
+            return Glib::Variant<std::map<Glib::ustring, Glib::VariantBase>>::create(arguments);
+        }
+    }
+
+    MockService::MockService(Listener &listener,
+                             const Glib::DBusObjectPathString &path,
+                             const Glib::ustring &name,
+                             const Glib::ustring &security,
+                             std::uint8_t strength,
+                             std::uint64_t connect_step_ms) :
+        listener_(listener),
+        path_(path),
+        security_(security),
+        connect_step_ms_(connect_step_ms),
+        state_(STATE_IDLE)
+    {
+        properties_ = {
+            {"Type", StringVariant::create("wifi")},
+            {"Name", StringVariant::create(name)},
+            {"Security", Glib::Variant<std::vector<Glib::ustring>>::create({security})},
+            {"State", StringVariant::create(state_)},
+            {"Strength", Glib::Variant<std::uint8_t>::create(strength)},
+            {"AutoConnect", Glib::Variant<bool>::create(false)}};
+    }
+
+    MockService::~MockService()
+    {
+        connect_step_connection_.disconnect();
+
+        if (connect_invocation_) {
+            connect_invocation_->getMessage()->return_dbus_error(
+                ConnManDBus::ERROR_OPERATION_ABORTED, "Service removed");
+        }
+    }
+
+    bool MockService::register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection)
+    {
+        return ServiceStub::register_object(connection, path_) != 0;
+    }
+
+    bool MockService::connected() const
+    {
+        return state_ == STATE_READY || state_ == STATE_ONLINE;
+    }
+
+    void MockService::set_strength(std::uint8_t strength)
+    {
+        property_set("Strength", Glib::Variant<std::uint8_t>::create(strength));
+    }
+
+    void MockService::connect()
+    {
+        if (connecting() || connected()) {
+            return;
+        }
+
+        state_set(STATE_ASSOCIATION);
+
+        if (security_ != "none" && !credentials_stored_) {
+            waiting_for_input_ = true;
+            listener_.service_request_input(*this, input_fields());
+            return;
+        }
+
+        connect_step_schedule();
+    }
+
+    void MockService::input_received(Input input)
+    {
+        if (!waiting_for_input_) {
+            return;
+        }
+
+        waiting_for_input_ = false;
+
+        switch (input) {
+        case Input::ACCEPTED:
+            credentials_stored_ = true;
+            connect_step_schedule();
+            break;
+        case Input::REJECTED:
+            connect_finish(ConnManDBus::ERROR_INVALID_ARGUMENTS);
+            break;
+        case Input::CANCELED:
+            connect_finish(ConnManDBus::ERROR_OPERATION_ABORTED);
+            break;
+        }
+    }
+
+    void MockService::SetProperty(const Glib::ustring &name,
+                                  const Glib::VariantBase &value,
+                                  MethodInvocation &invocation)
+    {
+        if (name != "AutoConnect" || !value.is_of_type(Glib::VARIANT_TYPE_BOOL)) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_INVALID_PROPERTY,
+                                                       "Invalid property");
+            return;
+        }
+
+        property_set(name, value);
+        invocation.ret();
+    }
+
+    void MockService::Connect(MethodInvocation &invocation)
+    {
+        if (connected()) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_ALREADY_CONNECTED,
+                                                       "Already connected");
+            return;
+        }
+
+        if (connecting()) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_IN_PROGRESS,
+                                                       "In progress");
+            return;
+        }
+
+        connect_invocation_ = invocation;
+        connect();
+    }
+
+    void MockService::Disconnect(MethodInvocation &invocation)
+    {
+        connect_step_connection_.disconnect();
+
+        if (connecting()) {
+            waiting_for_input_ = false;
+            connect_finish(ConnManDBus::ERROR_OPERATION_ABORTED);
+        }
+
+        state_set(STATE_IDLE);
+
+        invocation.ret();
+    }
+
+    bool MockService::connecting() const
+    {
+        return state_ == STATE_ASSOCIATION || state_ == STATE_CONFIGURATION;
+    }
+
+    MockService::PropertyMap MockService::input_fields() const
+    {
+        if (security_ == "wep") {
+            return {{"Passphrase", field("wep")}};
+        }
+
+        if (security_ == "ieee8021x") {
+            return {{"Identity", field("string")}, {"Passphrase", field("passphrase")}};
+        }
+
+        return {{"Passphrase", field("psk")}};
+    }
+
+    void MockService::connect_step_schedule()
+    {
+        connect_step_connection_ = Glib::signal_timeout().connect(
+            [this] {
+                connect_step();
+                return false;
+            },
+            static_cast<unsigned int>(connect_step_ms_));
+    }
+
+    void MockService::connect_step()
+    {
+        if (state_ == STATE_ASSOCIATION) {
+            state_set(STATE_CONFIGURATION);
+            connect_step_schedule();
+
+        } else if (state_ == STATE_CONFIGURATION) {
+            state_set(STATE_READY);
+            connect_finish(nullptr);
+            connect_step_schedule();
+
+        } else if (state_ == STATE_READY) {
+            state_set(STATE_ONLINE);
+        }
+    }
+
+    void MockService::connect_finish(const char *error_name)
+    {
+        if (error_name) {
+            state_set(STATE_FAILURE);
+        }
+
+        if (!connect_invocation_) {
+            return;
+        }
+
+        if (error_name) {
+            connect_invocation_->getMessage()->return_dbus_error(error_name, "Connect failed");
+        } else {
+            connect_invocation_->ret();
+        }
+
+        connect_invocation_.reset();
+    }
+
+    void MockService::state_set(const char *state)
+    {
+        if (state_ == state) {
+            return;
+        }
+
+        state_ = state;
+        property_set("State", StringVariant::create(state_));
+
+        listener_.service_state_changed(*this);
+    }
+
+    void MockService::property_set(const Glib::ustring &name, const Glib::VariantBase &value)
+    {
+        properties_[name] = value;
+        PropertyChanged_signal.emit(name, value);
+    }
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_SERVICE_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_SERVICE_H
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+#include "generated/dbus/connman_stub.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Mock of a ConnMan Wi-Fi service. See doc/service-api.txt in the ConnMan repo.
+    //
+    // Connecting goes through the states ConnMan uses: association, configuration, ready and
+    // online, connect_step_ms in each. If the service has security and no credentials are stored,
+    // input is requested through Listener in association state (see input_received()). Credentials
+    // are considered stored after a successful connect, like for a ConnMan favorite service.
+    //
+    // Connect() returns when ready is reached (or on failure) and fails with the same errors as
+    // ConnMan when already connected or connecting.
+    class MockService : private net::connman::ServiceStub
+    {
+    public:
+        using MethodInvocation = net::connman::ServiceStub::MethodInvocation;
+        using PropertyMap = std::map<Glib::ustring, Glib::VariantBase>;
+
+        enum class Input
+        {
+            ACCEPTED,
+            REJECTED,
+            CANCELED
+        };
+
+        class Listener;
+
+        MockService(Listener &listener,
+                    const Glib::DBusObjectPathString &path,
+                    const Glib::ustring &name,
+                    const Glib::ustring &security,
+                    std::uint8_t strength,
+                    std::uint64_t connect_step_ms);
+        ~MockService();
+
+        MockService(const MockService &other) = delete;
+        MockService(MockService &&other) = delete;
+        MockService &operator=(const MockService &other) = delete;
+        MockService &operator=(MockService &&other) = delete;
+
+        bool register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection);
+
+        const Glib::DBusObjectPathString &path() const
+        {
+            return path_;
+        }
+
+        const PropertyMap &properties() const
+        {
+            return properties_;
+        }
+
+        bool connected() const;
+
+        void set_strength(std::uint8_t strength);
+
+        // Starts connecting without a Connect() call, as ConnMan does when auto connecting.
+        void connect();
+
+        void input_received(Input input);
+
+    private:
+        void SetProperty(const Glib::ustring &name,
+                         const Glib::VariantBase &value,
+                         MethodInvocation &invocation) override;
+
+        void Connect(MethodInvocation &invocation) override;
+
+        void Disconnect(MethodInvocation &invocation) override;
+
+        bool connecting() const;
+
+        PropertyMap input_fields() const;
+
+        void connect_step_schedule();
+        void connect_step();
+        void connect_finish(const char *error_name);
+
+        void state_set(const char *state);
+        void property_set(const Glib::ustring &name, const Glib::VariantBase &value);
+
+        Listener &listener_;
+        const Glib::DBusObjectPathString path_;
+        const Glib::ustring security_;
+        const std::uint64_t connect_step_ms_;
+
+        PropertyMap properties_;
+        Glib::ustring state_;
+
+        bool credentials_stored_ = false;
+        bool waiting_for_input_ = false;
+        std::optional<MethodInvocation> connect_invocation_;
+        sigc::connection connect_step_connection_;
+    };
+
+    class MockService::Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        virtual void service_request_input(MockService &service, const PropertyMap &fields) = 0;
+        virtual void service_state_changed(MockService &service) = 0;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_SERVICE_H
@@ -0,0 +1,106 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/mock_technology.h"
+
+#include <utility>
+
+#include "mock_connman/connman_dbus.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        using BoolVariant = Glib::Variant<bool>;
+        using StringVariant = Glib::Variant<Glib::ustring>;
+
+        // Settable property name and D-Bus type.
+        const std::map<Glib::ustring, Glib::ustring> SETTABLE_PROPERTIES = {
+            {"Powered", "b"},
+            {"Tethering", "b"},
+            {"TetheringIdentifier", "s"},
+            {"TetheringPassphrase", "s"}};
+    }
+
+    MockTechnology::MockTechnology()
+    {
+        properties_ = {{"Name", StringVariant::create("WiFi")},
+                       {"Type", StringVariant::create("wifi")},
+                       {"Powered", BoolVariant::create(true)},
+                       {"Connected", BoolVariant::create(false)},
+                       {"Tethering", BoolVariant::create(false)},
+                       {"TetheringIdentifier", StringVariant::create("")},
+                       {"TetheringPassphrase", StringVariant::create("")}};
+    }
+
+    MockTechnology::~MockTechnology()
+    {
+        scan_connection_.disconnect();
+    }
+
+    bool MockTechnology::register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection)
+    {
+        return TechnologyStub::register_object(connection,
+                                               ConnManDBus::WIFI_TECHNOLOGY_OBJECT_PATH) != 0;
+    }
+
+    void MockTechnology::set_connected(bool connected)
+    {
+        auto value = BoolVariant::create(connected);
+
+        if (!properties_["Connected"].equal(value)) {
+            property_set("Connected", value);
+        }
+    }
+
+    void MockTechnology::SetProperty(const Glib::ustring &name,
+                                     const Glib::VariantBase &value,
+                                     MethodInvocation &invocation)
+    {
+        auto i = SETTABLE_PROPERTIES.find(name);
+
+        if (i == SETTABLE_PROPERTIES.cend() || value.get_type_string() != i->second) {
+            invocation.getMessage()->return_dbus_error(ConnManDBus::ERROR_INVALID_PROPERTY,
+                                                       "Invalid property");
+            return;
+        }
+
+        invocation.ret();
+
+        if (!properties_[name].equal(value)) {
+            property_set(name, value);
+        }
+    }
+
+    void MockTechnology::Scan(MethodInvocation &invocation)
+    {
+        scan_invocations_.push_back(invocation);
+
+        if (!scan_connection_.connected()) {
+            scan_connection_ = Glib::signal_timeout().connect(
+                [this] {
+                    scan_finished();
+                    return false;
+                },
+                SCAN_TIME_MS);
+        }
+    }
+
+    void MockTechnology::scan_finished()
+    {
+        for (auto &invocation : std::exchange(scan_invocations_, {})) {
+            invocation.ret();
+        }
+    }
+
+    void MockTechnology::property_set(const Glib::ustring &name, const Glib::VariantBase &value)
+    {
+        properties_[name] = value;
+        PropertyChanged_signal.emit(name, value);
+    }
+}
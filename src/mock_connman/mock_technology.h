@@ -0,0 +1,70 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_TECHNOLOGY_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_TECHNOLOGY_H
+
+#include <giomm.h>
+#include <glibmm.h>
+#include <sigc++/sigc++.h>
+
+#include <map>
+#include <vector>
+
+#include "generated/dbus/connman_stub.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Mock of ConnMan's Wi-Fi technology. See doc/technology-api.txt in the ConnMan repo.
+    //
+    // Settable properties are changed and signalled directly when set. Scan() returns after
+    // SCAN_TIME_MS, calls made while scanning return at the same time.
+    class MockTechnology : private net::connman::TechnologyStub
+    {
+    public:
+        using MethodInvocation = net::connman::TechnologyStub::MethodInvocation;
+        using PropertyMap = std::map<Glib::ustring, Glib::VariantBase>;
+
+        static constexpr unsigned int SCAN_TIME_MS = 500;
+
+        MockTechnology();
+        ~MockTechnology();
+
+        MockTechnology(const MockTechnology &other) = delete;
+        MockTechnology(MockTechnology &&other) = delete;
+        MockTechnology &operator=(const MockTechnology &other) = delete;
+        MockTechnology &operator=(MockTechnology &&other) = delete;
+
+        bool register_object(const Glib::RefPtr<Gio::DBus::Connection> &connection);
+
+        const PropertyMap &properties() const
+        {
+            return properties_;
+        }
+
+        void set_connected(bool connected);
+
+    private:
+        void SetProperty(const Glib::ustring &name,
+                         const Glib::VariantBase &value,
+                         MethodInvocation &invocation) override;
+
+        void Scan(MethodInvocation &invocation) override;
+
+        void scan_finished();
+
+        void property_set(const Glib::ustring &name, const Glib::VariantBase &value);
+
+        PropertyMap properties_;
+
+        std::vector<MethodInvocation> scan_invocations_;
+        sigc::connection scan_connection_;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_MOCK_TECHNOLOGY_H
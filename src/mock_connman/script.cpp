@@ -0,0 +1,131 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/script.h"
+
+#include <cstddef>
+#include <sstream>
+#include <utility>
+
+#include "common/string_to_uint64.h"
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        using Command = Script::Command;
+
+        bool is_security(const std::string &str)
+        {
+            return str == "none" || str == "wep" || str == "psk" || str == "ieee8021x";
+        }
+
+        std::optional<Command> words_to_command(const std::vector<std::string> &words)
+        {
+            const std::string &name = words[0];
+            const std::size_t argument_count = words.size() - 1;
+
+            auto number = [&](std::size_t i) { return Common::string_to_uint64(words[i]); };
+
+            Command command;
+
+            if (name == "add-services" && (argument_count == 1 || argument_count == 2)) {
+                auto count = number(1);
+                std::string security = argument_count == 2 ? words[2] : "psk";
+                if (!count || !is_security(security)) {
+                    return {};
+                }
+                command.type = Command::Type::ADD_SERVICES;
+                command.value = *count;
+                command.text = security;
+
+            } else if (name == "remove-services" && argument_count == 1) {
+                auto count = number(1);
+                if (!count) {
+                    return {};
+                }
+                command.type = Command::Type::REMOVE_SERVICES;
+                command.value = *count;
+
+            } else if (name == "storm" && argument_count == 2) {
+                auto rate_hz = number(1);
+                auto duration_ms = number(2);
+                if (!rate_hz || *rate_hz == 0 || !duration_ms) {
+                    return {};
+                }
+                command.type = Command::Type::STORM;
+                command.value = *rate_hz;
+                command.duration_ms = *duration_ms;
+
+            } else if (name == "connect" && argument_count == 1) {
+                auto index = number(1);
+                if (!index) {
+                    return {};
+                }
+                command.type = Command::Type::CONNECT;
+                command.value = *index;
+
+            } else if (name == "passphrase" && argument_count == 1) {
+                command.type = Command::Type::PASSPHRASE;
+                command.text = words[1];
+
+            } else if (name == "restart" && argument_count == 0) {
+                command.type = Command::Type::RESTART;
+
+            } else if (name == "wait" && argument_count == 1) {
+                auto duration_ms = number(1);
+                if (!duration_ms) {
+                    return {};
+                }
+                command.type = Command::Type::WAIT;
+                command.value = *duration_ms;
+
+            } else if (name == "quit" && argument_count == 0) {
+                command.type = Command::Type::QUIT;
+
+            } else {
+                return {};
+            }
+
+            return command;
+        }
+    }
+
+    std::optional<Script> Script::parse(const std::string &text, std::ostream &errors)
+    {
+        Script script;
+        std::istringstream lines(text);
+        std::string line;
+        std::size_t line_number = 0;
+
+        while (std::getline(lines, line)) {
+            line_number++;
+
+            std::istringstream line_stream(line);
+            std::vector<std::string> words;
+
+            for (std::string word; line_stream >> word;) {
+                words.push_back(word);
+            }
+
+            if (words.empty() || words[0][0] == '#') {
+                continue;
+            }
+
+            auto command = words_to_command(words);
+            if (!command) {
+                errors << "line " << line_number << ": invalid command \"" << line << "\"\n";
+                return {};
+            }
+
+            script.commands.push_back(std::move(*command));
+        }
+
+        return script;
+    }
+}
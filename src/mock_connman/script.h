@@ -0,0 +1,62 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#ifndef CONNECTIVITY_MANAGER_MOCK_CONNMAN_SCRIPT_H
+#define CONNECTIVITY_MANAGER_MOCK_CONNMAN_SCRIPT_H
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ConnectivityManager::MockConnMan
+{
+    // Script with commands for MockConnMan. One command per line, executed in order. Empty lines
+    // and lines starting with # are ignored.
+    //
+    //   add-services COUNT [none|wep|psk|ieee8021x]  Add Wi-Fi services (default security: psk).
+    //   remove-services COUNT                        Remove most recently added services.
+    //   storm RATE_HZ DURATION_MS                    Change strength of random services.
+    //   connect INDEX                                Connect service as if auto connecting.
+    //   passphrase PASSPHRASE                        Passphrase required by psk/wep services.
+    //   restart                                      Drop off the bus and come back (new owner).
+    //   wait DURATION_MS                             Wait before next command.
+    //   quit                                         Exit.
+    //
+    // "connect" makes the service ask the registered agent for input (RequestInput()) if it does
+    // not have credentials, like ConnMan does when auto connecting.
+    struct Script
+    {
+        struct Command
+        {
+            enum class Type
+            {
+                ADD_SERVICES,
+                REMOVE_SERVICES,
+                STORM,
+                CONNECT,
+                PASSPHRASE,
+                RESTART,
+                WAIT,
+                QUIT
+            };
+
+            Type type = Type::QUIT;
+            std::uint64_t value = 0;       // Count, rate, index or duration depending on type.
+            std::uint64_t duration_ms = 0; // Only used by STORM.
+            std::string text;              // Security or passphrase depending on type.
+        };
+
+        static std::optional<Script> parse(const std::string &text, std::ostream &errors);
+
+        std::vector<Command> commands;
+    };
+}
+
+#endif // CONNECTIVITY_MANAGER_MOCK_CONNMAN_SCRIPT_H
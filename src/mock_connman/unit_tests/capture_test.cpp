@@ -0,0 +1,166 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/capture.h"
+
+#include <giomm.h>
+#include <glib/gstdio.h>
+#include <glibmm.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        using Record = Capture::Record;
+
+        class CaptureTest : public testing::Test
+        {
+        protected:
+            static void SetUpTestCase()
+            {
+                Gio::init();
+            }
+
+            void SetUp() override
+            {
+                int fd = Glib::file_open_tmp(path_, "capture-test");
+                close(fd);
+            }
+
+            void TearDown() override
+            {
+                g_unlink(path_.c_str());
+            }
+
+            std::optional<Capture> load()
+            {
+                std::ostringstream errors;
+                return Capture::load(path_, errors);
+            }
+
+            std::string path_;
+        };
+
+        Record property_changed(std::uint64_t time_us, std::uint8_t strength)
+        {
+            Record record;
+            record.time_us = time_us;
+            record.type = Record::Type::SIGNAL;
+            record.path = "/net/connman/service/wifi_1_managed_psk";
+            record.interface = "net.connman.Service";
+            record.member = "PropertyChanged";
+            record.body = Glib::VariantContainerBase::create_tuple(
+                {Glib::Variant<Glib::ustring>::create("Strength"),
+                 Glib::Variant<Glib::VariantBase>::create(
+                     Glib::Variant<std::uint8_t>::create(strength))});
+            return record;
+        }
+
+        Record get_services_reply(std::uint64_t time_us)
+        {
+            using PropertyMap = std::map<Glib::ustring, Glib::VariantBase>;
+            using PropertiesArray =
+                std::vector<std::tuple<Glib::DBusObjectPathString, PropertyMap>>;
+
+            PropertiesArray services = {
+                {Glib::DBusObjectPathString("/net/connman/service/wifi_1_managed_psk"),
+                 {{"Name", Glib::Variant<Glib::ustring>::create("home")}}}};
+
+            Record record;
+            record.time_us = time_us;
+            record.type = Record::Type::METHOD_REPLY;
+            record.path = "/";
+            record.interface = "net.connman.Manager";
+            record.member = "GetServices";
+            record.body = Glib::VariantContainerBase::create_tuple(
+                Glib::Variant<PropertiesArray>::create(services));
+            return record;
+        }
+    }
+
+    TEST_F(CaptureTest, WrittenRecordsAreLoaded)
+    {
+        std::vector<Record> records = {
+            get_services_reply(10), property_changed(1000, 50), property_changed(2500, 60)};
+
+        {
+            Capture::Writer writer(path_);
+            for (const Record &record : records) {
+                writer.write(record);
+            }
+            writer.close();
+        }
+
+        std::optional<Capture> capture = load();
+
+        ASSERT_TRUE(capture);
+        ASSERT_EQ(capture->records.size(), records.size());
+
+        for (std::size_t i = 0; i < records.size(); i++) {
+            const Record &loaded = capture->records[i];
+
+            EXPECT_EQ(loaded.time_us, records[i].time_us);
+            EXPECT_EQ(loaded.type, records[i].type);
+            EXPECT_EQ(loaded.path, records[i].path);
+            EXPECT_EQ(loaded.interface, records[i].interface);
+            EXPECT_EQ(loaded.member, records[i].member);
+            EXPECT_TRUE(loaded.body.equal(records[i].body));
+        }
+    }
+
+    TEST_F(CaptureTest, RecordWithoutBodyIsLoadedWithEmptyTuple)
+    {
+        Record record;
+        record.type = Record::Type::METHOD_REPLY;
+        record.path = "/";
+        record.interface = "net.connman.Manager";
+        record.member = "RegisterAgent";
+
+        {
+            Capture::Writer writer(path_);
+            writer.write(record);
+            writer.close();
+        }
+
+        std::optional<Capture> capture = load();
+
+        ASSERT_TRUE(capture);
+        ASSERT_EQ(capture->records.size(), 1U);
+        EXPECT_EQ(capture->records[0].body.get_type_string(), "()");
+    }
+
+    TEST_F(CaptureTest, EmptyCaptureIsLoaded)
+    {
+        {
+            Capture::Writer writer(path_);
+            writer.close();
+        }
+
+        std::optional<Capture> capture = load();
+
+        ASSERT_TRUE(capture);
+        EXPECT_TRUE(capture->records.empty());
+    }
+
+    TEST_F(CaptureTest, FileWithoutMagicIsRejected)
+    {
+        Glib::file_set_contents(path_, "not a capture");
+
+        EXPECT_FALSE(load());
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2019 Luxoft Sweden AB
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+//
+// SPDX-License-Identifier: MPL-2.0
+
+#include "mock_connman/script.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <sstream>
+#include <string>
+
+namespace ConnectivityManager::MockConnMan
+{
+    namespace
+    {
+        using Type = Script::Command::Type;
+
+        std::optional<Script> parse(const std::string &text)
+        {
+            std::ostringstream errors;
+            return Script::parse(text, errors);
+        }
+    }
+
+    TEST(Script, EmptyLinesAndCommentsAreIgnored)
+    {
+        auto script = parse("\n# Comment\n   \n");
+
+        ASSERT_TRUE(script);
+        EXPECT_TRUE(script->commands.empty());
+    }
+
+    TEST(Script, AllCommands)
+    {
+        auto script = parse("add-services 10\n"
+                            "add-services 2 none\n"
+                            "remove-services 3\n"
+                            "storm 500 2000\n"
+                            "connect 1\n"
+                            "passphrase secret\n"
+                            "restart\n"
+                            "wait 100\n"
+                            "quit\n");
+
+        ASSERT_TRUE(script);
+        ASSERT_EQ(script->commands.size(), 9U);
+
+        const auto &c = script->commands;
+
+        EXPECT_EQ(c[0].type, Type::ADD_SERVICES);
+        EXPECT_EQ(c[0].value, 10U);
+        EXPECT_EQ(c[0].text, "psk");
+        EXPECT_EQ(c[1].type, Type::ADD_SERVICES);
+        EXPECT_EQ(c[1].value, 2U);
+        EXPECT_EQ(c[1].text, "none");
+        EXPECT_EQ(c[2].type, Type::REMOVE_SERVICES);
+        EXPECT_EQ(c[2].value, 3U);
+        EXPECT_EQ(c[3].type, Type::STORM);
+        EXPECT_EQ(c[3].value, 500U);
+        EXPECT_EQ(c[3].duration_ms, 2000U);
+        EXPECT_EQ(c[4].type, Type::CONNECT);
+        EXPECT_EQ(c[4].value, 1U);
+        EXPECT_EQ(c[5].type, Type::PASSPHRASE);
+        EXPECT_EQ(c[5].text, "secret");
+        EXPECT_EQ(c[6].type, Type::RESTART);
+        EXPECT_EQ(c[7].type, Type::WAIT);
+        EXPECT_EQ(c[7].value, 100U);
+        EXPECT_EQ(c[8].type, Type::QUIT);
+    }
+
+    TEST(Script, InvalidCommandsFail)
+    {
+        EXPECT_FALSE(parse("unknown\n"));
+        EXPECT_FALSE(parse("add-services\n"));
+        EXPECT_FALSE(parse("add-services ten\n"));
+        EXPECT_FALSE(parse("add-services 1 wpa3\n"));
+        EXPECT_FALSE(parse("storm 0 100\n"));
+        EXPECT_FALSE(parse("storm 100\n"));
+        EXPECT_FALSE(parse("restart now\n"));
+        EXPECT_FALSE(parse("wait -1\n"));
+    }
+
+    TEST(Script, ErrorContainsLineNumber)
+    {
+        std::ostringstream errors;
+
+        EXPECT_FALSE(Script::parse("wait 1\n\nbogus\n", errors));
+        EXPECT_NE(errors.str().find("line 3"), std::string::npos);
+    }
+}